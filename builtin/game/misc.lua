@@ -124,9 +124,14 @@ end
 -- To be overridden by protection mods
 
 function core.is_protected(pos, name)
-	return false
+	if core.get_protection(pos, name) ~= "denied" then
+		return false
+	end
+	return not (name and core.check_player_privs(name, "protection_bypass"))
 end
 
+local default_is_protected = core.is_protected
+
 
 function core.record_protection_violation(pos, name)
 	for _, func in pairs(core.registered_on_protection_violation) do
@@ -171,6 +176,12 @@ function core.is_area_protected(minp, maxp, player_name, interval)
 		end
 	end
 
+	-- Nothing else can protect the volume if no mod overrides is_protected()
+	if core.is_protected == default_is_protected and
+			core.get_area_protection(minp, maxp, player_name) ~= "denied" then
+		return false
+	end
+
 	for zf = minp.z, maxp.z, d.z do
 		local z = math.floor(zf + 0.5)
 		for yf = minp.y, maxp.y, d.y do
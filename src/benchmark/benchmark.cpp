@@ -18,15 +18,29 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 */
 
 #include "benchmark/benchmark.h"
+#include "settings.h"
+#include <string>
+#include <vector>
 
 // This must be set in just this file
 #define CATCH_CONFIG_RUNNER
 #include "benchmark_setup.h"
 
-int run_benchmarks()
+int run_benchmarks(const Settings &cmd_args)
 {
-	int argc = 1;
-	const char *argv[] = { "MinetestBenchmark", NULL };
-	int errCount = Catch::Session().run(argc, argv);
+	std::vector<std::string> args = { "MinetestBenchmark" };
+	// e.g. "benchmark_server"
+	if (cmd_args.exists("benchmark-filter"))
+		args.push_back(cmd_args.get("benchmark-filter"));
+	// Machine-readable results, to track regressions
+	if (cmd_args.exists("benchmark-output")) {
+		args.insert(args.end(), { "--reporter", "xml",
+			"--out", cmd_args.get("benchmark-output") });
+	}
+
+	std::vector<const char *> argv;
+	for (const std::string &arg : args)
+		argv.push_back(arg.c_str());
+	int errCount = Catch::Session().run((int)argv.size(), argv.data());
 	return errCount ? 1 : 0;
 }
@@ -22,5 +22,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "config.h"
 
 #if BUILD_BENCHMARKS
-extern int run_benchmarks();
+class Settings;
+
+extern int run_benchmarks(const Settings &cmd_args);
 #endif
@@ -0,0 +1,135 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "benchmark_setup.h"
+#include "mapgen/mg_biome.h"
+#include "noise.h"
+#include <cfloat>
+
+// About what biome-rich games register
+static const int NUM_BIOMES = 150;
+
+// The linear scan calcBiomeFromNoise used before biome bands
+static Biome *calcBiomeLinear(BiomeManager *bmgr, float heat, float humidity, v3s32 pos)
+{
+	Biome *biome_closest = nullptr;
+	Biome *biome_closest_blend = nullptr;
+	float dist_min = FLT_MAX;
+	float dist_min_blend = FLT_MAX;
+
+	for (size_t i = 1; i < bmgr->getNumObjects(); i++) {
+		Biome *b = (Biome *)bmgr->getRaw(i);
+		if (!b ||
+				pos.Y < b->min_pos.Y || pos.Y > b->max_pos.Y + b->vertical_blend ||
+				pos.X < b->min_pos.X || pos.X > b->max_pos.X ||
+				pos.Z < b->min_pos.Z || pos.Z > b->max_pos.Z)
+			continue;
+
+		float d_heat = heat - b->heat_point;
+		float d_humidity = humidity - b->humidity_point;
+		float dist = (d_heat * d_heat) + (d_humidity * d_humidity);
+
+		if (pos.Y <= b->max_pos.Y) {
+			if (dist < dist_min) {
+				dist_min = dist;
+				biome_closest = b;
+			}
+		} else if (dist < dist_min_blend) {
+			dist_min_blend = dist;
+			biome_closest_blend = b;
+		}
+	}
+
+	const u64 seed = pos.Y + (heat + humidity) * 0.9f;
+	PcgRandom rng(seed);
+
+	if (biome_closest_blend && dist_min_blend <= dist_min &&
+			rng.range(0, biome_closest_blend->vertical_blend) >=
+			pos.Y - biome_closest_blend->max_pos.Y)
+		return biome_closest_blend;
+
+	return (biome_closest) ? biome_closest : (Biome *)bmgr->getRaw(BIOME_NONE);
+}
+
+TEST_CASE("benchmark_biome")
+{
+	BiomeManager bmgr(nullptr);
+	PcgRandom rng(42);
+
+	// Surface, ocean and underground variants on a coarse heat/humidity
+	// grid, so equal distances are common
+	for (int i = 0; i < NUM_BIOMES; i++) {
+		Biome *b = BiomeManager::create(BIOMETYPE_NORMAL);
+		b->name = "biome" + std::to_string(i);
+		b->flags = 0;
+		switch (i % 3) {
+		case 0:
+			b->min_pos = v3s32(-31000, 4, -31000);
+			b->max_pos = v3s32(31000, 31000, 31000);
+			break;
+		case 1:
+			b->min_pos = v3s32(-31000, -255, -31000);
+			b->max_pos = v3s32(31000, 3, 31000);
+			break;
+		default:
+			b->min_pos = v3s32(-31000, -31000, -31000);
+			b->max_pos = v3s32(31000, -256, 31000);
+			break;
+		}
+		if (i % 7 == 0)
+			b->min_pos.X = rng.range(-200, 0);
+		b->heat_point = rng.range(0, 10) * 10.0f;
+		b->humidity_point = rng.range(0, 10) * 10.0f;
+		b->vertical_blend = (i % 5 == 0) ? 8 : 0;
+		bmgr.add(b);
+	}
+
+	BiomeParamsOriginal params;
+	params.seed = 0;
+	BiomeGenOriginal biomegen(&bmgr, &params, v3s32(80, 80, 80));
+
+	const int num_points = 4096;
+	std::vector<v3s32> positions;
+	std::vector<float> heat, humidity;
+	for (int i = 0; i < num_points; i++) {
+		positions.emplace_back(rng.range(-400, 400), rng.range(-400, 400),
+			rng.range(-400, 400));
+		heat.push_back(rng.range(-200, 1200) * 0.1f);
+		humidity.push_back(rng.range(-200, 1200) * 0.1f);
+	}
+
+	for (int i = 0; i < num_points; i++) {
+		REQUIRE(biomegen.calcBiomeFromNoise(heat[i], humidity[i], positions[i]) ==
+			calcBiomeLinear(&bmgr, heat[i], humidity[i], positions[i]));
+	}
+
+	BENCHMARK("calcBiomeFromNoise_linear") {
+		size_t sum = 0;
+		for (int i = 0; i < num_points; i++)
+			sum += calcBiomeLinear(&bmgr, heat[i], humidity[i], positions[i])->index;
+		return sum;
+	};
+
+	BENCHMARK("calcBiomeFromNoise_banded") {
+		size_t sum = 0;
+		for (int i = 0; i < num_points; i++)
+			sum += biomegen.calcBiomeFromNoise(heat[i], humidity[i], positions[i])->index;
+		return sum;
+	};
+}
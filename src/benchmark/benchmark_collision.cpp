@@ -0,0 +1,148 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest Authors
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "benchmark_setup.h"
+#include "collision.h"
+#include "dummyenvironment.h"
+#include "dummygamedef.h"
+#include "dummymap.h"
+#include "noise.h"
+#include "server/activeobjectmgr.h"
+
+class BenchmarkSAO : public ServerActiveObject
+{
+public:
+	BenchmarkSAO(const v3f &p) : ServerActiveObject(nullptr, p) {}
+
+	ActiveObjectType getType() const override { return ACTIVEOBJECT_TYPE_TEST; }
+	bool getCollisionBox(aabb3f *toset) const override { return false; }
+	bool getSelectionBox(aabb3f *toset) const override { return false; }
+	bool collideWithObjects() const override { return true; }
+};
+
+static const int ENTITY_COUNT = 1000;
+
+TEST_CASE("benchmark_collision")
+{
+	DummyGameDef gamedef;
+	NodeDefManager *ndef = gamedef.getWritableNodeDefManager();
+
+	content_t c_stone, c_slab;
+	{
+		ContentFeatures f;
+		f.name = "stone";
+		c_stone = ndef->set(f.name, f);
+	}
+	{
+		ContentFeatures f;
+		f.name = "slab";
+		f.drawtype = NDT_NODEBOX;
+		f.node_box.type = NODEBOX_FIXED;
+		f.node_box.fixed.emplace_back(-BS / 2, -BS / 2, -BS / 2, BS / 2, 0, BS / 2);
+		c_slab = ndef->set(f.name, f);
+	}
+
+	// Flat ground with scattered pillars and slabs
+	v3s32 bpmin(-3, -1, -3), bpmax(2, 1, 2);
+	DummyMap map(&gamedef, bpmin, bpmax);
+	PcgRandom pr(42);
+	v3s32 nmin = bpmin * MAP_BLOCKSIZE;
+	v3s32 nmax = (bpmax + v3s32(1, 1, 1)) * MAP_BLOCKSIZE - v3s32(1, 1, 1);
+	for (s32 z = nmin.Z; z <= nmax.Z; z++)
+	for (s32 x = nmin.X; x <= nmax.X; x++) {
+		s32 height = 0;
+		content_t top = CONTENT_AIR;
+		u32 r = pr.range(0, 99);
+		if (r < 5)
+			height = pr.range(1, 3);
+		else if (r < 15)
+			top = c_slab;
+		for (s32 y = nmin.Y; y <= nmax.Y; y++) {
+			content_t c = CONTENT_AIR;
+			if (y <= height)
+				c = c_stone;
+			else if (y == height + 1)
+				c = top;
+			map.setNode(v3s32(x, y, z), MapNode(c));
+		}
+	}
+
+	DummyEnvironment env(&gamedef, &map);
+
+	struct Entity {
+		v3f pos;
+		v3f speed;
+	};
+	std::vector<Entity> entities;
+	s32 extent = (MAP_BLOCKSIZE * 5) / 2;
+	for (int i = 0; i < ENTITY_COUNT; i++) {
+		Entity e;
+		e.pos = v3f(pr.range(-extent, extent), 3, pr.range(-extent, extent)) * BS;
+		e.speed = v3f(pr.range(-40, 40), 0, pr.range(-40, 40)) * (BS / 10.0f);
+		entities.push_back(e);
+	}
+
+	const aabb3f box(-0.3f * BS, -0.5f * BS, -0.3f * BS, 0.3f * BS, 1.2f * BS, 0.3f * BS);
+
+	BENCHMARK_ADVANCED("collisionMoveSimple_entities")(Catch::Benchmark::Chronometer meter) {
+		meter.measure([&] {
+			for (Entity &e : entities) {
+				collisionMoveSimple(&env, &gamedef, BS * 0.5f, box, 0.6f * BS,
+					0.05f, &e.pos, &e.speed, v3f(0, -9.81f * BS, 0), nullptr, false);
+				// Keep the entities on the map
+				if (std::fabs(e.pos.X) > extent * BS || std::fabs(e.pos.Z) > extent * BS) {
+					e.pos = v3f(0, 3 * BS, 0);
+					e.speed = -e.speed;
+				}
+			}
+		});
+	};
+
+	server::ActiveObjectMgr saomgr;
+	for (const Entity &e : entities)
+		saomgr.registerObject(new BenchmarkSAO(e.pos));
+	saomgr.step(0.05f, [] (ServerActiveObject *obj) {});
+
+	BENCHMARK_ADVANCED("getObjectsInsideRadius_all_objects")(Catch::Benchmark::Chronometer meter) {
+		std::vector<ServerActiveObject *> result;
+		meter.measure([&] {
+			for (const Entity &e : entities) {
+				result.clear();
+				saomgr.getObjectsInsideRadius(e.pos, 2.0f * BS, result, nullptr);
+			}
+			return result.size();
+		});
+	};
+
+	BENCHMARK_ADVANCED("getCollisionCandidates_all_objects")(Catch::Benchmark::Chronometer meter) {
+		std::vector<ServerActiveObject *> result;
+		meter.measure([&] {
+			for (const Entity &e : entities) {
+				result.clear();
+				saomgr.getCollisionCandidates(e.pos, 2.0f * BS, result, nullptr);
+			}
+			return result.size();
+		});
+	};
+
+	saomgr.clear([] (ServerActiveObject *obj, u16 id) {
+		delete obj;
+		return true;
+	});
+}
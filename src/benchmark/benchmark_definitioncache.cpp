@@ -0,0 +1,75 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest Authors
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "benchmark_setup.h"
+#include "server/definitioncache.h"
+#include "itemdef.h"
+#include "nodedef.h"
+#include "network/networkprotocol.h"
+#include <memory>
+
+// Number of clients joining at once after a server restart
+static const int JOIN_STORM_CLIENTS = 50;
+
+TEST_CASE("benchmark_definitioncache")
+{
+	std::unique_ptr<IWritableItemDefManager> idef(createItemDefManager());
+	std::unique_ptr<NodeDefManager> ndef(createNodeDefManager());
+
+	// Roughly what a large game registers
+	for (int i = 0; i < 15000; i++) {
+		std::string name = "bench:node_" + std::to_string(i);
+
+		ItemDefinition item;
+		item.type = ITEM_NODE;
+		item.name = name;
+		item.description = "Benchmark node " + std::to_string(i);
+		item.inventory_image = "bench_node_" + std::to_string(i % 64) + ".png";
+		item.groups["cracky"] = 1 + i % 3;
+		idef->registerItem(item);
+
+		ContentFeatures f;
+		f.name = name;
+		f.groups["cracky"] = 1 + i % 3;
+		for (TileDef &tile : f.tiledef)
+			tile.name = "bench_node_" + std::to_string(i % 64) + ".png";
+		ndef->set(name, f);
+	}
+
+	BENCHMARK("join_storm_uncached") {
+		size_t total = 0;
+		for (int i = 0; i < JOIN_STORM_CLIENTS; i++) {
+			DefinitionCache::Blob blob = DefinitionCache::build(idef.get(),
+					ndef.get(), LATEST_PROTOCOL_VERSION);
+			total += blob.itemdef.size() + blob.nodedef.size();
+		}
+		return total;
+	};
+
+	BENCHMARK("join_storm_cached") {
+		DefinitionCache cache(idef.get(), ndef.get());
+		cache.prepare(LATEST_PROTOCOL_VERSION);
+		size_t total = 0;
+		for (int i = 0; i < JOIN_STORM_CLIENTS; i++) {
+			auto blob = cache.get(LATEST_PROTOCOL_VERSION);
+			total += blob->itemdef.size() + blob->nodedef.size();
+		}
+		return total;
+	};
+}
@@ -0,0 +1,74 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "benchmark_setup.h"
+#include "filesys.h"
+#include "porting.h"
+#include "irrlicht_changes/CGUITTFont.h"
+
+using namespace irr::gui;
+
+// Rasterizes glyphs the way CGUITTFont does, without a video driver.
+static void benchmark_rasterize(FT_Face face, u32 font_size, FT_Int32 load_flags,
+		const char *name)
+{
+	std::vector<u32> char_indices;
+	for (u32 c = 0x20; c < 0x180; c++) {
+		u32 char_index = FT_Get_Char_Index(face, c);
+		if (char_index)
+			char_indices.push_back(char_index);
+	}
+	REQUIRE(!char_indices.empty());
+
+	BENCHMARK(name) {
+		size_t pixels = 0;
+		for (u32 char_index : char_indices) {
+			SGUITTGlyphBitmap bitmap;
+			if (bitmap.rasterize(face, char_index, font_size, load_flags))
+				pixels += bitmap.coverage.size();
+		}
+		return pixels;
+	};
+}
+
+TEST_CASE("benchmark_fonts")
+{
+	std::string path = porting::path_share + DIR_DELIM "fonts" DIR_DELIM
+		"Arimo-Regular.ttf";
+	if (!fs::PathExists(path)) {
+		WARN("font not found: " << path);
+		return;
+	}
+
+	FT_Library library;
+	REQUIRE(FT_Init_FreeType(&library) == 0);
+	FT_Face face;
+	REQUIRE(FT_New_Face(library, path.c_str(), 0, &face) == 0);
+
+	const FT_Int32 gray = FT_LOAD_DEFAULT | FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL;
+	const FT_Int32 mono = FT_LOAD_DEFAULT | FT_LOAD_RENDER | FT_LOAD_MONOCHROME |
+		FT_LOAD_TARGET_MONO;
+
+	benchmark_rasterize(face, 16, gray, "rasterize_latin_16px");
+	benchmark_rasterize(face, 32, gray, "rasterize_latin_32px");
+	benchmark_rasterize(face, 32, mono, "rasterize_latin_32px_mono");
+
+	FT_Done_Face(face);
+	FT_Done_FreeType(library);
+}
@@ -0,0 +1,70 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "benchmark_setup.h"
+#include "formspec_patch.h"
+
+// A machine-style UI: inventory lists, a grid of buttons and status labels
+static std::string makeFormspec(int progress)
+{
+	std::string fs = "formspec_version[4]size[10.75,11]"
+		"list[context;src;0.375,0.5;3,3;]list[context;dst;6.375,0.5;3,3;]"
+		"list[current_player;main;0.375,6;8,4;]";
+	for (int i = 0; i < 100; i++) {
+		std::string n = std::to_string(i);
+		fs += "button[" + std::to_string(i % 10) + "," + std::to_string(i / 10) +
+			";1,0.5;btn" + n + ";Button " + n + "]";
+		fs += "label[" + std::to_string(i % 10) + "," + std::to_string(i / 10) +
+			".5;Status " + n + "]";
+	}
+	fs += "image[4.5,1.5;1,1;gui_furnace_arrow_bg.png^[lowpart:" +
+		std::to_string(progress) + ":gui_furnace_arrow_fg.png^[transformR270]";
+	fs += "button[4,3;2,0.8;progress;" + std::to_string(progress) + "%]";
+	return fs;
+}
+
+TEST_CASE("benchmark_formspec")
+{
+	const std::string formspec = makeFormspec(0);
+
+	BENCHMARK("splitFormspec") {
+		return splitFormspec(formspec).size();
+	};
+
+	BENCHMARK_ADVANCED("patchFormspecElements")(Catch::Benchmark::Chronometer meter) {
+		std::vector<std::string> elements = splitFormspec(formspec);
+		int progress = 0;
+		meter.measure([&] {
+			progress = (progress + 1) % 100;
+			StringMap patches;
+			patches["progress"] = "button[4,3;2,0.8;progress;" +
+				std::to_string(progress) + "%]";
+			return patchFormspecElements(elements, patches).size();
+		});
+	};
+
+	BENCHMARK_ADVANCED("applyFormspecPatch")(Catch::Benchmark::Chronometer meter) {
+		std::vector<std::string> elements = splitFormspec(formspec);
+		FormspecPatch patch = {{(u32)elements.size() - 2, "button[4,3;2,0.8;progress;50%"}};
+		meter.measure([&] {
+			applyFormspecPatch(elements, patch);
+			return joinFormspec(elements).size();
+		});
+	};
+}
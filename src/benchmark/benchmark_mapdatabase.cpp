@@ -0,0 +1,114 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "benchmark_setup.h"
+#include "cmake_config.h"
+#include "database/database-sqlite3.h"
+#if USE_POSTGRESQL
+#include "database/database-postgresql.h"
+#endif
+#if USE_REDIS
+#include "database/database-redis.h"
+#include "settings.h"
+#endif
+#include "filesys.h"
+#include <cstdlib>
+#include <memory>
+
+// Blocks requested by a single emerge or save pass
+static const int BATCH_BLOCKS = 256;
+
+static void benchmarkMapDatabase(const char *name, MapDatabase *db)
+{
+	std::vector<v3s32> positions;
+	std::vector<std::pair<v3s32, std::string>> blocks;
+	for (int i = 0; i < BATCH_BLOCKS; i++) {
+		v3s32 pos(i % 8, i / 64, (i / 8) % 8);
+		positions.push_back(pos);
+		// About the size of a compressed block
+		blocks.emplace_back(pos, std::string(2000, (char)i));
+	}
+
+	db->beginSave();
+	db->saveBlocks(blocks);
+	db->endSave();
+
+	BENCHMARK(std::string(name) + "_load_single") {
+		std::string data;
+		size_t total = 0;
+		for (const v3s32 &pos : positions) {
+			db->loadBlock(pos, &data);
+			total += data.size();
+		}
+		return total;
+	};
+
+	BENCHMARK(std::string(name) + "_load_batched") {
+		std::vector<std::string> data;
+		db->loadBlocks(positions, data);
+		return data.size();
+	};
+
+	BENCHMARK(std::string(name) + "_save_single") {
+		db->beginSave();
+		for (const auto &block : blocks)
+			db->saveBlock(block.first, block.second);
+		db->endSave();
+	};
+
+	BENCHMARK(std::string(name) + "_save_batched") {
+		db->beginSave();
+		db->saveBlocks(blocks);
+		db->endSave();
+	};
+
+	db->beginSave();
+	for (const v3s32 &pos : positions)
+		db->deleteBlock(pos);
+	db->endSave();
+}
+
+TEST_CASE("benchmark_mapdatabase")
+{
+	std::string dir = fs::TempPath() + DIR_DELIM "mtbench_mapdatabase";
+	fs::CreateAllDirs(dir);
+	{
+		MapDatabaseSQLite3 db(dir);
+		benchmarkMapDatabase("sqlite3", &db);
+	}
+	fs::RecursiveDelete(dir);
+
+	// Networked backends are benchmarked against a local test database
+#if USE_POSTGRESQL
+	if (const char *connect_string = getenv("MINETEST_POSTGRESQL_CONNECT_STRING")) {
+		MapDatabasePostgreSQL db(connect_string);
+		benchmarkMapDatabase("postgresql", &db);
+	}
+#endif
+
+#if USE_REDIS
+	if (const char *address = getenv("MINETEST_REDIS_ADDRESS")) {
+		Settings conf;
+		conf.set("redis_address", address);
+		conf.set("redis_hash", "mtbench_mapdatabase");
+		Database_Redis db(conf);
+		benchmarkMapDatabase("redis", &db);
+	}
+#endif
+}
@@ -0,0 +1,309 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "benchmark_setup.h"
+#include "clientiface.h"
+#include "content/subgames.h"
+#include "emerge.h"
+#include "filesys.h"
+#include "map.h"
+#include "mapblock.h"
+#include "nodedef.h"
+#include "noise.h"
+#include "remoteplayer.h"
+#include "server.h"
+#include "serverenvironment.h"
+#include "settings.h"
+#include "voxel.h"
+#include "server/luaentity_sao.h"
+#include "server/player_sao.h"
+#include "threading/mutex_auto_lock.h"
+#include <condition_variable>
+#include <mutex>
+
+/*
+	Times the parts of a server step that limit how many players a server
+	can hold, on a devtest world generated by mapgen v7 with a fixed seed.
+*/
+
+static const int NUM_PLAYERS = 16;
+static const int NUM_ENTITIES = 500;
+// Players are spread over a ring of this radius (in nodes)
+static const s32 PLAYER_RING = 256;
+// Blocks generated around each player before timing, in each direction
+static const s16 PLAYER_AREA = 3;
+
+// Trigger on common nodes without changing anything, to time the scan
+class BenchmarkABM : public ActiveBlockModifier
+{
+public:
+	const std::vector<std::string> &getTriggerContents() const override
+	{ return m_contents; }
+	const std::vector<std::string> &getRequiredNeighbors() const override
+	{ return m_neighbors; }
+	float getTriggerInterval() override { return 1.0f; }
+	u32 getTriggerChance() override { return 50; }
+	bool getSimpleCatchUp() override { return true; }
+	s32 getMinY() override { return -MAX_MAP_GENERATION_LIMIT; }
+	s32 getMaxY() override { return MAX_MAP_GENERATION_LIMIT; }
+	void trigger(ServerEnvironment *env, v3s32 p, MapNode n,
+			u32 active_object_count, u32 active_object_count_wider) override
+	{ triggered++; }
+
+	u32 triggered = 0;
+
+private:
+	std::vector<std::string> m_contents = {"basenodes:stone",
+		"basenodes:dirt_with_grass"};
+	std::vector<std::string> m_neighbors = {"air"};
+};
+
+struct EmergeWait
+{
+	std::mutex mutex;
+	std::condition_variable done;
+	size_t remaining = 0;
+};
+
+static void emerge_callback(v3s32 blockpos, EmergeAction action, void *param)
+{
+	EmergeWait *wait = (EmergeWait *)param;
+	MutexAutoLock lock(wait->mutex);
+	if (--wait->remaining == 0)
+		wait->done.notify_all();
+}
+
+// Sets up a server without networking and gives access to its internals
+class BenchmarkServerFixture
+{
+public:
+	BenchmarkServerFixture(const std::string &world, const SubgameSpec &gamespec) :
+		m_server(world, gamespec, false, Address(), true)
+	{
+		m_server.init();
+	}
+
+	ServerEnvironment &env() { return *m_server.m_env; }
+	ServerMap &map() { return m_server.m_env->getServerMap(); }
+	EmergeManager *emerge() { return m_server.m_emerge; }
+
+	PlayerSAO *addPlayer(const std::string &name, session_t peer_id)
+	{
+		return m_server.emergePlayer(name.c_str(), peer_id, LATEST_PROTOCOL_VERSION);
+	}
+
+	// Emerges the blocks and waits until all are done
+	void emergeArea(v3s32 bmin, v3s32 bmax)
+	{
+		EmergeWait wait;
+		VoxelArea area(bmin, bmax);
+		wait.remaining = area.getVolume();
+		for (s32 z = bmin.Z; z <= bmax.Z; z++)
+		for (s32 y = bmin.Y; y <= bmax.Y; y++)
+		for (s32 x = bmin.X; x <= bmax.X; x++) {
+			m_server.m_emerge->enqueueBlockEmergeEx(v3s32(x, y, z),
+				PEER_ID_INEXISTENT, BLOCK_EMERGE_ALLOW_GEN | BLOCK_EMERGE_FORCE_QUEUE,
+				emerge_callback, &wait);
+		}
+
+		std::unique_lock<std::mutex> lock(wait.mutex);
+		wait.done.wait(lock, [&] { return wait.remaining == 0; });
+	}
+
+private:
+	Server m_server;
+};
+
+TEST_CASE("benchmark_server")
+{
+	SubgameSpec gamespec = findSubgame("devtest");
+	if (!gamespec.isValid()) {
+		WARN("devtest game not found, skipping server benchmarks");
+		return;
+	}
+
+	std::string world = fs::TempPath() + DIR_DELIM "mtbench_server";
+	fs::RecursiveDelete(world);
+	fs::CreateAllDirs(world);
+	fs::safeWriteToFile(world + DIR_DELIM "map_meta.txt",
+		"mg_name = v7\nseed = 42\n[end_of_params]\n");
+
+	{
+		BenchmarkServerFixture fixture(world, gamespec);
+		ServerEnvironment &env = fixture.env();
+		ServerMap &map = fixture.map();
+		EmergeManager *emerge = fixture.emerge();
+		PcgRandom pr(42);
+
+		emerge->startThreads();
+
+		// A mapchunk further away each time, so every run generates
+		int emerge_run = 0;
+		BENCHMARK_ADVANCED("emerge_mapchunk")(Catch::Benchmark::Chronometer meter) {
+			meter.measure([&] {
+				v3s32 bmin(-2 + 5 * (PLAYER_RING / MAP_BLOCKSIZE + 10 + emerge_run++),
+					-2, -2);
+				fixture.emergeArea(bmin, bmin + v3s32(4, 4, 4));
+			});
+		};
+
+		// Players on the ground, each with its surroundings generated
+		std::vector<PlayerSAO *> players;
+		std::vector<v3s32> player_nodes;
+		for (int i = 0; i < NUM_PLAYERS; i++) {
+			f32 angle = 2 * core::PI * i / NUM_PLAYERS;
+			v2s32 p2d(PLAYER_RING * std::cos(angle), PLAYER_RING * std::sin(angle));
+			s32 y = emerge->getSpawnLevelAtPoint(p2d);
+			if (y == MAX_MAP_GENERATION_LIMIT)
+				y = 10;
+			v3s32 pos(p2d.X, y, p2d.Y);
+
+			v3s32 bp = getNodeBlockPos(pos);
+			v3s32 extent(PLAYER_AREA, PLAYER_AREA, PLAYER_AREA);
+			fixture.emergeArea(bp - extent, bp + extent);
+
+			PlayerSAO *sao = fixture.addPlayer("bench" + itos(i), i + 1);
+			REQUIRE(sao);
+			sao->setBasePosition(v3d(pos.X, pos.Y, pos.Z) * BS);
+			players.push_back(sao);
+			player_nodes.push_back(pos);
+		}
+
+		// Generation is done, nothing may touch the map concurrently from now on
+		emerge->stopThreads();
+
+		// Dropped items around the players
+		for (int i = 0; i < NUM_ENTITIES; i++) {
+			v3s32 pos = player_nodes[i % NUM_PLAYERS] +
+				v3s32(pr.range(-32, 32), 1, pr.range(-32, 32));
+			env.addActiveObject(new LuaEntitySAO(&env, intToFloat(pos, BS),
+				"__builtin:item", "return {itemstring = \"basenodes:stone\"}"));
+		}
+
+		BenchmarkABM *abm = new BenchmarkABM();
+		env.addActiveBlockModifier(abm);
+
+		// Activates the blocks around the players
+		env.step(g_settings->getFloat("active_block_mgmt_interval"));
+
+		const s16 active_block_range = g_settings->getS16("active_block_range");
+		const s16 active_object_range = g_settings->getS16("active_object_send_range_blocks");
+		const f32 server_step = g_settings->getFloat("dedicated_server_step");
+		const f32 abm_interval = g_settings->getFloat("abm_interval");
+
+		BENCHMARK_ADVANCED("ActiveBlockList::update")(Catch::Benchmark::Chronometer meter) {
+			ActiveBlockList blocks;
+			std::set<v3s32> removed, added;
+			blocks.update(players, active_block_range, active_object_range,
+				removed, added);
+			// Every player moves a block and back, so blocks change each time
+			meter.measure([&] (int i) {
+				v3d offset = v3d(i % 2 ? 1 : -1, 0, 0) * (MAP_BLOCKSIZE * BS);
+				for (PlayerSAO *sao : players)
+					sao->setBasePosition(sao->getBasePosition() + offset);
+				removed.clear();
+				added.clear();
+				blocks.update(players, active_block_range, active_object_range,
+					removed, added);
+				return added.size();
+			});
+
+			for (int i = 0; i < NUM_PLAYERS; i++)
+				players[i]->setBasePosition(v3d(player_nodes[i].X,
+					player_nodes[i].Y, player_nodes[i].Z) * BS);
+		};
+
+		BENCHMARK("ServerEnvironment::step") {
+			env.step(server_step);
+		};
+
+		BENCHMARK("ServerEnvironment::step_abm") {
+			// Long enough for a pass over all active blocks each time
+			env.step(abm_interval);
+			return abm->triggered;
+		};
+
+		BENCHMARK_ADVANCED("getObjectsInsideRadius_players")(Catch::Benchmark::Chronometer meter) {
+			std::vector<ServerActiveObject *> result;
+			meter.measure([&] {
+				for (PlayerSAO *sao : players) {
+					result.clear();
+					env.getObjectsInsideRadius(result, sao->getBasePosition(),
+						active_object_range * MAP_BLOCKSIZE * BS, nullptr);
+				}
+				return result.size();
+			});
+		};
+
+		BENCHMARK_ADVANCED("RemoteClient::GetNextBlocks")(Catch::Benchmark::Chronometer meter) {
+			std::vector<PrioritySortedBlockTransfer> queue;
+			meter.measure([&] {
+				queue.clear();
+				// Fresh clients that have not been sent anything yet
+				for (PlayerSAO *sao : players) {
+					RemoteClient client;
+					client.peer_id = sao->getPeerID();
+					client.GetNextBlocks(&env, emerge, server_step, queue);
+				}
+				return queue.size();
+			});
+		};
+
+		// Sources on the surface next to the players
+		content_t c_water = env.getGameDef()->ndef()->getId("basenodes:water_source");
+		std::vector<v3s32> sources;
+		for (int i = 0; i < 64; i++) {
+			sources.push_back(player_nodes[i % NUM_PLAYERS] +
+				v3s32(pr.range(-24, 24), 1, pr.range(-24, 24)));
+		}
+
+		BENCHMARK_ADVANCED("ServerMap::transformLiquids")(Catch::Benchmark::Chronometer meter) {
+			meter.measure([&] (int i) {
+				v3s32 p = sources[i % sources.size()];
+				map.setNode(p, MapNode(c_water));
+				map.transforming_liquid_add(p);
+				std::map<v3s32, MapBlock *> modified_blocks;
+				map.transformLiquids(modified_blocks, &env);
+				return modified_blocks.size();
+			});
+		};
+
+		// Blocks are loaded over themselves below, which objects would not survive
+		env.clearObjects(CLEAR_OBJECTS_MODE_QUICK);
+
+		std::vector<v3s32> positions;
+		map.listAllLoadedBlocks(positions);
+		MapBlockVect blocks;
+		for (v3s32 p : positions)
+			blocks.push_back(map.getBlockNoCreateNoEx(p));
+
+		BENCHMARK("ServerMap::saveBlocks") {
+			map.beginSave();
+			map.saveBlocks(blocks);
+			map.endSave();
+		};
+
+		BENCHMARK("ServerMap::loadBlock") {
+			for (v3s32 p : positions)
+				map.loadBlock(p);
+		};
+	}
+
+	fs::RecursiveDelete(world);
+}
@@ -0,0 +1,42 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "benchmark_setup.h"
+#include "settings.h"
+
+TEST_CASE("benchmark_settings")
+{
+	// Set in the defaults layer, so a lookup walks the whole hierarchy
+	const std::string name = "max_block_send_distance";
+	SettingHandle<s32> handle(g_settings, name);
+
+	BENCHMARK("Settings::getS32") {
+		s32 sum = 0;
+		for (int i = 0; i < 1000; i++)
+			sum += g_settings->getS32(name);
+		return sum;
+	};
+
+	BENCHMARK("SettingHandle::get") {
+		s32 sum = 0;
+		for (int i = 0; i < 1000; i++)
+			sum += handle.get();
+		return sum;
+	};
+}
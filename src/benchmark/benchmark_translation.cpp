@@ -0,0 +1,50 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "benchmark_setup.h"
+#include "translation.h"
+#include "util/string.h"
+
+TEST_CASE("benchmark_translation")
+{
+	std::string data = "# textdomain: hud\n";
+	for (int i = 0; i < 500; i++) {
+		std::string n = std::to_string(i);
+		data += "Item " + n + " x@1=Gegenstand " + n + " x@1\n";
+	}
+	Translations translations;
+	translations.loadTranslation(data);
+
+	// A HUD line with an argument, as it is drawn every frame
+	const std::wstring hud = L"\x1b(T@hud)Item 250 x\x1b" L"F99\x1b" L"E\x1b" L"E";
+	REQUIRE(translate_string(hud, &translations) == L"Gegenstand 250 x99");
+
+	BENCHMARK("getTranslation") {
+		return translations.getTranslation(L"hud", L"Item 250 x@1").size();
+	};
+
+	BENCHMARK("translate_string_hud") {
+		return translate_string(hud, &translations).size();
+	};
+
+	const std::wstring plain = L"Plain chat message without escapes";
+	BENCHMARK("translate_string_plain") {
+		return translate_string(plain, &translations).size();
+	};
+}
@@ -0,0 +1,514 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "benchmark/loadtest.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "constants.h"
+#include "exceptions.h"
+#include "log.h"
+#include "network/networkpacket.h"
+#include "network/networkexceptions.h"
+#include "porting.h"
+#include "serialization.h"
+#include "settings.h"
+#include "util/auth.h"
+#include "util/pointedthing.h"
+#include "util/srp.h"
+#include "util/string.h"
+#include "version.h"
+
+// Walking speed in nodes per second, below what the anticheat allows
+static const f32 BOT_SPEED = 3.0f;
+
+LoadTestBot::LoadTestBot(const std::string &name, const Address &address,
+		u64 seed) :
+	m_name(name),
+	m_address(address),
+	m_rand(seed)
+{
+}
+
+LoadTestBot::~LoadTestBot()
+{
+	disconnect();
+	if (m_srp_user)
+		srp_user_delete((SRPUser *)m_srp_user);
+}
+
+void LoadTestBot::connect()
+{
+	m_con.reset(new con::Connection(PROTOCOL_ID, 512, CONNECTION_TIMEOUT,
+		m_address.isIPv6(), this));
+	m_con->SetTimeoutMs(0);
+	m_con->Connect(m_address);
+	sendInit();
+}
+
+void LoadTestBot::disconnect()
+{
+	if (!m_con)
+		return;
+	m_con->Disconnect();
+	m_con.reset();
+	if (m_state != State::Gone && m_error.empty())
+		m_error = "disconnected";
+	m_state = State::Gone;
+}
+
+void LoadTestBot::deletingPeer(con::Peer *peer, bool timeout)
+{
+	if (m_error.empty())
+		m_error = timeout ? "timed out" : "connection closed";
+	m_state = State::Gone;
+}
+
+LoadTestBot::Stats LoadTestBot::getStats()
+{
+	if (m_con && m_state != State::Gone)
+		m_stats.avg_rtt = m_con->getPeerStat(PEER_ID_SERVER, con::AVG_RTT);
+	return m_stats;
+}
+
+bool LoadTestBot::step(f32 dtime)
+{
+	if (!m_con || m_state == State::Gone)
+		return false;
+
+	m_time += dtime;
+
+	NetworkPacket pkt;
+	try {
+		while (m_con->TryReceive(&pkt)) {
+			m_stats.packets_received++;
+			m_stats.bytes_received += pkt.getSize();
+			handlePacket(&pkt);
+			if (m_state == State::Gone)
+				return false;
+			pkt.clear();
+		}
+	} catch (con::InvalidIncomingDataException &e) {
+		m_error = std::string("invalid data: ") + e.what();
+		disconnect();
+		return false;
+	} catch (PacketError &e) {
+		m_error = std::string("invalid data: ") + e.what();
+		disconnect();
+		return false;
+	}
+
+	switch (m_state) {
+	case State::Connecting:
+		// TOSERVER_INIT is unreliable
+		m_init_timer += dtime;
+		if (m_init_timer >= 1.0f) {
+			m_init_timer = 0;
+			sendInit();
+		}
+		break;
+	case State::Ready:
+		act(dtime);
+		break;
+	default:
+		break;
+	}
+	return m_state != State::Gone;
+}
+
+void LoadTestBot::send(NetworkPacket *pkt, u8 channel, bool reliable)
+{
+	m_stats.packets_sent++;
+	m_stats.bytes_sent += pkt->getSize();
+	m_con->Send(PEER_ID_SERVER, channel, pkt, reliable);
+}
+
+void LoadTestBot::handlePacket(NetworkPacket *pkt)
+{
+	switch (pkt->getCommand()) {
+	case TOCLIENT_HELLO:
+		handleHello(pkt);
+		break;
+	case TOCLIENT_SRP_BYTES_S_B:
+		handleSrpBytesSandB(pkt);
+		break;
+	case TOCLIENT_AUTH_ACCEPT:
+		handleAuthAccept(pkt);
+		break;
+	case TOCLIENT_ANNOUNCE_MEDIA: {
+		// Media is not needed, the bot is ready once it has the definitions
+		if (m_state != State::Joining)
+			break;
+		NetworkPacket resp(TOSERVER_CLIENT_READY, 0);
+		resp << (u8)VERSION_MAJOR << (u8)VERSION_MINOR << (u8)VERSION_PATCH
+			<< (u8)0 << (u16)strlen(g_version_hash);
+		resp.putRawString(g_version_hash, (u16)strlen(g_version_hash));
+		resp << (u16)FORMSPEC_API_VERSION;
+		send(&resp, 1, true);
+
+		m_state = State::Ready;
+		m_stats.join_time = m_time;
+		break;
+	}
+	case TOCLIENT_ACCESS_DENIED: {
+		u8 reason;
+		*pkt >> reason;
+		m_error = "access denied (" + itos(reason) + ")";
+		if (pkt->getRemainingBytes() >= 2) {
+			std::string custom_reason;
+			*pkt >> custom_reason;
+			if (!custom_reason.empty())
+				m_error += ": " + custom_reason;
+		}
+		disconnect();
+		break;
+	}
+	case TOCLIENT_BLOCKDATA: {
+		v3s32 p;
+		*pkt >> p;
+		m_stats.blocks_received++;
+
+		// Without this the server stops sending after a few blocks
+		NetworkPacket resp(TOSERVER_GOTBLOCKS, 1 + 12);
+		resp << (u8)1 << p;
+		send(&resp, 2, true);
+		break;
+	}
+	case TOCLIENT_MOVE_PLAYER: {
+		f32 pitch;
+		*pkt >> m_pos >> pitch >> m_yaw;
+		break;
+	}
+	case TOCLIENT_CHAT_MESSAGE: {
+		m_stats.chat_messages++;
+
+		u8 version, type;
+		std::wstring sender, message;
+		*pkt >> version >> type >> sender >> message;
+		// Mods may decorate the line, so look for the text within it
+		for (auto it = m_pending_chat.begin(); it != m_pending_chat.end(); ++it) {
+			if (message.find(it->first) == std::wstring::npos)
+				continue;
+			m_chat_response_sum += m_time - it->second;
+			m_chat_responses++;
+			m_stats.chat_response_time = m_chat_response_sum / m_chat_responses;
+			m_pending_chat.erase(it);
+			break;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void LoadTestBot::handleHello(NetworkPacket *pkt)
+{
+	if (m_state != State::Connecting)
+		return;
+
+	u8 serialization_ver;
+	u16 compression_mode, proto_ver;
+	u32 auth_mechs;
+	std::string username_legacy;
+	*pkt >> serialization_ver >> compression_mode >> proto_ver
+		>> auth_mechs >> username_legacy;
+
+	m_state = State::Authenticating;
+	if (auth_mechs & AUTH_MECHANISM_SRP) {
+		std::string name_lower = lowercase(m_name);
+		m_srp_user = srp_user_new(SRP_SHA256, SRP_NG_2048,
+			m_name.c_str(), name_lower.c_str(),
+			(const unsigned char *)"", 0, NULL, NULL);
+		char *bytes_A = nullptr;
+		size_t len_A = 0;
+		SRP_Result res = srp_user_start_authentication((SRPUser *)m_srp_user,
+			NULL, NULL, 0, (unsigned char **)&bytes_A, &len_A);
+		if (res != SRP_OK) {
+			m_error = "SRP authentication failed";
+			disconnect();
+			return;
+		}
+
+		NetworkPacket resp(TOSERVER_SRP_BYTES_A, 0);
+		resp << std::string(bytes_A, len_A) << (u8)1;
+		send(&resp, 1, true);
+	} else if (auth_mechs & AUTH_MECHANISM_FIRST_SRP) {
+		std::string verifier, salt;
+		generate_srp_verifier_and_salt(m_name, "", &verifier, &salt);
+
+		NetworkPacket resp(TOSERVER_FIRST_SRP, 0);
+		resp << salt << verifier << (u8)1;
+		send(&resp, 1, true);
+	} else {
+		m_error = "no supported auth mechanism";
+		disconnect();
+	}
+}
+
+void LoadTestBot::handleSrpBytesSandB(NetworkPacket *pkt)
+{
+	if (!m_srp_user)
+		return;
+
+	std::string s, B;
+	*pkt >> s >> B;
+
+	char *bytes_M = nullptr;
+	size_t len_M = 0;
+	srp_user_process_challenge((SRPUser *)m_srp_user,
+		(const unsigned char *)s.c_str(), s.size(),
+		(const unsigned char *)B.c_str(), B.size(),
+		(unsigned char **)&bytes_M, &len_M);
+	if (!bytes_M) {
+		m_error = "SRP-6a safety check violation";
+		disconnect();
+		return;
+	}
+
+	NetworkPacket resp(TOSERVER_SRP_BYTES_M, 0);
+	resp << std::string(bytes_M, len_M);
+	send(&resp, 1, true);
+}
+
+void LoadTestBot::handleAuthAccept(NetworkPacket *pkt)
+{
+	if (m_srp_user) {
+		srp_user_delete((SRPUser *)m_srp_user);
+		m_srp_user = nullptr;
+	}
+
+	u64 map_seed;
+	u32 sudo_auth_methods;
+	*pkt >> m_pos >> map_seed >> m_send_interval >> sudo_auth_methods;
+	m_pos -= v3f(0, BS / 2, 0);
+
+	// Empty language code
+	NetworkPacket resp(TOSERVER_INIT2, 2);
+	resp << std::string();
+	send(&resp, 1, true);
+
+	m_state = State::Joining;
+}
+
+void LoadTestBot::sendInit()
+{
+	NetworkPacket pkt(TOSERVER_INIT, 1 + 2 + 2 + 2 + (1 + m_name.size()));
+	pkt << (u8)SER_FMT_VER_HIGHEST_READ << (u16)NETPROTO_COMPRESSION_NONE;
+	pkt << (u16)LATEST_PROTOCOL_VERSION << (u16)LATEST_PROTOCOL_VERSION;
+	pkt << m_name;
+	send(&pkt, 1, false);
+}
+
+void LoadTestBot::sendPlayerPos()
+{
+	static const u8 fov = 1.26f * 80; // 72 degrees
+	const u8 wanted_range = MYMIN(255,
+		std::ceil(g_settings->getFloat("viewing_range") / MAP_BLOCKSIZE));
+
+	v3f pf = m_pos * 100;
+	v3f sf = m_speed * 100;
+	NetworkPacket pkt(TOSERVER_PLAYERPOS, 12 + 12 + 4 + 4 + 4 + 1 + 1);
+	pkt << v3s32(pf.X, pf.Y, pf.Z) << v3s32(sf.X, sf.Y, sf.Z);
+	pkt << (s32)0 << (s32)(m_yaw * 100) << (u32)0 << fov << wanted_range;
+	send(&pkt, 0, false);
+}
+
+void LoadTestBot::interact(InteractAction action, v3s32 under, v3s32 above)
+{
+	NetworkPacket pkt(TOSERVER_INTERACT, 0);
+	pkt << (u8)action << (u16)0;
+
+	PointedThing pointed(under, above, under, intToFloat(above, BS),
+		intToFloat(above - under, 1), 0, 0);
+	std::ostringstream os(std::ios::binary);
+	pointed.serialize(os);
+	pkt.putLongString(os.str());
+
+	v3f pf = m_pos * 100;
+	v3f sf = m_speed * 100;
+	pkt << v3s32(pf.X, pf.Y, pf.Z) << v3s32(sf.X, sf.Y, sf.Z);
+	pkt << (s32)0 << (s32)(m_yaw * 100) << (u32)0 << (u8)100 << (u8)1;
+	send(&pkt, 0, true);
+}
+
+void LoadTestBot::act(f32 dtime)
+{
+	// Walk in a direction for a while, sometimes flying up or down
+	m_turn_timer -= dtime;
+	if (m_turn_timer <= 0) {
+		m_turn_timer = m_rand.range(2, 8);
+		m_yaw = m_rand.range(0, 359);
+		f32 yaw = m_yaw * core::DEGTORAD;
+		m_speed = v3f(-std::sin(yaw), 0, std::cos(yaw)) * BOT_SPEED * BS;
+		if (m_rand.range(0, 3) == 0)
+			m_speed.Y = (m_rand.range(0, 1) ? 1 : -1) * BOT_SPEED * BS / 2;
+	}
+	m_pos += m_speed * dtime;
+
+	m_pos_timer += dtime;
+	if (m_pos_timer >= m_send_interval) {
+		m_pos_timer = 0;
+		sendPlayerPos();
+	}
+
+	m_action_timer -= dtime;
+	if (m_action_timer > 0)
+		return;
+	m_action_timer = m_rand.range(2, 6);
+	m_stats.actions++;
+
+	f32 yaw = m_yaw * core::DEGTORAD;
+	v3f front = m_pos + v3f(-std::sin(yaw), 0, std::cos(yaw)) * BS;
+	v3s32 under = floatToInt(front, BS) - v3s32(0, 1, 0);
+	v3s32 above = under + v3s32(0, 1, 0);
+
+	switch (m_rand.range(0, 2)) {
+	case 0:
+		interact(INTERACT_START_DIGGING, under, above);
+		interact(INTERACT_DIGGING_COMPLETED, under, above);
+		break;
+	case 1:
+		interact(INTERACT_PLACE, under, above);
+		break;
+	default: {
+		// The brackets delimit the bot name, so that the message of
+		// loadbot1 is not found inside the one of loadbot10
+		std::wstring message = utf8_to_wide("[load test message " +
+			itos(m_stats.actions) + " from " + m_name + "]");
+		NetworkPacket pkt(TOSERVER_CHAT_MESSAGE, 2 + message.size() * 2);
+		pkt << message;
+		send(&pkt, 0, true);
+		m_pending_chat.emplace_back(message, m_time);
+		break;
+	}
+	}
+}
+
+/*
+	Driver
+*/
+
+static void print_stats(const std::vector<std::unique_ptr<LoadTestBot>> &bots,
+		f32 duration)
+{
+	std::cout << std::left << std::setw(16) << "bot"
+		<< std::right << std::setw(8) << "join ms"
+		<< std::setw(8) << "rtt ms"
+		<< std::setw(10) << "in KB/s" << std::setw(10) << "out KB/s"
+		<< std::setw(8) << "blocks" << std::setw(8) << "actions"
+		<< std::setw(8) << "chat" << std::setw(8) << "chat ms"
+		<< "  status" << std::endl;
+
+	f32 total_in = 0, total_out = 0, rtt_sum = 0, rtt_max = 0, chat_sum = 0;
+	u32 rtt_count = 0, chat_count = 0, ready = 0;
+	for (const auto &bot : bots) {
+		LoadTestBot::Stats stats = bot->getStats();
+		f32 in = stats.bytes_received / 1024.0f / duration;
+		f32 out = stats.bytes_sent / 1024.0f / duration;
+		total_in += in;
+		total_out += out;
+		if (stats.avg_rtt >= 0) {
+			rtt_sum += stats.avg_rtt;
+			rtt_max = std::max(rtt_max, stats.avg_rtt);
+			rtt_count++;
+		}
+		if (stats.chat_response_time >= 0) {
+			chat_sum += stats.chat_response_time;
+			chat_count++;
+		}
+		if (bot->isReady())
+			ready++;
+
+		std::cout << std::left << std::setw(16) << bot->getName() << std::right
+			<< std::fixed << std::setprecision(0)
+			<< std::setw(8) << stats.join_time * 1000
+			<< std::setw(8) << stats.avg_rtt * 1000
+			<< std::setprecision(1)
+			<< std::setw(10) << in << std::setw(10) << out
+			<< std::setw(8) << stats.blocks_received
+			<< std::setw(8) << stats.actions
+			<< std::setw(8) << stats.chat_messages
+			<< std::setprecision(0)
+			<< std::setw(8) << stats.chat_response_time * 1000
+			<< "  " << (bot->isReady() ? "ok" : bot->getError()) << std::endl;
+	}
+
+	std::cout << std::fixed << std::setprecision(1)
+		<< ready << "/" << bots.size() << " bots in game, rtt avg "
+		<< (rtt_count ? rtt_sum / rtt_count * 1000 : 0) << " ms, max "
+		<< rtt_max * 1000 << " ms, chat response avg "
+		<< (chat_count ? chat_sum / chat_count * 1000 : 0) << " ms, total "
+		<< total_in << " KB/s in, "
+		<< total_out << " KB/s out" << std::endl;
+}
+
+int run_loadtest(const Settings &cmd_args)
+{
+	std::string address_str = "127.0.0.1";
+	if (cmd_args.exists("address") && !cmd_args.get("address").empty())
+		address_str = cmd_args.get("address");
+	u16 port = cmd_args.exists("port") ? cmd_args.getU16("port") : 30000;
+	u32 num_bots = cmd_args.exists("loadtest-bots") ?
+		cmd_args.getU32("loadtest-bots") : 10;
+	f32 duration = cmd_args.exists("loadtest-duration") ?
+		cmd_args.getFloat("loadtest-duration") : 60;
+
+	Address address(0, 0, 0, 0, port);
+	try {
+		address.Resolve(address_str.c_str());
+	} catch (ResolveError &e) {
+		errorstream << "Couldn't resolve address: " << e.what() << std::endl;
+		return 1;
+	}
+
+	actionstream << "Load test: " << num_bots << " bots for " << duration
+		<< " s against " << address.serializeString() << ":" << port
+		<< std::endl;
+
+	std::vector<std::unique_ptr<LoadTestBot>> bots;
+	for (u32 i = 0; i < num_bots; i++) {
+		bots.emplace_back(new LoadTestBot("loadbot" + itos(i), address, i));
+		bots.back()->connect();
+	}
+
+	bool &kill = *porting::signal_handler_killstatus();
+	u64 start = porting::getTimeMs();
+	u64 last = start;
+	f32 elapsed = 0;
+	while (!kill && elapsed < duration) {
+		u64 now = porting::getTimeMs();
+		f32 dtime = (now - last) / 1000.0f;
+		last = now;
+		elapsed = (now - start) / 1000.0f;
+
+		for (auto &bot : bots)
+			bot->step(dtime);
+
+		sleep_ms(10);
+	}
+
+	print_stats(bots, std::max(elapsed, 0.001f));
+
+	for (auto &bot : bots)
+		bot->disconnect();
+	return 0;
+}
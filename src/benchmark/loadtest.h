@@ -0,0 +1,132 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "config.h"
+
+#if BUILD_BENCHMARKS
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "irrlichttypes_bloated.h"
+#include "network/address.h"
+#include "network/connection.h"
+#include "network/networkprotocol.h"
+#include "noise.h"
+
+class NetworkPacket;
+class Settings;
+
+/*
+	A headless player for load testing servers.
+
+	It speaks the client protocol without a map, media or rendering:
+	it logs in with an empty password, acknowledges the blocks it is
+	sent and then walks, flies, digs, places and chats at random.
+*/
+class LoadTestBot : public con::PeerHandler
+{
+public:
+	struct Stats
+	{
+		u64 packets_received = 0;
+		u64 bytes_received = 0;
+		u64 packets_sent = 0;
+		u64 bytes_sent = 0;
+		u32 blocks_received = 0;
+		u32 actions = 0;
+		u32 chat_messages = 0;
+		// Seconds from connecting until being spawned, -1 if not yet
+		f32 join_time = -1;
+		// Average round trip time in seconds, -1 if not connected
+		f32 avg_rtt = -1;
+		// Average seconds until an own chat message came back from the
+		// server, -1 if none did
+		f32 chat_response_time = -1;
+	};
+
+	LoadTestBot(const std::string &name, const Address &address, u64 seed);
+	~LoadTestBot();
+
+	void connect();
+	void disconnect();
+
+	// Handles received packets and acts.
+	// Returns false once the bot was disconnected.
+	bool step(f32 dtime);
+
+	const std::string &getName() const { return m_name; }
+	bool isReady() const { return m_state == State::Ready; }
+	// Why the bot was disconnected, empty if it wasn't
+	const std::string &getError() const { return m_error; }
+	Stats getStats();
+
+	// con::PeerHandler
+	void peerAdded(con::Peer *peer) override {}
+	void deletingPeer(con::Peer *peer, bool timeout) override;
+
+private:
+	enum class State : u8 { Connecting, Authenticating, Joining, Ready, Gone };
+
+	void send(NetworkPacket *pkt, u8 channel, bool reliable);
+	void handlePacket(NetworkPacket *pkt);
+	void handleHello(NetworkPacket *pkt);
+	void handleSrpBytesSandB(NetworkPacket *pkt);
+	void handleAuthAccept(NetworkPacket *pkt);
+
+	void sendInit();
+	void sendPlayerPos();
+	void interact(InteractAction action, v3s32 under, v3s32 above);
+	void act(f32 dtime);
+
+	std::string m_name;
+	Address m_address;
+	std::unique_ptr<con::Connection> m_con;
+	PcgRandom m_rand;
+
+	State m_state = State::Connecting;
+	std::string m_error;
+	Stats m_stats;
+	void *m_srp_user = nullptr;
+
+	f32 m_time = 0;
+	f32 m_init_timer = 0;
+	f32 m_pos_timer = 0;
+	f32 m_send_interval = 0.1f;
+	f32 m_turn_timer = 0;
+	f32 m_action_timer = 0;
+
+	// Own chat messages not seen back yet, with the time they were sent
+	std::vector<std::pair<std::wstring, f32>> m_pending_chat;
+	f32 m_chat_response_sum = 0;
+	u32 m_chat_responses = 0;
+
+	// In BS units, like the client's LocalPlayer
+	v3f m_pos;
+	v3f m_speed;
+	f32 m_yaw = 0;
+};
+
+// Connects bots to a running server, lets them play for a while and
+// prints their stats
+int run_loadtest(const Settings &cmd_args);
+
+#endif
@@ -29,6 +29,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "threading/mutex_auto_lock.h"
 #include "client/clientevent.h"
 #include "client/gameui.h"
+#include "client/fontengine.h"
 #include "client/renderingengine.h"
 #include "client/sound.h"
 #include "client/tile.h"
@@ -362,6 +363,7 @@ Client::~Client()
 	m_minimap = nullptr;
 
 	delete m_media_downloader;
+	clientMediaFlushCache();
 
 	// Write the changes and delete
 	if (m_mod_storage_database)
@@ -1811,6 +1813,10 @@ void Client::afterContentReceived()
 
 	text = wgettext("Done!");
 	m_rendering_engine->draw_load_screen(text, guienv, m_tsrc, 0, 100);
+
+	// Rasterize the glyphs of the translated strings before they are shown
+	g_fontengine->prewarm(g_client_translations->getCharacters());
+
 	infostream<<"Client::afterContentReceived() done"<<std::endl;
 	delete[] text;
 }
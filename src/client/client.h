@@ -230,6 +230,8 @@ class Client : public con::PeerHandler, public InventoryManager, public IGameDef
 	void handleCommand_MediaPush(NetworkPacket *pkt);
 	void handleCommand_MinimapModes(NetworkPacket *pkt);
 	void handleCommand_SetLighting(NetworkPacket *pkt);
+	void handleCommand_FormspecPatch(NetworkPacket *pkt);
+	void handleCommand_SpawnParticleBurst(NetworkPacket *pkt);
 
 	void ProcessData(NetworkPacket *pkt);
 
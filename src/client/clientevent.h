@@ -21,8 +21,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <string>
 #include "irrlichttypes_bloated.h"
+#include "formspec_patch.h"
 
 struct ParticleParameters;
+struct ParticleBurst;
 struct ParticleSpawnerParameters;
 struct SkyboxParams;
 struct SunParams;
@@ -37,9 +39,11 @@ enum ClientEventType : u8
 	CE_DEATHSCREEN,
 	CE_SHOW_FORMSPEC,
 	CE_SHOW_LOCAL_FORMSPEC,
+	CE_PATCH_FORMSPEC,
 	CE_SPAWN_PARTICLE,
 	CE_ADD_PARTICLESPAWNER,
 	CE_DELETE_PARTICLESPAWNER,
+	CE_SPAWN_PARTICLE_BURST,
 	CE_HUDADD,
 	CE_HUDRM,
 	CE_HUDCHANGE,
@@ -106,9 +110,15 @@ struct ClientEvent
 			std::string *formspec;
 			std::string *formname;
 		} show_formspec;
+		struct
+		{
+			std::string *formname;
+			FormspecPatch *patch;
+		} patch_formspec;
 		// struct{
 		//} textures_updated;
 		ParticleParameters *spawn_particle;
+		ParticleBurst *spawn_particle_burst;
 		struct
 		{
 			ParticleSpawnerParameters *p;
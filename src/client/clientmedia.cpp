@@ -25,23 +25,96 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "log.h"
 #include "porting.h"
 #include "settings.h"
+#include "threading/thread.h"
 #include "util/hex.h"
 #include "util/serialize.h"
 #include "util/sha1.h"
 #include "util/string.h"
+#include <algorithm>
+#include <memory>
 
 static std::string getMediaCacheDir()
 {
 	return porting::path_cache + DIR_DELIM + "media";
 }
 
+// Shared by all downloaders, the cache keeps its index in memory
+static FileCache &getMediaCache()
+{
+	static FileCache media_cache(getMediaCacheDir(),
+		(u64)g_settings->getU32("media_cache_size") * 1024 * 1024);
+	return media_cache;
+}
+
 bool clientMediaUpdateCache(const std::string &raw_hash, const std::string &filedata)
 {
-	FileCache media_cache(getMediaCacheDir());
+	FileCache &media_cache = getMediaCache();
 	std::string sha1_hex = hex_encode(raw_hash);
-	if (!media_cache.exists(sha1_hex))
-		return media_cache.update(sha1_hex, filedata);
-	return true;
+	return media_cache.update(sha1_hex, filedata);
+}
+
+void clientMediaFlushCache()
+{
+	getMediaCache().flush();
+}
+
+static std::string getMediaHash(const std::string &data)
+{
+	SHA1 sha1_calculator;
+	sha1_calculator.addBytes(data.c_str(), data.size());
+	unsigned char *digest = sha1_calculator.getDigest();
+	std::string result((char *)digest, 20);
+	free(digest);
+	return result;
+}
+
+// Cached files are read in batches and hashed on worker threads
+#define MEDIA_CACHE_READ_BATCH 256
+#define MEDIA_CACHE_HASH_THREADED_MIN 16
+#define MEDIA_CACHE_HASH_MAX_THREADS 4
+
+namespace {
+
+struct CachedMediaRead {
+	std::string sha1;
+	std::string data;
+	std::string data_sha1;
+	bool found = false;
+};
+
+class MediaHashThread : public Thread
+{
+public:
+	MediaHashThread(std::vector<CachedMediaRead> &reads, size_t begin, size_t end) :
+		Thread("MediaHash"),
+		m_reads(reads), m_begin(begin), m_end(end)
+	{}
+
+	static void hashRange(std::vector<CachedMediaRead> &reads,
+			size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++) {
+			if (reads[i].found)
+				reads[i].data_sha1 = getMediaHash(reads[i].data);
+		}
+	}
+
+	void *run()
+	{
+		BEGIN_DEBUG_EXCEPTION_HANDLER
+
+		hashRange(m_reads, m_begin, m_end);
+
+		END_DEBUG_EXCEPTION_HANDLER
+
+		return nullptr;
+	}
+
+private:
+	std::vector<CachedMediaRead> &m_reads;
+	size_t m_begin, m_end;
+};
+
 }
 
 /*
@@ -63,6 +136,10 @@ ClientMediaDownloader::~ClientMediaDownloader()
 
 	for (auto &remote : m_remotes)
 		delete remote;
+
+	// Write the index once for the whole batch, pushed media are written
+	// when the client shuts down
+	m_media_cache.flush();
 }
 
 bool ClientMediaDownloader::loadMedia(Client *client, const std::string &data,
@@ -176,15 +253,12 @@ void ClientMediaDownloader::initialStep(Client *client)
 {
 	// Check media cache
 	m_uncached_count = m_files.size();
-	for (auto &file_it : m_files) {
-		const std::string &name = file_it.first;
-		FileStatus *filestatus = file_it.second;
-		const std::string &sha1 = filestatus->sha1;
-
-		if (tryLoadFromCache(name, sha1, client)) {
-			filestatus->received = true;
-			m_uncached_count--;
-		}
+	auto it = m_files.begin();
+	while (it != m_files.end()) {
+		std::vector<std::pair<const std::string *, FileStatus *>> batch;
+		for (; it != m_files.end() && batch.size() < MEDIA_CACHE_READ_BATCH; ++it)
+			batch.emplace_back(&it->first, it->second);
+		loadCachedBatch(batch, client);
 	}
 
 	assert(m_uncached_received_count == 0);
@@ -270,6 +344,67 @@ void ClientMediaDownloader::initialStep(Client *client)
 	}
 }
 
+void ClientMediaDownloader::loadCachedBatch(
+		const std::vector<std::pair<const std::string *, FileStatus *>> &batch,
+		Client *client)
+{
+	std::vector<CachedMediaRead> reads(batch.size());
+	std::vector<std::string> names;
+	names.reserve(batch.size());
+	for (size_t i = 0; i < batch.size(); i++) {
+		reads[i].sha1 = batch[i].second->sha1;
+		names.push_back(hex_encode(reads[i].sha1));
+	}
+
+	// One pass over the packs for the whole batch
+	std::unordered_map<std::string, std::string> cached;
+	m_media_cache.loadMany(names, cached);
+	for (size_t i = 0; i < batch.size(); i++) {
+		auto it = cached.find(names[i]);
+		if (it != cached.end()) {
+			reads[i].data = std::move(it->second);
+			reads[i].found = true;
+		}
+	}
+	cached.clear();
+
+	// Hashing is independent per file. Decoding and loading into the
+	// client stays on this thread, the texture source and sound manager
+	// are not thread-safe.
+	size_t num_threads = 1;
+	if (reads.size() >= MEDIA_CACHE_HASH_THREADED_MIN) {
+		num_threads = std::min<size_t>(MEDIA_CACHE_HASH_MAX_THREADS,
+				std::max(1U, Thread::getNumberOfProcessors()));
+	}
+
+	if (num_threads > 1) {
+		std::vector<std::unique_ptr<MediaHashThread>> threads;
+		size_t chunk = (reads.size() + num_threads - 1) / num_threads;
+		for (size_t begin = 0; begin < reads.size(); begin += chunk) {
+			threads.emplace_back(new MediaHashThread(reads,
+					begin, std::min(begin + chunk, reads.size())));
+			threads.back()->start();
+		}
+		for (auto &thread : threads)
+			thread->wait();
+	} else {
+		MediaHashThread::hashRange(reads, 0, reads.size());
+	}
+
+	for (size_t i = 0; i < batch.size(); i++) {
+		CachedMediaRead &read = reads[i];
+		if (!read.found)
+			continue;
+		if (checkAndLoadHashed(*batch[i].first, read.sha1, read.data,
+				read.data_sha1, true, client)) {
+			batch[i].second->received = true;
+			m_uncached_count--;
+		}
+		// Free the file data as soon as possible
+		std::string().swap(read.data);
+	}
+}
+
 void ClientMediaDownloader::remoteHashSetReceived(
 		const HTTPFetchResult &fetch_result)
 {
@@ -507,7 +642,11 @@ bool ClientMediaDownloader::conventionalTransferDone(
 */
 
 IClientMediaDownloader::IClientMediaDownloader():
-	m_media_cache(getMediaCacheDir()), m_write_to_cache(true)
+	m_media_cache(getMediaCache()), m_write_to_cache(true)
+{
+}
+
+IClientMediaDownloader::~IClientMediaDownloader()
 {
 }
 
@@ -526,12 +665,12 @@ void IClientMediaDownloader::createCacheDirs()
 bool IClientMediaDownloader::tryLoadFromCache(const std::string &name,
 	const std::string &sha1, Client *client)
 {
-	std::ostringstream tmp_os(std::ios_base::binary);
-	bool found_in_cache = m_media_cache.load(hex_encode(sha1), tmp_os);
+	std::string data;
+	bool found_in_cache = m_media_cache.load(hex_encode(sha1), data);
 
 	// If found in cache, try to load it from there
 	if (found_in_cache)
-		return checkAndLoad(name, sha1, tmp_os.str(), true, client);
+		return checkAndLoad(name, sha1, data, true, client);
 
 	return false;
 }
@@ -539,21 +678,20 @@ bool IClientMediaDownloader::tryLoadFromCache(const std::string &name,
 bool IClientMediaDownloader::checkAndLoad(
 		const std::string &name, const std::string &sha1,
 		const std::string &data, bool is_from_cache, Client *client)
+{
+	return checkAndLoadHashed(name, sha1, data, getMediaHash(data),
+			is_from_cache, client);
+}
+
+bool IClientMediaDownloader::checkAndLoadHashed(
+		const std::string &name, const std::string &sha1,
+		const std::string &data, const std::string &data_sha1,
+		bool is_from_cache, Client *client)
 {
 	const char *cached_or_received = is_from_cache ? "cached" : "received";
 	const char *cached_or_received_uc = is_from_cache ? "Cached" : "Received";
 	std::string sha1_hex = hex_encode(sha1);
 
-	// Compute actual checksum of data
-	std::string data_sha1;
-	{
-		SHA1 data_sha1_calculator;
-		data_sha1_calculator.addBytes(data.c_str(), data.size());
-		unsigned char *data_tmpdigest = data_sha1_calculator.getDigest();
-		data_sha1.assign((char*) data_tmpdigest, 20);
-		free(data_tmpdigest);
-	}
-
 	// Check that received file matches announced checksum
 	if (data_sha1 != sha1) {
 		std::string data_sha1_hex = hex_encode(data_sha1);
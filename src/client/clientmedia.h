@@ -39,6 +39,9 @@ struct HTTPFetchResult;
 bool clientMediaUpdateCache(const std::string &raw_hash,
 	const std::string &filedata);
 
+// Write the media cache index if it changed
+void clientMediaFlushCache();
+
 // more of a base class than an interface but this name was most convenient...
 class IClientMediaDownloader
 {
@@ -75,7 +78,7 @@ class IClientMediaDownloader
 
 protected:
 	IClientMediaDownloader();
-	virtual ~IClientMediaDownloader() = default;
+	virtual ~IClientMediaDownloader();
 
 	// Forwards the call to the appropriate Client method
 	virtual bool loadMedia(Client *client, const std::string &data,
@@ -89,8 +92,13 @@ class IClientMediaDownloader
 	bool checkAndLoad(const std::string &name, const std::string &sha1,
 			const std::string &data, bool is_from_cache, Client *client);
 
-	// Filesystem-based media cache
-	FileCache m_media_cache;
+	// Same as above, with the checksum of data already computed
+	bool checkAndLoadHashed(const std::string &name, const std::string &sha1,
+			const std::string &data, const std::string &data_sha1,
+			bool is_from_cache, Client *client);
+
+	// Filesystem-based media cache, shared by all downloaders
+	FileCache &m_media_cache;
 	bool m_write_to_cache;
 };
 
@@ -146,6 +154,10 @@ class ClientMediaDownloader : public IClientMediaDownloader
 	};
 
 	void initialStep(Client *client);
+	// Loads a batch of files from the media cache, if present
+	void loadCachedBatch(
+			const std::vector<std::pair<const std::string *, FileStatus *>> &batch,
+			Client *client);
 	void remoteHashSetReceived(const HTTPFetchResult &fetch_result);
 	void remoteMediaReceived(const HTTPFetchResult &fetch_result,
 			Client *client);
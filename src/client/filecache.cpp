@@ -21,77 +21,428 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "filecache.h"
 
 #include "network/networkprotocol.h"
+#include "exceptions.h"
 #include "log.h"
 #include "filesys.h"
+#include "threading/mutex_auto_lock.h"
+#include "util/serialize.h"
+#include "util/string.h"
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <cstdlib>
 
-bool FileCache::loadByPath(const std::string &path, std::ostream &os)
+#define FILECACHE_INDEX_SIGNATURE 0x4d544349 // 'MTCI'
+#define FILECACHE_INDEX_VERSION 1
+#define FILECACHE_INDEX_NAME "index.mti"
+#define FILECACHE_PACK_PREFIX "pack"
+#define FILECACHE_PACK_SUFFIX ".mtp"
+// New files go into a new pack once the current one reaches this size
+#define FILECACHE_PACK_MAX_SIZE (64 * 1024 * 1024)
+
+static u64 getFileSize(const std::string &path)
 {
-	std::ifstream fis(path.c_str(), std::ios_base::binary);
+	std::ifstream is(path, std::ios_base::binary | std::ios_base::ate);
+	if (!is.good())
+		return 0;
+	return is.tellg();
+}
 
-	if(!fis.good()){
-		verbosestream<<"FileCache: File not found in cache: "
-				<<path<<std::endl;
-		return false;
+FileCache::FileCache(const std::string &dir, u64 max_size) :
+	m_dir(dir), m_max_size(max_size)
+{
+}
+
+FileCache::~FileCache()
+{
+	flush();
+}
+
+std::string FileCache::getPackPath(u32 pack) const
+{
+	return m_dir + DIR_DELIM FILECACHE_PACK_PREFIX + std::to_string(pack) +
+		FILECACHE_PACK_SUFFIX;
+}
+
+std::string FileCache::getIndexPath() const
+{
+	return m_dir + DIR_DELIM FILECACHE_INDEX_NAME;
+}
+
+void FileCache::loadIndex()
+{
+	if (m_index_loaded)
+		return;
+	m_index_loaded = true;
+
+	// Find the pack files, including ones the index doesn't know about
+	for (const fs::DirListNode &node : fs::GetDirListing(m_dir)) {
+		if (node.dir || !str_starts_with(node.name, FILECACHE_PACK_PREFIX) ||
+				!str_ends_with(node.name, FILECACHE_PACK_SUFFIX))
+			continue;
+		std::string id = node.name.substr(strlen(FILECACHE_PACK_PREFIX),
+			node.name.size() - strlen(FILECACHE_PACK_PREFIX) -
+			strlen(FILECACHE_PACK_SUFFIX));
+		if (id.empty() || !string_allowed(id, "0123456789"))
+			continue;
+		u32 pack = std::stoul(id);
+		m_pack_sizes[pack] = getFileSize(m_dir + DIR_DELIM + node.name);
+		m_current_pack = std::max(m_current_pack, pack);
 	}
 
-	bool bad = false;
-	for(;;){
-		char buf[1024];
-		fis.read(buf, 1024);
-		std::streamsize len = fis.gcount();
-		os.write(buf, len);
-		if(fis.eof())
-			break;
-		if(!fis.good()){
-			bad = true;
-			break;
+	std::string data;
+	if (fs::ReadFile(getIndexPath(), data))
+		readIndex(data);
+
+	// Packs without any indexed file can't be reached anymore
+	std::map<u32, u64> live;
+	for (const auto &it : m_entries)
+		live[it.second.pack] += it.second.size;
+	for (auto it = m_pack_sizes.begin(); it != m_pack_sizes.end();) {
+		if (it->first != m_current_pack && live[it->first] == 0) {
+			fs::DeleteSingleFileOrEmptyDirectory(getPackPath(it->first));
+			it = m_pack_sizes.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void FileCache::readIndex(const std::string &data)
+{
+	std::istringstream is(data, std::ios_base::binary);
+	try {
+		if (readU32(is) != FILECACHE_INDEX_SIGNATURE ||
+				readU8(is) != FILECACHE_INDEX_VERSION)
+			throw SerializationError("unknown format");
+		m_clock = readU64(is);
+		u32 count = readU32(is);
+		for (u32 i = 0; i < count; i++) {
+			std::string name = deSerializeString16(is);
+			Entry entry;
+			entry.pack = readU32(is);
+			entry.offset = readU32(is);
+			entry.size = readU32(is);
+			entry.last_used = readU64(is);
+			if (!is.good())
+				throw SerializationError("truncated");
+
+			// Drop entries whose data is gone
+			auto pack_it = m_pack_sizes.find(entry.pack);
+			if (pack_it == m_pack_sizes.end() ||
+					(u64)entry.offset + entry.size > pack_it->second) {
+				m_index_dirty = true;
+				continue;
+			}
+			m_entries[name] = entry;
+			m_total_size += entry.size;
 		}
+	} catch (SerializationError &e) {
+		errorstream << "FileCache: Ignoring broken index in \"" << m_dir
+			<< "\": " << e.what() << std::endl;
+		m_entries.clear();
+		m_total_size = 0;
+		m_index_dirty = true;
 	}
-	if(bad){
-		errorstream<<"FileCache: Failed to read file from cache: \""
-				<<path<<"\""<<std::endl;
+}
+
+bool FileCache::flush()
+{
+	MutexAutoLock lock(m_mutex);
+	return saveIndex();
+}
+
+bool FileCache::saveIndex()
+{
+	if (!m_index_dirty)
+		return true;
+
+	std::ostringstream os(std::ios_base::binary);
+	writeU32(os, FILECACHE_INDEX_SIGNATURE);
+	writeU8(os, FILECACHE_INDEX_VERSION);
+	writeU64(os, m_clock);
+	writeU32(os, m_entries.size());
+	for (const auto &it : m_entries) {
+		os << serializeString16(it.first);
+		writeU32(os, it.second.pack);
+		writeU32(os, it.second.offset);
+		writeU32(os, it.second.size);
+		writeU64(os, it.second.last_used);
 	}
 
-	return !bad;
+	if (!fs::safeWriteToFile(getIndexPath(), os.str())) {
+		errorstream << "FileCache: Can't write index to \""
+			<< getIndexPath() << "\"" << std::endl;
+		return false;
+	}
+	m_index_dirty = false;
+	return true;
 }
 
-bool FileCache::updateByPath(const std::string &path, const std::string &data)
+bool FileCache::readEntry(const std::string &name, Entry &entry, std::string &data)
 {
-	std::ofstream file(path.c_str(), std::ios_base::binary |
-			std::ios_base::trunc);
+	std::ifstream is(getPackPath(entry.pack), std::ios_base::binary);
+	data.resize(entry.size);
+	if (is.good()) {
+		is.seekg(entry.offset);
+		is.read(&data[0], entry.size);
+	}
 
-	if(!file.good())
-	{
-		errorstream<<"FileCache: Can't write to file at "
-				<<path<<std::endl;
+	if (!is.good()) {
+		errorstream << "FileCache: Failed to read \"" << name
+			<< "\" from cache" << std::endl;
+		m_total_size -= entry.size;
+		m_entries.erase(name);
+		m_index_dirty = true;
 		return false;
 	}
 
-	file.write(data.c_str(), data.length());
-	file.close();
+	entry.last_used = ++m_clock;
+	m_index_dirty = true;
+	return true;
+}
 
-	return !file.fail();
+bool FileCache::append(const std::string &name, const std::string &data)
+{
+	if (!fs::CreateAllDirs(m_dir)) {
+		errorstream << "FileCache: Can't create directory "
+			<< m_dir << std::endl;
+		return false;
+	}
+
+	// The sizes come from the files, another client sharing the directory
+	// or an earlier failed write may have appended to a pack
+	std::string path = getPackPath(m_current_pack);
+	u64 pack_size = getFileSize(path);
+	while (pack_size > 0 && pack_size + data.size() > FILECACHE_PACK_MAX_SIZE) {
+		m_current_pack++;
+		path = getPackPath(m_current_pack);
+		pack_size = getFileSize(path);
+	}
+
+	std::ofstream os(path, std::ios_base::binary | std::ios_base::app);
+	os.seekp(0, std::ios_base::end);
+	if (os.good())
+		pack_size = os.tellp();
+	os.write(data.c_str(), data.size());
+	os.close();
+	if (os.fail()) {
+		errorstream << "FileCache: Can't write to file at "
+			<< path << std::endl;
+		// Whatever was written is garbage now
+		m_pack_sizes[m_current_pack] = getFileSize(path);
+		return false;
+	}
+
+	auto it = m_entries.find(name);
+	if (it != m_entries.end())
+		m_total_size -= it->second.size;
+
+	Entry &entry = m_entries[name];
+	entry.pack = m_current_pack;
+	entry.offset = pack_size;
+	entry.size = data.size();
+	entry.last_used = ++m_clock;
+	m_pack_sizes[m_current_pack] = pack_size + data.size();
+	m_total_size += data.size();
+	m_index_dirty = true;
+	return true;
 }
 
-bool FileCache::update(const std::string &name, const std::string &data)
+bool FileCache::importLoose(const std::string &name, std::string &data)
 {
 	std::string path = m_dir + DIR_DELIM + name;
-	return updateByPath(path, data);
+	if (!fs::ReadFile(path, data))
+		return false;
+
+	if (append(name, data))
+		fs::DeleteSingleFileOrEmptyDirectory(path);
+	return true;
+}
+
+void FileCache::evict()
+{
+	if (m_max_size == 0 || m_total_size <= m_max_size)
+		return;
+
+	// Leave some room so that evictions don't happen on every update
+	u64 target = m_max_size / 10 * 9;
+	std::vector<std::pair<u64, std::string>> by_age;
+	by_age.reserve(m_entries.size());
+	for (const auto &it : m_entries)
+		by_age.emplace_back(it.second.last_used, it.first);
+	std::sort(by_age.begin(), by_age.end());
+
+	for (const auto &it : by_age) {
+		if (m_total_size <= target)
+			break;
+		m_total_size -= m_entries[it.second].size;
+		m_entries.erase(it.second);
+	}
+	m_index_dirty = true;
+
+	std::map<u32, u64> live;
+	auto count_live = [&] () {
+		live.clear();
+		for (const auto &it : m_entries)
+			live[it.second.pack] += it.second.size;
+	};
+	count_live();
+
+	std::vector<u32> packs;
+	for (const auto &it : m_pack_sizes)
+		packs.push_back(it.first);
+	for (u32 pack : packs) {
+		u64 live_size = live[pack];
+		if (live_size == 0) {
+			fs::DeleteSingleFileOrEmptyDirectory(getPackPath(pack));
+			m_pack_sizes.erase(pack);
+		} else if (live_size < m_pack_sizes[pack] / 2) {
+			compact(pack);
+			// Compaction appended to the current pack
+			count_live();
+		}
+	}
+
+	// Compacted packs are gone, the index must not point to them anymore
+	saveIndex();
+}
+
+void FileCache::compact(u32 pack)
+{
+	std::vector<std::pair<u32, std::string>> names;
+	for (const auto &it : m_entries) {
+		if (it.second.pack == pack)
+			names.emplace_back(it.second.offset, it.first);
+	}
+	std::sort(names.begin(), names.end());
+
+	// Never append to the pack being compacted
+	if (m_current_pack == pack)
+		m_current_pack = m_pack_sizes.rbegin()->first + 1;
+
+	std::string data;
+	for (const auto &it : names) {
+		Entry &entry = m_entries[it.second];
+		u64 last_used = entry.last_used;
+		if (!readEntry(it.second, entry, data))
+			continue;
+		if (!append(it.second, data)) {
+			// Keep the old pack, it is still referenced
+			return;
+		}
+		m_entries[it.second].last_used = last_used;
+	}
+
+	fs::DeleteSingleFileOrEmptyDirectory(getPackPath(pack));
+	m_pack_sizes.erase(pack);
+}
+
+bool FileCache::update(const std::string &name, const std::string &data)
+{
+	MutexAutoLock lock(m_mutex);
+	loadIndex();
+
+	// Replaces an existing entry, callers only update files that were
+	// missing or failed to verify
+	if (!append(name, data))
+		return false;
+	evict();
+	return true;
 }
 
 bool FileCache::load(const std::string &name, std::ostream &os)
 {
-	std::string path = m_dir + DIR_DELIM + name;
-	return loadByPath(path, os);
+	std::string data;
+	if (!load(name, data))
+		return false;
+	os.write(data.c_str(), data.size());
+	return true;
+}
+
+bool FileCache::load(const std::string &name, std::string &data)
+{
+	MutexAutoLock lock(m_mutex);
+	loadIndex();
+
+	auto it = m_entries.find(name);
+	if (it != m_entries.end())
+		return readEntry(name, it->second, data);
+
+	if (importLoose(name, data))
+		return true;
+
+	verbosestream << "FileCache: File not found in cache: "
+			<< name << std::endl;
+	return false;
+}
+
+void FileCache::loadMany(const std::vector<std::string> &names,
+		std::unordered_map<std::string, std::string> &result)
+{
+	MutexAutoLock lock(m_mutex);
+	loadIndex();
+
+	// Sorted by pack and offset, so each pack is read front to back
+	std::vector<std::pair<std::pair<u32, u32>, const std::string *>> order;
+	for (const std::string &name : names) {
+		auto it = m_entries.find(name);
+		if (it != m_entries.end()) {
+			order.push_back({{it->second.pack, it->second.offset}, &name});
+		} else {
+			std::string data;
+			if (importLoose(name, data))
+				result[name] = std::move(data);
+		}
+	}
+	std::sort(order.begin(), order.end());
+
+	std::ifstream is;
+	u32 open_pack = 0;
+	for (const auto &it : order) {
+		const std::string &name = *it.second;
+		u32 pack = it.first.first;
+		if (!is.is_open() || open_pack != pack) {
+			is.close();
+			is.clear();
+			is.open(getPackPath(pack), std::ios_base::binary);
+			open_pack = pack;
+		}
+
+		auto entry_it = m_entries.find(name);
+		if (entry_it == m_entries.end())
+			continue;
+		Entry &entry = entry_it->second;
+		std::string data(entry.size, '\0');
+		is.clear();
+		is.seekg(entry.offset);
+		is.read(&data[0], entry.size);
+		if (!is.good()) {
+			errorstream << "FileCache: Failed to read \"" << name
+				<< "\" from cache" << std::endl;
+			m_total_size -= entry.size;
+			m_entries.erase(entry_it);
+			m_index_dirty = true;
+			continue;
+		}
+
+		entry.last_used = ++m_clock;
+		m_index_dirty = true;
+		result[name] = std::move(data);
+	}
 }
 
 bool FileCache::exists(const std::string &name)
 {
-	std::string path = m_dir + DIR_DELIM + name;
-	std::ifstream fis(path.c_str(), std::ios_base::binary);
+	MutexAutoLock lock(m_mutex);
+	loadIndex();
+
+	if (m_entries.find(name) != m_entries.end())
+		return true;
+
+	std::ifstream fis((m_dir + DIR_DELIM + name).c_str(), std::ios_base::binary);
 	return fis.good();
 }
@@ -20,24 +20,83 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #pragma once
 
+#include "irrlichttypes.h"
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+/*
+	Content-addressed file cache.
+
+	Files are appended to pack files, an index maps each name to its pack,
+	offset and size. The index is read once when the cache is first used,
+	so lookups don't touch the filesystem. Once the cache grows beyond its
+	size limit the least recently used files are evicted and mostly unused
+	packs are compacted.
+
+	Files stored one per name by older versions are moved into the packs
+	when they are first loaded.
+
+	All methods are thread-safe.
+*/
 class FileCache
 {
 public:
 	/*
 		'dir' is the file cache directory to use.
+		'max_size' is the size limit in bytes, 0 for no limit.
 	*/
-	FileCache(const std::string &dir) : m_dir(dir) {}
+	FileCache(const std::string &dir, u64 max_size = 0);
+	~FileCache();
 
 	bool update(const std::string &name, const std::string &data);
 	bool load(const std::string &name, std::ostream &os);
+	bool load(const std::string &name, std::string &data);
 	bool exists(const std::string &name);
 
+	// Loads several files at once, reading each pack in offset order.
+	// Files that are not cached are left out of result.
+	void loadMany(const std::vector<std::string> &names,
+			std::unordered_map<std::string, std::string> &result);
+
+	// Writes the index if it changed
+	bool flush();
+
 private:
+	struct Entry {
+		u32 pack;
+		u32 offset;
+		u32 size;
+		// Value of m_clock at the last access
+		u64 last_used;
+	};
+
+	std::string getPackPath(u32 pack) const;
+	std::string getIndexPath() const;
+
+	// These require m_mutex held
+	void loadIndex();
+	void readIndex(const std::string &data);
+	bool saveIndex();
+	bool readEntry(const std::string &name, Entry &entry, std::string &data);
+	bool append(const std::string &name, const std::string &data);
+	bool importLoose(const std::string &name, std::string &data);
+	void evict();
+	void compact(u32 pack);
+
 	std::string m_dir;
+	u64 m_max_size;
 
-	bool loadByPath(const std::string &path, std::ostream &os);
-	bool updateByPath(const std::string &path, const std::string &data);
+	std::mutex m_mutex;
+	bool m_index_loaded = false;
+	bool m_index_dirty = false;
+	std::unordered_map<std::string, Entry> m_entries;
+	// Size of each pack file, including data no longer referenced
+	std::map<u32, u64> m_pack_sizes;
+	u32 m_current_pack = 0;
+	u64 m_total_size = 0;
+	u64 m_clock = 0;
 };
@@ -87,6 +87,7 @@ void FontEngine::cleanCache()
 		}
 		font_cache_it.clear();
 	}
+	m_font_generation++;
 }
 
 /******************************************************************************/
@@ -131,6 +132,29 @@ irr::gui::IGUIFont *FontEngine::getFont(FontSpec spec, bool may_fail)
 	return font;
 }
 
+/******************************************************************************/
+void FontEngine::prewarm(const std::wstring &text)
+{
+	if (text.empty())
+		return;
+
+	RecursiveMutexAutoLock l(m_font_mutex);
+
+	getFont();
+
+	core::ustring utext(text.c_str());
+	for (u16 hash = 0; hash < (FM_MaxMode << 2); hash++) {
+		// Fallback fonts are handed what the others lack
+		if ((hash >> 2) == _FM_Fallback)
+			continue;
+		for (auto &it : m_font_cache[hash]) {
+			gui::CGUITTFont *font = dynamic_cast<gui::CGUITTFont *>(it.second);
+			if (font)
+				font->prewarm(utext);
+		}
+	}
+}
+
 /******************************************************************************/
 unsigned int FontEngine::getTextHeight(const FontSpec &spec)
 {
@@ -19,6 +19,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include "util/basic_macros.h"
 #include "irrlichttypes.h"
@@ -129,6 +130,14 @@ class FontEngine
 	/** update internal parameters from settings */
 	void readSettings();
 
+	/** rasterize the glyphs of text in the background for the default font
+	 *  and every font already in use, so they don't stall drawing later */
+	void prewarm(const std::wstring &text);
+
+	/** changes whenever the cached fonts are dropped, so anything keyed
+	 *  by font pointers must be thrown away */
+	u32 getFontGeneration() const { return m_font_generation; }
+
 private:
 	irr::gui::IGUIFont *getFont(FontSpec spec, bool may_fail);
 
@@ -156,6 +165,9 @@ class FontEngine
 	/** default font size to use */
 	unsigned int m_default_size[FM_MaxMode];
 
+	/** incremented by cleanCache */
+	std::atomic<u32> m_font_generation{0};
+
 	/** default bold and italic */
 	bool m_default_bold = false;
 	bool m_default_italic = false;
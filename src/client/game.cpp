@@ -682,6 +682,10 @@ struct FpsControl {
 
 	// all values in microseconds (us)
 	u64 last_time, busy_time, sleep_time;
+
+private:
+	SettingHandle<float> m_fps_max {g_settings, "fps_max"};
+	SettingHandle<float> m_fps_max_unfocused {g_settings, "fps_max_unfocused"};
 };
 
 
@@ -896,6 +900,7 @@ class Game {
 	void handleClientEvent_Deathscreen(ClientEvent *event, CameraOrientation *cam);
 	void handleClientEvent_ShowFormSpec(ClientEvent *event, CameraOrientation *cam);
 	void handleClientEvent_ShowLocalFormSpec(ClientEvent *event, CameraOrientation *cam);
+	void handleClientEvent_PatchFormSpec(ClientEvent *event, CameraOrientation *cam);
 	void handleClientEvent_HandleParticleEvent(ClientEvent *event,
 		CameraOrientation *cam);
 	void handleClientEvent_HudAdd(ClientEvent *event, CameraOrientation *cam);
@@ -2714,6 +2719,8 @@ const ClientEventHandler Game::clientEventHandler[CLIENTEVENT_MAX] = {
 	{&Game::handleClientEvent_Deathscreen},
 	{&Game::handleClientEvent_ShowFormSpec},
 	{&Game::handleClientEvent_ShowLocalFormSpec},
+	{&Game::handleClientEvent_PatchFormSpec},
+	{&Game::handleClientEvent_HandleParticleEvent},
 	{&Game::handleClientEvent_HandleParticleEvent},
 	{&Game::handleClientEvent_HandleParticleEvent},
 	{&Game::handleClientEvent_HandleParticleEvent},
@@ -2818,6 +2825,23 @@ void Game::handleClientEvent_ShowLocalFormSpec(ClientEvent *event, CameraOrienta
 	delete event->show_formspec.formname;
 }
 
+void Game::handleClientEvent_PatchFormSpec(ClientEvent *event, CameraOrientation *cam)
+{
+	// Patches for a formspec that was closed or replaced in the meantime
+	// are dropped
+	auto formspec = m_game_ui->getFormspecGUI();
+	if (formspec && *event->patch_formspec.formname == m_game_ui->getFormspecName()) {
+		if (!formspec->patchFormSpec(*event->patch_formspec.formname,
+				*event->patch_formspec.patch))
+			infostream << "Formspec patch for \""
+				<< *event->patch_formspec.formname
+				<< "\" doesn't match the shown formspec" << std::endl;
+	}
+
+	delete event->patch_formspec.formname;
+	delete event->patch_formspec.patch;
+}
+
 void Game::handleClientEvent_HandleParticleEvent(ClientEvent *event,
 		CameraOrientation *cam)
 {
@@ -4238,8 +4262,8 @@ void FpsControl::reset()
 void FpsControl::limit(IrrlichtDevice *device, f32 *dtime)
 {
 	const float fps_limit = (device->isWindowFocused() && !g_menumgr.pausesGame())
-			? g_settings->getFloat("fps_max")
-			: g_settings->getFloat("fps_max_unfocused");
+			? m_fps_max.get()
+			: m_fps_max_unfocused.get();
 	const u64 frametime_min = 1000000.0f / std::max(fps_limit, 1.0f);
 
 	u64 time = porting::getTimeUs();
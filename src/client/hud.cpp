@@ -47,6 +47,42 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #define OBJECT_CROSSHAIR_LINE_SIZE 8
 #define CROSSHAIR_LINE_SIZE 10
 
+const HudTextLayout &HudTextLayoutCache::get(const HudElement *e,
+		gui::IGUIFont *font, const Measure &measure)
+{
+	Entry &entry = m_layouts[e];
+	entry.used = true;
+	HudTextLayout &layout = entry.layout;
+	if (layout.font == font && layout.source == e->text && font)
+		return layout;
+
+	layout.source = e->text;
+	layout.font = font;
+	layout.lines.clear();
+
+	std::wstring text = unescape_translate(utf8_to_wide(e->text));
+	layout.size = measure(text);
+	std::wstringstream wss(text);
+	std::wstring line;
+	while (std::getline(wss, line, L'\n')) {
+		core::dimension2d<u32> linesize = measure(line);
+		layout.lines.push_back({std::move(line), linesize});
+	}
+	return layout;
+}
+
+void HudTextLayoutCache::prune()
+{
+	for (auto it = m_layouts.begin(); it != m_layouts.end();) {
+		if (!it->second.used) {
+			it = m_layouts.erase(it);
+		} else {
+			it->second.used = false;
+			++it;
+		}
+	}
+}
+
 Hud::Hud(Client *client, LocalPlayer *player,
 		Inventory *inventory)
 {
@@ -338,6 +374,11 @@ void Hud::drawLuaElements(const v3s32 &camera_offset)
 	const u32 text_height = g_fontengine->getTextHeight();
 	gui::IGUIFont *const font = g_fontengine->getFont();
 
+	if (m_font_generation != g_fontengine->getFontGeneration()) {
+		m_font_generation = g_fontengine->getFontGeneration();
+		m_text_layouts.clear();
+	}
+
 	// Reorder elements by z_index
 	std::vector<HudElement*> elems;
 	elems.reserve(player->maxHudId());
@@ -378,22 +419,20 @@ void Hud::drawLuaElements(const v3s32 &camera_offset)
 				video::SColor color(255, (e->number >> 16) & 0xFF,
 										 (e->number >> 8)  & 0xFF,
 										 (e->number >> 0)  & 0xFF);
-				std::wstring text = unescape_translate(utf8_to_wide(e->text));
-				core::dimension2d<u32> textsize = textfont->getDimension(text.c_str());
+				const HudTextLayout &layout = m_text_layouts.get(e, textfont,
+					[textfont] (const std::wstring &s) {
+						return textfont->getDimension(s.c_str());
+					});
 
-				v2s32 offset(0, (e->align.Y - 1.0) * (textsize.Height / 2));
+				v2s32 offset(0, (e->align.Y - 1.0) * (layout.size.Height / 2));
 				core::rect<s32> size(0, 0, e->scale.X * m_scale_factor,
 						text_height * e->scale.Y * m_scale_factor);
 				v2s32 offs(e->offset.X * m_scale_factor,
 						e->offset.Y * m_scale_factor);
-				std::wstringstream wss(text);
-				std::wstring line;
-				while (std::getline(wss, line, L'\n'))
-				{
-					core::dimension2d<u32> linesize = textfont->getDimension(line.c_str());
-					v2s32 line_offset((e->align.X - 1.0) * (linesize.Width / 2), 0);
-					textfont->draw(line.c_str(), size + pos + offset + offs + line_offset, color);
-					offset.Y += linesize.Height;
+				for (const HudTextLayout::Line &line : layout.lines) {
+					v2s32 line_offset((e->align.X - 1.0) * (line.size.Width / 2), 0);
+					textfont->draw(line.text.c_str(), size + pos + offset + offs + line_offset, color);
+					offset.Y += line.size.Height;
 				}
 				break; }
 			case HUD_ELEM_STATBAR: {
@@ -532,6 +571,8 @@ void Hud::drawLuaElements(const v3s32 &camera_offset)
 					<< " due to unrecognized type" << std::endl;
 		}
 	}
+
+	m_text_layouts.prune();
 }
 
 void Hud::drawCompassTranslate(HudElement *e, video::ITexture *texture,
@@ -20,6 +20,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #pragma once
 
+#include <functional>
+#include <unordered_map>
 #include <vector>
 #include <IGUIFont.h>
 #include "irr_aabb3d.h"
@@ -32,6 +34,54 @@ class InventoryList;
 class LocalPlayer;
 struct ItemStack;
 
+/*
+	The text of a HUD element split into lines, with their sizes.
+*/
+struct HudTextLayout
+{
+	struct Line
+	{
+		std::wstring text;
+		core::dimension2d<u32> size;
+	};
+
+	// HudElement::text and font it was made for
+	std::string source;
+	gui::IGUIFont *font = nullptr;
+
+	core::dimension2d<u32> size;
+	std::vector<Line> lines;
+};
+
+/*
+	Keeps the layout of HUD texts between frames, so they are only
+	translated and measured again when the text or the font changes.
+*/
+class HudTextLayoutCache
+{
+public:
+	typedef std::function<core::dimension2d<u32>(const std::wstring &)> Measure;
+
+	// measure is only called if the layout has to be made anew
+	const HudTextLayout &get(const HudElement *e, gui::IGUIFont *font,
+			const Measure &measure);
+
+	// Drops the layouts of elements not used since the last call
+	void prune();
+
+	void clear() { m_layouts.clear(); }
+	size_t size() const { return m_layouts.size(); }
+
+private:
+	struct Entry
+	{
+		HudTextLayout layout;
+		bool used = false;
+	};
+
+	std::unordered_map<const HudElement *, Entry> m_layouts;
+};
+
 class Hud
 {
 public:
@@ -140,6 +190,10 @@ class Hud
 
 	scene::SMeshBuffer m_rotation_mesh_buffer;
 
+	HudTextLayoutCache m_text_layouts;
+	// Fonts the layouts were made with may be gone when this changes
+	u32 m_font_generation = 0;
+
 	enum
 	{
 		HIGHLIGHT_BOX,
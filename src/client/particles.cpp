@@ -759,44 +759,57 @@ void ParticleManager::handleParticleEvent(ClientEvent *event, Client *client,
 			break;
 		}
 		case CE_SPAWN_PARTICLE: {
-			ParticleParameters &p = *event->spawn_particle;
+			spawnParticle(*event->spawn_particle, client, player);
+			delete event->spawn_particle;
+			break;
+		}
+		case CE_SPAWN_PARTICLE_BURST: {
+			const ParticleBurst &burst = *event->spawn_particle_burst;
+			ParticleParameters p;
+			for (size_t i = 0; i < burst.particles.size(); i++) {
+				burst.getParticle(i, p);
+				spawnParticle(p, client, player);
+			}
+			delete event->spawn_particle_burst;
+			break;
+		}
+		default: break;
+	}
+}
 
-			ClientTexRef texture;
-			v2f texpos, texsize;
-			video::SColor color(0xFFFFFFFF);
+void ParticleManager::spawnParticle(ParticleParameters &p, Client *client,
+	LocalPlayer *player)
+{
+	ClientTexRef texture;
+	v2f texpos, texsize;
+	video::SColor color(0xFFFFFFFF);
 
-			f32 oldsize = p.size;
+	f32 oldsize = p.size;
 
-			if (p.node.getContent() != CONTENT_IGNORE) {
-				const ContentFeatures &f = m_env->getGameDef()->ndef()->get(p.node);
-				getNodeParticleParams(p.node, f, p, &texture.ref, texpos,
-						texsize, &color, p.node_tile);
-			} else {
-				/* with no particlespawner to own the texture, we need
-				 * to save it on the heap. it will be freed when the
-				 * particle is destroyed */
-				auto texstore = new ClientTexture(p.texture, client->tsrc());
-
-				texture = ClientTexRef(*texstore);
-				texpos = v2f(0.0f, 0.0f);
-				texsize = v2f(1.0f, 1.0f);
-			}
+	if (p.node.getContent() != CONTENT_IGNORE) {
+		const ContentFeatures &f = m_env->getGameDef()->ndef()->get(p.node);
+		getNodeParticleParams(p.node, f, p, &texture.ref, texpos,
+				texsize, &color, p.node_tile);
+	} else {
+		/* with no particlespawner to own the texture, we need
+		 * to save it on the heap. it will be freed when the
+		 * particle is destroyed */
+		auto texstore = new ClientTexture(p.texture, client->tsrc());
 
-			// Allow keeping default random size
-			if (oldsize > 0.0f)
-				p.size = oldsize;
+		texture = ClientTexRef(*texstore);
+		texpos = v2f(0.0f, 0.0f);
+		texsize = v2f(1.0f, 1.0f);
+	}
 
-			if (texture.ref) {
-				Particle *toadd = new Particle(client, player, m_env,
-						p, texture, texpos, texsize, color);
+	// Allow keeping default random size
+	if (oldsize > 0.0f)
+		p.size = oldsize;
 
-				addParticle(toadd);
-			}
+	if (texture.ref) {
+		Particle *toadd = new Particle(client, player, m_env,
+				p, texture, texpos, texsize, color);
 
-			delete event->spawn_particle;
-			break;
-		}
-		default: break;
+		addParticle(toadd);
 	}
 }
 
@@ -225,6 +225,10 @@ friend class ParticleSpawner;
 	void addParticleSpawner(u64 id, ParticleSpawner *toadd);
 	void deleteParticleSpawner(u64 id);
 
+	// Spawns a particle sent by the server or a client-side mod
+	void spawnParticle(ParticleParameters &p, Client *client,
+			LocalPlayer *player);
+
 	void stepParticles(float dtime);
 	void stepSpawners(float dtime);
 
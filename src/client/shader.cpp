@@ -426,6 +426,11 @@ class ShaderSource : public IWritableShaderSource
 	// Global constant setter factories
 	std::vector<std::unique_ptr<IShaderConstantSetterFactory>> m_setter_factories;
 
+	// Read on first use and when rebuilding shaders
+	// This should be only accessed from the main thread
+	ShaderHeaderParams m_header_params;
+	bool m_header_params_valid = false;
+
 	// Generate shader given the shader name.
 	ShaderInfo generateShader(const std::string &name,
 			MaterialType material_type, NodeDrawType drawtype);
@@ -577,6 +582,9 @@ void ShaderSource::rebuildShaders()
 		(This would be nice to do in the destructor too)
 	*/
 
+	// Settings may have changed
+	m_header_params_valid = false;
+
 	// Recreate shaders
 	for (ShaderInfo &i : m_shaderinfo_cache) {
 		ShaderInfo *info = &i;
@@ -627,18 +635,124 @@ ShaderInfo ShaderSource::generateShader(const std::string &name,
 	}
 	video::IGPUProgrammingServices *gpu = driver->getGPUProgrammingServices();
 
-	// Create shaders header
-	bool use_gles = false;
+	if (!m_header_params_valid) {
+		m_header_params = ShaderHeaderParams();
 #if ENABLE_GLES
-	use_gles = driver->getDriverType() == video::EDT_OGLES2;
+		m_header_params.use_gles = driver->getDriverType() == video::EDT_OGLES2;
 #endif
-	std::stringstream shaders_header;
-	shaders_header
+
+		// Since this is the first time we're using the GL bindings be extra careful.
+		// This should be removed before 5.6.0 or similar.
+		if (!GL.GetString) {
+			errorstream << "OpenGL procedures were not loaded correctly, "
+				"please open a bug report with details about your platform/OS." << std::endl;
+			abort();
+		}
+
+		m_header_params.use_discard = m_header_params.use_gles;
+		// For renderers that should use discard instead of GL_ALPHA_TEST
+		const char *renderer = reinterpret_cast<const char*>(GL.GetString(GL.RENDERER));
+		if (strstr(renderer, "GC7000"))
+			m_header_params.use_discard = true;
+
+		m_header_params.readSettings();
+		m_header_params_valid = true;
+	}
+
+	ShaderProgramSources templates;
+	templates.vertex = m_sourcecache.getOrLoad(name, "opengl_vertex.glsl");
+	templates.fragment = m_sourcecache.getOrLoad(name, "opengl_fragment.glsl");
+	templates.geometry = m_sourcecache.getOrLoad(name, "opengl_geometry.glsl");
+
+	// Preprocessing is only string concatenation. The compile below needs
+	// the GL context of the main thread, so variants are not prepared on
+	// a worker.
+	ShaderProgramSources sources = preprocessShader(m_header_params, shaderinfo, templates);
+	const char *geometry_shader_ptr = nullptr; // optional
+	if (!sources.geometry.empty())
+		geometry_shader_ptr = sources.geometry.c_str();
+
+	irr_ptr<ShaderCallback> cb{new ShaderCallback(m_setter_factories)};
+	infostream<<"Compiling high level shaders for "<<name<<std::endl;
+	s32 shadermat = gpu->addHighLevelShaderMaterial(
+		sources.vertex.c_str(), nullptr, video::EVST_VS_1_1,
+		sources.fragment.c_str(), nullptr, video::EPST_PS_1_1,
+		geometry_shader_ptr, nullptr, video::EGST_GS_4_0, scene::EPT_TRIANGLES, scene::EPT_TRIANGLES, 0,
+		cb.get(), shaderinfo.base_material,  1);
+	if (shadermat == -1) {
+		errorstream<<"generate_shader(): "
+				"failed to generate \""<<name<<"\", "
+				"addHighLevelShaderMaterial failed."
+				<<std::endl;
+		dumpShaderProgram(warningstream, "Vertex", sources.vertex);
+		dumpShaderProgram(warningstream, "Fragment", sources.fragment);
+		dumpShaderProgram(warningstream, "Geometry", sources.geometry);
+		return shaderinfo;
+	}
+
+	// Apply the newly created material type
+	shaderinfo.material = (video::E_MATERIAL_TYPE) shadermat;
+	return shaderinfo;
+}
+
+void ShaderHeaderParams::readSettings()
+{
+	std::ostringstream os;
+	os
 		<< std::noboolalpha
 		<< std::showpoint // for GLSL ES
 		;
+
+	bool enable_waving_water = g_settings->getBool("enable_waving_water");
+	os << "#define ENABLE_WAVING_WATER " << enable_waving_water << "\n";
+	if (enable_waving_water) {
+		os << "#define WATER_WAVE_HEIGHT " << g_settings->getFloat("water_wave_height") << "\n";
+		os << "#define WATER_WAVE_LENGTH " << g_settings->getFloat("water_wave_length") << "\n";
+		os << "#define WATER_WAVE_SPEED " << g_settings->getFloat("water_wave_speed") << "\n";
+	}
+
+	os << "#define ENABLE_WAVING_LEAVES " << g_settings->getBool("enable_waving_leaves") << "\n";
+	os << "#define ENABLE_WAVING_PLANTS " << g_settings->getBool("enable_waving_plants") << "\n";
+	os << "#define ENABLE_TONE_MAPPING " << g_settings->getBool("tone_mapping") << "\n";
+
+	os << "#define FOG_START " << core::clamp(g_settings->getFloat("fog_start"), 0.0f, 0.99f) << "\n";
+
+	if (g_settings->getBool("enable_dynamic_shadows")) {
+		os << "#define ENABLE_DYNAMIC_SHADOWS 1\n";
+		if (g_settings->getBool("shadow_map_color"))
+			os << "#define COLORED_SHADOWS 1\n";
+
+		if (g_settings->getBool("shadow_poisson_filter"))
+			os << "#define POISSON_FILTER 1\n";
+
+		s32 shadow_filter = g_settings->getS32("shadow_filters");
+		os << "#define SHADOW_FILTER " << shadow_filter << "\n";
+
+		float shadow_soft_radius = g_settings->getFloat("shadow_soft_radius");
+		if (shadow_soft_radius < 1.0f)
+			shadow_soft_radius = 1.0f;
+		os << "#define SOFTSHADOWRADIUS " << shadow_soft_radius << "\n";
+	}
+
+	if (g_settings->getBool("enable_bloom")) {
+		os << "#define ENABLE_BLOOM 1\n";
+		if (g_settings->getBool("enable_bloom_debug"))
+			os << "#define ENABLE_BLOOM_DEBUG 1\n";
+	}
+
+	if (g_settings->getBool("enable_auto_exposure"))
+		os << "#define ENABLE_AUTO_EXPOSURE 1\n";
+
+	defines = os.str();
+}
+
+ShaderProgramSources preprocessShader(const ShaderHeaderParams &params,
+		const ShaderInfo &info, const ShaderProgramSources &templates)
+{
+	// Create shaders header
+	std::ostringstream shaders_header;
 	std::string vertex_header, fragment_header, geometry_header;
-	if (use_gles) {
+	if (params.use_gles) {
 		shaders_header << R"(
 			#version 100
 		)";
@@ -689,23 +803,10 @@ ShaderInfo ShaderSource::generateShader(const std::string &name,
 		#define textureFlags texture2
 	)";
 
-	// Since this is the first time we're using the GL bindings be extra careful.
-	// This should be removed before 5.6.0 or similar.
-	if (!GL.GetString) {
-		errorstream << "OpenGL procedures were not loaded correctly, "
-			"please open a bug report with details about your platform/OS." << std::endl;
-		abort();
-	}
-
-	bool use_discard = use_gles;
-	// For renderers that should use discard instead of GL_ALPHA_TEST
-	const char *renderer = reinterpret_cast<const char*>(GL.GetString(GL.RENDERER));
-	if (strstr(renderer, "GC7000"))
-		use_discard = true;
-	if (use_discard) {
-		if (shaderinfo.base_material == video::EMT_TRANSPARENT_ALPHA_CHANNEL)
+	if (params.use_discard) {
+		if (info.base_material == video::EMT_TRANSPARENT_ALPHA_CHANNEL)
 			shaders_header << "#define USE_DISCARD 1\n";
-		else if (shaderinfo.base_material == video::EMT_TRANSPARENT_ALPHA_CHANNEL_REF)
+		else if (info.base_material == video::EMT_TRANSPARENT_ALPHA_CHANNEL_REF)
 			shaders_header << "#define USE_DISCARD_REF 1\n";
 	}
 
@@ -744,86 +845,21 @@ ShaderInfo ShaderSource::generateShader(const std::string &name,
 
 #undef PROVIDE
 
-	shaders_header << "#define MATERIAL_TYPE " << (int)material_type << "\n";
-	shaders_header << "#define DRAW_TYPE " << (int)drawtype << "\n";
-
-	bool enable_waving_water = g_settings->getBool("enable_waving_water");
-	shaders_header << "#define ENABLE_WAVING_WATER " << enable_waving_water << "\n";
-	if (enable_waving_water) {
-		shaders_header << "#define WATER_WAVE_HEIGHT " << g_settings->getFloat("water_wave_height") << "\n";
-		shaders_header << "#define WATER_WAVE_LENGTH " << g_settings->getFloat("water_wave_length") << "\n";
-		shaders_header << "#define WATER_WAVE_SPEED " << g_settings->getFloat("water_wave_speed") << "\n";
-	}
+	shaders_header << "#define MATERIAL_TYPE " << (int)info.material_type << "\n";
+	shaders_header << "#define DRAW_TYPE " << (int)info.drawtype << "\n";
 
-	shaders_header << "#define ENABLE_WAVING_LEAVES " << g_settings->getBool("enable_waving_leaves") << "\n";
-	shaders_header << "#define ENABLE_WAVING_PLANTS " << g_settings->getBool("enable_waving_plants") << "\n";
-	shaders_header << "#define ENABLE_TONE_MAPPING " << g_settings->getBool("tone_mapping") << "\n";
-
-	shaders_header << "#define FOG_START " << core::clamp(g_settings->getFloat("fog_start"), 0.0f, 0.99f) << "\n";
-
-	if (g_settings->getBool("enable_dynamic_shadows")) {
-		shaders_header << "#define ENABLE_DYNAMIC_SHADOWS 1\n";
-		if (g_settings->getBool("shadow_map_color"))
-			shaders_header << "#define COLORED_SHADOWS 1\n";
-
-		if (g_settings->getBool("shadow_poisson_filter"))
-			shaders_header << "#define POISSON_FILTER 1\n";
-
-		s32 shadow_filter = g_settings->getS32("shadow_filters");
-		shaders_header << "#define SHADOW_FILTER " << shadow_filter << "\n";
-
-		float shadow_soft_radius = g_settings->getFloat("shadow_soft_radius");
-		if (shadow_soft_radius < 1.0f)
-			shadow_soft_radius = 1.0f;
-		shaders_header << "#define SOFTSHADOWRADIUS " << shadow_soft_radius << "\n";
-	}
-
-	if (g_settings->getBool("enable_bloom")) {
-		shaders_header << "#define ENABLE_BLOOM 1\n";
-		if (g_settings->getBool("enable_bloom_debug"))
-			shaders_header << "#define ENABLE_BLOOM_DEBUG 1\n";
-	}
-
-	if (g_settings->getBool("enable_auto_exposure"))
-		shaders_header << "#define ENABLE_AUTO_EXPOSURE 1\n";
+	shaders_header << params.defines;
 
 	shaders_header << "#line 0\n"; // reset the line counter for meaningful diagnostics
 
 	std::string common_header = shaders_header.str();
 
-	std::string vertex_shader = m_sourcecache.getOrLoad(name, "opengl_vertex.glsl");
-	std::string fragment_shader = m_sourcecache.getOrLoad(name, "opengl_fragment.glsl");
-	std::string geometry_shader = m_sourcecache.getOrLoad(name, "opengl_geometry.glsl");
-
-	vertex_shader = common_header + vertex_header + vertex_shader;
-	fragment_shader = common_header + fragment_header + fragment_shader;
-	const char *geometry_shader_ptr = nullptr; // optional
-	if (!geometry_shader.empty()) {
-		geometry_shader = common_header + geometry_header + geometry_shader;
-		geometry_shader_ptr = geometry_shader.c_str();
-	}
-
-	irr_ptr<ShaderCallback> cb{new ShaderCallback(m_setter_factories)};
-	infostream<<"Compiling high level shaders for "<<name<<std::endl;
-	s32 shadermat = gpu->addHighLevelShaderMaterial(
-		vertex_shader.c_str(), nullptr, video::EVST_VS_1_1,
-		fragment_shader.c_str(), nullptr, video::EPST_PS_1_1,
-		geometry_shader_ptr, nullptr, video::EGST_GS_4_0, scene::EPT_TRIANGLES, scene::EPT_TRIANGLES, 0,
-		cb.get(), shaderinfo.base_material,  1);
-	if (shadermat == -1) {
-		errorstream<<"generate_shader(): "
-				"failed to generate \""<<name<<"\", "
-				"addHighLevelShaderMaterial failed."
-				<<std::endl;
-		dumpShaderProgram(warningstream, "Vertex", vertex_shader);
-		dumpShaderProgram(warningstream, "Fragment", fragment_shader);
-		dumpShaderProgram(warningstream, "Geometry", geometry_shader);
-		return shaderinfo;
-	}
-
-	// Apply the newly created material type
-	shaderinfo.material = (video::E_MATERIAL_TYPE) shadermat;
-	return shaderinfo;
+	ShaderProgramSources sources;
+	sources.vertex = common_header + vertex_header + templates.vertex;
+	sources.fragment = common_header + fragment_header + templates.fragment;
+	if (!templates.geometry.empty())
+		sources.geometry = common_header + geometry_header + templates.geometry;
+	return sources;
 }
 
 void dumpShaderProgram(std::ostream &output_stream,
@@ -55,6 +55,37 @@ struct ShaderInfo {
 	virtual ~ShaderInfo() = default;
 };
 
+/*
+	What the generated shader headers depend on besides the material and
+	drawtype of a variant. It is read once, so generating a variant doesn't
+	query the settings or the driver.
+*/
+struct ShaderHeaderParams
+{
+	bool use_gles = false;
+	// Use discard instead of GL_ALPHA_TEST
+	bool use_discard = false;
+	// Defines derived from the settings
+	std::string defines;
+
+	void readSettings();
+};
+
+struct ShaderProgramSources
+{
+	std::string vertex;
+	std::string fragment;
+	// Empty if there is no geometry shader
+	std::string geometry;
+};
+
+/*
+	Puts the header of a shader variant in front of the source templates.
+	This doesn't need the GPU.
+*/
+ShaderProgramSources preprocessShader(const ShaderHeaderParams &params,
+		const ShaderInfo &info, const ShaderProgramSources &templates);
+
 /*
 	Setter of constants for shaders
 */
@@ -39,11 +39,12 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 struct NearbyCollisionInfo {
 	// node
 	NearbyCollisionInfo(bool is_ul, int bouncy, const v3s32 &pos,
-			const aabb3f &box) :
+			const aabb3f &box, s32 run = 1) :
 		is_unloaded(is_ul),
 		obj(nullptr),
 		bouncy(bouncy),
 		position(pos),
+		run(run),
 		box(box)
 	{}
 
@@ -58,11 +59,22 @@ struct NearbyCollisionInfo {
 
 	inline bool isObject() const { return obj != nullptr; }
 
+	// Node of a merged box that is closest to the given position
+	inline v3s32 getNodePos(const v3f &pos) const
+	{
+		v3s32 p = position;
+		if (run > 1)
+			p.X = rangelim(floatToInt(pos, BS).X, position.X, position.X + run - 1);
+		return p;
+	}
+
 	bool is_unloaded;
 	bool is_step_up = false;
 	ActiveObject *obj;
 	int bouncy;
 	v3s32 position;
+	// Number of nodes along X covered by a merged box
+	s32 run = 1;
 	aabb3f box;
 };
 
@@ -222,6 +234,131 @@ static inline void getNeighborConnectingFace(const v3s32 &p,
 		*neighbors |= v;
 }
 
+static void addConnectedNodeBoxes(const v3s32 &p, const NodeDefManager *nodedef,
+	Map *map, std::vector<NearbyCollisionInfo> &cinfo)
+{
+	MapNode n = map->getNode(p);
+	const ContentFeatures &f = nodedef->get(n);
+
+	// Negative bouncy may have a meaning, but we need +value here.
+	int n_bouncy_value = abs(itemgroup_get(f.groups, "bouncy"));
+
+	int neighbors = 0;
+	v3s32 p2 = p;
+
+	p2.Y++;
+	getNeighborConnectingFace(p2, nodedef, map, n, 1, &neighbors);
+
+	p2 = p;
+	p2.Y--;
+	getNeighborConnectingFace(p2, nodedef, map, n, 2, &neighbors);
+
+	p2 = p;
+	p2.Z--;
+	getNeighborConnectingFace(p2, nodedef, map, n, 4, &neighbors);
+
+	p2 = p;
+	p2.X--;
+	getNeighborConnectingFace(p2, nodedef, map, n, 8, &neighbors);
+
+	p2 = p;
+	p2.Z++;
+	getNeighborConnectingFace(p2, nodedef, map, n, 16, &neighbors);
+
+	p2 = p;
+	p2.X++;
+	getNeighborConnectingFace(p2, nodedef, map, n, 32, &neighbors);
+
+	std::vector<aabb3f> nodeboxes;
+	n.getCollisionBoxes(nodedef, &nodeboxes, neighbors);
+
+	// Calculate float position only once
+	v3d posf = intToDouble(p, BS);
+	for (auto box : nodeboxes) {
+		box.MinEdge += posf;
+		box.MaxEdge += posf;
+		cinfo.emplace_back(false, n_bouncy_value, p, box);
+	}
+}
+
+void BlockCollisionCache::update(MapBlock *block, const NodeDefManager *nodedef)
+{
+	boxes.clear();
+	connected_nodes.clear();
+
+	const aabb3f full_box = getNodeBox(v3s32(0, 0, 0), BS);
+
+	// Extends the previous box if it is a full node right next to p
+	auto add_full_box = [&] (const v3s32 &p, int bouncy, bool is_ignore) {
+		if (!boxes.empty()) {
+			Box &last = boxes.back();
+			if (last.node_p.Y == p.Y && last.node_p.Z == p.Z &&
+					last.node_p.X + last.run == p.X && last.bouncy == bouncy &&
+					last.is_ignore == is_ignore && last.box == full_box) {
+				last.run++;
+				return;
+			}
+		}
+		Box box;
+		box.box = full_box;
+		box.node_p = p;
+		box.bouncy = bouncy;
+		box.is_ignore = is_ignore;
+		boxes.push_back(box);
+	};
+
+	std::vector<aabb3f> nodeboxes;
+	v3s32 p;
+	for (p.Z = 0; p.Z < MAP_BLOCKSIZE; p.Z++)
+	for (p.Y = 0; p.Y < MAP_BLOCKSIZE; p.Y++)
+	for (p.X = 0; p.X < MAP_BLOCKSIZE; p.X++) {
+		MapNode n = block->getNodeNoCheck(p);
+		if (n.getContent() == CONTENT_IGNORE) {
+			add_full_box(p, 0, true);
+			continue;
+		}
+
+		const ContentFeatures &f = nodedef->get(n);
+		if (!f.walkable)
+			continue;
+
+		if (f.drawtype == NDT_NODEBOX &&
+				f.node_box.type == NODEBOX_CONNECTED) {
+			connected_nodes.push_back(p);
+			continue;
+		}
+
+		// Negative bouncy may have a meaning, but we need +value here.
+		int n_bouncy_value = abs(itemgroup_get(f.groups, "bouncy"));
+
+		nodeboxes.clear();
+		n.getCollisionBoxes(nodedef, &nodeboxes);
+		if (nodeboxes.size() == 1 && nodeboxes[0] == full_box) {
+			add_full_box(p, n_bouncy_value, false);
+			continue;
+		}
+
+		for (const aabb3f &nodebox : nodeboxes) {
+			Box box;
+			box.box = nodebox;
+			box.node_p = p;
+			box.bouncy = n_bouncy_value;
+			boxes.push_back(box);
+		}
+	}
+
+	// Merged boxes never span rows, so the boxes are already in row order
+	const u32 row_count = MAP_BLOCKSIZE * MAP_BLOCKSIZE;
+	row_start.resize(row_count + 1);
+	u32 i = 0;
+	for (u32 row = 0; row < row_count; row++) {
+		row_start[row] = i;
+		while (i < boxes.size() && getRow(boxes[i].node_p.Y, boxes[i].node_p.Z) == row)
+			i++;
+	}
+	row_start[row_count] = i;
+}
+
 collisionMoveResult collisionMoveSimple(Environment *env, IGameDef *gamedef,
 		f32 pos_max_d, const aabb3f &box_0,
 		f32 stepheight, f32 dtime,
@@ -289,71 +426,86 @@ collisionMoveResult collisionMoveSimple(Environment *env, IGameDef *gamedef,
 	v3s32 max = floatToInt(maxpos_f + box_0.MaxEdge, BS) + v3s32(1, 1, 1);
 
 	bool any_position_valid = false;
+	const NodeDefManager *nodedef = gamedef->getNodeDefManager();
+
+	v3s32 blockpos_min = getNodeBlockPos(min);
+	v3s32 blockpos_max = getNodeBlockPos(max);
+	v3s32 bp;
+	for (bp.X = blockpos_min.X; bp.X <= blockpos_max.X; bp.X++)
+	for (bp.Y = blockpos_min.Y; bp.Y <= blockpos_max.Y; bp.Y++)
+	for (bp.Z = blockpos_min.Z; bp.Z <= blockpos_max.Z; bp.Z++) {
+		// Part of the movement range in this block, relative to the block
+		v3s32 block_origin = bp * MAP_BLOCKSIZE;
+		v3s32 rmin(
+			MYMAX(min.X - block_origin.X, 0),
+			MYMAX(min.Y - block_origin.Y, 0),
+			MYMAX(min.Z - block_origin.Z, 0)
+		);
+		v3s32 rmax(
+			MYMIN(max.X - block_origin.X, MAP_BLOCKSIZE - 1),
+			MYMIN(max.Y - block_origin.Y, MAP_BLOCKSIZE - 1),
+			MYMIN(max.Z - block_origin.Z, MAP_BLOCKSIZE - 1)
+		);
+		s32 run_x = rmax.X - rmin.X + 1;
+
+		MapBlock *block = map->getBlockNoCreateNoEx(bp);
+		if (!block) {
+			// Collide with unloaded nodes, one box per row
+			for (s32 z = rmin.Z; z <= rmax.Z; z++)
+			for (s32 y = rmin.Y; y <= rmax.Y; y++) {
+				v3s32 p = block_origin + v3s32(rmin.X, y, z);
+				aabb3f box = getNodeBox(p, BS);
+				box.MaxEdge.X = getNodeBox(p + v3s32(run_x - 1, 0, 0), BS).MaxEdge.X;
+				cinfo.emplace_back(true, 0, p, box, run_x);
+			}
+			continue;
+		}
 
-	v3s32 p;
-	for (p.X = min.X; p.X <= max.X; p.X++)
-	for (p.Y = min.Y; p.Y <= max.Y; p.Y++)
-	for (p.Z = min.Z; p.Z <= max.Z; p.Z++) {
-		bool is_position_valid;
-		MapNode n = map->getNode(p, &is_position_valid);
-
-		if (is_position_valid && n.getContent() != CONTENT_IGNORE) {
-			// Object collides into walkable nodes
-
-			any_position_valid = true;
-			const NodeDefManager *nodedef = gamedef->getNodeDefManager();
-			const ContentFeatures &f = nodedef->get(n);
-
-			if (!f.walkable)
-				continue;
-
-			// Negative bouncy may have a meaning, but we need +value here.
-			int n_bouncy_value = abs(itemgroup_get(f.groups, "bouncy"));
-
-			int neighbors = 0;
-			if (f.drawtype == NDT_NODEBOX &&
-				f.node_box.type == NODEBOX_CONNECTED) {
-				v3s32 p2 = p;
-
-				p2.Y++;
-				getNeighborConnectingFace(p2, nodedef, map, n, 1, &neighbors);
-
-				p2 = p;
-				p2.Y--;
-				getNeighborConnectingFace(p2, nodedef, map, n, 2, &neighbors);
-
-				p2 = p;
-				p2.Z--;
-				getNeighborConnectingFace(p2, nodedef, map, n, 4, &neighbors);
-
-				p2 = p;
-				p2.X--;
-				getNeighborConnectingFace(p2, nodedef, map, n, 8, &neighbors);
-
-				p2 = p;
-				p2.Z++;
-				getNeighborConnectingFace(p2, nodedef, map, n, 16, &neighbors);
+		const BlockCollisionCache &cache = block->getCollisionCache();
+		s32 ignore_count = 0;
+		for (s32 z = rmin.Z; z <= rmax.Z; z++)
+		for (s32 y = rmin.Y; y <= rmax.Y; y++) {
+			const u32 row = BlockCollisionCache::getRow(y, z);
+			for (u32 i = cache.row_start[row]; i < cache.row_start[row + 1]; i++) {
+				const BlockCollisionCache::Box &cbox = cache.boxes[i];
+				const v3s32 &np = cbox.node_p;
+
+				// Only the nodes of a merged box that are in range
+				s32 x0 = MYMAX(np.X, rmin.X);
+				s32 x1 = MYMIN(np.X + cbox.run - 1, rmax.X);
+				if (x0 > x1)
+					continue;
+
+				v3s32 p = block_origin + v3s32(x0, np.Y, np.Z);
+				v3s32 p_last = p + v3s32(x1 - x0, 0, 0);
+
+				if (cbox.is_ignore) {
+					// Collide with loaded CONTENT_IGNORE nodes
+					ignore_count += x1 - x0 + 1;
+					aabb3f box = getNodeBox(p, BS);
+					box.MaxEdge.X = getNodeBox(p_last, BS).MaxEdge.X;
+					cinfo.emplace_back(true, 0, p, box, x1 - x0 + 1);
+					continue;
+				}
 
-				p2 = p;
-				p2.X++;
-				getNeighborConnectingFace(p2, nodedef, map, n, 32, &neighbors);
-			}
-			std::vector<aabb3f> nodeboxes;
-			n.getCollisionBoxes(gamedef->ndef(), &nodeboxes, neighbors);
-
-			// Calculate float position only once
-			v3d posf = intToDouble(p, BS);
-			for (auto box : nodeboxes) {
-				box.MinEdge += posf;
-				box.MaxEdge += posf;
-				cinfo.emplace_back(false, n_bouncy_value, p, box);
+				aabb3f box = cbox.box;
+				box.MinEdge += intToDouble(p, BS);
+				box.MaxEdge += intToDouble(p_last, BS);
+				cinfo.emplace_back(false, cbox.bouncy, p, box, x1 - x0 + 1);
 			}
-		} else {
-			// Collide with unloaded nodes (position invalid) and loaded
-			// CONTENT_IGNORE nodes (position valid)
-			aabb3f box = getNodeBox(p, BS);
-			cinfo.emplace_back(true, 0, p, box);
 		}
+
+		for (const v3s32 &np : cache.connected_nodes) {
+			if (np.X >= rmin.X && np.X <= rmax.X &&
+					np.Y >= rmin.Y && np.Y <= rmax.Y &&
+					np.Z >= rmin.Z && np.Z <= rmax.Z)
+				addConnectedNodeBoxes(block_origin + np, nodedef, map, cinfo);
+		}
+
+		// Object collides into walkable nodes, if any node is not CONTENT_IGNORE
+		s32 volume = run_x * (rmax.Y - rmin.Y + 1) * (rmax.Z - rmin.Z + 1);
+		if (volume > ignore_count)
+			any_position_valid = true;
 	}
 
 	// Do not move if world has not loaded yet, since custom node boxes
@@ -409,7 +561,7 @@ collisionMoveResult collisionMoveSimple(Environment *env, IGameDef *gamedef,
 				};
 
 				std::vector<ServerActiveObject *> s_objects;
-				s_env->getObjectsInsideRadius(s_objects, *pos_f, distance, include_obj_cb);
+				s_env->getCollisionCandidates(s_objects, *pos_f, distance, include_obj_cb);
 			}
 		}
 
@@ -536,7 +688,7 @@ collisionMoveResult collisionMoveSimple(Environment *env, IGameDef *gamedef,
 			else
 				info.type = COLLISION_NODE;
 
-			info.node_p = nearest_info.position;
+			info.node_p = nearest_info.getNodePos(*pos_f);
 			info.object = nearest_info.obj;
 			info.old_speed = *speed_f;
 			info.plane = nearest_collided;
@@ -20,12 +20,15 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #pragma once
 
 #include "irrlichttypes_bloated.h"
+#include "constants.h"
 #include <vector>
 
 class Map;
+class MapBlock;
 class IGameDef;
 class Environment;
 class ActiveObject;
+class NodeDefManager;
 
 enum CollisionType
 {
@@ -64,6 +67,41 @@ struct collisionMoveResult
 	std::vector<CollisionInfo> collisions;
 };
 
+/*
+	Collision boxes of all nodes of a MapBlock, so that moving objects do not
+	need to look up every node they might touch. Runs of full nodes along X
+	are merged into a single box.
+	Kept by MapBlock and rebuilt after the block has been modified.
+*/
+struct BlockCollisionCache
+{
+	struct Box
+	{
+		// Relative to the position of the first node
+		aabb3f box;
+		// Position of the first node, relative to the block
+		v3s32 node_p;
+		// Number of nodes covered along X, only full nodes are merged
+		s32 run = 1;
+		int bouncy = 0;
+		// CONTENT_IGNORE, which is collided with like unloaded nodes
+		bool is_ignore = false;
+	};
+
+	void update(MapBlock *block, const NodeDefManager *nodedef);
+
+	// Index of the rows of nodes along X, by Z * MAP_BLOCKSIZE + Y
+	static u32 getRow(s32 y, s32 z) { return z * MAP_BLOCKSIZE + y; }
+
+	// Ordered by row, boxes of row r are boxes[row_start[r]] up to
+	// boxes[row_start[r + 1]]
+	std::vector<Box> boxes;
+	std::vector<u32> row_start;
+	// Connected nodeboxes depend on the neighbouring nodes, which might be
+	// in other blocks. They are looked up on every collision check instead.
+	std::vector<v3s32> connected_nodes;
+};
+
 // Moves using a single iteration; speed should not exceed pos_max_d/dtime
 collisionMoveResult collisionMoveSimple(Environment *env,IGameDef *gamedef,
 		f32 pos_max_d, const aabb3f &box_0,
@@ -254,6 +254,13 @@ const std::vector<std::string> &ModStorage::getKeys(std::vector<std::string> *pl
 	return *place;
 }
 
+void ModStorage::getKeysWithPrefix(const std::string &prefix,
+		std::vector<std::string> *place) const
+{
+	place->clear();
+	m_database->getModKeysWithPrefix(m_mod_name, prefix, place);
+}
+
 const std::string *ModStorage::getStringRaw(const std::string &name, std::string *place) const
 {
 	return m_database->getModEntry(m_mod_name, name, place) ? place : nullptr;
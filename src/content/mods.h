@@ -129,6 +129,9 @@ class ModStorage : public IMetadata
 
 	const std::vector<std::string> &getKeys(std::vector<std::string> *place) const override;
 
+	// Keys starting with prefix, in sorted order when the database is buffered
+	void getKeysWithPrefix(const std::string &prefix, std::vector<std::string> *place) const;
+
 protected:
 	const std::string *getStringRaw(const std::string &name,
 			std::string *place) const override;
@@ -0,0 +1,310 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "database-buffered.h"
+#include "exceptions.h"
+#include "log.h"
+#include "threading/event.h"
+#include "threading/mutex_auto_lock.h"
+#include "threading/thread.h"
+#include <algorithm>
+#include <unordered_set>
+
+// Queued batches beyond this are merged, so the queue stays bounded while
+// the backend keeps failing
+#define MOD_STORAGE_MAX_QUEUED 8
+
+class ModStorageFlushThread : public Thread
+{
+public:
+	ModStorageFlushThread(ModStorageDatabaseBuffered *db) :
+		Thread("ModStorageFlush"), m_db(db)
+	{}
+
+	void signal() { m_event.signal(); }
+
+	void *run()
+	{
+		BEGIN_DEBUG_EXCEPTION_HANDLER
+
+		while (!stopRequested()) {
+			m_event.wait();
+			m_db->flushQueued();
+		}
+
+		END_DEBUG_EXCEPTION_HANDLER
+
+		return nullptr;
+	}
+
+private:
+	ModStorageDatabaseBuffered *m_db;
+	Event m_event;
+};
+
+ModStorageDatabaseBuffered::ModStorageDatabaseBuffered(ModStorageDatabase *backend) :
+	m_backend(backend),
+	m_thread(new ModStorageFlushThread(this))
+{
+	m_thread->start();
+}
+
+ModStorageDatabaseBuffered::~ModStorageDatabaseBuffered()
+{
+	m_thread->stop();
+	m_thread->signal();
+	m_thread->wait();
+	m_thread.reset();
+
+	// Whatever was not handed over yet is written now
+	endSave();
+	flushQueued();
+	if (!m_queue.empty()) {
+		errorstream << "ModStorageDatabaseBuffered: " << m_queue.size()
+			<< " batches of mod storage changes could not be written" << std::endl;
+	}
+}
+
+ModStorageDatabaseBuffered::ModEntries &ModStorageDatabaseBuffered::getMod(
+		const std::string &modname)
+{
+	auto it = m_mods.find(modname);
+	if (it != m_mods.end())
+		return it->second;
+
+	ModEntries &mod = m_mods[modname];
+	StringMap entries;
+	{
+		MutexAutoLock lock(m_backend_mutex);
+		m_backend->getModEntries(modname, &entries);
+	}
+	mod.entries.insert(entries.begin(), entries.end());
+	return mod;
+}
+
+void ModStorageDatabaseBuffered::getModEntries(const std::string &modname,
+		StringMap *storage)
+{
+	const ModEntries &mod = getMod(modname);
+	for (const auto &entry : mod.entries)
+		(*storage)[entry.first] = entry.second;
+}
+
+void ModStorageDatabaseBuffered::getModKeys(const std::string &modname,
+		std::vector<std::string> *storage)
+{
+	const ModEntries &mod = getMod(modname);
+	storage->reserve(storage->size() + mod.entries.size());
+	for (const auto &entry : mod.entries)
+		storage->push_back(entry.first);
+}
+
+void ModStorageDatabaseBuffered::getModKeysWithPrefix(const std::string &modname,
+		const std::string &prefix, std::vector<std::string> *storage)
+{
+	const ModEntries &mod = getMod(modname);
+	for (auto it = mod.entries.lower_bound(prefix); it != mod.entries.end(); ++it) {
+		if (!str_starts_with(it->first, prefix))
+			break;
+		storage->push_back(it->first);
+	}
+}
+
+bool ModStorageDatabaseBuffered::getModEntry(const std::string &modname,
+		const std::string &key, std::string *value)
+{
+	const ModEntries &mod = getMod(modname);
+	auto it = mod.entries.find(key);
+	if (it == mod.entries.end())
+		return false;
+	*value = it->second;
+	return true;
+}
+
+bool ModStorageDatabaseBuffered::hasModEntry(const std::string &modname,
+		const std::string &key)
+{
+	const ModEntries &mod = getMod(modname);
+	return mod.entries.find(key) != mod.entries.end();
+}
+
+bool ModStorageDatabaseBuffered::setModEntry(const std::string &modname,
+		const std::string &key, const std::string &value)
+{
+	ModEntries &mod = getMod(modname);
+	mod.entries[key] = value;
+	mod.dirty.insert(key);
+	return true;
+}
+
+bool ModStorageDatabaseBuffered::removeModEntry(const std::string &modname,
+		const std::string &key)
+{
+	ModEntries &mod = getMod(modname);
+	if (mod.entries.erase(key) == 0)
+		return false;
+	mod.dirty.insert(key);
+	return true;
+}
+
+bool ModStorageDatabaseBuffered::removeModEntries(const std::string &modname)
+{
+	ModEntries &mod = getMod(modname);
+	if (mod.entries.empty())
+		return false;
+	mod.entries.clear();
+	mod.dirty.clear();
+	mod.cleared = true;
+	return true;
+}
+
+void ModStorageDatabaseBuffered::listMods(std::vector<std::string> *res)
+{
+	std::vector<std::string> stored;
+	{
+		MutexAutoLock lock(m_backend_mutex);
+		m_backend->listMods(&stored);
+	}
+
+	// The cache is authoritative for every mod it holds
+	for (const std::string &modname : stored) {
+		auto it = m_mods.find(modname);
+		if (it == m_mods.end() || !it->second.entries.empty())
+			res->push_back(modname);
+	}
+	std::set<std::string> known(stored.begin(), stored.end());
+	for (const auto &it : m_mods) {
+		if (!it.second.entries.empty() && known.find(it.first) == known.end())
+			res->push_back(it.first);
+	}
+}
+
+void ModStorageDatabaseBuffered::endSave()
+{
+	WriteBatch batch;
+	for (auto &it : m_mods) {
+		ModEntries &mod = it.second;
+		if (mod.cleared) {
+			batch.cleared_mods.push_back(it.first);
+			// Everything still present was set after the clear
+			for (const auto &entry : mod.entries)
+				batch.changes.push_back({it.first, entry.first, entry.second, false});
+		} else {
+			for (const std::string &key : mod.dirty) {
+				auto entry = mod.entries.find(key);
+				if (entry == mod.entries.end())
+					batch.changes.push_back({it.first, key, "", true});
+				else
+					batch.changes.push_back({it.first, key, entry->second, false});
+			}
+		}
+		mod.dirty.clear();
+		mod.cleared = false;
+	}
+
+	if (batch.cleared_mods.empty() && batch.changes.empty())
+		return;
+
+	{
+		MutexAutoLock lock(m_queue_mutex);
+		if (m_queue.size() >= MOD_STORAGE_MAX_QUEUED)
+			mergeBatch(m_queue.back(), std::move(batch));
+		else
+			m_queue.push_back(std::move(batch));
+	}
+	if (m_thread)
+		m_thread->signal();
+}
+
+void ModStorageDatabaseBuffered::mergeBatch(WriteBatch &batch, WriteBatch &&later)
+{
+	// Clearing a mod discards the earlier changes to it
+	if (!later.cleared_mods.empty()) {
+		std::unordered_set<std::string> cleared(later.cleared_mods.begin(),
+			later.cleared_mods.end());
+		auto end = std::remove_if(batch.changes.begin(), batch.changes.end(),
+			[&] (const EntryChange &change) {
+				return cleared.count(change.modname) != 0;
+			});
+		batch.changes.erase(end, batch.changes.end());
+		for (std::string &modname : later.cleared_mods) {
+			if (std::find(batch.cleared_mods.begin(), batch.cleared_mods.end(),
+					modname) == batch.cleared_mods.end())
+				batch.cleared_mods.push_back(std::move(modname));
+		}
+	}
+
+	// A later change of the same key replaces the earlier one
+	std::map<std::pair<std::string, std::string>, size_t> index;
+	for (size_t i = 0; i < batch.changes.size(); i++)
+		index[{batch.changes[i].modname, batch.changes[i].key}] = i;
+	for (EntryChange &change : later.changes) {
+		auto it = index.find({change.modname, change.key});
+		if (it != index.end()) {
+			batch.changes[it->second] = std::move(change);
+		} else {
+			index[{change.modname, change.key}] = batch.changes.size();
+			batch.changes.push_back(std::move(change));
+		}
+	}
+}
+
+void ModStorageDatabaseBuffered::flushQueued()
+{
+	MutexAutoLock lock(m_backend_mutex);
+	while (true) {
+		WriteBatch batch;
+		{
+			MutexAutoLock queue_lock(m_queue_mutex);
+			if (m_queue.empty())
+				break;
+			batch = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+
+		try {
+			m_backend->beginSave();
+			for (const std::string &modname : batch.cleared_mods)
+				m_backend->removeModEntries(modname);
+			for (const EntryChange &change : batch.changes) {
+				if (change.removed)
+					m_backend->removeModEntry(change.modname, change.key);
+				else
+					m_backend->setModEntry(change.modname, change.key, change.value);
+			}
+			m_backend->endSave();
+		} catch (DatabaseException &e) {
+			errorstream << "ModStorageDatabaseBuffered: failed to write "
+				<< batch.changes.size() << " entries, retrying with the next "
+				"flush: " << e.what() << std::endl;
+			// Otherwise the backend would stay inside the failed transaction
+			try {
+				m_backend->abortSave();
+			} catch (DatabaseException &e2) {
+				errorstream << "ModStorageDatabaseBuffered: failed to abort "
+					"the transaction: " << e2.what() << std::endl;
+			}
+			// Applying a batch again has the same result, keep it in front
+			// of the newer ones
+			MutexAutoLock queue_lock(m_queue_mutex);
+			m_queue.push_front(std::move(batch));
+			break;
+		}
+	}
+}
@@ -0,0 +1,107 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "database.h"
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+class ModStorageFlushThread;
+
+/*
+	Write-back layer in front of another mod storage database.
+
+	The entries of a mod are read from the backend once and then served
+	from memory. Changed keys are remembered per mod, endSave() hands them
+	to a background thread which writes them to the backend in a single
+	transaction.
+*/
+class ModStorageDatabaseBuffered : public ModStorageDatabase
+{
+public:
+	// Takes ownership of the backend
+	ModStorageDatabaseBuffered(ModStorageDatabase *backend);
+	~ModStorageDatabaseBuffered();
+
+	void getModEntries(const std::string &modname, StringMap *storage);
+	void getModKeys(const std::string &modname, std::vector<std::string> *storage);
+	void getModKeysWithPrefix(const std::string &modname,
+		const std::string &prefix, std::vector<std::string> *storage);
+	bool getModEntry(const std::string &modname,
+		const std::string &key, std::string *value);
+	bool hasModEntry(const std::string &modname, const std::string &key);
+	bool setModEntry(const std::string &modname,
+		const std::string &key, const std::string &value);
+	bool removeModEntry(const std::string &modname, const std::string &key);
+	bool removeModEntries(const std::string &modname);
+	void listMods(std::vector<std::string> *res);
+
+	// Changes are buffered regardless of these
+	void beginSave() {}
+	// Queues the changes since the last call for writing
+	void endSave();
+
+	// Writes all queued changes, called by the flush thread
+	void flushQueued();
+
+private:
+	struct ModEntries
+	{
+		// Sorted for the prefix queries
+		std::map<std::string, std::string> entries;
+		// Keys changed since the last endSave()
+		std::set<std::string> dirty;
+		// All entries were removed since the last endSave()
+		bool cleared = false;
+	};
+
+	struct EntryChange
+	{
+		std::string modname;
+		std::string key;
+		std::string value;
+		bool removed;
+	};
+
+	struct WriteBatch
+	{
+		std::vector<std::string> cleared_mods;
+		std::vector<EntryChange> changes;
+	};
+
+	ModEntries &getMod(const std::string &modname);
+	// Appends the effect of a later batch to an earlier one
+	static void mergeBatch(WriteBatch &batch, WriteBatch &&later);
+
+	std::unique_ptr<ModStorageDatabase> m_backend;
+	// Held while accessing the backend
+	std::mutex m_backend_mutex;
+
+	std::unordered_map<std::string, ModEntries> m_mods;
+
+	std::mutex m_queue_mutex;
+	std::deque<WriteBatch> m_queue;
+
+	std::unique_ptr<ModStorageFlushThread> m_thread;
+};
@@ -45,7 +45,7 @@ void PlayerDatabaseFiles::deSerialize(RemotePlayer *p, std::istream &is,
 		throw SerializationError("PlayerArgsEnd of player " + playername + " not found!");
 	}
 
-	p->m_dirty = true;
+	p->setModified(true);
 	//args.getS32("version"); // Version field value not used
 	const std::string &name = args.get("name");
 	strlcpy(p->m_name, name.c_str(), PLAYERNAME_SIZE);
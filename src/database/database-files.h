@@ -39,16 +39,17 @@ class PlayerDatabaseFiles : public PlayerDatabase
 	bool removePlayer(const std::string &name);
 	void listPlayers(std::vector<std::string> &res);
 
-private:
-	void deSerialize(RemotePlayer *p, std::istream &is, const std::string &playername,
-			PlayerSAO *sao);
+	// Also used for the players section of world archives
+	static void deSerialize(RemotePlayer *p, std::istream &is,
+			const std::string &playername, PlayerSAO *sao);
 	/*
 		serialize() writes a bunch of text that can contain
 		any characters except a '\0', and such an ending that
 		deSerialize stops reading exactly at the right point.
 	*/
-	void serialize(RemotePlayer *p, std::ostream &os);
+	static void serialize(RemotePlayer *p, std::ostream &os);
 
+private:
 	std::string m_savedir;
 };
 
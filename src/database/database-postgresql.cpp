@@ -38,7 +38,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "settings.h"
 #include "remoteplayer.h"
 #include "server/player_sao.h"
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <unordered_map>
 
 Database_PostgreSQL::Database_PostgreSQL(const std::string &connect_string,
 	const char *type) :
@@ -223,6 +226,13 @@ void MapDatabasePostgreSQL::initStatements()
 	prepareStatement("delete_block", "DELETE FROM blocks WHERE "
 		"posX = $1::int4 AND posY = $2::int4 AND posZ = $3::int4");
 
+	if (getPGVersion() >= 90500) {
+		prepareStatement("read_blocks",
+			"SELECT posX, posY, posZ, data FROM blocks "
+				"WHERE (posX, posY, posZ) IN (SELECT * FROM "
+				"unnest($1::int4[], $2::int4[], $3::int4[]))");
+	}
+
 	prepareStatement("list_all_loadable_blocks",
 		"SELECT posX, posY, posZ FROM blocks");
 }
@@ -283,6 +293,119 @@ void MapDatabasePostgreSQL::loadBlock(const v3s32 &pos, std::string *block)
 	PQclear(results);
 }
 
+void MapDatabasePostgreSQL::loadBlocks(const std::vector<v3s32> &positions,
+		std::vector<std::string> &blocks)
+{
+	if (getPGVersion() < 90500) {
+		MapDatabase::loadBlocks(positions, blocks);
+		return;
+	}
+
+	blocks.clear();
+	blocks.resize(positions.size());
+	if (positions.empty())
+		return;
+
+	verifyDatabase();
+
+	// Coordinate arrays in text format, e.g. {1,-2,3}
+	std::string arrays[3];
+	for (std::string &array : arrays)
+		array = "{";
+	for (size_t i = 0; i < positions.size(); i++) {
+		const char *sep = i == 0 ? "" : ",";
+		arrays[0].append(sep).append(itos(positions[i].X));
+		arrays[1].append(sep).append(itos(positions[i].Y));
+		arrays[2].append(sep).append(itos(positions[i].Z));
+	}
+	for (std::string &array : arrays)
+		array += "}";
+
+	const char *args[] = {
+		arrays[0].c_str(), arrays[1].c_str(), arrays[2].c_str()
+	};
+
+	PGresult *results = execPrepared("read_blocks", ARRLEN(args), args, false);
+
+	std::unordered_map<v3s32, size_t> index;
+	index.reserve(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+		index[positions[i]] = i;
+
+	int numrows = PQntuples(results);
+	for (int row = 0; row < numrows; ++row) {
+		// Binary results, integers are in network byte order
+		s32 coords[3];
+		for (int col = 0; col < 3; col++) {
+			u32 v;
+			memcpy(&v, PQgetvalue(results, row, col), sizeof(v));
+			coords[col] = (s32)ntohl(v);
+		}
+
+		auto it = index.find(v3s32(coords[0], coords[1], coords[2]));
+		if (it != index.end())
+			blocks[it->second] = pg_to_string(results, row, 3);
+	}
+
+	PQclear(results);
+}
+
+bool MapDatabasePostgreSQL::saveBlocks(
+		const std::vector<std::pair<v3s32, std::string>> &blocks)
+{
+	if (getPGVersion() < 90500)
+		return MapDatabase::saveBlocks(blocks);
+
+	// Keeps the number of parameters far below the protocol limit of 65535
+	const size_t max_rows = 256;
+
+	for (const auto &block : blocks) {
+		if (block.second.size() > INT_MAX) {
+			errorstream << "Database_PostgreSQL::saveBlocks: Data truncation! "
+				<< "data.size() over 0xFFFFFFFF (== " << block.second.size()
+				<< ")" << std::endl;
+			return false;
+		}
+	}
+
+	verifyDatabase();
+
+	for (size_t start = 0; start < blocks.size(); start += max_rows) {
+		size_t count = std::min(max_rows, blocks.size() - start);
+
+		std::string sql = "INSERT INTO blocks (posX, posY, posZ, data) VALUES ";
+		std::vector<s32> coords(count * 3);
+		std::vector<const void *> args(count * 4);
+		std::vector<int> argLen(count * 4);
+		std::vector<int> argFmt(count * 4, 1);
+
+		for (size_t i = 0; i < count; i++) {
+			const auto &block = blocks[start + i];
+			coords[i * 3] = htonl(block.first.X);
+			coords[i * 3 + 1] = htonl(block.first.Y);
+			coords[i * 3 + 2] = htonl(block.first.Z);
+
+			for (size_t j = 0; j < 3; j++) {
+				args[i * 4 + j] = &coords[i * 3 + j];
+				argLen[i * 4 + j] = sizeof(s32);
+			}
+			args[i * 4 + 3] = block.second.c_str();
+			argLen[i * 4 + 3] = (int)block.second.size();
+
+			sql += std::string(i == 0 ? "" : ", ") +
+				"($" + itos(i * 4 + 1) + "::int4, $" + itos(i * 4 + 2) +
+				"::int4, $" + itos(i * 4 + 3) + "::int4, $" + itos(i * 4 + 4) +
+				"::bytea)";
+		}
+		sql += " ON CONFLICT ON CONSTRAINT blocks_pkey DO "
+			"UPDATE SET data = EXCLUDED.data";
+
+		execParams(sql, (int)args.size(), args.data(), argLen.data(),
+			argFmt.data());
+	}
+	return true;
+}
+
 bool MapDatabasePostgreSQL::deleteBlock(const v3s32 &pos)
 {
 	verifyDatabase();
@@ -461,6 +584,10 @@ void PlayerDatabasePostgreSQL::savePlayer(RemotePlayer *player)
 	if (!sao)
 		return;
 
+	u8 dirty = player->getDirtyFlags();
+	if (!dirty)
+		return;
+
 	verifyDatabase();
 
 	v3f pos = sao->getBasePosition();
@@ -481,69 +608,100 @@ void PlayerDatabasePostgreSQL::savePlayer(RemotePlayer *player)
 	};
 
 	const char* rmvalues[] = { player->getName() };
-	beginSave();
+	if (!m_in_batch)
+		beginSave();
 
 	if (getPGVersion() < 90500) {
-		if (!playerDataExists(player->getName()))
+		if (!playerDataExists(player->getName())) {
+			// Everything has to be written for a new player
+			dirty = PLAYER_DIRTY_ALL;
 			execPrepared("create_player", 8, values, true, false);
-		else
+		} else if (dirty & PLAYER_DIRTY_STATE) {
 			execPrepared("update_player", 8, values, true, false);
+		}
+	} else {
+		if (dirty != PLAYER_DIRTY_ALL && !playerDataExists(player->getName()))
+			dirty = PLAYER_DIRTY_ALL;
+		if (dirty & PLAYER_DIRTY_STATE)
+			execPrepared("save_player", 8, values, true, false);
 	}
-	else
-		execPrepared("save_player", 8, values, true, false);
 
 	// Write player inventories
-	execPrepared("remove_player_inventories", 1, rmvalues);
-	execPrepared("remove_player_inventory_items", 1, rmvalues);
-
-	const auto &inventory_lists = sao->getInventory()->getLists();
-	std::ostringstream oss;
-	for (u16 i = 0; i < inventory_lists.size(); i++) {
-		const InventoryList* list = inventory_lists[i];
-		const std::string &name = list->getName();
-		std::string width = itos(list->getWidth()),
-			inv_id = itos(i), lsize = itos(list->getSize());
-
-		const char* inv_values[] = {
-			player->getName(),
-			inv_id.c_str(),
-			width.c_str(),
-			name.c_str(),
-			lsize.c_str()
-		};
-		execPrepared("add_player_inventory", 5, inv_values);
-
-		for (u32 j = 0; j < list->getSize(); j++) {
-			oss.str("");
-			oss.clear();
-			list->getItem(j).serialize(oss);
-			std::string itemStr = oss.str(), slotId = itos(j);
-
-			const char* invitem_values[] = {
+	if (dirty & PLAYER_DIRTY_INVENTORY) {
+		execPrepared("remove_player_inventories", 1, rmvalues);
+		execPrepared("remove_player_inventory_items", 1, rmvalues);
+
+		const auto &inventory_lists = sao->getInventory()->getLists();
+		std::ostringstream oss;
+		for (u16 i = 0; i < inventory_lists.size(); i++) {
+			const InventoryList* list = inventory_lists[i];
+			const std::string &name = list->getName();
+			std::string width = itos(list->getWidth()),
+				inv_id = itos(i), lsize = itos(list->getSize());
+
+			const char* inv_values[] = {
 				player->getName(),
 				inv_id.c_str(),
-				slotId.c_str(),
-				itemStr.c_str()
+				width.c_str(),
+				name.c_str(),
+				lsize.c_str()
 			};
-			execPrepared("add_player_inventory_item", 4, invitem_values);
+			execPrepared("add_player_inventory", 5, inv_values);
+
+			for (u32 j = 0; j < list->getSize(); j++) {
+				const ItemStack &item = list->getItem(j);
+				// Empty slots are the default when loading
+				if (item.empty())
+					continue;
+
+				oss.str("");
+				oss.clear();
+				item.serialize(oss);
+				std::string itemStr = oss.str(), slotId = itos(j);
+
+				const char* invitem_values[] = {
+					player->getName(),
+					inv_id.c_str(),
+					slotId.c_str(),
+					itemStr.c_str()
+				};
+				execPrepared("add_player_inventory_item", 4, invitem_values);
+			}
 		}
 	}
 
-	execPrepared("remove_player_metadata", 1, rmvalues);
-	const StringMap &attrs = sao->getMeta().getStrings();
-	for (const auto &attr : attrs) {
-		const char *meta_values[] = {
-			player->getName(),
-			attr.first.c_str(),
-			attr.second.c_str()
-		};
-		execPrepared("save_player_metadata", 3, meta_values);
+	if (dirty & PLAYER_DIRTY_META) {
+		execPrepared("remove_player_metadata", 1, rmvalues);
+		const StringMap &attrs = sao->getMeta().getStrings();
+		for (const auto &attr : attrs) {
+			const char *meta_values[] = {
+				player->getName(),
+				attr.first.c_str(),
+				attr.second.c_str()
+			};
+			execPrepared("save_player_metadata", 3, meta_values);
+		}
 	}
-	endSave();
+
+	if (!m_in_batch)
+		endSave();
 
 	player->onSuccessfulSave();
 }
 
+void PlayerDatabasePostgreSQL::beginSaveBatch()
+{
+	verifyDatabase();
+	beginSave();
+	m_in_batch = true;
+}
+
+void PlayerDatabasePostgreSQL::endSaveBatch()
+{
+	m_in_batch = false;
+	endSave();
+}
+
 bool PlayerDatabasePostgreSQL::loadPlayer(RemotePlayer *player, PlayerSAO *sao)
 {
 	sanity_check(sao);
@@ -87,6 +87,16 @@ class Database_PostgreSQL: public Database
 			(const void **)params, NULL, NULL, clear, nobinary);
 	}
 
+	// For statements with a varying number of parameters
+	inline PGresult *execParams(const std::string &sql, const int paramsNumber,
+		const void **params, const int *paramsLengths, const int *paramsFormats,
+		bool clear = true, bool nobinary = true)
+	{
+		return checkResults(PQexecParams(m_conn, sql.c_str(), paramsNumber,
+			NULL, (const char* const*) params, paramsLengths, paramsFormats,
+			nobinary ? 1 : 0), clear);
+	}
+
 	void createTableIfNotExists(const std::string &table_name, const std::string &definition);
 	void verifyDatabase();
 
@@ -124,6 +134,9 @@ class MapDatabasePostgreSQL : private Database_PostgreSQL, public MapDatabase
 	void loadBlock(const v3s32 &pos, std::string *block);
 	bool deleteBlock(const v3s32 &pos);
 	void listAllLoadableBlocks(std::vector<v3s32> &dst);
+	void loadBlocks(const std::vector<v3s32> &positions,
+			std::vector<std::string> &blocks);
+	bool saveBlocks(const std::vector<std::pair<v3s32, std::string>> &blocks);
 
 	void beginSave() { Database_PostgreSQL::beginSave(); }
 	void endSave() { Database_PostgreSQL::endSave(); }
@@ -144,12 +157,17 @@ class PlayerDatabasePostgreSQL : private Database_PostgreSQL, public PlayerDatab
 	bool removePlayer(const std::string &name);
 	void listPlayers(std::vector<std::string> &res);
 
+	void beginSaveBatch();
+	void endSaveBatch();
+
 protected:
 	virtual void createDatabase();
 	virtual void initStatements();
 
 private:
 	bool playerDataExists(const std::string &playername);
+
+	bool m_in_batch = false;
 };
 
 class AuthDatabasePostgreSQL : private Database_PostgreSQL, public AuthDatabase
@@ -193,6 +211,7 @@ class ModStorageDatabasePostgreSQL : private Database_PostgreSQL, public ModStor
 
 	void beginSave() { Database_PostgreSQL::beginSave(); }
 	void endSave() { Database_PostgreSQL::endSave(); }
+	void abortSave() { Database_PostgreSQL::rollback(); }
 
 protected:
 	virtual void createDatabase();
@@ -154,6 +154,102 @@ void Database_Redis::loadBlock(const v3s32 &pos, std::string *block)
 		"Redis command 'HGET %s %s' gave invalid reply."));
 }
 
+void Database_Redis::loadBlocks(const std::vector<v3s32> &positions,
+		std::vector<std::string> &blocks)
+{
+	blocks.clear();
+	blocks.resize(positions.size());
+	if (positions.empty())
+		return;
+
+	// HMGET hash field...
+	std::vector<std::string> keys;
+	keys.reserve(positions.size());
+	for (const v3s32 &pos : positions)
+		keys.push_back(i64tos(getBlockAsInteger(pos)));
+
+	std::vector<const char *> argv;
+	std::vector<size_t> argvlen;
+	argv.reserve(keys.size() + 2);
+	argvlen.reserve(keys.size() + 2);
+	argv.push_back("HMGET");
+	argvlen.push_back(5);
+	argv.push_back(hash.c_str());
+	argvlen.push_back(hash.size());
+	for (const std::string &key : keys) {
+		argv.push_back(key.c_str());
+		argvlen.push_back(key.size());
+	}
+
+	redisReply *reply = static_cast<redisReply *>(redisCommandArgv(ctx,
+			argv.size(), argv.data(), argvlen.data()));
+	if (!reply) {
+		throw DatabaseException(std::string(
+			"Redis command 'HMGET %s ...' failed: ") + ctx->errstr);
+	}
+
+	if (reply->type == REDIS_REPLY_ERROR) {
+		std::string errstr(reply->str, reply->len);
+		freeReplyObject(reply);
+		throw DatabaseException(std::string(
+			"Redis command 'HMGET %s ...' errored: ") + errstr);
+	}
+
+	if (reply->type != REDIS_REPLY_ARRAY || reply->elements != positions.size()) {
+		freeReplyObject(reply);
+		throw DatabaseException(std::string(
+			"Redis command 'HMGET %s ...' gave invalid reply."));
+	}
+
+	for (size_t i = 0; i < reply->elements; i++) {
+		const redisReply *elem = reply->element[i];
+		if (elem->type == REDIS_REPLY_STRING)
+			blocks[i].assign(elem->str, elem->len);
+	}
+	freeReplyObject(reply);
+}
+
+bool Database_Redis::saveBlocks(const std::vector<std::pair<v3s32, std::string>> &blocks)
+{
+	// Pipeline the writes so that all of them take a single round trip
+	size_t appended = 0;
+	std::string append_error;
+	for (const auto &block : blocks) {
+		std::string tmp = i64tos(getBlockAsInteger(block.first));
+		if (redisAppendCommand(ctx, "HSET %s %s %b", hash.c_str(), tmp.c_str(),
+				block.second.c_str(), block.second.size()) != REDIS_OK) {
+			append_error = ctx->errstr;
+			break;
+		}
+		appended++;
+	}
+
+	// Read the reply of every appended command, so that none is left on
+	// the connection for the next command
+	bool success = true;
+	for (size_t i = 0; i < appended; i++) {
+		redisReply *reply = nullptr;
+		if (redisGetReply(ctx, (void **)&reply) != REDIS_OK || !reply) {
+			// hiredis refuses any further command on a broken connection
+			throw DatabaseException(std::string(
+				"Redis command 'HSET' failed: ") + ctx->errstr);
+		}
+
+		if (reply->type == REDIS_REPLY_ERROR) {
+			warningstream << "saveBlocks: saving block " << PP(blocks[i].first)
+				<< " failed: " << std::string(reply->str, reply->len) << std::endl;
+			success = false;
+		}
+		freeReplyObject(reply);
+	}
+
+	if (!append_error.empty()) {
+		throw DatabaseException(std::string(
+			"Redis command 'HSET' failed: ") + append_error);
+	}
+	return success;
+}
+
 bool Database_Redis::deleteBlock(const v3s32 &pos)
 {
 	std::string tmp = i64tos(getBlockAsInteger(pos));
@@ -41,6 +41,9 @@ class Database_Redis : public MapDatabase
 	bool saveBlock(const v3s32 &pos, const std::string &data);
 	void loadBlock(const v3s32 &pos, std::string *block);
 	bool deleteBlock(const v3s32 &pos);
+	void loadBlocks(const std::vector<v3s32> &positions,
+			std::vector<std::string> &blocks);
+	bool saveBlocks(const std::vector<std::pair<v3s32, std::string>> &blocks);
 	void listAllLoadableBlocks(std::vector<v3s32> &dst);
 
 private:
@@ -135,6 +135,15 @@ void Database_SQLite3::endSave()
 	sqlite3_reset(m_stmt_end);
 }
 
+void Database_SQLite3::rollback()
+{
+	// SQLite already rolls back by itself after some errors
+	if (!m_database || sqlite3_get_autocommit(m_database))
+		return;
+	SQLOK(sqlite3_exec(m_database, "ROLLBACK;", NULL, NULL, NULL),
+		"Failed to roll back SQLite3 transaction");
+}
+
 void Database_SQLite3::openDatabase()
 {
 	if (m_database) return;
@@ -437,10 +446,17 @@ void PlayerDatabaseSQLite3::savePlayer(RemotePlayer *player)
 	PlayerSAO* sao = player->getPlayerSAO();
 	sanity_check(sao);
 
+	u8 dirty = player->getDirtyFlags();
+	if (!dirty)
+		return;
+
 	const v3d &pos = sao->getBasePosition();
 	// Begin save in brace is mandatory
-	if (!playerDataExists(player->getName())) {
+	if (!m_in_batch)
 		beginSave();
+	if (!playerDataExists(player->getName())) {
+		// Everything has to be written for a new player
+		dirty = PLAYER_DIRTY_ALL;
 		str_to_sqlite(m_stmt_player_add, 1, player->getName());
 		double_to_sqlite(m_stmt_player_add, 2, sao->getLookPitch());
 		double_to_sqlite(m_stmt_player_add, 3, sao->getRotation().Y);
@@ -452,8 +468,7 @@ void PlayerDatabaseSQLite3::savePlayer(RemotePlayer *player)
 
 		sqlite3_vrfy(sqlite3_step(m_stmt_player_add), SQLITE_DONE);
 		sqlite3_reset(m_stmt_player_add);
-	} else {
-		beginSave();
+	} else if (dirty & PLAYER_DIRTY_STATE) {
 		double_to_sqlite(m_stmt_player_update, 1, sao->getLookPitch());
 		double_to_sqlite(m_stmt_player_update, 2, sao->getRotation().Y);
 		double_to_sqlite(m_stmt_player_update, 3, pos.X);
@@ -468,60 +483,82 @@ void PlayerDatabaseSQLite3::savePlayer(RemotePlayer *player)
 	}
 
 	// Write player inventories
-	str_to_sqlite(m_stmt_player_remove_inventory, 1, player->getName());
-	sqlite3_vrfy(sqlite3_step(m_stmt_player_remove_inventory), SQLITE_DONE);
-	sqlite3_reset(m_stmt_player_remove_inventory);
-
-	str_to_sqlite(m_stmt_player_remove_inventory_items, 1, player->getName());
-	sqlite3_vrfy(sqlite3_step(m_stmt_player_remove_inventory_items), SQLITE_DONE);
-	sqlite3_reset(m_stmt_player_remove_inventory_items);
-
-	const auto &inventory_lists = sao->getInventory()->getLists();
-	std::ostringstream oss;
-	for (u16 i = 0; i < inventory_lists.size(); i++) {
-		const InventoryList *list = inventory_lists[i];
-
-		str_to_sqlite(m_stmt_player_add_inventory, 1, player->getName());
-		int_to_sqlite(m_stmt_player_add_inventory, 2, i);
-		int_to_sqlite(m_stmt_player_add_inventory, 3, list->getWidth());
-		str_to_sqlite(m_stmt_player_add_inventory, 4, list->getName());
-		int_to_sqlite(m_stmt_player_add_inventory, 5, list->getSize());
-		sqlite3_vrfy(sqlite3_step(m_stmt_player_add_inventory), SQLITE_DONE);
-		sqlite3_reset(m_stmt_player_add_inventory);
-
-		for (u32 j = 0; j < list->getSize(); j++) {
-			oss.str("");
-			oss.clear();
-			list->getItem(j).serialize(oss);
-			std::string itemStr = oss.str();
-
-			str_to_sqlite(m_stmt_player_add_inventory_items, 1, player->getName());
-			int_to_sqlite(m_stmt_player_add_inventory_items, 2, i);
-			int_to_sqlite(m_stmt_player_add_inventory_items, 3, j);
-			str_to_sqlite(m_stmt_player_add_inventory_items, 4, itemStr);
-			sqlite3_vrfy(sqlite3_step(m_stmt_player_add_inventory_items), SQLITE_DONE);
-			sqlite3_reset(m_stmt_player_add_inventory_items);
+	if (dirty & PLAYER_DIRTY_INVENTORY) {
+		str_to_sqlite(m_stmt_player_remove_inventory, 1, player->getName());
+		sqlite3_vrfy(sqlite3_step(m_stmt_player_remove_inventory), SQLITE_DONE);
+		sqlite3_reset(m_stmt_player_remove_inventory);
+
+		str_to_sqlite(m_stmt_player_remove_inventory_items, 1, player->getName());
+		sqlite3_vrfy(sqlite3_step(m_stmt_player_remove_inventory_items), SQLITE_DONE);
+		sqlite3_reset(m_stmt_player_remove_inventory_items);
+
+		const auto &inventory_lists = sao->getInventory()->getLists();
+		std::ostringstream oss;
+		for (u16 i = 0; i < inventory_lists.size(); i++) {
+			const InventoryList *list = inventory_lists[i];
+
+			str_to_sqlite(m_stmt_player_add_inventory, 1, player->getName());
+			int_to_sqlite(m_stmt_player_add_inventory, 2, i);
+			int_to_sqlite(m_stmt_player_add_inventory, 3, list->getWidth());
+			str_to_sqlite(m_stmt_player_add_inventory, 4, list->getName());
+			int_to_sqlite(m_stmt_player_add_inventory, 5, list->getSize());
+			sqlite3_vrfy(sqlite3_step(m_stmt_player_add_inventory), SQLITE_DONE);
+			sqlite3_reset(m_stmt_player_add_inventory);
+
+			for (u32 j = 0; j < list->getSize(); j++) {
+				const ItemStack &item = list->getItem(j);
+				// Empty slots are the default when loading
+				if (item.empty())
+					continue;
+
+				oss.str("");
+				oss.clear();
+				item.serialize(oss);
+				std::string itemStr = oss.str();
+
+				str_to_sqlite(m_stmt_player_add_inventory_items, 1, player->getName());
+				int_to_sqlite(m_stmt_player_add_inventory_items, 2, i);
+				int_to_sqlite(m_stmt_player_add_inventory_items, 3, j);
+				str_to_sqlite(m_stmt_player_add_inventory_items, 4, itemStr);
+				sqlite3_vrfy(sqlite3_step(m_stmt_player_add_inventory_items), SQLITE_DONE);
+				sqlite3_reset(m_stmt_player_add_inventory_items);
+			}
 		}
 	}
 
-	str_to_sqlite(m_stmt_player_metadata_remove, 1, player->getName());
-	sqlite3_vrfy(sqlite3_step(m_stmt_player_metadata_remove), SQLITE_DONE);
-	sqlite3_reset(m_stmt_player_metadata_remove);
-
-	const StringMap &attrs = sao->getMeta().getStrings();
-	for (const auto &attr : attrs) {
-		str_to_sqlite(m_stmt_player_metadata_add, 1, player->getName());
-		str_to_sqlite(m_stmt_player_metadata_add, 2, attr.first);
-		str_to_sqlite(m_stmt_player_metadata_add, 3, attr.second);
-		sqlite3_vrfy(sqlite3_step(m_stmt_player_metadata_add), SQLITE_DONE);
-		sqlite3_reset(m_stmt_player_metadata_add);
+	if (dirty & PLAYER_DIRTY_META) {
+		str_to_sqlite(m_stmt_player_metadata_remove, 1, player->getName());
+		sqlite3_vrfy(sqlite3_step(m_stmt_player_metadata_remove), SQLITE_DONE);
+		sqlite3_reset(m_stmt_player_metadata_remove);
+
+		const StringMap &attrs = sao->getMeta().getStrings();
+		for (const auto &attr : attrs) {
+			str_to_sqlite(m_stmt_player_metadata_add, 1, player->getName());
+			str_to_sqlite(m_stmt_player_metadata_add, 2, attr.first);
+			str_to_sqlite(m_stmt_player_metadata_add, 3, attr.second);
+			sqlite3_vrfy(sqlite3_step(m_stmt_player_metadata_add), SQLITE_DONE);
+			sqlite3_reset(m_stmt_player_metadata_add);
+		}
 	}
 
-	endSave();
+	if (!m_in_batch)
+		endSave();
 
 	player->onSuccessfulSave();
 }
 
+void PlayerDatabaseSQLite3::beginSaveBatch()
+{
+	beginSave();
+	m_in_batch = true;
+}
+
+void PlayerDatabaseSQLite3::endSaveBatch()
+{
+	m_in_batch = false;
+	endSave();
+}
+
 bool PlayerDatabaseSQLite3::loadPlayer(RemotePlayer *player, PlayerSAO *sao)
 {
 	verifyDatabase();
@@ -35,6 +35,8 @@ class Database_SQLite3 : public Database
 
 	void beginSave();
 	void endSave();
+	// Rolls back the open transaction, if there is one
+	void rollback();
 
 	bool initialized() const { return m_initialized; }
 protected:
@@ -189,6 +191,9 @@ class PlayerDatabaseSQLite3 : private Database_SQLite3, public PlayerDatabase
 	bool removePlayer(const std::string &name);
 	void listPlayers(std::vector<std::string> &res);
 
+	void beginSaveBatch();
+	void endSaveBatch();
+
 protected:
 	virtual void createDatabase();
 	virtual void initStatements();
@@ -196,6 +201,8 @@ class PlayerDatabaseSQLite3 : private Database_SQLite3, public PlayerDatabase
 private:
 	bool playerDataExists(const std::string &name);
 
+	bool m_in_batch = false;
+
 	// Players
 	sqlite3_stmt *m_stmt_player_load = nullptr;
 	sqlite3_stmt *m_stmt_player_add = nullptr;
@@ -263,6 +270,7 @@ class ModStorageDatabaseSQLite3 : private Database_SQLite3, public ModStorageDat
 
 	virtual void beginSave() { Database_SQLite3::beginSave(); }
 	virtual void endSave() { Database_SQLite3::endSave(); }
+	virtual void abortSave() { Database_SQLite3::rollback(); }
 
 protected:
 	virtual void createDatabase();
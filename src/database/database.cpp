@@ -67,3 +67,29 @@ v3s32 MapDatabase::getIntegerAsBlock(s64 i)
 	return pos;
 }
 
+void MapDatabase::loadBlocks(const std::vector<v3s32> &positions,
+		std::vector<std::string> &blocks)
+{
+	blocks.resize(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+		loadBlock(positions[i], &blocks[i]);
+}
+
+bool MapDatabase::saveBlocks(const std::vector<std::pair<v3s32, std::string>> &blocks)
+{
+	bool success = true;
+	for (const auto &block : blocks)
+		success &= saveBlock(block.first, block.second);
+	return success;
+}
+
+void ModStorageDatabase::getModKeysWithPrefix(const std::string &modname,
+		const std::string &prefix, std::vector<std::string> *storage)
+{
+	std::vector<std::string> keys;
+	getModKeys(modname, &keys);
+	for (std::string &key : keys) {
+		if (str_starts_with(key, prefix))
+			storage->push_back(std::move(key));
+	}
+}
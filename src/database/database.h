@@ -21,6 +21,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 #include "irr_v3d.h"
 #include "irrlichttypes.h"
@@ -44,6 +45,14 @@ class MapDatabase : public Database
 	virtual void loadBlock(const v3s32 &pos, std::string *block) = 0;
 	virtual bool deleteBlock(const v3s32 &pos) = 0;
 
+	// Batched variants, backends with a network round trip per query
+	// override these. Positions must be unique within a batch.
+	// blocks[i] is the data of positions[i], empty if it does not exist.
+	virtual void loadBlocks(const std::vector<v3s32> &positions,
+			std::vector<std::string> &blocks);
+	// Returns false if any of the blocks could not be saved
+	virtual bool saveBlocks(const std::vector<std::pair<v3s32, std::string>> &blocks);
+
 	static s64 getBlockAsInteger(const v3s32 &pos);
 	static v3s32 getIntegerAsBlock(s64 i);
 
@@ -58,8 +67,13 @@ class PlayerDatabase
 public:
 	virtual ~PlayerDatabase() = default;
 
+	// Saves the parts of the player data that are marked as dirty
 	virtual void savePlayer(RemotePlayer *player) = 0;
 	virtual bool loadPlayer(RemotePlayer *player, PlayerSAO *sao) = 0;
+
+	// Calls to savePlayer() between these are written in a single transaction
+	virtual void beginSaveBatch() {}
+	virtual void endSaveBatch() {}
 	virtual bool removePlayer(const std::string &name) = 0;
 	virtual void listPlayers(std::vector<std::string> &res) = 0;
 };
@@ -93,6 +107,9 @@ class ModStorageDatabase : public Database
 
 	virtual void getModEntries(const std::string &modname, StringMap *storage) = 0;
 	virtual void getModKeys(const std::string &modname, std::vector<std::string> *storage) = 0;
+	// Keys starting with prefix, the default implementation filters getModKeys()
+	virtual void getModKeysWithPrefix(const std::string &modname,
+		const std::string &prefix, std::vector<std::string> *storage);
 	virtual bool hasModEntry(const std::string &modname, const std::string &key) = 0;
 	virtual bool getModEntry(const std::string &modname,
 		const std::string &key, std::string *value) = 0;
@@ -101,4 +118,8 @@ class ModStorageDatabase : public Database
 	virtual bool removeModEntry(const std::string &modname, const std::string &key) = 0;
 	virtual bool removeModEntries(const std::string &modname) = 0;
 	virtual void listMods(std::vector<std::string> *res) = 0;
+
+	// Discards the changes since beginSave() after one of them failed,
+	// so that beginSave() can be called again
+	virtual void abortSave() {}
 };
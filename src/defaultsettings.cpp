@@ -62,6 +62,7 @@ void set_default_settings()
 	settings->setDefault("curl_file_download_timeout", "300000");
 	settings->setDefault("curl_verify_cert", "true");
 	settings->setDefault("enable_remote_media_server", "true");
+	settings->setDefault("media_cache_size", "1024");
 	settings->setDefault("enable_client_modding", "false");
 	settings->setDefault("max_out_chat_queue_size", "20");
 	settings->setDefault("pause_on_lost_focus", "false");
@@ -414,7 +415,12 @@ void set_default_settings()
 	settings->setDefault("world_start_time", "6125");
 	settings->setDefault("server_unload_unused_data_timeout", "29");
 	settings->setDefault("max_objects_per_block", "256");
+	settings->setDefault("object_activation_range", "8");
+	settings->setDefault("object_activation_limit", "64");
 	settings->setDefault("server_map_save_interval", "5.3");
+	settings->setDefault("map_journal", "false");
+	settings->setDefault("map_journal_checkpoint_interval", "10.0");
+	settings->setDefault("map_journal_checkpoint_blocks", "32");
 	settings->setDefault("chat_message_max_size", "500");
 	settings->setDefault("chat_message_limit_per_10sec", "8.0");
 	settings->setDefault("chat_message_limit_trigger_kick", "50");
@@ -0,0 +1,39 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "environment.h"
+
+// Environment without objects around an existing map
+class DummyEnvironment : public Environment
+{
+public:
+	DummyEnvironment(IGameDef *gamedef, Map *map) :
+		Environment(gamedef), m_map(map)
+	{}
+
+	void step(f32 dtime) override {}
+	Map &getMap() override { return *m_map; }
+	void getSelectedActiveObjects(const core::line3d<f32> &shootline_on_map,
+			std::vector<PointedThing> &objects) override {}
+
+private:
+	Map *m_map;
+};
@@ -22,7 +22,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "emerge.h"
 
 #include <iostream>
-#include <queue>
+#include <deque>
+#include <unordered_set>
 
 #include "util/container.h"
 #include "util/thread.h"
@@ -74,9 +75,14 @@ class EmergeThread : public Thread {
 	Mapgen *m_mapgen;
 
 	Event m_queue_event;
-	std::queue<v3s32> m_block_queue;
+	std::deque<v3s32> m_block_queue;
+	// Blocks that were loaded along with the last block loaded from disk.
+	// Only the latest batch is kept, entries for blocks that were unloaded
+	// or dropped from the queue meanwhile don't pile up.
+	std::unordered_set<v3s32> m_prefetched;
 
 	bool popBlockEmerge(v3s32 *pos, BlockEmergeData *bedata);
+	void peekBlockEmerges(std::vector<v3s32> &dst, size_t max);
 
 	EmergeAction getBlockOrStartGen(
 		const v3s32 &pos, bool allow_gen, MapBlock **block, BlockMakeData *data);
@@ -533,7 +539,7 @@ void EmergeThread::signal()
 
 bool EmergeThread::pushBlock(const v3s32 &pos)
 {
-	m_block_queue.push(pos);
+	m_block_queue.push_back(pos);
 	return true;
 }
 
@@ -547,12 +553,13 @@ void EmergeThread::cancelPendingItems()
 		v3s32 pos;
 
 		pos = m_block_queue.front();
-		m_block_queue.pop();
+		m_block_queue.pop_front();
 
 		m_emerge->popBlockEmergeData(pos, &bedata);
 
 		runCompletionCallbacks(pos, EMERGE_CANCELLED, bedata.callbacks);
 	}
+	m_prefetched.clear();
 }
 
 
@@ -581,7 +588,7 @@ bool EmergeThread::popBlockEmerge(v3s32 *pos, BlockEmergeData *bedata)
 		return false;
 
 	*pos = m_block_queue.front();
-	m_block_queue.pop();
+	m_block_queue.pop_front();
 
 	m_emerge->popBlockEmergeData(*pos, bedata);
 
@@ -589,19 +596,43 @@ bool EmergeThread::popBlockEmerge(v3s32 *pos, BlockEmergeData *bedata)
 }
 
 
+void EmergeThread::peekBlockEmerges(std::vector<v3s32> &dst, size_t max)
+{
+	MutexAutoLock queuelock(m_emerge->m_queue_mutex);
+
+	for (size_t i = 0; i < m_block_queue.size() && i < max; i++)
+		dst.push_back(m_block_queue[i]);
+}
+
+
 EmergeAction EmergeThread::getBlockOrStartGen(
 	const v3s32 &pos, bool allow_gen, MapBlock **block, BlockMakeData *bmdata)
 {
+	// Blocks queued after this one are loaded along with it, which saves
+	// round trips to networked database backends
+	std::vector<v3s32> batch;
+	batch.push_back(pos);
+	peekBlockEmerges(batch, EMERGE_LOAD_BATCH_SIZE - 1);
+
 	MutexAutoLock envlock(m_server->m_env_mutex);
 
 	// 1). Attempt to fetch block from memory
 	*block = m_map->getBlockNoCreateNoEx(pos);
 	if (*block) {
+		bool prefetched = m_prefetched.erase(pos) > 0;
 		if ((*block)->isGenerated())
-			return EMERGE_FROM_MEMORY;
+			return prefetched ? EMERGE_FROM_DISK : EMERGE_FROM_MEMORY;
 	} else {
 		// 2). Attempt to load block from disk if it was not in the memory
-		*block = m_map->loadBlock(pos);
+		std::vector<v3s32> loaded;
+		m_map->loadBlocks(batch, &loaded);
+		m_prefetched.clear();
+		for (v3s32 p : loaded) {
+			if (p != pos)
+				m_prefetched.insert(p);
+		}
+
+		*block = m_map->getBlockNoCreateNoEx(pos);
 		if (*block && (*block)->isGenerated())
 			return EMERGE_FROM_DISK;
 	}
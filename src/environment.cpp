@@ -17,10 +17,17 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <memory>
+#include <unordered_map>
 #include "environment.h"
 #include "collision.h"
+#include "debug.h"
+#include "mapblock.h"
 #include "raycast.h"
+#include "threading/thread.h"
 #include "scripting_server.h"
 #include "server.h"
 #include "daynightratio.h"
@@ -101,6 +108,228 @@ bool Environment::line_of_sight(v3f pos1, v3f pos2, v3s32 *p)
 	return true;
 }
 
+// Batches of at least this many lines are split among worker threads
+#define LINE_OF_SIGHT_BULK_THREADED_MIN 256
+#define LINE_OF_SIGHT_BULK_MAX_THREADS 4
+
+namespace {
+
+struct LineOfSightBlock
+{
+	// nullptr if the block is not loaded
+	MapBlock *block;
+	bool air_only;
+};
+
+typedef std::unordered_map<v3s32, LineOfSightBlock> LineOfSightBlockMap;
+
+inline v3f toVoxelPos(const v3f &pos)
+{
+	return pos / BS;
+}
+
+/*
+	Walks the blocks crossed by a line with a 3D DDA. A node at position n
+	covers [n - 0.5, n + 0.5), so blocks are cells of MAP_BLOCKSIZE nodes
+	shifted by half a node.
+*/
+void collectLineBlocks(const v3f &start, const v3f &end, std::vector<v3s32> &blocks)
+{
+	v3f a = (start + v3f(0.5f, 0.5f, 0.5f)) / MAP_BLOCKSIZE;
+	v3f b = (end + v3f(0.5f, 0.5f, 0.5f)) / MAP_BLOCKSIZE;
+	const f32 origin[3] = {a.X, a.Y, a.Z};
+	const f32 dir[3] = {b.X - a.X, b.Y - a.Y, b.Z - a.Z};
+	s32 cell[3] = {(s32)std::floor(a.X), (s32)std::floor(a.Y), (s32)std::floor(a.Z)};
+	v3s32 last(std::floor(b.X), std::floor(b.Y), std::floor(b.Z));
+
+	s32 step[3];
+	f32 t_max[3], t_delta[3];
+	for (int i = 0; i < 3; i++) {
+		if (dir[i] > 0.0f) {
+			step[i] = 1;
+			t_max[i] = (cell[i] + 1 - origin[i]) / dir[i];
+			t_delta[i] = 1.0f / dir[i];
+		} else if (dir[i] < 0.0f) {
+			step[i] = -1;
+			t_max[i] = (cell[i] - origin[i]) / dir[i];
+			t_delta[i] = -1.0f / dir[i];
+		} else {
+			step[i] = 0;
+			t_max[i] = t_delta[i] = INFINITY;
+		}
+	}
+
+	blocks.emplace_back(cell[0], cell[1], cell[2]);
+	s32 remaining = std::abs(last.X - cell[0]) + std::abs(last.Y - cell[1]) +
+			std::abs(last.Z - cell[2]);
+	for (; remaining > 0; remaining--) {
+		int axis = 0;
+		if (t_max[1] < t_max[axis])
+			axis = 1;
+		if (t_max[2] < t_max[axis])
+			axis = 2;
+		if (step[axis] == 0)
+			break;
+		cell[axis] += step[axis];
+		t_max[axis] += t_delta[axis];
+		blocks.emplace_back(cell[0], cell[1], cell[2]);
+	}
+}
+
+/*
+	Same as Environment::line_of_sight(), but only reads the blocks that
+	were collected beforehand so that it can run on any thread.
+	Returns false if the line reached a block that was not collected.
+*/
+bool lineOfSightInBlocks(const core::line3d<f32> &line,
+		const LineOfSightBlockMap &blocks, Environment::LineOfSightResult &result)
+{
+	v3f start = toVoxelPos(line.start);
+	voxalgo::VoxelLineIterator iterator(start, toVoxelPos(line.end) - start);
+
+	v3s32 blockpos;
+	const LineOfSightBlock *current = nullptr;
+	do {
+		const v3s32 &p = iterator.m_current_node_pos;
+		v3s32 p_blockpos = getContainerPos(p, MAP_BLOCKSIZE);
+		if (!current || p_blockpos != blockpos) {
+			auto it = blocks.find(p_blockpos);
+			if (it == blocks.end())
+				return false;
+			current = &it->second;
+			blockpos = p_blockpos;
+		}
+
+		if (!current->air_only) {
+			// Unloaded blocks read as ignore
+			if (!current->block || current->block->getNodeNoCheck(
+					p - blockpos * MAP_BLOCKSIZE).getContent() != CONTENT_AIR) {
+				result.clear = false;
+				result.node_pos = p;
+				return true;
+			}
+		}
+		iterator.next();
+	} while (iterator.m_current_index <= iterator.m_last_index);
+
+	result.clear = true;
+	return true;
+}
+
+class LineOfSightThread : public Thread
+{
+public:
+	LineOfSightThread(const std::vector<core::line3d<f32>> &lines,
+			const std::vector<u32> &order, size_t begin, size_t end,
+			const LineOfSightBlockMap &blocks,
+			std::vector<Environment::LineOfSightResult> &results,
+			std::vector<u8> &incomplete) :
+		Thread("LineOfSight"),
+		m_lines(lines), m_order(order), m_begin(begin), m_end(end),
+		m_blocks(blocks), m_results(results), m_incomplete(incomplete)
+	{}
+
+	void *run()
+	{
+		BEGIN_DEBUG_EXCEPTION_HANDLER
+
+		for (size_t i = m_begin; i < m_end; i++) {
+			u32 index = m_order[i];
+			if (!lineOfSightInBlocks(m_lines[index], m_blocks, m_results[index]))
+				m_incomplete[index] = 1;
+		}
+
+		END_DEBUG_EXCEPTION_HANDLER
+
+		return nullptr;
+	}
+
+private:
+	const std::vector<core::line3d<f32>> &m_lines;
+	const std::vector<u32> &m_order;
+	size_t m_begin, m_end;
+	const LineOfSightBlockMap &m_blocks;
+	std::vector<Environment::LineOfSightResult> &m_results;
+	std::vector<u8> &m_incomplete;
+};
+
+}
+
+void Environment::lineOfSightBulk(const std::vector<core::line3d<f32>> &lines,
+		std::vector<LineOfSightResult> &results)
+{
+	results.clear();
+	results.resize(lines.size());
+
+	// Group the lines by their starting block
+	std::vector<u32> order(lines.size());
+	std::vector<v3s32> start_blocks(lines.size());
+	for (u32 i = 0; i < lines.size(); i++) {
+		order[i] = i;
+		start_blocks[i] = getContainerPos(
+				floatToInt(lines[i].start, BS), MAP_BLOCKSIZE);
+	}
+	std::sort(order.begin(), order.end(), [&] (u32 a, u32 b) {
+		const v3s32 &pa = start_blocks[a], &pb = start_blocks[b];
+		if (pa.Z != pb.Z)
+			return pa.Z < pb.Z;
+		if (pa.Y != pb.Y)
+			return pa.Y < pb.Y;
+		return pa.X < pb.X;
+	});
+
+	// Look up the blocks and their summaries on this thread, the map
+	// and the summaries are not safe to access from the workers
+	Map &map = getMap();
+	LineOfSightBlockMap blocks;
+	std::vector<v3s32> line_blocks;
+	for (u32 index : order) {
+		line_blocks.clear();
+		collectLineBlocks(toVoxelPos(lines[index].start),
+				toVoxelPos(lines[index].end), line_blocks);
+		for (const v3s32 &blockpos : line_blocks) {
+			if (blocks.find(blockpos) != blocks.end())
+				continue;
+			MapBlock *block = map.getBlockNoCreateNoEx(blockpos);
+			blocks[blockpos] = {block, block && block->isAirOnly()};
+		}
+	}
+
+	std::vector<u8> incomplete(lines.size(), 0);
+	size_t num_threads = 1;
+	if (lines.size() >= LINE_OF_SIGHT_BULK_THREADED_MIN) {
+		num_threads = std::min<size_t>(LINE_OF_SIGHT_BULK_MAX_THREADS,
+				std::max(1U, Thread::getNumberOfProcessors()));
+	}
+
+	if (num_threads > 1) {
+		std::vector<std::unique_ptr<LineOfSightThread>> threads;
+		size_t chunk = (order.size() + num_threads - 1) / num_threads;
+		for (size_t begin = 0; begin < order.size(); begin += chunk) {
+			threads.emplace_back(new LineOfSightThread(lines, order, begin,
+					std::min(begin + chunk, order.size()), blocks, results,
+					incomplete));
+			threads.back()->start();
+		}
+		for (auto &thread : threads)
+			thread->wait();
+	} else {
+		for (u32 index : order) {
+			if (!lineOfSightInBlocks(lines[index], blocks, results[index]))
+				incomplete[index] = 1;
+		}
+	}
+
+	// The block walk can disagree with the node walk in corner cases,
+	// check those lines the slow way
+	for (u32 i = 0; i < lines.size(); i++) {
+		if (!incomplete[i])
+			continue;
+		results[i].clear = line_of_sight(lines[i].start, lines[i].end,
+				&results[i].node_pos);
+	}
+}
+
 /*
 	Check if a node is pointable
 */
@@ -86,6 +86,24 @@ class Environment
 	 */
 	bool line_of_sight(v3f pos1, v3f pos2, v3s32 *p = nullptr);
 
+	struct LineOfSightResult
+	{
+		bool clear = true;
+		// Position of the first non-air node, if not clear
+		v3s32 node_pos;
+	};
+
+	/*!
+	 * Same as line_of_sight() for many lines at once.
+	 * Lines are grouped by the block they start in and blocks
+	 * that only contain air are skipped without reading their nodes.
+	 * Large batches are split among worker threads.
+	 * \param lines lines in world coordinates
+	 * \param results output, one entry per line
+	 */
+	void lineOfSightBulk(const std::vector<core::line3d<f32>> &lines,
+			std::vector<LineOfSightResult> &results);
+
 	/*!
 	 * Gets the objects pointed by the shootline as
 	 * pointed things.
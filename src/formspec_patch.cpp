@@ -0,0 +1,117 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "formspec_patch.h"
+#include "log.h"
+
+std::vector<std::string> splitFormspec(const std::string &formspec)
+{
+	// Same splitting as GUIFormSpecMenu::regenerateGui
+	return split(formspec, ']');
+}
+
+std::string joinFormspec(const std::vector<std::string> &elements)
+{
+	return str_join(elements, "]");
+}
+
+std::string getFormspecElementType(const std::string &element)
+{
+	size_t pos = element.find('[');
+	if (pos == std::string::npos)
+		return "";
+	return trim(element.substr(0, pos));
+}
+
+std::string getFormspecElementName(const std::string &element)
+{
+	size_t pos = element.find('[');
+	if (pos == std::string::npos)
+		return "";
+
+	const std::string type = trim(element.substr(0, pos));
+	const std::vector<std::string> parts = split(element.substr(pos + 1), ';');
+
+	size_t index;
+	if (type == "checkbox") {
+		index = 1;
+	} else if (type == "field") {
+		// field[name;label;default] or field[pos;size;name;label;default]
+		index = parts.size() <= 4 ? 0 : 2;
+	} else if (type == "pwdfield" || type == "textarea" || type == "button" ||
+			type == "button_exit" || type == "dropdown" || type == "textlist" ||
+			type == "table" || type == "hypertext" || type == "model" ||
+			type == "animated_image") {
+		index = 2;
+	} else if (type == "image_button" || type == "image_button_exit" ||
+			type == "item_image_button" || type == "scrollbar") {
+		index = 3;
+	} else {
+		return "";
+	}
+
+	if (index >= parts.size())
+		return "";
+	return parts[index];
+}
+
+FormspecPatch patchFormspecElements(std::vector<std::string> &elements,
+		const StringMap &patches)
+{
+	FormspecPatch patch;
+	if (patches.empty())
+		return patch;
+
+	for (size_t i = 0; i < elements.size(); i++) {
+		const std::string name = getFormspecElementName(elements[i]);
+		if (name.empty())
+			continue;
+		auto it = patches.find(name);
+		if (it == patches.end())
+			continue;
+
+		std::vector<std::string> replacement = splitFormspec(it->second);
+		// "elem[...]" splits into the element and an empty remainder
+		if (replacement.size() == 2 && replacement[1].empty())
+			replacement.pop_back();
+		if (replacement.size() != 1) {
+			warningstream << "Formspec patch for \"" << name
+				<< "\" is not a single element, skipping" << std::endl;
+			continue;
+		}
+
+		if (replacement[0] == elements[i])
+			continue;
+		elements[i] = replacement[0];
+		patch.emplace_back((u32)i, elements[i]);
+	}
+	return patch;
+}
+
+bool applyFormspecPatch(std::vector<std::string> &elements,
+		const FormspecPatch &patch)
+{
+	for (const auto &change : patch) {
+		if (change.first >= elements.size())
+			return false;
+	}
+	for (const auto &change : patch)
+		elements[change.first] = change.second;
+	return true;
+}
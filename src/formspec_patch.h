@@ -0,0 +1,66 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include "util/string.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+	Formspec patches replace single elements of a formspec that is already
+	shown, so live UIs don't have to re-send (and the client re-parse) the
+	whole formspec on every change.
+
+	Elements are addressed by their index in the list produced by
+	splitFormspec(). Replacing an element with an empty string removes it
+	without shifting the indices of the elements after it.
+*/
+
+typedef std::vector<std::pair<u32, std::string>> FormspecPatch;
+
+// Splits a formspec into its elements, without the closing ']'.
+// Joining them again with ']' gives back the formspec.
+std::vector<std::string> splitFormspec(const std::string &formspec);
+
+std::string joinFormspec(const std::vector<std::string> &elements);
+
+// Returns the element type, e.g. "button", without surrounding whitespace
+std::string getFormspecElementType(const std::string &element);
+
+// Returns the name of an element, or an empty string if the element
+// type has no name or the element is malformed
+std::string getFormspecElementName(const std::string &element);
+
+/*
+	Replaces every element whose name is a key of 'patches' by the
+	corresponding value. The values are complete elements, the closing ']'
+	is optional. Replacements that would not form exactly one element
+	are skipped.
+	Returns the elements that changed.
+*/
+FormspecPatch patchFormspecElements(std::vector<std::string> &elements,
+		const StringMap &patches);
+
+// Applies a patch made by patchFormspecElements, returns false if it
+// doesn't fit the elements
+bool applyFormspecPatch(std::vector<std::string> &elements,
+		const FormspecPatch &patch);
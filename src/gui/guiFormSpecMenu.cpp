@@ -3019,6 +3019,111 @@ void GUIFormSpecMenu::parseElement(parserData* data, const std::string &element)
 			<< std::endl;
 }
 
+bool GUIFormSpecMenu::patchFormSpec(const std::string &formname,
+		const FormspecPatch &patch)
+{
+	// Only formspecs shown by the server are patched
+	auto *fs_src = dynamic_cast<FormspecFormSource *>(m_form_src);
+	if (!fs_src || !m_text_dst || m_text_dst->m_formname != formname)
+		return false;
+
+	const std::vector<std::string> old_elements = splitFormspec(fs_src->getForm());
+	std::vector<std::string> elements = old_elements;
+	if (!applyFormspecPatch(elements, patch))
+		return false;
+
+	// A pending regeneration rebuilds everything anyway
+	bool in_place = m_is_form_regenerated && fs_src->getForm() == m_formspec_string;
+	for (const auto &change : patch) {
+		if (!in_place)
+			break;
+		in_place = patchElementInPlace(old_elements[change.first],
+				elements[change.first]);
+	}
+
+	m_formspec_string = joinFormspec(elements);
+	fs_src->setForm(m_formspec_string);
+	if (!in_place) {
+		m_is_form_regenerated = false;
+		regenerateGui(m_screensize_old);
+	}
+	return true;
+}
+
+bool GUIFormSpecMenu::patchElementInPlace(const std::string &old_element,
+		const std::string &new_element)
+{
+	const std::string type = getFormspecElementType(new_element);
+	if (type.empty() || type != getFormspecElementType(old_element))
+		return false;
+
+	const std::string name = getFormspecElementName(new_element);
+	if (name.empty() || name != getFormspecElementName(old_element))
+		return false;
+
+	size_t count = 0;
+	for (const FieldSpec &field : m_fields) {
+		if (field.fname == name)
+			count++;
+	}
+	if (count != 1)
+		return false;
+
+	// The only argument that may change
+	size_t value_index;
+	if (type == "button" || type == "button_exit" || type == "checkbox")
+		value_index = 3;
+	else if (type == "scrollbar")
+		value_index = 4;
+	else
+		return false;
+
+	std::vector<std::string> old_parts =
+			split(old_element.substr(old_element.find('[') + 1), ';');
+	std::vector<std::string> new_parts =
+			split(new_element.substr(new_element.find('[') + 1), ';');
+	if (new_parts.size() != old_parts.size() || value_index >= new_parts.size())
+		return false;
+	for (size_t i = 0; i < new_parts.size(); i++) {
+		if (i != value_index && new_parts[i] != old_parts[i])
+			return false;
+	}
+	const std::string &value = new_parts[value_index];
+
+	if (type == "checkbox") {
+		for (auto &checkbox : m_checkboxes) {
+			if (checkbox.first.fname == name) {
+				checkbox.second->setChecked(value == "true");
+				return true;
+			}
+		}
+		return false;
+	}
+
+	if (type == "scrollbar") {
+		for (auto &scrollbar : m_scrollbars) {
+			if (scrollbar.first.fname == name) {
+				scrollbar.second->setPos(stoi(value));
+				return true;
+			}
+		}
+		return false;
+	}
+
+	for (FieldSpec &field : m_fields) {
+		if (field.fname != name || field.ftype != f_Button)
+			continue;
+
+		IGUIElement *element = getElementFromId(field.fid, true);
+		if (!element)
+			return false;
+		field.flabel = translate_string(utf8_to_wide(unescape_string(value)));
+		element->setText(field.flabel.c_str());
+		return true;
+	}
+	return false;
+}
+
 void GUIFormSpecMenu::regenerateGui(v2u32 screensize)
 {
 	// Useless to regenerate without a screensize
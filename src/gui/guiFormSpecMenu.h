@@ -31,6 +31,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "guiScrollBar.h"
 #include "guiTable.h"
 #include "network/networkprotocol.h"
+#include "formspec_patch.h"
 #include "client/joystick_controller.h"
 #include "util/Optional.h"
 #include "util/string.h"
@@ -178,6 +179,14 @@ class GUIFormSpecMenu : public GUIModalMenu
 		regenerateGui(m_screensize_old);
 	}
 
+	/*
+		Applies a patch from the server to the shown formspec 'formname'.
+		Button labels, checkbox states and scrollbar positions are updated
+		in place, any other change regenerates the GUI.
+		Returns false if the patch doesn't fit the shown formspec.
+	*/
+	bool patchFormSpec(const std::string &formname, const FormspecPatch &patch);
+
 	const InventoryLocation &getFormspecLocation()
 	{
 		return m_current_inventory_location;
@@ -283,6 +292,8 @@ class GUIFormSpecMenu : public GUIModalMenu
 	v2s32 getRealCoordinateGeometry(const std::vector<std::string> &v_geom);
 	bool precheckElement(const std::string &name, const std::string &element,
 		size_t args_min, size_t args_max, std::vector<std::string> &parts);
+	bool patchElementInPlace(const std::string &old_element,
+		const std::string &new_element);
 
 	std::unordered_map<std::string, std::vector<StyleSpec>> theme_by_type;
 	std::unordered_map<std::string, std::vector<StyleSpec>> theme_by_name;
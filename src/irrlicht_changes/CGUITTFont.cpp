@@ -30,7 +30,13 @@
 */
 
 #include <irrlicht.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "CGUITTFont.h"
 
 namespace irr
@@ -41,7 +47,7 @@ namespace gui
 // Manages the FT_Face cache.
 struct SGUITTFace : public virtual irr::IReferenceCounted
 {
-	SGUITTFace() : face_buffer(0), face_buffer_size(0)
+	SGUITTFace()
 	{
 		memset((void*)&face, 0, sizeof(FT_Face));
 	}
@@ -49,18 +55,227 @@ struct SGUITTFace : public virtual irr::IReferenceCounted
 	~SGUITTFace()
 	{
 		FT_Done_Face(face);
-		delete[] face_buffer;
 	}
 
 	FT_Face face;
-	FT_Byte* face_buffer;
-	FT_Long face_buffer_size;
+	// Shared with the background rasterizer, which opens its own face from it.
+	std::shared_ptr<std::vector<FT_Byte>> face_buffer;
+};
+
+// Rasterizes glyphs on a background thread.
+// FT_Face objects must not be used by several threads at once, so the thread
+// has its own FreeType library and opens its own faces.
+class CGUITTGlyphRasterizer
+{
+public:
+	CGUITTGlyphRasterizer() : stop_requested(false), thread(&CGUITTGlyphRasterizer::run, this) {}
+
+	~CGUITTGlyphRasterizer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop_requested = true;
+		}
+		jobs_changed.notify_one();
+		thread.join();
+	}
+
+	//! Queue glyphs to rasterize.  buffer may be null if the face was loaded from the file directly.
+	void queue(const io::path& filename, const std::shared_ptr<std::vector<FT_Byte>>& buffer,
+		u32 font_size, FT_Int32 load_flags, std::vector<u32>&& char_indices)
+	{
+		SJob job;
+		job.filename = filename;
+		job.buffer = buffer;
+		job.font_size = font_size;
+		job.load_flags = load_flags;
+		job.char_indices = std::move(char_indices);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back(std::move(job));
+		}
+		jobs_changed.notify_one();
+	}
+
+	//! Drop the queued and finished glyphs of a font that are not taken yet.
+	void discard(const io::path& filename, u32 font_size, FT_Int32 load_flags)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto it = jobs.begin(); it != jobs.end();)
+		{
+			if (it->filename == filename && it->font_size == font_size && it->load_flags == load_flags)
+				it = jobs.erase(it);
+			else
+				++it;
+		}
+		if (active && active->filename == filename && active->font_size == font_size &&
+				active->load_flags == load_flags)
+			active_discarded = true;
+		for (auto it = results.begin(); it != results.end();)
+		{
+			const SKey& key = it->first;
+			if (key.filename == filename && key.font_size == font_size && key.load_flags == load_flags)
+				it = results.erase(it);
+			else
+				++it;
+		}
+	}
+
+	//! Take a glyph rasterized in the background, if it is ready.
+	bool take(const io::path& filename, u32 font_size, FT_Int32 load_flags, u32 char_index, SGUITTGlyphBitmap& bitmap)
+	{
+		SKey key = { filename, font_size, load_flags, char_index };
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = results.find(key);
+		if (it == results.end())
+			return false;
+		bitmap = std::move(it->second);
+		results.erase(it);
+		return true;
+	}
+
+private:
+	struct SKey
+	{
+		io::path filename;
+		u32 font_size;
+		FT_Int32 load_flags;
+		u32 char_index;
+
+		bool operator<(const SKey& other) const
+		{
+			if (char_index != other.char_index)
+				return char_index < other.char_index;
+			if (font_size != other.font_size)
+				return font_size < other.font_size;
+			if (load_flags != other.load_flags)
+				return load_flags < other.load_flags;
+			return filename < other.filename;
+		}
+	};
+
+	struct SJob
+	{
+		io::path filename;
+		std::shared_ptr<std::vector<FT_Byte>> buffer;
+		u32 font_size;
+		FT_Int32 load_flags;
+		std::vector<u32> char_indices;
+	};
+
+	struct SFace
+	{
+		FT_Face face;
+		// Keeps the face data alive while the face is open.
+		std::shared_ptr<std::vector<FT_Byte>> buffer;
+	};
+
+	FT_Face getFace(FT_Library library, std::map<io::path, SFace>& faces, const SJob& job)
+	{
+		auto it = faces.find(job.filename);
+		if (it != faces.end())
+			return it->second.face;
+
+		SFace face = { 0, job.buffer };
+		FT_Error error;
+		if (job.buffer)
+		{
+			error = FT_New_Memory_Face(library, job.buffer->data(), job.buffer->size(), 0, &face.face);
+		}
+		else
+		{
+			core::ustring converter(job.filename);
+			error = FT_New_Face(library, reinterpret_cast<const char*>(converter.toUTF8_s().c_str()), 0, &face.face);
+		}
+		if (error)
+			face.face = 0;
+		faces[job.filename] = face;
+		return face.face;
+	}
+
+	void run()
+	{
+		FT_Library library;
+		if (FT_Init_FreeType(&library))
+			return;
+		std::map<io::path, SFace> faces;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			jobs_changed.wait(lock, [this] { return stop_requested || !jobs.empty(); });
+			if (stop_requested)
+				break;
+			SJob job = std::move(jobs.front());
+			jobs.pop_front();
+			active = &job;
+			active_discarded = false;
+			lock.unlock();
+
+			FT_Face face = getFace(library, faces, job);
+			for (u32 char_index : job.char_indices)
+			{
+				if (!face || stop_requested)
+					break;
+
+				SKey key = { job.filename, job.font_size, job.load_flags, char_index };
+				{
+					std::lock_guard<std::mutex> result_lock(mutex);
+					if (active_discarded)
+						break;
+					if (results.find(key) != results.end())
+						continue;
+				}
+
+				SGUITTGlyphBitmap bitmap;
+				if (!bitmap.rasterize(face, char_index, job.font_size, job.load_flags))
+					continue;
+
+				std::lock_guard<std::mutex> result_lock(mutex);
+				if (active_discarded)
+					break;
+				results.emplace(key, std::move(bitmap));
+			}
+
+			lock.lock();
+			active = 0;
+		}
+		lock.unlock();
+
+		for (auto& it : faces)
+		{
+			if (it.second.face)
+				FT_Done_Face(it.second.face);
+		}
+		FT_Done_FreeType(library);
+	}
+
+	std::mutex mutex;
+	std::condition_variable jobs_changed;
+	std::deque<SJob> jobs;
+	// The job being rasterized, and whether discard() was called for its font
+	const SJob* active = 0;
+	bool active_discarded = false;
+	std::map<SKey, SGUITTGlyphBitmap> results;
+	std::atomic<bool> stop_requested;
+	std::thread thread;
+};
+
+// Glyphs to draw from one page.  Kept apart from the page, as the pages are
+// shared with other fonts that may draw in between, like the fallback font.
+struct SGUITTRenderBatch
+{
+	core::array<core::vector2di> positions;
+	core::array<core::recti> source_rects;
+	core::array<video::SColor> colors;
 };
 
 // Static variables.
 FT_Library CGUITTFont::c_library;
 std::map<io::path, SGUITTFace*> CGUITTFont::c_faces;
 bool CGUITTFont::c_libraryLoaded = false;
+core::array<CGUITTGlyphPage*> CGUITTFont::c_glyph_pages;
+CGUITTGlyphRasterizer* CGUITTFont::c_rasterizer = 0;
 scene::IMesh* CGUITTFont::shared_plane_ptr_ = 0;
 scene::SMesh CGUITTFont::shared_plane_;
 
@@ -79,16 +294,73 @@ inline void checkFontBitmapSize(const FT_Bitmap &bits)
 	}
 }
 
-video::IImage* SGUITTGlyph::createGlyphImage(const FT_Bitmap& bits, video::IVideoDriver* driver) const
+bool SGUITTGlyphBitmap::rasterize(FT_Face face, u32 char_index, u32 font_size, const FT_Int32 loadFlags)
 {
+	// Set the size of the glyph.
+	FT_Set_Pixel_Sizes(face, 0, font_size);
+
+	// Attempt to load the glyph.
+	if (FT_Load_Glyph(face, char_index, loadFlags) != FT_Err_Ok)
+		// TODO: error message?
+		return false;
+
+	FT_GlyphSlot glyph = face->glyph;
+	const FT_Bitmap& bits = glyph->bitmap;
+
 	// Make sure our casts to s32 in the loops below will not cause problems
 	checkFontBitmapSize(bits);
 
+	advance = glyph->advance;
+	offset = core::vector2di(glyph->bitmap_left, glyph->bitmap_top);
+	width = bits.width;
+	rows = bits.rows;
+	pixel_mode = bits.pixel_mode;
+	coverage.assign(width * rows, 0);
+
+	const u8* glyph_data = bits.buffer;
+	switch (bits.pixel_mode)
+	{
+		case FT_PIXEL_MODE_MONO:
+		{
+			for (s32 y = 0; y < (s32)bits.rows; ++y)
+			{
+				for (s32 x = 0; x < (s32)bits.width; ++x)
+				{
+					// Monochrome bitmaps store 8 pixels per byte.  The left-most pixel is the bit 0x80.
+					// So, we go through the data each bit at a time.
+					if ((glyph_data[y * bits.pitch + (x / 8)] & (0x80 >> (x % 8))) != 0)
+						coverage[y * width + x] = 255;
+				}
+			}
+			break;
+		}
+
+		case FT_PIXEL_MODE_GRAY:
+		{
+			const float gray_count = static_cast<float>(bits.num_grays);
+			for (s32 y = 0; y < (s32)bits.rows; ++y)
+			{
+				const u8* row = glyph_data;
+				for (s32 x = 0; x < (s32)bits.width; ++x)
+					coverage[y * width + x] = static_cast<u8>(255.0f * (static_cast<float>(*row++) / gray_count));
+				glyph_data += bits.pitch;
+			}
+			break;
+		}
+		default:
+			// TODO: error message?
+			// The glyph keeps its metrics but isn't drawn.
+			coverage.clear();
+			break;
+	}
+	return true;
+}
+
+video::IImage* SGUITTGlyph::createGlyphImage(const SGUITTGlyphBitmap& bits, video::IVideoDriver* driver) const
+{
 	// Determine what our texture size should be.
 	// Add 1 because textures are inclusive-exclusive.
-	core::dimension2du d(bits.width + 1, bits.rows + 1);
-	core::dimension2du texture_size;
-	//core::dimension2du texture_size(bits.width + 1, bits.rows + 1);
+	core::dimension2du texture_size(bits.width + 1, bits.rows + 1);
 
 	// Create and load our image now.
 	video::IImage* image = 0;
@@ -97,27 +369,22 @@ video::IImage* SGUITTGlyph::createGlyphImage(const FT_Bitmap& bits, video::IVide
 		case FT_PIXEL_MODE_MONO:
 		{
 			// Create a blank image and fill it with transparent pixels.
-			texture_size = d.getOptimalSize(true, true);
 			image = driver->createImage(video::ECF_A1R5G5B5, texture_size);
 			image->fill(video::SColor(0, 255, 255, 255));
 
 			// Load the monochrome data in.
 			const u32 image_pitch = image->getPitch() / sizeof(u16);
 			u16* image_data = (u16*)image->getData();
-			u8* glyph_data = bits.buffer;
-
-			for (s32 y = 0; y < (s32)bits.rows; ++y)
+			const u8* glyph_data = bits.coverage.data();
+			for (u32 y = 0; y < bits.rows; ++y)
 			{
-				u16* row = image_data;
-				for (s32 x = 0; x < (s32)bits.width; ++x)
+				for (u32 x = 0; x < bits.width; ++x)
 				{
-					// Monochrome bitmaps store 8 pixels per byte.  The left-most pixel is the bit 0x80.
-					// So, we go through the data each bit at a time.
-					if ((glyph_data[y * bits.pitch + (x / 8)] & (0x80 >> (x % 8))) != 0)
-						*row = 0xFFFF;
-					++row;
+					if (glyph_data[x] != 0)
+						image_data[x] = 0xFFFF;
 				}
 				image_data += image_pitch;
+				glyph_data += bits.width;
 			}
 			break;
 		}
@@ -125,24 +392,19 @@ video::IImage* SGUITTGlyph::createGlyphImage(const FT_Bitmap& bits, video::IVide
 		case FT_PIXEL_MODE_GRAY:
 		{
 			// Create our blank image.
-			texture_size = d.getOptimalSize(!driver->queryFeature(video::EVDF_TEXTURE_NPOT), !driver->queryFeature(video::EVDF_TEXTURE_NSQUARE), true, 0);
 			image = driver->createImage(video::ECF_A8R8G8B8, texture_size);
 			image->fill(video::SColor(0, 255, 255, 255));
 
 			// Load the grayscale data in.
-			const float gray_count = static_cast<float>(bits.num_grays);
 			const u32 image_pitch = image->getPitch() / sizeof(u32);
 			u32* image_data = (u32*)image->getData();
-			u8* glyph_data = bits.buffer;
-			for (s32 y = 0; y < (s32)bits.rows; ++y)
+			const u8* glyph_data = bits.coverage.data();
+			for (u32 y = 0; y < bits.rows; ++y)
 			{
-				u8* row = glyph_data;
-				for (s32 x = 0; x < (s32)bits.width; ++x)
-				{
-					image_data[y * image_pitch + x] |= static_cast<u32>(255.0f * (static_cast<float>(*row++) / gray_count)) << 24;
-					//data[y * image_pitch + x] |= ((u32)(*bitsdata++) << 24);
-				}
-				glyph_data += bits.pitch;
+				for (u32 x = 0; x < bits.width; ++x)
+					image_data[x] |= static_cast<u32>(glyph_data[x]) << 24;
+				image_data += image_pitch;
+				glyph_data += bits.width;
 			}
 			break;
 		}
@@ -153,52 +415,32 @@ video::IImage* SGUITTGlyph::createGlyphImage(const FT_Bitmap& bits, video::IVide
 	return image;
 }
 
-void SGUITTGlyph::preload(u32 char_index, FT_Face face, video::IVideoDriver* driver, u32 font_size, const FT_Int32 loadFlags)
+void SGUITTGlyph::preload(const SGUITTGlyphBitmap& bits, video::IVideoDriver* driver)
 {
 	if (isLoaded) return;
 
-	// Set the size of the glyph.
-	FT_Set_Pixel_Sizes(face, 0, font_size);
-
-	// Attempt to load the glyph.
-	if (FT_Load_Glyph(face, char_index, loadFlags) != FT_Err_Ok)
-		// TODO: error message?
-		return;
-
-	FT_GlyphSlot glyph = face->glyph;
-	FT_Bitmap bits = glyph->bitmap;
-
 	// Setup the glyph information here:
-	advance = glyph->advance;
-	offset = core::vector2di(glyph->bitmap_left, glyph->bitmap_top);
+	advance = bits.advance;
+	offset = bits.offset;
 
-	// Try to get the last page with available slots.
-	CGUITTGlyphPage* page = parent->getLastGlyphPage();
-
-	// If we need to make a new page, do that now.
+	// Find room for the glyph and a blank border in the glyph pages.
+	core::dimension2du glyph_size(bits.width + 1, bits.rows + 1);
+	core::vector2di page_position;
+	CGUITTGlyphPage* page = parent->allocateGlyph(bits.pixel_mode, glyph_size, glyph_page, page_position);
 	if (!page)
-	{
-		page = parent->createGlyphPage(bits.pixel_mode);
-		if (!page)
-			// TODO: add error message?
-			return;
-	}
+		// TODO: add error message?
+		return;
 
-	glyph_page = parent->getLastGlyphPageIndex();
-	u32 texture_side_length = page->texture->getOriginalSize().Width;
-	core::vector2di page_position(
-		(page->used_slots % (texture_side_length / font_size)) * font_size,
-		(page->used_slots / (texture_side_length / font_size)) * font_size
-		);
 	source_rect.UpperLeftCorner = page_position;
 	source_rect.LowerRightCorner = core::vector2di(page_position.X + bits.width, page_position.Y + bits.rows);
 
-	page->dirty = true;
-	++page->used_slots;
-	--page->available_slots;
-
-	// We grab the glyph bitmap here so the data won't be removed when the next glyph is loaded.
-	surface = createGlyphImage(bits, driver);
+	// The page copies the image into its texture before the next draw.
+	video::IImage* image = createGlyphImage(bits, driver);
+	if (image)
+	{
+		page->pushGlyphToBePaged(image, page_position);
+		image->drop();
+	}
 
 	// Set our glyph as loaded.
 	isLoaded = true;
@@ -206,10 +448,10 @@ void SGUITTGlyph::preload(u32 char_index, FT_Face face, video::IVideoDriver* dri
 
 void SGUITTGlyph::unload()
 {
-	if (surface)
+	if (isLoaded && parent)
 	{
-		surface->drop();
-		surface = 0;
+		core::dimension2du glyph_size(source_rect.getWidth() + 1, source_rect.getHeight() + 1);
+		parent->releaseGlyph(glyph_page, glyph_size, source_rect.UpperLeftCorner);
 	}
 	isLoaded = false;
 }
@@ -336,13 +578,12 @@ bool CGUITTFont::load(const io::path& filename, const u32 size, const bool antia
 				face = 0;
 				return false;
 			}
-			face->face_buffer = new FT_Byte[file->getSize()];
-			file->read(face->face_buffer, file->getSize());
-			face->face_buffer_size = file->getSize();
+			face->face_buffer = std::make_shared<std::vector<FT_Byte>>(file->getSize());
+			file->read(face->face_buffer->data(), file->getSize());
 			file->drop();
 
 			// Create the face.
-			if (FT_New_Memory_Face(c_library, face->face_buffer, face->face_buffer_size, 0, &face->face))
+			if (FT_New_Memory_Face(c_library, face->face_buffer->data(), face->face_buffer->size(), 0, &face->face))
 			{
 				if (logger) logger->log(L"CGUITTFont", L"FT_New_Memory_Face failed.", irr::ELL_INFORMATION);
 
@@ -391,7 +632,6 @@ bool CGUITTFont::load(const io::path& filename, const u32 size, const bool antia
 		Glyphs[i].source_rect = core::recti();
 		Glyphs[i].offset = core::vector2di();
 		Glyphs[i].advance = FT_Vector();
-		Glyphs[i].surface = 0;
 		Glyphs[i].parent = this;
 	}
 
@@ -406,7 +646,7 @@ bool CGUITTFont::load(const io::path& filename, const u32 size, const bool antia
 
 CGUITTFont::~CGUITTFont()
 {
-	// Delete the glyphs and glyph pages.
+	// Delete the glyphs.
 	reset_images();
 	Glyphs.clear();
 
@@ -423,6 +663,14 @@ CGUITTFont::~CGUITTFont()
 		// If there are no more faces referenced by FreeType, clean up.
 		if (c_faces.empty())
 		{
+			delete c_rasterizer;
+			c_rasterizer = 0;
+
+			// No font is left to use the glyph pages, unload them from video memory.
+			for (u32 i = 0; i != c_glyph_pages.size(); ++i)
+				delete c_glyph_pages[i];
+			c_glyph_pages.clear();
+
 			FT_Done_FreeType(c_library);
 			c_libraryLoaded = false;
 		}
@@ -435,14 +683,13 @@ CGUITTFont::~CGUITTFont()
 
 void CGUITTFont::reset_images()
 {
-	// Delete the glyphs.
+	// Delete the glyphs and give their room on the shared glyph pages back.
 	for (u32 i = 0; i != Glyphs.size(); ++i)
 		Glyphs[i].unload();
 
-	// Unload the glyph pages from video memory.
-	for (u32 i = 0; i != Glyph_Pages.size(); ++i)
-		delete Glyph_Pages[i];
-	Glyph_Pages.clear();
+	// Glyphs prewarmed with the old flags would never be taken.
+	if (c_rasterizer)
+		c_rasterizer->discard(filename, size, load_flags);
 
 	// Always update the internal FreeType loading flags after resetting.
 	update_load_flags();
@@ -450,43 +697,36 @@ void CGUITTFont::reset_images()
 
 void CGUITTFont::update_glyph_pages() const
 {
-	for (u32 i = 0; i != Glyph_Pages.size(); ++i)
+	for (u32 i = 0; i != c_glyph_pages.size(); ++i)
 	{
-		if (Glyph_Pages[i]->dirty)
-			Glyph_Pages[i]->updateTexture();
+		if (c_glyph_pages[i]->dirty)
+			c_glyph_pages[i]->updateTexture();
 	}
 }
 
-CGUITTGlyphPage* CGUITTFont::getLastGlyphPage() const
+CGUITTGlyphPage* CGUITTFont::allocateGlyph(const u8& pixel_mode, const core::dimension2du& glyph_size, u32& page_index, core::vector2di& position) const
 {
-	CGUITTGlyphPage* page = 0;
-	if (Glyph_Pages.empty())
-		return 0;
-	else
+	// Everything but monochrome glyphs goes on 32-bit pages.
+	const u8 page_mode = (pixel_mode == FT_PIXEL_MODE_MONO) ? FT_PIXEL_MODE_MONO : FT_PIXEL_MODE_GRAY;
+
+	// Try the existing pages, the newest first as older ones are likely full.
+	for (u32 i = c_glyph_pages.size(); i-- > 0;)
 	{
-		page = Glyph_Pages[getLastGlyphPageIndex()];
-		if (page->available_slots == 0)
-			page = 0;
+		CGUITTGlyphPage* page = c_glyph_pages[i];
+		if (page->driver != Driver || page->pixel_mode != page_mode)
+			continue;
+		if (page->allocate(glyph_size, position))
+		{
+			page_index = i;
+			return page;
+		}
 	}
-	return page;
-}
-
-CGUITTGlyphPage* CGUITTFont::createGlyphPage(const u8& pixel_mode)
-{
-	CGUITTGlyphPage* page = 0;
 
 	// Name of our page.
 	io::path name("TTFontGlyphPage_");
-	name += tt_face->family_name;
-	name += ".";
-	name += tt_face->style_name;
-	name += ".";
-	name += size;
+	name += (u32)page_mode;
 	name += "_";
-	name += Glyph_Pages.size(); // The newly created page will be at the end of the collection.
-
-	// Create the new page.
-	page = new CGUITTGlyphPage(Driver, name);
+	name += c_glyph_pages.size(); // The newly created page will be at the end of the collection.
 
 	// Determine our maximum texture size.
 	// If we keep getting 0, set it to 1024x1024, as that number is pretty safe.
@@ -496,30 +736,75 @@ CGUITTGlyphPage* CGUITTFont::createGlyphPage(const u8& pixel_mode)
 	if (max_texture_size.Width == 0 || max_texture_size.Height == 0)
 		max_texture_size = core::dimension2du(1024, 1024);
 
-	// We want to try to put at least 144 glyphs on a single texture.
-	core::dimension2du page_texture_size;
-	if (size <= 21) page_texture_size = core::dimension2du(256, 256);
-	else if (size <= 42) page_texture_size = core::dimension2du(512, 512);
-	else if (size <= 84) page_texture_size = core::dimension2du(1024, 1024);
-	else if (size <= 168) page_texture_size = core::dimension2du(2048, 2048);
-	else page_texture_size = core::dimension2du(4096, 4096);
+	// Pages are shared by all fonts, so this holds a few sizes of the usual
+	// scripts.  Huge glyphs get a page of their own.
+	core::dimension2du page_texture_size(1024, 1024);
+	if (glyph_size.Width > page_texture_size.Width || glyph_size.Height > page_texture_size.Height)
+	{
+		u32 side = core::max_(glyph_size.Width, glyph_size.Height);
+		page_texture_size = core::dimension2du(side, side).getOptimalSize();
+	}
 
 	if (page_texture_size.Width > max_texture_size.Width || page_texture_size.Height > max_texture_size.Height)
 		page_texture_size = max_texture_size;
 
-	if (!page->createPageTexture(pixel_mode, page_texture_size)) {
+	// Create the new page.
+	CGUITTGlyphPage* page = new CGUITTGlyphPage(Driver, name, page_mode);
+	if (!page->createPageTexture(page_texture_size) || !page->allocate(glyph_size, position))
+	{
 		// TODO: add error message?
 		delete page;
 		return 0;
 	}
 
-	if (page)
+	page_index = c_glyph_pages.size();
+	c_glyph_pages.push_back(page);
+	return page;
+}
+
+void CGUITTFont::releaseGlyph(u32 page_index, const core::dimension2du& glyph_size, const core::vector2di& position) const
+{
+	if (page_index < c_glyph_pages.size())
+		c_glyph_pages[page_index]->release(glyph_size, position);
+}
+
+void CGUITTFont::prewarm(const core::ustring& text)
+{
+	auto face = c_faces.find(filename);
+	if (face == c_faces.end())
+		return;
+
+	// Collect the glyphs that are not loaded yet.  Characters we don't have
+	// are drawn by the fallback font, so it gets to prewarm those.
+	std::vector<u32> char_indices;
+	std::vector<bool> queued(Glyphs.size(), false);
+	core::ustring missing;
+	core::ustring::const_iterator iter(text);
+	for (; !iter.atEnd(); ++iter)
 	{
-		// Determine the number of glyph slots on the page and add it to the list of pages.
-		page->available_slots = (page_texture_size.Width / size) * (page_texture_size.Height / size);
-		Glyph_Pages.push_back(page);
+		uchar32_t c = *iter;
+		u32 char_index = FT_Get_Char_Index(tt_face, c);
+		if (char_index == 0)
+		{
+			missing.append(c);
+			continue;
+		}
+		if (Glyphs[char_index - 1].isLoaded || queued[char_index - 1])
+			continue;
+		queued[char_index - 1] = true;
+		char_indices.push_back(char_index);
 	}
-	return page;
+
+	CGUITTFont* fallback_tt = dynamic_cast<CGUITTFont*>(fallback);
+	if (fallback_tt && !missing.empty())
+		fallback_tt->prewarm(missing);
+
+	if (char_indices.empty())
+		return;
+
+	if (!c_rasterizer)
+		c_rasterizer = new CGUITTGlyphRasterizer();
+	c_rasterizer->queue(filename, face->second->face_buffer, size, load_flags, std::move(char_indices));
 }
 
 void CGUITTFont::setTransparency(const bool flag)
@@ -553,14 +838,6 @@ void CGUITTFont::draw(const EnrichedString &text, const core::rect<s32>& positio
 	if (!Driver)
 		return;
 
-	// Clear the glyph pages of their render information.
-	for (u32 i = 0; i < Glyph_Pages.size(); ++i)
-	{
-		Glyph_Pages[i]->render_positions.clear();
-		Glyph_Pages[i]->render_source_rects.clear();
-		Glyph_Pages[i]->render_colors.clear();
-	}
-
 	// Set up some variables.
 	core::dimension2d<s32> textDimension;
 	core::position2d<s32> offset = position.UpperLeftCorner;
@@ -581,7 +858,7 @@ void CGUITTFont::draw(const EnrichedString &text, const core::rect<s32>& positio
 	core::ustring utext = text.getString();
 
 	// Set up our render map.
-	std::map<u32, CGUITTGlyphPage*> Render_Map;
+	std::map<u32, SGUITTRenderBatch> Render_Map;
 
 	// Start parsing characters.
 	u32 n;
@@ -629,14 +906,13 @@ void CGUITTFont::draw(const EnrichedString &text, const core::rect<s32>& positio
 
 			// Determine rendering information.
 			SGUITTGlyph& glyph = Glyphs[n-1];
-			CGUITTGlyphPage* const page = Glyph_Pages[glyph.glyph_page];
-			page->render_positions.push_back(core::position2di(offset.X + offx, offset.Y + offy));
-			page->render_source_rects.push_back(glyph.source_rect);
+			SGUITTRenderBatch& batch = Render_Map[glyph.glyph_page];
+			batch.positions.push_back(core::position2di(offset.X + offx, offset.Y + offy));
+			batch.source_rects.push_back(glyph.source_rect);
 			if (iter.getPos() < colors.size())
-				page->render_colors.push_back(colors[iter.getPos()]);
+				batch.colors.push_back(colors[iter.getPos()]);
 			else
-				page->render_colors.push_back(video::SColor(255,255,255,255));
-			Render_Map[glyph.glyph_page] = page;
+				batch.colors.push_back(video::SColor(255,255,255,255));
 		}
 		if (n > 0)
 		{
@@ -675,27 +951,28 @@ void CGUITTFont::draw(const EnrichedString &text, const core::rect<s32>& positio
 	core::array<core::recti> tmp_source_rects;
 	while (it != ie)
 	{
-		CGUITTGlyphPage* page = it->second;
+		CGUITTGlyphPage* page = c_glyph_pages[it->first];
+		SGUITTRenderBatch& batch = it->second;
 		++it;
 
 		if (shadow_offset) {
-			for (size_t i = 0; i < page->render_positions.size(); ++i)
-				page->render_positions[i] += core::vector2di(shadow_offset, shadow_offset);
-			Driver->draw2DImageBatch(page->texture, page->render_positions, page->render_source_rects, clip, video::SColor(shadow_alpha,0,0,0), true);
-			for (size_t i = 0; i < page->render_positions.size(); ++i)
-				page->render_positions[i] -= core::vector2di(shadow_offset, shadow_offset);
+			for (size_t i = 0; i < batch.positions.size(); ++i)
+				batch.positions[i] += core::vector2di(shadow_offset, shadow_offset);
+			Driver->draw2DImageBatch(page->texture, batch.positions, batch.source_rects, clip, video::SColor(shadow_alpha,0,0,0), true);
+			for (size_t i = 0; i < batch.positions.size(); ++i)
+				batch.positions[i] -= core::vector2di(shadow_offset, shadow_offset);
 		}
 		// render runs of matching color in batch
 		size_t ibegin;
 		video::SColor colprev;
-		for (size_t i = 0; i < page->render_positions.size(); ++i) {
+		for (size_t i = 0; i < batch.positions.size(); ++i) {
 			ibegin = i;
-			colprev = page->render_colors[i];
+			colprev = batch.colors[i];
 			do
 				++i;
-			while (i < page->render_positions.size() && page->render_colors[i] == colprev);
-			tmp_positions.set_data(&page->render_positions[ibegin], i - ibegin);
-			tmp_source_rects.set_data(&page->render_source_rects[ibegin], i - ibegin);
+			while (i < batch.positions.size() && batch.colors[i] == colprev);
+			tmp_positions.set_data(&batch.positions[ibegin], i - ibegin);
+			tmp_source_rects.set_data(&batch.source_rects[ibegin], i - ibegin);
 			--i;
 
 			if (!use_transparency)
@@ -866,12 +1143,8 @@ u32 CGUITTFont::getGlyphIndexByChar(uchar32_t c) const
 		// If the glyph hasn't been loaded yet, do it now.
 		if (char_index)
 		{
-			SGUITTGlyph& glyph = Glyphs[char_index - 1];
-			if (!glyph.isLoaded)
-			{
-				glyph.preload(char_index, tt_face, Driver, size, load_flags);
-				Glyph_Pages[glyph.glyph_page]->pushGlyphToBePaged(&glyph);
-			}
+			if (!Glyphs[char_index - 1].isLoaded)
+				loadGlyph(char_index);
 		}
 	}
 	while (++start_pos < end_pos);
@@ -880,6 +1153,18 @@ u32 CGUITTFont::getGlyphIndexByChar(uchar32_t c) const
 	return glyph;
 }
 
+void CGUITTFont::loadGlyph(u32 char_index) const
+{
+	// Use the bitmap rasterized in the background if there is one.
+	SGUITTGlyphBitmap bitmap;
+	if (!c_rasterizer || !c_rasterizer->take(filename, size, load_flags, char_index, bitmap))
+	{
+		if (!bitmap.rasterize(tt_face, char_index, size, load_flags))
+			return;
+	}
+	Glyphs[char_index - 1].preload(bitmap, Driver);
+}
+
 s32 CGUITTFont::getCharacterFromPos(const wchar_t* text, s32 pixel_x) const
 {
 	return getCharacterFromPos(core::ustring(text), pixel_x);
@@ -1016,7 +1301,7 @@ video::IImage* CGUITTFont::createTextureFromChar(const uchar32_t& ch)
 		n = getGlyphIndexByChar((uchar32_t) core::unicode::UTF_REPLACEMENT_CHARACTER);
 
 	const SGUITTGlyph& glyph = Glyphs[n-1];
-	CGUITTGlyphPage* page = Glyph_Pages[glyph.glyph_page];
+	CGUITTGlyphPage* page = c_glyph_pages[glyph.glyph_page];
 
 	if (page->dirty)
 		page->updateTexture();
@@ -1041,8 +1326,8 @@ video::IImage* CGUITTFont::createTextureFromChar(const uchar32_t& ch)
 
 video::ITexture* CGUITTFont::getPageTextureByIndex(const u32& page_index) const
 {
-	if (page_index < Glyph_Pages.size())
-		return Glyph_Pages[page_index]->texture;
+	if (page_index < c_glyph_pages.size())
+		return c_glyph_pages[page_index]->texture;
 	else
 		return 0;
 }
@@ -1208,7 +1493,7 @@ core::array<scene::ISceneNode*> CGUITTFont::addTextSceneNode(const wchar_t* text
 	{
 		u32 n = glyph_indices[i];
 		SGUITTGlyph const& glyph = Glyphs[n-1];
-		ITexture* current_tex = Glyph_Pages[glyph.glyph_page]->texture;
+		ITexture* current_tex = c_glyph_pages[glyph.glyph_page]->texture;
 		f32 page_texture_size = (f32)current_tex->getSize().Width;
 		//Now we calculate the UV position according to the texture size and the source rect.
 		//
@@ -46,6 +46,33 @@ namespace gui
 {
 	struct SGUITTFace;
 	class CGUITTFont;
+	class CGUITTGlyphRasterizer;
+
+	//! A glyph rendered by FreeType, with its coverage converted to 8 bits per pixel.
+	//! Creating it doesn't need the video driver, so it can be done on any thread.
+	struct SGUITTGlyphBitmap
+	{
+		SGUITTGlyphBitmap() : advance(), offset(), width(0), rows(0), pixel_mode(FT_PIXEL_MODE_GRAY) {}
+
+		//! Loads and renders a glyph.
+		//! The face must not be used by another thread meanwhile.
+		bool rasterize(FT_Face face, u32 char_index, u32 font_size, const FT_Int32 loadFlags);
+
+		//! Glyph advance information.
+		FT_Vector advance;
+
+		//! The offset of glyph when drawn.
+		core::vector2di offset;
+
+		u32 width;
+		u32 rows;
+
+		//! The FT_Pixel_Mode FreeType rendered the glyph in.
+		u8 pixel_mode;
+
+		//! width * rows coverage values, 0 to 255.
+		std::vector<u8> coverage;
+	};
 
 	//! Structure representing a single TrueType glyph.
 	struct SGUITTGlyph
@@ -57,40 +84,20 @@ namespace gui
 			source_rect(),
 			offset(),
 			advance(),
-			surface(0),
 			parent(0)
 		{}
 
-		DISABLE_CLASS_COPY(SGUITTGlyph);
-
-		//! This class would be trivially copyable except for the reference count on `surface`.
-		SGUITTGlyph(SGUITTGlyph &&other) :
-			isLoaded(other.isLoaded),
-			glyph_page(other.glyph_page),
-			source_rect(other.source_rect),
-			offset(other.offset),
-			advance(other.advance),
-			surface(other.surface),
-			parent(other.parent)
-		{
-			other.surface = 0;
-		}
-
-		//! Destructor.
-		~SGUITTGlyph() { unload(); }
-
 		//! Preload the glyph.
-		//!	The preload process occurs when the program tries to cache the glyph from FT_Library.
-		//! However, it simply defines the SGUITTGlyph's properties and will only create the page
-		//! textures if necessary.  The actual creation of the textures should only occur right
-		//! before the batch draw call.
-		void preload(u32 char_index, FT_Face face, video::IVideoDriver* driver, u32 font_size, const FT_Int32 loadFlags);
+		//! This defines the SGUITTGlyph's properties, reserves its place in the glyph atlas
+		//! and queues its image there.  The page textures are only updated right before
+		//! the batch draw call.
+		void preload(const SGUITTGlyphBitmap& bits, video::IVideoDriver* driver);
 
 		//! Unloads the glyph.
 		void unload();
 
-		//! Creates the IImage object from the FT_Bitmap.
-		video::IImage* createGlyphImage(const FT_Bitmap& bits, video::IVideoDriver* driver) const;
+		//! Creates the IImage object from the rasterized bitmap.
+		video::IImage* createGlyphImage(const SGUITTGlyphBitmap& bits, video::IVideoDriver* driver) const;
 
 		//! If true, the glyph has been loaded.
 		bool isLoaded;
@@ -107,21 +114,23 @@ namespace gui
 		//! Glyph advance information.
 		FT_Vector advance;
 
-		//! This is just the temporary image holder.  After this glyph is paged,
-		//! it will be dropped.
-		mutable video::IImage* surface;
-
 		//! The pointer pointing to the parent (CGUITTFont)
 		CGUITTFont* parent;
 	};
 
 	//! Holds a sheet of glyphs.
+	//! Pages are shared by all fonts, whatever their face and size.  Glyphs are
+	//! packed on shelves, rows of glyphs of about the same height.  The room of
+	//! released glyphs is reused, and a page without glyphs starts over.
 	class CGUITTGlyphPage
 	{
 		public:
-			CGUITTGlyphPage(video::IVideoDriver* Driver, const io::path& texture_name) :texture(0), available_slots(0), used_slots(0), dirty(false), driver(Driver), name(texture_name) {}
+			CGUITTGlyphPage(video::IVideoDriver* Driver, const io::path& texture_name, const u8& mode) :texture(0), dirty(false), pixel_mode(mode), driver(Driver), name(texture_name), shelves_height(0), live_glyphs(0) {}
 			~CGUITTGlyphPage()
 			{
+				for (u32 i = 0; i < glyph_to_be_paged.size(); ++i)
+					glyph_to_be_paged[i].image->drop();
+
 				if (texture)
 				{
 					if (driver)
@@ -131,7 +140,7 @@ namespace gui
 			}
 
 			//! Create the actual page texture,
-			bool createPageTexture(const u8& pixel_mode, const core::dimension2du& texture_size)
+			bool createPageTexture(const core::dimension2du& texture_size)
 			{
 				if( texture )
 					return false;
@@ -163,11 +172,102 @@ namespace gui
 				return texture ? true : false;
 			}
 
-			//! Add the glyph to a list of glyphs to be paged.
-			//! This collection will be cleared after updateTexture is called.
-			void pushGlyphToBePaged(const SGUITTGlyph* glyph)
+			//! Find room for a glyph of the given size.
+			//! \return false if the page is full.
+			bool allocate(const core::dimension2du& glyph_size, core::vector2di& position)
 			{
-				glyph_to_be_paged.push_back(glyph);
+				const core::dimension2du page_size = texture->getOriginalSize();
+				if (glyph_size.Width > page_size.Width)
+					return false;
+
+				// Use the first shelf the glyph fits on without wasting more than
+				// a quarter of the shelf height.  Released room comes first.
+				for (u32 i = 0; i < shelves.size(); ++i)
+				{
+					SShelf& shelf = shelves[i];
+					if (glyph_size.Height > shelf.height || glyph_size.Height < shelf.height * 3 / 4)
+						continue;
+					for (u32 j = 0; j < shelf.free_spans.size(); ++j)
+					{
+						SSpan& span = shelf.free_spans[j];
+						if (span.width < glyph_size.Width)
+							continue;
+						position = core::vector2di(span.x, shelf.y);
+						span.x += glyph_size.Width;
+						span.width -= glyph_size.Width;
+						if (span.width == 0)
+							shelf.free_spans.erase(j);
+						++shelf.glyphs;
+						++live_glyphs;
+						return true;
+					}
+					if (shelf.used_width + glyph_size.Width > page_size.Width)
+						continue;
+					position = core::vector2di(shelf.used_width, shelf.y);
+					shelf.used_width += glyph_size.Width;
+					++shelf.glyphs;
+					++live_glyphs;
+					return true;
+				}
+
+				// Open a new shelf.
+				if (shelves_height + glyph_size.Height > page_size.Height)
+					return false;
+				SShelf shelf;
+				shelf.y = shelves_height;
+				shelf.height = glyph_size.Height;
+				shelf.used_width = glyph_size.Width;
+				shelf.glyphs = 1;
+				shelves.push_back(shelf);
+				shelves_height += glyph_size.Height;
+				++live_glyphs;
+				position = core::vector2di(0, shelf.y);
+				return true;
+			}
+
+			//! Give back the room of a glyph returned by allocate().
+			void release(const core::dimension2du& glyph_size, const core::vector2di& position)
+			{
+				for (u32 i = 0; i < shelves.size(); ++i)
+				{
+					SShelf& shelf = shelves[i];
+					if (shelf.y != (u32)position.Y)
+						continue;
+
+					--live_glyphs;
+					if (--shelf.glyphs == 0)
+					{
+						shelf.used_width = 0;
+						shelf.free_spans.clear();
+					}
+					else if (position.X + glyph_size.Width == shelf.used_width)
+					{
+						shelf.used_width = position.X;
+					}
+					else
+					{
+						SSpan span = { (u32)position.X, glyph_size.Width };
+						shelf.free_spans.push_back(span);
+					}
+					break;
+				}
+
+				// Without glyphs, any shelf heights may be used again.
+				if (live_glyphs == 0)
+				{
+					shelves.clear();
+					shelves_height = 0;
+				}
+			}
+
+			//! Add a glyph image to the list of images to be paged.
+			//! The page grabs the image.  This collection will be cleared after updateTexture is called.
+			void pushGlyphToBePaged(video::IImage* image, const core::vector2di& position)
+			{
+				image->grab();
+				SPendingGlyph pending = { image, position };
+				glyph_to_be_paged.push_back(pending);
+				dirty = true;
 			}
 
 			//! Updates the texture atlas with new glyphs.
@@ -182,21 +282,9 @@ namespace gui
 
 				for (u32 i = 0; i < glyph_to_be_paged.size(); ++i)
 				{
-					const SGUITTGlyph* glyph = glyph_to_be_paged[i];
-					if (glyph && glyph->isLoaded)
-					{
-						if (glyph->surface)
-						{
-							glyph->surface->copyTo(pageholder, glyph->source_rect.UpperLeftCorner);
-							glyph->surface->drop();
-							glyph->surface = 0;
-						}
-						else
-						{
-							; // TODO: add error message?
-							//currently, if we failed to create the image, just ignore this operation.
-						}
-					}
+					SPendingGlyph& pending = glyph_to_be_paged[i];
+					pending.image->copyTo(pageholder, pending.position);
+					pending.image->drop();
 				}
 
 				pageholder->drop();
@@ -206,18 +294,39 @@ namespace gui
 			}
 
 			video::ITexture* texture;
-			u32 available_slots;
-			u32 used_slots;
 			bool dirty;
-
-			core::array<core::vector2di> render_positions;
-			core::array<core::recti> render_source_rects;
-			core::array<video::SColor> render_colors;
+			const u8 pixel_mode;
+			video::IVideoDriver* const driver;
 
 		private:
-			core::array<const SGUITTGlyph*> glyph_to_be_paged;
-			video::IVideoDriver* driver;
+			struct SSpan
+			{
+				u32 x;
+				u32 width;
+			};
+
+			struct SShelf
+			{
+				u32 y;
+				u32 height;
+				u32 used_width;
+				//! Glyphs on the shelf.
+				u32 glyphs;
+				//! Released room left of used_width.
+				core::array<SSpan> free_spans;
+			};
+
+			struct SPendingGlyph
+			{
+				video::IImage* image;
+				core::vector2di position;
+			};
+
+			core::array<SPendingGlyph> glyph_to_be_paged;
 			io::path name;
+			core::array<SShelf> shelves;
+			u32 shelves_height;
+			u32 live_glyphs;
 	};
 
 	//! Class representing a TrueType font.
@@ -315,17 +424,17 @@ namespace gui
 			virtual void setInvisibleCharacters(const wchar_t *s);
 			virtual void setInvisibleCharacters(const core::ustring& s);
 
-			//! Get the last glyph page if there's still available slots.
-			//! If not, it will return zero.
-			CGUITTGlyphPage* getLastGlyphPage() const;
-
-			//! Create a new glyph page texture.
+			//! Find room for a glyph in the shared glyph pages, creating a new page if necessary.
 			//! \param pixel_mode the pixel mode defined by FT_Pixel_Mode
-			//should be better typed. fix later.
-			CGUITTGlyphPage* createGlyphPage(const u8& pixel_mode);
+			//! \return The page, or zero on failure.  page_index and position are set on success.
+			CGUITTGlyphPage* allocateGlyph(const u8& pixel_mode, const core::dimension2du& glyph_size, u32& page_index, core::vector2di& position) const;
+
+			//! Give back the room allocateGlyph() found for a glyph.
+			void releaseGlyph(u32 page_index, const core::dimension2du& glyph_size, const core::vector2di& position) const;
 
-			//! Get the last glyph page's index.
-			u32 getLastGlyphPageIndex() const { return Glyph_Pages.size() - 1; }
+			//! Rasterize the glyphs of the given characters on a background thread,
+			//! so loading them later only has to copy the bitmaps into the atlas.
+			void prewarm(const core::ustring& text);
 
 			//! Set font that should be used for glyphs not present in ours
 			void setFallback(gui::IGUIFont* font) { fallback = font; }
@@ -360,6 +469,9 @@ namespace gui
 			static FT_Library c_library;
 			static std::map<io::path, SGUITTFace*> c_faces;
 			static bool c_libraryLoaded;
+			// Glyph pages shared by all fonts.
+			static core::array<CGUITTGlyphPage*> c_glyph_pages;
+			static CGUITTGlyphRasterizer* c_rasterizer;
 			static scene::IMesh* shared_plane_ptr_;
 			static scene::SMesh  shared_plane_;
 
@@ -382,6 +494,7 @@ namespace gui
 			u32 getHeightFromCharacter(uchar32_t c) const;
 			u32 getGlyphIndexByChar(wchar_t c) const;
 			u32 getGlyphIndexByChar(uchar32_t c) const;
+			void loadGlyph(u32 char_index) const;
 			core::vector2di getKerning(const wchar_t thisLetter, const wchar_t previousLetter) const;
 			core::vector2di getKerning(const uchar32_t thisLetter, const uchar32_t previousLetter) const;
 			core::dimension2d<u32> getDimensionUntilEndOfLine(const wchar_t* p) const;
@@ -396,7 +509,6 @@ namespace gui
 			FT_Size_Metrics font_metrics;
 			FT_Int32 load_flags;
 
-			mutable core::array<CGUITTGlyphPage*> Glyph_Pages;
 			mutable core::array<SGUITTGlyph> Glyphs;
 
 			s32 GlobalKerningWidth;
@@ -21,6 +21,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "irrlicht.h" // createDevice
 #include "irrlichttypes_extrabloated.h"
 #include "benchmark/benchmark.h"
+#include "benchmark/loadtest.h"
 #include "chat_interface.h"
 #include "debug.h"
 #include "unittest/test.h"
@@ -40,6 +41,11 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "porting.h"
 #include "network/socket.h"
 #include "mapblock.h"
+#include "dummygamedef.h"
+#include "worldarchive.h"
+#include "threading/thread.h"
+#include <algorithm>
+#include <memory>
 #if USE_CURSES
 	#include "terminal_chat_console.h"
 #endif
@@ -124,7 +130,7 @@ static bool determine_subgame(GameParams *game_params);
 
 static bool run_dedicated_server(const GameParams &game_params, const Settings &cmd_args);
 static bool migrate_map_database(const GameParams &game_params, const Settings &cmd_args);
-static bool recompress_map_database(const GameParams &game_params, const Settings &cmd_args, const Address &addr);
+static bool recompress_map_database(const GameParams &game_params, bool outdated_only);
 
 /**********************************************************************/
 
@@ -229,7 +235,19 @@ int main(int argc, char *argv[])
 	// Run benchmarks
 	if (cmd_args.getFlag("run-benchmarks")) {
 #if BUILD_BENCHMARKS
-		return run_benchmarks();
+		return run_benchmarks(cmd_args);
+#else
+		errorstream << "Benchmark support is not enabled in this binary. "
+			<< "If you want to enable it, compile project with BUILD_BENCHMARKS=1 flag."
+			<< std::endl;
+		return 1;
+#endif
+	}
+
+	// Run load test against a server
+	if (cmd_args.getFlag("run-loadtest")) {
+#if BUILD_BENCHMARKS
+		return run_loadtest(cmd_args);
 #else
 		errorstream << "Benchmark support is not enabled in this binary. "
 			<< "If you want to enable it, compile project with BUILD_BENCHMARKS=1 flag."
@@ -327,6 +345,16 @@ static void set_allowed_options(OptionList *allowed_options)
 			_("Run the unit tests and exit"))));
 	allowed_options->insert(std::make_pair("run-benchmarks", ValueSpec(VALUETYPE_FLAG,
 			_("Run the benchmarks and exit"))));
+	allowed_options->insert(std::make_pair("benchmark-filter", ValueSpec(VALUETYPE_STRING,
+			_("Only run the benchmarks matching this name for --run-benchmarks"))));
+	allowed_options->insert(std::make_pair("benchmark-output", ValueSpec(VALUETYPE_STRING,
+			_("Write --run-benchmarks results as XML to this file"))));
+	allowed_options->insert(std::make_pair("run-loadtest", ValueSpec(VALUETYPE_FLAG,
+			_("Connect bots to a server (see --address and --port), print their stats and exit"))));
+	allowed_options->insert(std::make_pair("loadtest-bots", ValueSpec(VALUETYPE_STRING,
+			_("Number of bots for --run-loadtest (default 10)"))));
+	allowed_options->insert(std::make_pair("loadtest-duration", ValueSpec(VALUETYPE_STRING,
+			_("Seconds to run --run-loadtest for (default 60)"))));
 	allowed_options->insert(std::make_pair("map-dir", ValueSpec(VALUETYPE_STRING,
 			_("Same as --world (deprecated)"))));
 	allowed_options->insert(std::make_pair("world", ValueSpec(VALUETYPE_STRING,
@@ -365,6 +393,14 @@ static void set_allowed_options(OptionList *allowed_options)
 			_("Feature an interactive terminal (Only works when using minetestserver or with --server)"))));
 	allowed_options->insert(std::make_pair("recompress", ValueSpec(VALUETYPE_FLAG,
 			_("Recompress the blocks of the given map database."))));
+	allowed_options->insert(std::make_pair("upgrade-map", ValueSpec(VALUETYPE_FLAG,
+			_("Rewrite the blocks of the given map database that use an older format."))));
+	allowed_options->insert(std::make_pair("export-world", ValueSpec(VALUETYPE_STRING,
+			_("Write the databases of the given world to an archive file."))));
+	allowed_options->insert(std::make_pair("import-world", ValueSpec(VALUETYPE_STRING,
+			_("Restore the given world from an archive file."))));
+	allowed_options->insert(std::make_pair("import-region", ValueSpec(VALUETYPE_STRING,
+			_("Only restore map blocks in this area (\"x1,y1,z1 x2,y2,z2\", use with --import-world)"))));
 #ifndef SERVER
 	allowed_options->insert(std::make_pair("speedtests", ValueSpec(VALUETYPE_FLAG,
 			_("Run speed tests"))));
@@ -1071,8 +1107,15 @@ static bool run_dedicated_server(const GameParams &game_params, const Settings &
 	if (cmd_args.exists("migrate-mod-storage"))
 		return Server::migrateModStorageDatabase(game_params, cmd_args);
 
-	if (cmd_args.getFlag("recompress"))
-		return recompress_map_database(game_params, cmd_args, bind_addr);
+	if (cmd_args.getFlag("recompress") || cmd_args.getFlag("upgrade-map"))
+		return recompress_map_database(game_params, cmd_args.getFlag("upgrade-map"));
+
+	if (cmd_args.exists("export-world"))
+		return export_world(game_params.world_path, cmd_args.get("export-world"));
+
+	if (cmd_args.exists("import-world"))
+		return import_world(game_params.world_path, cmd_args.get("import-world"),
+			cmd_args.exists("import-region") ? cmd_args.get("import-region") : "");
 
 	if (cmd_args.exists("terminal")) {
 #if USE_CURSES
@@ -1224,7 +1267,88 @@ static bool migrate_map_database(const GameParams &game_params, const Settings &
 	return true;
 }
 
-static bool recompress_map_database(const GameParams &game_params, const Settings &cmd_args, const Address &addr)
+// Blocks that are loaded, recompressed and written back in one transaction
+static const size_t RECOMPRESS_BATCH = 4096;
+
+struct RecompressItem
+{
+	v3s32 pos;
+	std::string data;
+	// Whether data was rewritten and has to be saved
+	bool changed = false;
+	bool failed = false;
+};
+
+class RecompressThread : public Thread
+{
+public:
+	RecompressThread(std::vector<RecompressItem> &items, size_t begin, size_t end,
+			bool outdated_only, int compression_level) :
+		Thread("Recompress"),
+		m_items(items), m_begin(begin), m_end(end),
+		m_outdated_only(outdated_only), m_compression_level(compression_level)
+	{}
+
+	static void recompressRange(std::vector<RecompressItem> &items,
+			size_t begin, size_t end, bool outdated_only, int compression_level)
+	{
+		// Node names are allocated while deserializing, so every thread
+		// needs its own definitions
+		DummyGameDef gamedef;
+		const u8 serialize_as_ver = SER_FMT_VER_HIGHEST_WRITE;
+		std::istringstream iss(std::ios_base::binary);
+		std::ostringstream oss(std::ios_base::binary);
+
+		for (size_t i = begin; i < end; i++) {
+			RecompressItem &item = items[i];
+			if (item.data.empty()) {
+				item.failed = true;
+				continue;
+			}
+
+			iss.str(item.data);
+			iss.clear();
+			try {
+				u8 ver = readU8(iss);
+				if (outdated_only && ver >= serialize_as_ver)
+					continue;
+
+				MapBlock mb(nullptr, v3s32(0, 0, 0), &gamedef);
+				mb.deSerialize(iss, ver, true);
+
+				oss.str("");
+				oss.clear();
+				writeU8(oss, serialize_as_ver);
+				mb.serialize(oss, serialize_as_ver, true, compression_level);
+			} catch (SerializationError &e) {
+				item.failed = true;
+				continue;
+			}
+			item.data = oss.str();
+			item.changed = true;
+		}
+	}
+
+	void *run()
+	{
+		BEGIN_DEBUG_EXCEPTION_HANDLER
+
+		recompressRange(m_items, m_begin, m_end, m_outdated_only,
+				m_compression_level);
+
+		END_DEBUG_EXCEPTION_HANDLER
+
+		return nullptr;
+	}
+
+private:
+	std::vector<RecompressItem> &m_items;
+	size_t m_begin, m_end;
+	bool m_outdated_only;
+	int m_compression_level;
+};
+
+static bool recompress_map_database(const GameParams &game_params, bool outdated_only)
 {
 	Settings world_mt;
 	const std::string world_mt_path = game_params.world_path + DIR_DELIM + "world.mt";
@@ -1234,58 +1358,135 @@ static bool recompress_map_database(const GameParams &game_params, const Setting
 		return false;
 	}
 	const std::string &backend = world_mt.get("backend");
-	Server server(game_params.world_path, game_params.game_spec, false, addr, false);
-	MapDatabase *db = ServerMap::createDatabase(backend, game_params.world_path, world_mt);
+	std::unique_ptr<MapDatabase> db(ServerMap::createDatabase(backend,
+			game_params.world_path, world_mt));
 
-	u32 count = 0;
-	u64 last_update_time = 0;
+	const int compression_level = rangelim(
+			g_settings->getS32("map_compression_level_disk"), -1, 9);
+	const u32 num_threads = std::max(1U, Thread::getNumberOfProcessors());
+	const char *done_verb = outdated_only ? "upgraded" : "recompressed";
 	bool &kill = *porting::signal_handler_killstatus();
-	const u8 serialize_as_ver = SER_FMT_VER_HIGHEST_WRITE;
 
-	// This is ok because the server doesn't actually run
+	// In database key order, so that reads and writes are mostly sequential
 	std::vector<v3s32> blocks;
 	db->listAllLoadableBlocks(blocks);
-	db->beginSave();
-	std::istringstream iss(std::ios_base::binary);
-	std::ostringstream oss(std::ios_base::binary);
-	for (auto it = blocks.begin(); it != blocks.end(); ++it) {
-		if (kill) return false;
-
-		std::string data;
-		db->loadBlock(*it, &data);
-		if (data.empty()) {
-			errorstream << "Failed to load block " << PP(*it) << std::endl;
-			return false;
+	std::sort(blocks.begin(), blocks.end(), [] (const v3s32 &a, const v3s32 &b) {
+		return MapDatabase::getBlockAsInteger(a) < MapDatabase::getBlockAsInteger(b);
+	});
+
+	// An interrupted run leaves the key of the last block it wrote
+	const std::string checkpoint_path = game_params.world_path +
+			DIR_DELIM "recompress_checkpoint.txt";
+	const std::string mode = outdated_only ? "upgrade" : "recompress";
+	size_t first = 0;
+	std::string checkpoint;
+	if (fs::ReadFile(checkpoint_path, checkpoint)) {
+		std::istringstream is(checkpoint);
+		std::string checkpoint_mode;
+		s64 last_key;
+		if (is >> checkpoint_mode >> last_key && checkpoint_mode == mode) {
+			first = std::upper_bound(blocks.begin(), blocks.end(), last_key,
+				[] (s64 key, const v3s32 &pos) {
+					return key < MapDatabase::getBlockAsInteger(pos);
+				}) - blocks.begin();
+			actionstream << "Resuming after " << first << " of "
+				<< blocks.size() << " blocks" << std::endl;
+		} else {
+			warningstream << "Ignoring checkpoint of a different run at "
+				<< checkpoint_path << std::endl;
 		}
+	}
 
-		iss.str(data);
-		iss.clear();
-
-		{
-			MapBlock mb(nullptr, v3s32(0,0,0), &server);
-			u8 ver = readU8(iss);
-			mb.deSerialize(iss, ver, true);
+	u64 count = 0, failed = 0, bytes_in = 0;
+	const u64 start_time = porting::getTimeMs();
+	u64 last_update_time = start_time;
+
+	// Recompressed blocks waiting to be written
+	std::vector<RecompressItem> pending;
+	auto write_pending = [&] () -> bool {
+		if (pending.empty())
+			return true;
+
+		std::vector<std::pair<v3s32, std::string>> data;
+		for (RecompressItem &item : pending) {
+			if (item.failed) {
+				errorstream << "Failed to recompress block " << PP(item.pos)
+					<< ", skipping it." << std::endl;
+				failed++;
+			} else if (item.changed) {
+				data.emplace_back(item.pos, std::move(item.data));
+			}
+		}
 
-			oss.str("");
-			oss.clear();
-			writeU8(oss, serialize_as_ver);
-			mb.serialize(oss, serialize_as_ver, true, -1);
+		db->beginSave();
+		bool ok = db->saveBlocks(data);
+		db->endSave();
+		if (!ok) {
+			errorstream << "Failed to save recompressed blocks" << std::endl;
+			return false;
 		}
+		count += data.size();
 
-		db->saveBlock(*it, oss.str());
+		fs::safeWriteToFile(checkpoint_path, mode + " " +
+			std::to_string(MapDatabase::getBlockAsInteger(pending.back().pos)) + "\n");
+		pending.clear();
+		return true;
+	};
+
+	for (size_t begin = first; begin < blocks.size() && !kill; begin += RECOMPRESS_BATCH) {
+		size_t end = std::min(begin + RECOMPRESS_BATCH, blocks.size());
+		std::vector<v3s32> positions(blocks.begin() + begin, blocks.begin() + end);
+		std::vector<std::string> blobs;
+		db->loadBlocks(positions, blobs);
+
+		std::vector<RecompressItem> batch(positions.size());
+		for (size_t i = 0; i < batch.size(); i++) {
+			batch[i].pos = positions[i];
+			batch[i].data = std::move(blobs[i]);
+			bytes_in += batch[i].data.size();
+		}
 
-		count++;
-		if (count % 0xFF == 0 && porting::getTimeS() - last_update_time >= 1) {
-			std::cerr << " Recompressed " << count << " blocks, "
-				<< (100.0f * count / blocks.size()) << "% completed.\r";
-			db->endSave();
-			db->beginSave();
-			last_update_time = porting::getTimeS();
+		// The previous batch is written while this one is recompressed
+		std::vector<std::unique_ptr<RecompressThread>> threads;
+		size_t chunk = (batch.size() + num_threads - 1) / num_threads;
+		for (size_t i = 0; i < batch.size(); i += chunk) {
+			threads.emplace_back(new RecompressThread(batch, i,
+				std::min(i + chunk, batch.size()), outdated_only, compression_level));
+			threads.back()->start();
+		}
+		bool ok = write_pending();
+		for (auto &thread : threads)
+			thread->wait();
+		if (!ok)
+			return false;
+		pending = std::move(batch);
+
+		u64 now = porting::getTimeMs();
+		if (now - last_update_time >= 1000) {
+			f32 seconds = (now - start_time) / 1000.0f;
+			f32 rate = (end - first) / seconds;
+			std::cerr << " Processed " << end << " of " << blocks.size() << " blocks, "
+				<< (100.0f * end / blocks.size()) << "% completed, "
+				<< (u32)rate << " blocks/s, "
+				<< (bytes_in / seconds / (1024 * 1024)) << " MB/s, "
+				<< (u32)((blocks.size() - end) / rate) << " s left.\r";
+			last_update_time = now;
 		}
 	}
+	if (!write_pending())
+		return false;
 	std::cerr << std::endl;
-	db->endSave();
 
-	actionstream << "Done, " << count << " blocks were recompressed." << std::endl;
+	if (kill) {
+		actionstream << "Interrupted after " << count << " blocks were "
+			<< done_verb << ", run again to resume." << std::endl;
+		return false;
+	}
+
+	fs::DeleteSingleFileOrEmptyDirectory(checkpoint_path);
+	actionstream << "Done, " << count << " blocks were " << done_verb;
+	if (failed > 0)
+		actionstream << ", " << failed << " could not be read";
+	actionstream << "." << std::endl;
 	return true;
 }
@@ -21,6 +21,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "mapsector.h"
 #include "mapblock.h"
 #include "filesys.h"
+#include "mapjournal.h"
 #include "voxel.h"
 #include "voxelalgorithms.h"
 #include "porting.h"
@@ -1262,9 +1263,8 @@ ServerMap::ServerMap(const std::string &savedir, IGameDef *gamedef,
 						"directory." << std::endl;
 				}
 
-				m_map_saving_enabled = true;
 				// Map loaded, not creating new one
-				return;
+				m_map_saving_enabled = true;
 			}
 		}
 		// If directory doesn't exist, it is safe to save to it
@@ -1279,6 +1279,12 @@ ServerMap::ServerMap(const std::string &savedir, IGameDef *gamedef,
 		infostream<<"Please remove the map or fix it."<<std::endl;
 		warningstream<<"Map saving will be disabled."<<std::endl;
 	}
+
+	// Changes could not be checkpointed without saving
+	if (m_map_saving_enabled && g_settings->getBool("map_journal")) {
+		m_journal = std::make_unique<MapJournal>(savedir, m_nodedef);
+		addEventReceiver(m_journal.get());
+	}
 }
 
 ServerMap::~ServerMap()
@@ -1645,6 +1651,11 @@ void ServerMap::save(ModifiedState save_level)
 	// Don't do anything with sqlite unless something is really saved
 	bool save_started = false;
 
+	// Blocks are written in batches to save database round trips
+	const size_t batch_size = 64;
+	MapBlockVect batch;
+	bool save_ok = true;
+
 	for (auto &sector_it : m_sectors) {
 		MapSector *sector = sector_it.second;
 
@@ -1663,15 +1674,32 @@ void ServerMap::save(ModifiedState save_level)
 
 				modprofiler.add(block->getModifiedReasonString(), 1);
 
-				saveBlock(block);
+				batch.push_back(block);
+				if (batch.size() >= batch_size) {
+					save_ok &= saveBlocks(batch);
+					batch.clear();
+				}
 				block_count++;
 			}
 		}
 	}
 
+	if (!batch.empty())
+		save_ok &= saveBlocks(batch);
+
 	if(save_started)
 		endSave();
 
+	// Every change recorded in the journal is in the database now.
+	// Otherwise the journal is the only copy of the unsaved changes.
+	if (!save_ok) {
+		errorstream << "ServerMap: Failed to save some blocks" << std::endl;
+	} else if (m_journal && save_level <= MOD_STATE_WRITE_NEEDED) {
+		m_journal->clear();
+		m_checkpoint_queue.clear();
+		m_checkpoint_index = 0;
+	}
+
 	/*
 		Only print if something happened or saved whole map
 	*/
@@ -1712,6 +1740,107 @@ void ServerMap::listAllLoadedBlocks(std::vector<v3s32> &dst)
 	}
 }
 
+void ServerMap::stepJournal(float dtime)
+{
+	if (!m_journal)
+		return;
+
+	m_checkpoint_timer += dtime;
+
+	const u32 max_saves = m_checkpoint_blocks.get();
+	const u32 max_checks = max_saves * 32;
+	u32 saved = 0, checked = 0;
+	bool save_started = false;
+
+	auto save_block = [&] (MapBlock *block) {
+		if (!save_started) {
+			beginSave();
+			save_started = true;
+		}
+		saveBlock(block);
+		saved++;
+	};
+
+	// Blocks modified without journal records are not recoverable, save them first
+	v3s32 blockpos;
+	while (saved < max_saves && m_journal->popUnjournaledBlock(blockpos)) {
+		MapBlock *block = getBlockNoCreateNoEx(blockpos);
+		if (block && block->getModified() >= MOD_STATE_WRITE_NEEDED)
+			save_block(block);
+	}
+
+	// Continue the checkpoint of the blocks that were loaded at its start
+	while (saved < max_saves && checked < max_checks &&
+			m_checkpoint_index < m_checkpoint_queue.size()) {
+		MapBlock *block = getBlockNoCreateNoEx(m_checkpoint_queue[m_checkpoint_index++]);
+		checked++;
+		if (block && block->getModified() >= MOD_STATE_WRITE_NEEDED)
+			save_block(block);
+	}
+
+	if (save_started)
+		endSave();
+
+	if (m_checkpoint_index >= m_checkpoint_queue.size()) {
+		// Unloaded blocks were saved by unloadUnusedData()
+		m_journal->dropOldSegment();
+
+		if (m_checkpoint_timer >= m_checkpoint_interval.get()) {
+			m_checkpoint_timer = 0.0f;
+			m_journal->rotate();
+			m_checkpoint_queue.clear();
+			m_checkpoint_index = 0;
+			listAllLoadedBlocks(m_checkpoint_queue);
+		}
+	}
+
+	m_journal->flush();
+}
+
+size_t ServerMap::replayJournal()
+{
+	std::unique_ptr<MapJournal> tmp;
+	MapJournal *journal = m_journal.get();
+	if (!journal) {
+		// Recover changes from a run that had the journal enabled
+		tmp = std::make_unique<MapJournal>(m_savedir, m_nodedef);
+		journal = tmp.get();
+	}
+
+	std::map<v3s32, MapBlock*> modified_blocks;
+	size_t count = journal->replay([&] (v3s32 p, MapNode n, bool remove_metadata) {
+		if (!emergeBlock(getNodeBlockPos(p), false))
+			return false;
+		try {
+			addNodeAndUpdate(p, n, modified_blocks, remove_metadata);
+		} catch (InvalidPositionException &e) {
+			return false;
+		}
+		return true;
+	});
+
+	if (count > 0) {
+		actionstream << "ServerMap: Replayed " << count
+				<< " node changes from the map journal" << std::endl;
+		if (m_map_saving_enabled)
+			save(MOD_STATE_WRITE_NEEDED);
+	}
+	if (!m_map_saving_enabled)
+		return count;
+
+	// Keep the journal if any replayed change failed to be saved
+	for (auto &sector_it : m_sectors) {
+		MapBlockVect blocks;
+		sector_it.second->getBlocks(blocks);
+		for (MapBlock *block : blocks) {
+			if (block->getModified() >= MOD_STATE_WRITE_NEEDED)
+				return count;
+		}
+	}
+	journal->clear();
+	return count;
+}
+
 MapDatabase *ServerMap::createDatabase(
 	const std::string &name,
 	const std::string &savedir,
@@ -1752,7 +1881,34 @@ void ServerMap::endSave()
 
 bool ServerMap::saveBlock(MapBlock *block)
 {
-	return saveBlock(block, dbase, m_map_compression_level);
+	bool ret = saveBlock(block, dbase, m_map_compression_level);
+	if (ret && m_journal)
+		m_journal->blockSaved(block->getPos());
+	return ret;
+}
+
+bool ServerMap::saveBlocks(const MapBlockVect &blocks)
+{
+	std::vector<std::pair<v3s32, std::string>> data;
+	data.reserve(blocks.size());
+	for (MapBlock *block : blocks) {
+		std::ostringstream o(std::ios_base::binary);
+		u8 version = SER_FMT_VER_HIGHEST_WRITE;
+		o.write((char*) &version, 1);
+		block->serialize(o, version, true, m_map_compression_level);
+		data.emplace_back(block->getPos(), o.str());
+	}
+
+	if (!dbase->saveBlocks(data))
+		return false;
+
+	for (MapBlock *block : blocks) {
+		// We just wrote it to the disk so clear modified flag
+		block->resetModified();
+		if (m_journal)
+			m_journal->blockSaved(block->getPos());
+	}
+	return true;
 }
 
 bool ServerMap::saveBlock(MapBlock *block, MapDatabase *db, int compression_level)
@@ -1839,6 +1995,64 @@ void ServerMap::loadBlock(std::string *blob, v3s32 p3d, MapSector *sector, bool
 	}
 }
 
+void ServerMap::loadBlocks(const std::vector<v3s32> &positions,
+		std::vector<v3s32> *loaded)
+{
+	std::vector<v3s32> missing;
+	for (v3s32 blockpos : positions) {
+		if (!getBlockNoCreateNoEx(blockpos))
+			missing.push_back(blockpos);
+	}
+	if (missing.empty())
+		return;
+
+	std::vector<std::string> blobs;
+	dbase->loadBlocks(missing, blobs);
+
+	if (dbase_ro) {
+		std::vector<v3s32> missing_ro;
+		std::vector<size_t> index_ro;
+		for (size_t i = 0; i < missing.size(); i++) {
+			if (blobs[i].empty()) {
+				missing_ro.push_back(missing[i]);
+				index_ro.push_back(i);
+			}
+		}
+
+		std::vector<std::string> blobs_ro;
+		if (!missing_ro.empty())
+			dbase_ro->loadBlocks(missing_ro, blobs_ro);
+		for (size_t i = 0; i < blobs_ro.size(); i++)
+			blobs[index_ro[i]] = std::move(blobs_ro[i]);
+	}
+
+	std::map<v3s32, MapBlock*> modified_blocks;
+	for (size_t i = 0; i < missing.size(); i++) {
+		if (blobs[i].empty())
+			continue;
+
+		v3s32 blockpos = missing[i];
+		loadBlock(&blobs[i], blockpos,
+			createSector(v2s32(blockpos.X, blockpos.Z)), false);
+
+		// Fix lighting if necessary
+		MapBlock *block = getBlockNoCreateNoEx(blockpos);
+		if (!block)
+			continue;
+		voxalgo::update_block_border_lighting(this, block, modified_blocks);
+		if (loaded)
+			loaded->push_back(blockpos);
+	}
+
+	if (!modified_blocks.empty()) {
+		//Modified lighting, send event
+		MapEditEvent event;
+		event.type = MEET_OTHER;
+		event.setModifiedBlocks(modified_blocks);
+		dispatchEvent(event);
+	}
+}
+
 MapBlock* ServerMap::loadBlock(v3s32 blockpos)
 {
 	bool created_new = (getBlockNoCreateNoEx(blockpos) == NULL);
@@ -24,6 +24,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <set>
 #include <map>
 #include <list>
+#include <memory>
 
 #include "irrlichttypes_bloated.h"
 #include "mapblock.h"
@@ -50,6 +51,7 @@ class IRollbackManager;
 class EmergeManager;
 class MetricsBackend;
 class ServerEnvironment;
+class MapJournal;
 struct BlockMakeData;
 
 /*
@@ -408,7 +410,13 @@ class ServerMap : public Map
 
 	bool saveBlock(MapBlock *block) override;
 	static bool saveBlock(MapBlock *block, MapDatabase *db, int compression_level = -1);
+	// Saves the blocks with a single batched database call
+	bool saveBlocks(const MapBlockVect &blocks);
 	MapBlock* loadBlock(v3s32 p);
+	// Loads those of the blocks that are not in memory with a single
+	// batched database call, optionally returns the loaded positions
+	void loadBlocks(const std::vector<v3s32> &positions,
+			std::vector<v3s32> *loaded = nullptr);
 	// Database version
 	void loadBlock(std::string *blob, v3s32 p3d, MapSector *sector, bool save_after_load=false);
 
@@ -421,6 +429,15 @@ class ServerMap : public Map
 
 	bool isSavingEnabled(){ return m_map_saving_enabled; }
 
+	/*
+		Map journal (see mapjournal.h)
+	*/
+	// Saves a few blocks towards the next checkpoint and writes the journal
+	void stepJournal(float dtime);
+	// Applies the journal left by an unclean shutdown, returns the number
+	// of replayed changes
+	size_t replayJournal();
+
 	u64 getSeed();
 
 	/*!
@@ -476,6 +493,18 @@ class ServerMap : public Map
 	MetricGaugePtr m_loaded_blocks_gauge;
 	MetricCounterPtr m_save_time_counter;
 	MetricCounterPtr m_save_count_counter;
+
+	std::unique_ptr<MapJournal> m_journal;
+	// Loaded blocks to be saved before the old journal segment can be dropped
+	std::vector<v3s32> m_checkpoint_queue;
+	size_t m_checkpoint_index = 0;
+	float m_checkpoint_timer = 0.0f;
+	SettingHandle<float> m_checkpoint_interval {g_settings,
+		"map_journal_checkpoint_interval"};
+	SettingHandle<u32> m_checkpoint_blocks {g_settings, "map_journal_checkpoint_blocks",
+		[](const Settings *settings, const std::string &name) {
+			return (u32)MYMAX(1, settings->getS32(name));
+		}};
 };
 
 
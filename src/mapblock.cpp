@@ -200,6 +200,33 @@ void MapBlock::copyFrom(VoxelManipulator &dst)
 	// Copy from VoxelManipulator to data
 	dst.copyTo(data, data_area, v3s32(0,0,0),
 			getPosRelative(), data_size);
+
+	m_collision_cache_valid = false;
+	m_air_only_valid = false;
+}
+
+const BlockCollisionCache &MapBlock::getCollisionCache()
+{
+	if (!m_collision_cache_valid) {
+		m_collision_cache.update(this, m_gamedef->ndef());
+		m_collision_cache_valid = true;
+	}
+	return m_collision_cache;
+}
+
+bool MapBlock::isAirOnly()
+{
+	if (!m_air_only_valid) {
+		m_air_only = true;
+		for (u32 i = 0; i < nodecount; i++) {
+			if (data[i].getContent() != CONTENT_AIR) {
+				m_air_only = false;
+				break;
+			}
+		}
+		m_air_only_valid = true;
+	}
+	return m_air_only;
 }
 
 void MapBlock::actuallyUpdateDayNightDiff()
@@ -490,6 +517,8 @@ void MapBlock::deSerialize(std::istream &in_compressed, u8 version, bool disk)
 	TRACESTREAM(<<"MapBlock::deSerialize "<<PP(getPos())<<std::endl);
 
 	m_day_night_differs_expired = false;
+	m_collision_cache_valid = false;
+	m_air_only_valid = false;
 
 	if(version <= 21)
 	{
@@ -31,6 +31,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "util/numeric.h" // getContainerPos
 #include "settings.h"
 #include "mapgen/mapgen.h"
+#include "collision.h"
 
 class Map;
 class NodeMetadataList;
@@ -111,8 +112,11 @@ class MapBlock
 		} else if (mod == m_modified) {
 			m_modified_reason |= reason;
 		}
-		if (mod == MOD_STATE_WRITE_NEEDED)
+		if (mod == MOD_STATE_WRITE_NEEDED) {
 			contents_cached = false;
+			m_collision_cache_valid = false;
+			m_air_only_valid = false;
+		}
 	}
 
 	inline u32 getModified()
@@ -325,6 +329,12 @@ class MapBlock
 		return m_day_night_differs;
 	}
 
+	// Collision boxes of the nodes, rebuilt after the block was modified
+	const BlockCollisionCache &getCollisionCache();
+
+	// Whether every node of the block is air
+	bool isAirOnly();
+
 	bool onObjectsActivation();
 	bool saveStaticObject(u16 id, const StaticObject &obj, u32 reason);
 
@@ -419,6 +429,23 @@ class MapBlock
 		m_node_timers.clear();
 	}
 
+	// While attached, the node timers advance with the clock of the wheel
+	// instead of by step()
+	inline void attachNodeTimers(NodeTimerWheel *wheel)
+	{
+		m_node_timers.attach(wheel, getPos());
+	}
+
+	inline void detachNodeTimers()
+	{
+		m_node_timers.detach();
+	}
+
+	inline bool nodeTimersAttached() const
+	{
+		return m_node_timers.isAttached();
+	}
+
 	////
 	//// Serialization
 	///
@@ -524,6 +551,12 @@ class MapBlock
 	bool m_day_night_differs = false;
 	bool m_day_night_differs_expired = true;
 
+	BlockCollisionCache m_collision_cache;
+	bool m_collision_cache_valid = false;
+
+	bool m_air_only = false;
+	bool m_air_only_valid = false;
+
 	bool m_generated = false;
 
 	/*
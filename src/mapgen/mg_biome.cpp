@@ -27,6 +27,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "util/numeric.h"
 #include "porting.h"
 #include "settings.h"
+#include <algorithm>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -67,7 +68,9 @@ BiomeManager::BiomeManager(Server *server) :
 	b->m_nodenames.emplace_back("ignore");
 	b->m_nodenames.emplace_back("ignore");
 	b->m_nodenames.emplace_back("ignore");
-	m_ndef->pendNodeResolve(b);
+	// No node definitions without a server, e.g. in benchmarks
+	if (m_ndef)
+		m_ndef->pendNodeResolve(b);
 
 	add(b);
 }
@@ -147,6 +150,9 @@ BiomeGenOriginal::BiomeGenOriginal(BiomeManager *biomemgr,
 	// fallback biome when biome generation (which calculates the biomemap IDs)
 	// is disabled.
 	memset(biomemap, 0, sizeof(biome_t) * m_csize.X * m_csize.Z);
+
+	// Biomes can no longer be registered once the biome generator exists
+	buildBiomeBands();
 }
 
 BiomeGenOriginal::~BiomeGenOriginal()
@@ -232,36 +238,119 @@ Biome *BiomeGenOriginal::getBiomeAtIndex(size_t index, v3s32 pos) const
 }
 
 
-Biome *BiomeGenOriginal::calcBiomeFromNoise(float heat, float humidity, v3s32 pos) const
+void BiomeGenOriginal::buildBiomeBands()
 {
-	Biome *biome_closest = nullptr;
-	Biome *biome_closest_blend = nullptr;
-	float dist_min = FLT_MAX;
-	float dist_min_blend = FLT_MAX;
+	std::vector<s32> limits;
+	limits.push_back(S32_MIN);
+	auto add_limit = [&limits] (s64 y) {
+		if (y > S32_MIN && y <= S32_MAX)
+			limits.push_back(y);
+	};
 
 	for (size_t i = 1; i < m_bmgr->getNumObjects(); i++) {
 		Biome *b = (Biome *)m_bmgr->getRaw(i);
-		if (!b ||
-				pos.Y < b->min_pos.Y || pos.Y > b->max_pos.Y + b->vertical_blend ||
-				pos.X < b->min_pos.X || pos.X > b->max_pos.X ||
-				pos.Z < b->min_pos.Z || pos.Z > b->max_pos.Z)
+		if (!b)
 			continue;
+		add_limit(b->min_pos.Y);
+		add_limit((s64)b->max_pos.Y + 1);
+		add_limit((s64)b->max_pos.Y + b->vertical_blend + 1);
+	}
+	std::sort(limits.begin(), limits.end());
+	limits.erase(std::unique(limits.begin(), limits.end()), limits.end());
+
+	m_biome_bands.clear();
+	m_biome_bands.resize(limits.size());
+	for (size_t band_i = 0; band_i < limits.size(); band_i++) {
+		BiomeBand &band = m_biome_bands[band_i];
+		s32 y = limits[band_i];
+		band.y_min = y;
+
+		for (size_t i = 1; i < m_bmgr->getNumObjects(); i++) {
+			Biome *b = (Biome *)m_bmgr->getRaw(i);
+			if (!b || y < b->min_pos.Y ||
+					y > (s64)b->max_pos.Y + b->vertical_blend)
+				continue;
+
+			BiomeCandidate candidate = {b->heat_point, b->humidity_point, b};
+			if (y <= b->max_pos.Y)
+				band.biomes.push_back(candidate);
+			else
+				band.blend_biomes.push_back(candidate);
+		}
+
+		auto by_heat = [] (const BiomeCandidate &a, const BiomeCandidate &b) {
+			return a.heat_point < b.heat_point;
+		};
+		std::sort(band.biomes.begin(), band.biomes.end(), by_heat);
+		std::sort(band.blend_biomes.begin(), band.blend_biomes.end(), by_heat);
+	}
+}
+
+
+const BiomeGenOriginal::BiomeBand &BiomeGenOriginal::getBiomeBand(s32 y) const
+{
+	auto it = std::upper_bound(m_biome_bands.begin(), m_biome_bands.end(), y,
+		[] (s32 value, const BiomeBand &band) { return value < band.y_min; });
+	return *(it - 1);
+}
 
-		float d_heat = heat - b->heat_point;
-		float d_humidity = humidity - b->humidity_point;
-		float dist = (d_heat * d_heat) + (d_humidity * d_humidity);
 
-		if (pos.Y <= b->max_pos.Y) { // Within y limits of biome b
-			if (dist < dist_min) {
-				dist_min = dist;
-				biome_closest = b;
-			}
-		} else if (dist < dist_min_blend) { // Blend area above biome b
-			dist_min_blend = dist;
-			biome_closest_blend = b;
+Biome *BiomeGenOriginal::findClosestBiome(
+	const std::vector<BiomeCandidate> &candidates,
+	float heat, float humidity, v3s32 pos, float *dist_min)
+{
+	Biome *closest = nullptr;
+
+	auto check = [&] (const BiomeCandidate &c, float d_heat) {
+		Biome *b = c.biome;
+		if (pos.X < b->min_pos.X || pos.X > b->max_pos.X ||
+				pos.Z < b->min_pos.Z || pos.Z > b->max_pos.Z)
+			return;
+
+		float d_humidity = humidity - c.humidity_point;
+		float dist = (d_heat * d_heat) + (d_humidity * d_humidity);
+		// Same result as scanning all biomes by index
+		if (dist < *dist_min || (closest && dist == *dist_min &&
+				b->index < closest->index)) {
+			*dist_min = dist;
+			closest = b;
 		}
+	};
+
+	// Search outwards from the heat value. Candidates further away in heat
+	// alone than the best distance so far cannot be closer.
+	auto split = std::lower_bound(candidates.begin(), candidates.end(), heat,
+		[] (const BiomeCandidate &c, float value) { return c.heat_point < value; });
+
+	for (auto it = split; it != candidates.end(); ++it) {
+		float d_heat = heat - it->heat_point;
+		if (d_heat * d_heat > *dist_min)
+			break;
+		check(*it, d_heat);
+	}
+	for (auto it = split; it != candidates.begin();) {
+		--it;
+		float d_heat = heat - it->heat_point;
+		if (d_heat * d_heat > *dist_min)
+			break;
+		check(*it, d_heat);
 	}
 
+	return closest;
+}
+
+
+Biome *BiomeGenOriginal::calcBiomeFromNoise(float heat, float humidity, v3s32 pos) const
+{
+	const BiomeBand &band = getBiomeBand(pos.Y);
+
+	float dist_min = FLT_MAX;
+	float dist_min_blend = FLT_MAX;
+	Biome *biome_closest = findClosestBiome(band.biomes,
+		heat, humidity, pos, &dist_min);
+	Biome *biome_closest_blend = findClosestBiome(band.blend_biomes,
+		heat, humidity, pos, &dist_min_blend);
+
 	// Carefully tune pseudorandom seed variation to avoid single node dither
 	// and create larger scale blending patterns similar to horizontal biome
 	// blend.
@@ -191,8 +191,34 @@ class BiomeGenOriginal : public BiomeGen {
 	float *humidmap;
 
 private:
+	struct BiomeCandidate {
+		float heat_point;
+		float humidity_point;
+		Biome *biome;
+	};
+
+	// Y range between two consecutive biome Y limits. Within a band every
+	// biome is either inside its Y limits, inside its vertical blend area or
+	// absent. Candidates are sorted by heat point.
+	struct BiomeBand {
+		s32 y_min;
+		std::vector<BiomeCandidate> biomes;
+		std::vector<BiomeCandidate> blend_biomes;
+	};
+
+	void buildBiomeBands();
+	const BiomeBand &getBiomeBand(s32 y) const;
+
+	// Closest candidate by heat/humidity distance, ties go to the lowest
+	// biome index. Updates dist_min if a closer biome is found.
+	static Biome *findClosestBiome(const std::vector<BiomeCandidate> &candidates,
+		float heat, float humidity, v3s32 pos, float *dist_min);
+
 	const BiomeParamsOriginal *m_params;
 
+	// Sorted by y_min, the first band starts at S32_MIN
+	std::vector<BiomeBand> m_biome_bands;
+
 	Noise *noise_heat;
 	Noise *noise_humidity;
 	Noise *noise_heat_blend;
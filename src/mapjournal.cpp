@@ -0,0 +1,285 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "mapjournal.h"
+#include <unordered_map>
+#include "exceptions.h"
+#include "filesys.h"
+#include "log.h"
+#include "nodedef.h"
+#include "util/serialize.h"
+#ifdef _WIN32
+	#include <fcntl.h>
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+#define JOURNAL_VERSION 1
+
+enum JournalRecord : u8
+{
+	JOURNAL_NAME = 1,      // u16 id, string16 name
+	JOURNAL_SETNODE = 2,   // v3s32 p, u16 content, u8 param1, u8 param2
+	JOURNAL_SWAPNODE = 3,  // same as JOURNAL_SETNODE, keeps metadata
+	JOURNAL_SAVED = 4,     // v3s32 blockpos
+};
+
+MapJournal::MapJournal(const std::string &savedir, const NodeDefManager *ndef) :
+	m_path(savedir + DIR_DELIM + "map_journal"),
+	m_old_path(savedir + DIR_DELIM + "map_journal.old"),
+	m_ndef(ndef)
+{
+}
+
+MapJournal::~MapJournal()
+{
+	flush();
+	closeFile();
+}
+
+// Flushes the file to the disk, so that it survives a crash or power loss
+static bool sync_file(FILE *file)
+{
+	if (fflush(file) != 0)
+		return false;
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#elif defined(__linux__)
+	return fdatasync(fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+static void truncate_file(const std::string &path, long size)
+{
+#ifdef _WIN32
+	int fd = _open(path.c_str(), _O_WRONLY | _O_BINARY);
+	if (fd != -1) {
+		_chsize_s(fd, size);
+		_close(fd);
+	}
+#else
+	if (truncate(path.c_str(), size) != 0) {
+		errorstream << "MapJournal: failed to truncate " << path << std::endl;
+	}
+#endif
+}
+
+void MapJournal::closeFile()
+{
+	if (m_file) {
+		fclose(m_file);
+		m_file = nullptr;
+	}
+}
+
+void MapJournal::onMapEditEvent(const MapEditEvent &event)
+{
+	switch (event.type) {
+	case MEET_ADDNODE:
+	case MEET_REMOVENODE:
+		appendNode(event.p, event.n, true);
+		break;
+	case MEET_SWAPNODE:
+		appendNode(event.p, event.n, false);
+		break;
+	case MEET_BLOCK_NODE_METADATA_CHANGED:
+		m_unjournaled_blocks.insert(getNodeBlockPos(event.p));
+		break;
+	case MEET_OTHER:
+		for (v3s32 blockpos : event.modified_blocks)
+			m_unjournaled_blocks.insert(blockpos);
+		break;
+	}
+}
+
+void MapJournal::appendNode(v3s32 p, MapNode n, bool remove_metadata)
+{
+	if (m_named_ids.insert(n.getContent()).second) {
+		writeU8(m_buffer, JOURNAL_NAME);
+		writeU16(m_buffer, n.getContent());
+		m_buffer << serializeString16(m_ndef->get(n).name);
+	}
+
+	writeU8(m_buffer, remove_metadata ? JOURNAL_SETNODE : JOURNAL_SWAPNODE);
+	writeV3S32(m_buffer, p);
+	writeU16(m_buffer, n.getContent());
+	writeU8(m_buffer, n.getParam1());
+	writeU8(m_buffer, n.getParam2());
+}
+
+void MapJournal::blockSaved(v3s32 blockpos)
+{
+	writeU8(m_buffer, JOURNAL_SAVED);
+	writeV3S32(m_buffer, blockpos);
+	m_unjournaled_blocks.erase(blockpos);
+}
+
+bool MapJournal::popUnjournaledBlock(v3s32 &blockpos)
+{
+	if (m_unjournaled_blocks.empty())
+		return false;
+
+	auto it = m_unjournaled_blocks.begin();
+	blockpos = *it;
+	m_unjournaled_blocks.erase(it);
+	return true;
+}
+
+void MapJournal::flush()
+{
+	std::string data = m_buffer.str();
+	if (data.empty())
+		return;
+
+	if (!m_file) {
+		m_file = fopen(m_path.c_str(), "ab");
+		if (!m_file) {
+			errorstream << "MapJournal: failed to open " << m_path << std::endl;
+			return;
+		}
+	}
+
+	fseek(m_file, 0, SEEK_END);
+	long start = ftell(m_file);
+	if (start == 0)
+		data.insert(data.begin(), (char)JOURNAL_VERSION);
+
+	if (fwrite(data.c_str(), 1, data.size(), m_file) != data.size() ||
+			!sync_file(m_file)) {
+		errorstream << "MapJournal: failed to write " << m_path << std::endl;
+		// Cut off what was written, the records are written again by the
+		// next flush
+		closeFile();
+		truncate_file(m_path, start);
+		return;
+	}
+	m_buffer.str("");
+}
+
+void MapJournal::rotate()
+{
+	if (fs::PathExists(m_old_path))
+		return;
+
+	flush();
+	closeFile();
+	if (fs::PathExists(m_path) && !fs::Rename(m_path, m_old_path)) {
+		errorstream << "MapJournal: failed to rotate " << m_path << std::endl;
+		return;
+	}
+	m_named_ids.clear();
+}
+
+void MapJournal::dropOldSegment()
+{
+	if (fs::PathExists(m_old_path))
+		fs::DeleteSingleFileOrEmptyDirectory(m_old_path);
+}
+
+void MapJournal::clear()
+{
+	closeFile();
+	m_buffer.str("");
+	m_named_ids.clear();
+	m_unjournaled_blocks.clear();
+
+	for (const std::string &path : {m_old_path, m_path}) {
+		if (fs::PathExists(path))
+			fs::DeleteSingleFileOrEmptyDirectory(path);
+	}
+}
+
+size_t MapJournal::replay(const ReplayCallback &cb)
+{
+	struct NodeRecord
+	{
+		v3s32 p;
+		MapNode n;
+		bool remove_metadata;
+	};
+
+	std::vector<NodeRecord> records;
+	// Index of the first record that was not saved yet, per block
+	std::unordered_map<v3s32, size_t> saved_until;
+
+	for (const std::string &path : {m_old_path, m_path}) {
+		std::string data;
+		if (!fs::PathExists(path) || !fs::ReadFile(path, data))
+			continue;
+
+		std::istringstream is(data, std::ios::binary);
+		if (readU8(is) != JOURNAL_VERSION || !is.good()) {
+			warningstream << "MapJournal: ignoring " << path
+					<< " with unsupported version" << std::endl;
+			continue;
+		}
+
+		// Maps content IDs of this segment to the current ones
+		std::unordered_map<content_t, content_t> ids;
+		try {
+			while (is.peek() != EOF) {
+				u8 type = readU8(is);
+				if (type == JOURNAL_NAME) {
+					content_t id = readU16(is);
+					std::string name = deSerializeString16(is);
+					content_t current;
+					if (m_ndef->getId(name, current))
+						ids[id] = current;
+				} else if (type == JOURNAL_SETNODE || type == JOURNAL_SWAPNODE) {
+					v3s32 p = readV3S32(is);
+					content_t id = readU16(is);
+					u8 param1 = readU8(is);
+					u8 param2 = readU8(is);
+					if (!is.good())
+						break;
+					auto it = ids.find(id);
+					if (it == ids.end())
+						continue;
+					records.push_back({p, MapNode(it->second, param1, param2),
+							type == JOURNAL_SETNODE});
+				} else if (type == JOURNAL_SAVED) {
+					v3s32 blockpos = readV3S32(is);
+					if (!is.good())
+						break;
+					saved_until[blockpos] = records.size();
+				} else {
+					warningstream << "MapJournal: unknown record type "
+							<< (int)type << " in " << path << std::endl;
+					break;
+				}
+			}
+		} catch (SerializationError &e) {
+			// Truncated by a crash while writing, everything before is valid
+		}
+	}
+
+	size_t applied = 0;
+	for (size_t i = 0; i < records.size(); i++) {
+		const NodeRecord &r = records[i];
+		auto it = saved_until.find(getNodeBlockPos(r.p));
+		if (it != saved_until.end() && i < it->second)
+			continue;
+		if (cb(r.p, r.n, r.remove_metadata))
+			applied++;
+	}
+	return applied;
+}
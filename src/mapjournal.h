@@ -0,0 +1,95 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "map.h"
+#include <cstdio>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+
+class NodeDefManager;
+
+/*
+	Write-ahead journal of node changes.
+
+	Every node set through a map edit event is appended to the journal,
+	which is written to the world directory every server step. Blocks that
+	were changed in other ways (voxel manipulators, liquids, metadata) are
+	remembered so that they can be saved early instead.
+
+	The journal is made of two segments. rotate() starts a new segment when
+	a checkpoint pass over the loaded blocks begins, and the old segment is
+	dropped once the pass has saved every block that was loaded at that
+	time. Records for a block that precede a record of it being saved are
+	skipped when the journal is replayed.
+*/
+class MapJournal : public MapEventReceiver
+{
+public:
+	// Return false if the change could not be applied
+	typedef std::function<bool(v3s32 p, MapNode n, bool remove_metadata)>
+			ReplayCallback;
+
+	MapJournal(const std::string &savedir, const NodeDefManager *ndef);
+	~MapJournal();
+
+	void onMapEditEvent(const MapEditEvent &event) override;
+
+	// Records that the block was written to the database
+	void blockSaved(v3s32 blockpos);
+
+	// Returns a block that was changed without journal records
+	bool popUnjournaledBlock(v3s32 &blockpos);
+
+	// Writes the buffered records to the current segment and waits until
+	// they are on the disk
+	void flush();
+
+	// Closes the current segment and starts a new one.
+	// Does nothing while there is an old segment.
+	void rotate();
+	void dropOldSegment();
+
+	// Forgets everything, for use after all modified blocks were saved
+	void clear();
+
+	// Applies every record that may not have reached the database,
+	// returns the number of applied records
+	size_t replay(const ReplayCallback &cb);
+
+private:
+	void appendNode(v3s32 p, MapNode n, bool remove_metadata);
+
+	std::string m_path;
+	std::string m_old_path;
+	const NodeDefManager *m_ndef;
+
+	void closeFile();
+
+	FILE *m_file = nullptr;
+	std::ostringstream m_buffer;
+	// Content IDs whose name has been written to the current segment
+	std::unordered_set<content_t> m_named_ids;
+
+	std::set<v3s32> m_unjournaled_blocks;
+};
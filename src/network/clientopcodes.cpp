@@ -124,6 +124,8 @@ const ToClientCommandHandler toClientCommandTable[TOCLIENT_NUM_MSG_TYPES] =
 	{ "TOCLIENT_FORMSPEC_PREPEND",         TOCLIENT_STATE_CONNECTED, &Client::handleCommand_FormspecPrepend }, // 0x61,
 	{ "TOCLIENT_MINIMAP_MODES",            TOCLIENT_STATE_CONNECTED, &Client::handleCommand_MinimapModes }, // 0x62,
 	{ "TOCLIENT_SET_LIGHTING",        TOCLIENT_STATE_CONNECTED, &Client::handleCommand_SetLighting }, // 0x63,
+	{ "TOCLIENT_FORMSPEC_PATCH",           TOCLIENT_STATE_CONNECTED, &Client::handleCommand_FormspecPatch }, // 0x64,
+	{ "TOCLIENT_SPAWN_PARTICLE_BURST",     TOCLIENT_STATE_CONNECTED, &Client::handleCommand_SpawnParticleBurst }, // 0x65,
 };
 
 const static ServerCommandFactory null_command_factory = { "TOSERVER_NULL", 0, false };
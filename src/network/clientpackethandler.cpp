@@ -967,6 +967,28 @@ void Client::handleCommand_ShowFormSpec(NetworkPacket* pkt)
 	m_client_event_queue.push(event);
 }
 
+void Client::handleCommand_FormspecPatch(NetworkPacket *pkt)
+{
+	std::string formname;
+	u32 count;
+
+	*pkt >> formname >> count;
+
+	FormspecPatch *patch = new FormspecPatch();
+	patch->reserve(count);
+	for (u32 i = 0; i < count; i++) {
+		u32 index;
+		*pkt >> index;
+		patch->emplace_back(index, pkt->readLongString());
+	}
+
+	ClientEvent *event = new ClientEvent();
+	event->type = CE_PATCH_FORMSPEC;
+	event->patch_formspec.formname = new std::string(formname);
+	event->patch_formspec.patch = patch;
+	m_client_event_queue.push(event);
+}
+
 void Client::handleCommand_SpawnParticle(NetworkPacket* pkt)
 {
 	std::string datastring(pkt->getString(0), pkt->getSize());
@@ -982,6 +1004,21 @@ void Client::handleCommand_SpawnParticle(NetworkPacket* pkt)
 	m_client_event_queue.push(event);
 }
 
+void Client::handleCommand_SpawnParticleBurst(NetworkPacket *pkt)
+{
+	std::string datastring(pkt->getString(0), pkt->getSize());
+	std::istringstream is(datastring, std::ios_base::binary);
+
+	ParticleBurst *burst = new ParticleBurst();
+	burst->deSerialize(is, m_proto_ver);
+
+	ClientEvent *event = new ClientEvent();
+	event->type                 = CE_SPAWN_PARTICLE_BURST;
+	event->spawn_particle_burst = burst;
+
+	m_client_event_queue.push(event);
+}
+
 void Client::handleCommand_AddParticleSpawner(NetworkPacket* pkt)
 {
 	std::string datastring(pkt->getString(0), pkt->getSize());
@@ -209,9 +209,13 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 		TOCLIENT_MEDIA_PUSH changed, TOSERVER_HAVE_MEDIA added
 		Added new particlespawner parameters
 		[scheduled bump for 5.6.0]
+	PROTOCOL VERSION 42:
+		TOCLIENT_FORMSPEC_PATCH added
+	PROTOCOL VERSION 43:
+		TOCLIENT_SPAWN_PARTICLE_BURST added
 */
 
-#define LATEST_PROTOCOL_VERSION 41
+#define LATEST_PROTOCOL_VERSION 43
 #define LATEST_PROTOCOL_VERSION_STRING TOSTRING(LATEST_PROTOCOL_VERSION)
 
 // Server's supported network protocol range
@@ -840,7 +844,29 @@ enum ToClientCommand
 			f32 center_weight_power
 	*/
 
-	TOCLIENT_NUM_MSG_TYPES = 0x64,
+	TOCLIENT_FORMSPEC_PATCH = 0x64,
+	/*
+		u16 len
+		u8[len] formname
+		u32 count
+		for each changed element:
+			u32 element index
+			u32 len
+			u8[len] element (without the closing ']', empty to remove it)
+	*/
+
+	TOCLIENT_SPAWN_PARTICLE_BURST = 0x65,
+	/*
+		u16 count
+		for each particle, deltas from the shared parameters:
+			s16[3] pos (1/128 node)
+			s16[3] velocity (1/256 node/s)
+			s16 expirationtime (1/256 s)
+			s16 size (1/256)
+		shared parameters as in TOCLIENT_SPAWN_PARTICLE
+	*/
+
+	TOCLIENT_NUM_MSG_TYPES = 0x66,
 };
 
 enum ToServerCommand
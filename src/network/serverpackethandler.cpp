@@ -311,10 +311,10 @@ void Server::handleCommand_Init2(NetworkPacket* pkt)
 		std::endl;
 
 	// Send item definitions
-	SendItemDef(peer_id, m_itemdef, protocol_version);
+	SendItemDef(peer_id, protocol_version);
 
 	// Send node definitions
-	SendNodeDef(peer_id, m_nodedef, protocol_version);
+	SendNodeDef(peer_id, protocol_version);
 
 	m_clients.event(peer_id, CSE_SetDefinitionsSent);
 
@@ -1028,8 +1028,7 @@ void Server::handleCommand_Interact(NetworkPacket *pkt)
 	/*
 		Check that target is reasonably close
 	*/
-	static thread_local const bool enable_anticheat =
-			!g_settings->getBool("disable_anticheat");
+	const bool enable_anticheat = m_env->isAnticheatEnabled();
 
 	if ((action == INTERACT_START_DIGGING || action == INTERACT_DIGGING_COMPLETED ||
 			action == INTERACT_PLACE || action == INTERACT_USE) &&
@@ -1439,8 +1438,10 @@ void Server::handleCommand_InventoryFields(NetworkPacket* pkt)
 		const std::string &server_formspec_name = peer_state_iterator->second;
 		if (client_formspec_name == server_formspec_name) {
 			auto it = fields.find("quit");
-			if (it != fields.end() && it->second == "true")
+			if (it != fields.end() && it->second == "true") {
 				m_formspec_state_data.erase(peer_state_iterator);
+				m_formspec_elements.erase(peer_id);
+			}
 
 			m_script->on_playerReceiveFields(playersao, client_formspec_name, fields);
 			return;
@@ -1747,7 +1748,7 @@ void Server::handleCommand_ModChannelJoin(NetworkPacket *pkt)
 		1 + 2 + channel_name.size(), peer_id);
 
 	// Send signal to client to notify join succeed or not
-	if (g_settings->getBool("enable_mod_channels") &&
+	if (m_enable_mod_channels.get() &&
 			m_modchannel_mgr->joinChannel(channel_name, peer_id)) {
 		resp_pkt << (u8) MODCHANNEL_SIGNAL_JOIN_OK;
 		infostream << "Peer " << peer_id << " joined channel " <<
@@ -1772,7 +1773,7 @@ void Server::handleCommand_ModChannelLeave(NetworkPacket *pkt)
 		1 + 2 + channel_name.size(), peer_id);
 
 	// Send signal to client to notify join succeed or not
-	if (g_settings->getBool("enable_mod_channels") &&
+	if (m_enable_mod_channels.get() &&
 			m_modchannel_mgr->leaveChannel(channel_name, peer_id)) {
 		resp_pkt << (u8)MODCHANNEL_SIGNAL_LEAVE_OK;
 		infostream << "Peer " << peer_id << " left channel " << channel_name <<
@@ -1797,7 +1798,7 @@ void Server::handleCommand_ModChannelMsg(NetworkPacket *pkt)
 		std::endl;
 
 	// If mod channels are not enabled, discard message
-	if (!g_settings->getBool("enable_mod_channels")) {
+	if (!m_enable_mod_channels.get()) {
 		return;
 	}
 
@@ -22,6 +22,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "serialization.h"
 #include "util/serialize.h"
 #include "constants.h" // MAP_BLOCKSIZE
+#include <cmath>
 
 /*
 	NodeTimer
@@ -63,7 +64,7 @@ void NodeTimerList::serialize(std::ostream &os, u8 map_format_version) const
 	for (const auto &timer : m_timers) {
 		NodeTimer t = timer.second;
 		NodeTimer nt = NodeTimer(t.timeout,
-			t.timeout - (f32)(timer.first - m_time), t.position);
+			t.timeout - (f32)(timer.first - getTime()), t.position);
 		v3s32 p = t.position;
 
 		u16 p16 = p.Z * MAP_BLOCKSIZE * MAP_BLOCKSIZE + p.Y * MAP_BLOCKSIZE + p.X;
@@ -125,26 +126,166 @@ void NodeTimerList::deSerialize(std::istream &is, u8 map_format_version)
 	}
 }
 
+NodeTimerList::~NodeTimerList()
+{
+	detach();
+}
+
 std::vector<NodeTimer> NodeTimerList::step(float dtime)
 {
 	std::vector<NodeTimer> elapsed_timers;
-	m_time += dtime;
-	if (m_next_trigger_time == -1. || m_time < m_next_trigger_time) {
+	if (!m_wheel)
+		m_time += dtime;
+	double time = getTime();
+	if (m_next_trigger_time == -1. || time < m_next_trigger_time) {
+		// The wheel might have been early due to rounding
+		if (m_wheel && m_next_trigger_time != -1.)
+			m_wheel->schedule(m_blockpos, m_next_trigger_time);
 		return elapsed_timers;
 	}
 	std::multimap<double, NodeTimer>::iterator i = m_timers.begin();
 	// Process timers
-	for (; i != m_timers.end() && i->first <= m_time; ++i) {
+	for (; i != m_timers.end() && i->first <= time; ++i) {
 		NodeTimer t = i->second;
-		t.elapsed = t.timeout + (f32)(m_time - i->first);
+		t.elapsed = t.timeout + (f32)(time - i->first);
 		elapsed_timers.push_back(t);
 		m_iterators.erase(t.position);
 	}
 	// Delete elapsed timers
 	m_timers.erase(m_timers.begin(), i);
-	if (m_timers.empty())
-		m_next_trigger_time = -1.;
-	else
-		m_next_trigger_time = m_timers.begin()->first;
+	if (m_timers.empty()) {
+		setNextTriggerTime(-1.);
+	} else {
+		setNextTriggerTime(m_timers.begin()->first);
+		// The wheel has dropped the block if it was due
+		if (m_wheel)
+			m_wheel->schedule(m_blockpos, m_next_trigger_time);
+	}
 	return elapsed_timers;
 }
+
+void NodeTimerList::attach(NodeTimerWheel *wheel, v3s32 blockpos)
+{
+	detach();
+
+	// Rebase the trigger times onto the clock of the wheel. Adding the same
+	// offset to every key keeps the order, so the map is rebuilt in O(n).
+	double offset = wheel->getTime() - m_time;
+	std::multimap<double, NodeTimer> timers;
+	for (const auto &timer : m_timers)
+		timers.emplace_hint(timers.end(), timer.first + offset, timer.second);
+	m_timers.swap(timers);
+	m_iterators.clear();
+	for (auto it = m_timers.begin(); it != m_timers.end(); ++it)
+		m_iterators.emplace(it->second.position, it);
+
+	m_wheel = wheel;
+	m_blockpos = blockpos;
+	m_next_trigger_time = -1.;
+	setNextTriggerTime(m_timers.empty() ? -1. : m_timers.begin()->first);
+}
+
+void NodeTimerList::detach()
+{
+	if (!m_wheel)
+		return;
+
+	// Trigger times stay relative to the time of detaching
+	m_time = m_wheel->getTime();
+	m_wheel->unschedule(m_blockpos);
+	m_wheel = nullptr;
+}
+
+void NodeTimerList::setNextTriggerTime(double trigger_time)
+{
+	if (m_wheel && trigger_time != m_next_trigger_time) {
+		if (trigger_time == -1.)
+			m_wheel->unschedule(m_blockpos);
+		else
+			m_wheel->schedule(m_blockpos, trigger_time);
+	}
+	m_next_trigger_time = trigger_time;
+}
+
+/*
+	NodeTimerWheel
+*/
+
+NodeTimerWheel::NodeTimerWheel(double resolution) :
+	m_resolution(resolution)
+{
+}
+
+void NodeTimerWheel::schedule(v3s32 blockpos, double trigger_time)
+{
+	// The block is due at the first tick at or after its trigger time,
+	// but never at a tick that has already been processed
+	double ticks = std::ceil(trigger_time / m_resolution - 1e-6);
+	u64 tick = ticks > (double)m_tick ? (u64)ticks : m_tick + 1;
+
+	auto it = m_scheduled.find(blockpos);
+	if (it != m_scheduled.end()) {
+		if (it->second == tick)
+			return;
+		it->second = tick;
+	} else {
+		m_scheduled.emplace(blockpos, tick);
+	}
+	place({blockpos, tick});
+}
+
+void NodeTimerWheel::unschedule(v3s32 blockpos)
+{
+	// The entry in the slot is skipped later on
+	m_scheduled.erase(blockpos);
+}
+
+void NodeTimerWheel::place(const Entry &entry)
+{
+	u64 delta = entry.tick > m_tick ? entry.tick - m_tick : 0;
+	u32 level = 0;
+	while (level < LEVELS - 1 && delta >= ((u64)1 << (SLOT_BITS * (level + 1))))
+		level++;
+	u32 slot = (entry.tick >> (SLOT_BITS * level)) & (SLOT_COUNT - 1);
+	m_slots[level][slot].push_back(entry);
+}
+
+void NodeTimerWheel::step(double dtime, std::vector<v3s32> &due_blocks)
+{
+	m_time += dtime;
+	// Compensate for floating point error when stepping by the resolution
+	u64 target_tick = (u64)std::floor(m_time / m_resolution + 1e-6);
+
+	std::vector<Entry> entries;
+	while (m_tick < target_tick) {
+		m_tick++;
+
+		// Move the entries of higher levels down once the lower levels wrap
+		for (u32 level = 1; level < LEVELS; level++) {
+			if ((m_tick & (((u64)1 << (SLOT_BITS * level)) - 1)) != 0)
+				break;
+			u32 slot = (m_tick >> (SLOT_BITS * level)) & (SLOT_COUNT - 1);
+			entries.clear();
+			entries.swap(m_slots[level][slot]);
+			for (const Entry &entry : entries) {
+				auto it = m_scheduled.find(entry.blockpos);
+				if (it != m_scheduled.end() && it->second == entry.tick)
+					place(entry);
+			}
+		}
+
+		entries.clear();
+		entries.swap(m_slots[0][m_tick & (SLOT_COUNT - 1)]);
+		for (const Entry &entry : entries) {
+			auto it = m_scheduled.find(entry.blockpos);
+			if (it == m_scheduled.end() || it->second != entry.tick)
+				continue;
+			if (entry.tick <= m_tick) {
+				m_scheduled.erase(it);
+				due_blocks.push_back(entry.blockpos);
+			} else {
+				place(entry);
+			}
+		}
+	}
+}
@@ -20,8 +20,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #pragma once
 
 #include "irr_v3d.h"
+#include "util/basic_macros.h"
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 /*
@@ -50,6 +52,50 @@ class NodeTimer
 	v3s32 position;
 };
 
+/*
+	Server-wide hierarchical timing wheel that keeps track of when the next
+	node timer of each attached block elapses, so that stepping the timers
+	only costs time for blocks that actually have elapsed timers.
+*/
+
+class NodeTimerWheel
+{
+public:
+	NodeTimerWheel(double resolution = 0.2);
+	~NodeTimerWheel() = default;
+
+	double getTime() const { return m_time; }
+
+	// Sets the block's next trigger time, replacing an earlier one
+	void schedule(v3s32 blockpos, double trigger_time);
+	void unschedule(v3s32 blockpos);
+
+	// Move forward in time, appends the blocks that have elapsed timers
+	void step(double dtime, std::vector<v3s32> &due_blocks);
+
+	size_t size() const { return m_scheduled.size(); }
+
+private:
+	static constexpr u32 LEVELS = 4;
+	static constexpr u32 SLOT_BITS = 8;
+	static constexpr u32 SLOT_COUNT = 1 << SLOT_BITS;
+
+	struct Entry {
+		v3s32 blockpos;
+		u64 tick;
+	};
+
+	void place(const Entry &entry);
+
+	double m_resolution;
+	double m_time = 0.0;
+	u64 m_tick = 0;
+	// Currently scheduled tick of every block. Entries in the slots that
+	// do not match it are outdated and skipped.
+	std::unordered_map<v3s32, u64> m_scheduled;
+	std::vector<Entry> m_slots[LEVELS][SLOT_COUNT];
+};
+
 /*
 	List of timers of all the nodes of a block
 */
@@ -58,7 +104,8 @@ class NodeTimerList
 {
 public:
 	NodeTimerList() = default;
-	~NodeTimerList() = default;
+	~NodeTimerList();
+	DISABLE_CLASS_COPY(NodeTimerList)
 
 	void serialize(std::ostream &os, u8 map_format_version) const;
 	void deSerialize(std::istream &is, u8 map_format_version);
@@ -70,7 +117,7 @@ class NodeTimerList
 		if (n == m_iterators.end())
 			return NodeTimer();
 		NodeTimer t = n->second->second;
-		t.elapsed = t.timeout - (n->second->first - m_time);
+		t.elapsed = t.timeout - (n->second->first - getTime());
 		return t;
 	}
 	// Deletes timer
@@ -86,20 +133,20 @@ class NodeTimerList
 			// and thus we never lose precision
 			if (removed_time == m_next_trigger_time) {
 				if (m_timers.empty())
-					m_next_trigger_time = -1.;
+					setNextTriggerTime(-1.);
 				else
-					m_next_trigger_time = m_timers.begin()->first;
+					setNextTriggerTime(m_timers.begin()->first);
 			}
 		}
 	}
 	// Undefined behavior if there already is a timer
 	void insert(const NodeTimer &timer) {
 		v3s32 p = timer.position;
-		double trigger_time = m_time + (double)(timer.timeout - timer.elapsed);
+		double trigger_time = getTime() + (double)(timer.timeout - timer.elapsed);
 		std::multimap<double, NodeTimer>::iterator it = m_timers.emplace(trigger_time, timer);
 		m_iterators.emplace(p, it);
 		if (m_next_trigger_time == -1. || trigger_time < m_next_trigger_time)
-			m_next_trigger_time = trigger_time;
+			setNextTriggerTime(trigger_time);
 	}
 	// Deletes old timer and sets a new one
 	inline void set(const NodeTimer &timer) {
@@ -110,15 +157,28 @@ class NodeTimerList
 	void clear() {
 		m_timers.clear();
 		m_iterators.clear();
-		m_next_trigger_time = -1.;
+		setNextTriggerTime(-1.);
 	}
 
-	// Move forward in time, returns elapsed timers
+	// Move forward in time, returns elapsed timers.
+	// While attached to a wheel, its clock is used and dtime is ignored.
 	std::vector<NodeTimer> step(float dtime);
 
+	// Lets the wheel keep track of the timers of the block at blockpos,
+	// from now on the timers advance with the clock of the wheel
+	void attach(NodeTimerWheel *wheel, v3s32 blockpos);
+	void detach();
+	bool isAttached() const { return m_wheel != nullptr; }
+
 private:
+	double getTime() const { return m_wheel ? m_wheel->getTime() : m_time; }
+	void setNextTriggerTime(double trigger_time);
+
 	std::multimap<double, NodeTimer> m_timers;
 	std::map<v3s32, std::multimap<double, NodeTimer>::iterator> m_iterators;
 	double m_next_trigger_time = -1.0;
 	double m_time = 0.0;
+
+	NodeTimerWheel *m_wheel = nullptr;
+	v3s32 m_blockpos;
 };
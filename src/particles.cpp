@@ -18,6 +18,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 */
 
 #include "particles.h"
+#include <algorithm>
 #include <type_traits>
 using namespace ParticleParamTypes;
 
@@ -174,3 +175,90 @@ void ParticleParameters::deSerialize(std::istream &is, u16 protocol_ver)
 	jitter.deSerialize(is);
 	bounce.deSerialize(is);
 }
+
+// Resolution of the deltas in a ParticleBurst
+static const f32 BURST_POS_SCALE = 128.0f;
+static const f32 BURST_VEL_SCALE = 256.0f;
+static const f32 BURST_SCALAR_SCALE = 256.0f;
+
+static s16 quantizeBurstDelta(f32 delta, f32 scale)
+{
+	return rangelim(std::round(delta * scale), S16_MIN, S16_MAX);
+}
+
+static v3s16 quantizeBurstDelta(v3f delta, f32 scale)
+{
+	return v3s16(quantizeBurstDelta(delta.X, scale),
+		quantizeBurstDelta(delta.Y, scale),
+		quantizeBurstDelta(delta.Z, scale));
+}
+
+void ParticleBurst::center()
+{
+	if (particles.empty())
+		return;
+
+	v3f minp = particles[0].pos, maxp = particles[0].pos;
+	for (const Entry &e : particles) {
+		minp.X = std::min(minp.X, e.pos.X);
+		minp.Y = std::min(minp.Y, e.pos.Y);
+		minp.Z = std::min(minp.Z, e.pos.Z);
+		maxp.X = std::max(maxp.X, e.pos.X);
+		maxp.Y = std::max(maxp.Y, e.pos.Y);
+		maxp.Z = std::max(maxp.Z, e.pos.Z);
+	}
+	common.pos = (minp + maxp) / 2.0f;
+}
+
+void ParticleBurst::getParticle(size_t i, ParticleParameters &p) const
+{
+	p = common;
+	const Entry &e = particles[i];
+	p.pos = e.pos;
+	p.vel = e.vel;
+	p.expirationtime = e.expirationtime;
+	p.size = e.size;
+}
+
+void ParticleBurst::serialize(std::ostream &os, u16 protocol_ver,
+		size_t first, size_t count) const
+{
+	first = std::min(first, particles.size());
+	count = std::min<size_t>({count, particles.size() - first, U16_MAX});
+
+	writeU16(os, count);
+	for (size_t i = first; i < first + count; i++) {
+		const Entry &e = particles[i];
+		writeV3S16(os, quantizeBurstDelta(e.pos - common.pos, BURST_POS_SCALE));
+		writeV3S16(os, quantizeBurstDelta(e.vel - common.vel, BURST_VEL_SCALE));
+		writeS16(os, quantizeBurstDelta(e.expirationtime - common.expirationtime,
+			BURST_SCALAR_SCALE));
+		writeS16(os, quantizeBurstDelta(e.size - common.size, BURST_SCALAR_SCALE));
+	}
+	common.serialize(os, protocol_ver);
+}
+
+void ParticleBurst::deSerialize(std::istream &is, u16 protocol_ver)
+{
+	u16 count = readU16(is);
+	std::vector<v3s16> deltas;
+	deltas.reserve(count * 3);
+	for (u16 i = 0; i < count; i++) {
+		deltas.push_back(readV3S16(is));
+		deltas.push_back(readV3S16(is));
+		s16 expirationtime = readS16(is);
+		s16 size = readS16(is);
+		deltas.emplace_back(expirationtime, size, 0);
+	}
+	common.deSerialize(is, protocol_ver);
+
+	particles.resize(count);
+	for (u16 i = 0; i < count; i++) {
+		Entry &e = particles[i];
+		const v3s16 *d = &deltas[i * 3];
+		e.pos = common.pos + v3f(d[0].X, d[0].Y, d[0].Z) / BURST_POS_SCALE;
+		e.vel = common.vel + v3f(d[1].X, d[1].Y, d[1].Z) / BURST_VEL_SCALE;
+		e.expirationtime = common.expirationtime + d[2].X / BURST_SCALAR_SCALE;
+		e.size = common.size + d[2].Y / BURST_SCALAR_SCALE;
+	}
+}
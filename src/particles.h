@@ -400,6 +400,37 @@ struct ParticleParameters : CommonParticleParams
 	void deSerialize(std::istream &is, u16 protocol_ver);
 };
 
+/*
+	Many particles that share all parameters but position, velocity,
+	expiration time and size. Those are sent as quantized deltas from the
+	shared parameters: the position to 1/128 node within 256 nodes, the
+	velocity to 1/256 node/s within 128, expiration time and size to 1/256
+	within 128. Larger deltas are clamped.
+*/
+struct ParticleBurst
+{
+	struct Entry
+	{
+		v3f pos, vel;
+		f32 expirationtime, size;
+	};
+
+	ParticleParameters common;
+	std::vector<Entry> particles;
+
+	// Moves common.pos to the middle of the particles, so that their
+	// deltas stay small
+	void center();
+
+	// Parameters of the i-th particle
+	void getParticle(size_t i, ParticleParameters &p) const;
+
+	// Writes the particles [first, first + count)
+	void serialize(std::ostream &os, u16 protocol_ver,
+			size_t first = 0, size_t count = U16_MAX) const;
+	void deSerialize(std::istream &is, u16 protocol_ver);
+};
+
 struct ParticleSpawnerParameters : CommonParticleParams
 {
 	u16 amount = 1;
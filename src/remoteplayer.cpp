@@ -109,6 +109,16 @@ RemotePlayerChatResult RemotePlayer::canSendChatMessage()
 	return RPLAYER_CHATRESULT_OK;
 }
 
+u8 RemotePlayer::getDirtyFlags() const
+{
+	u8 flags = m_dirty_flags;
+	if (inventory.checkModified())
+		flags |= PLAYER_DIRTY_INVENTORY;
+	if (m_sao && m_sao->getMeta().isModified())
+		flags |= PLAYER_DIRTY_META;
+	return flags;
+}
+
 void RemotePlayer::onSuccessfulSave()
 {
 	setModified(false);
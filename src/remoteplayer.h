@@ -26,6 +26,16 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 class PlayerSAO;
 
+// Parts of the player data that changed since the last save
+enum PlayerDirtyFlags : u8
+{
+	// Position, look direction, HP, breath
+	PLAYER_DIRTY_STATE = 1 << 0,
+	PLAYER_DIRTY_INVENTORY = 1 << 1,
+	PLAYER_DIRTY_META = 1 << 2,
+	PLAYER_DIRTY_ALL = PLAYER_DIRTY_STATE | PLAYER_DIRTY_INVENTORY | PLAYER_DIRTY_META,
+};
+
 enum RemotePlayerChatResult
 {
 	RPLAYER_CHATRESULT_OK,
@@ -108,9 +118,13 @@ class RemotePlayer : public Player
 
 	const CloudParams &getCloudParams() const { return m_cloud_params; }
 
-	bool checkModified() const { return m_dirty || inventory.checkModified(); }
+	bool checkModified() const { return getDirtyFlags() != 0; }
+
+	inline void setModified(const bool x) { m_dirty_flags = x ? PLAYER_DIRTY_ALL : 0; }
 
-	inline void setModified(const bool x) { m_dirty = x; }
+	// Combination of PlayerDirtyFlags
+	u8 getDirtyFlags() const;
+	void setDirtyFlags(u8 flags) { m_dirty_flags |= flags; }
 
 	void setLocalAnimations(v2s32 frames[4], float frame_speed)
 	{
@@ -130,7 +144,7 @@ class RemotePlayer : public Player
 
 	const Lighting& getLighting() const { return m_lighting; }
 
-	void setDirty(bool dirty) { m_dirty = true; }
+	void setDirty(bool dirty) { m_dirty_flags |= PLAYER_DIRTY_STATE; }
 
 	u16 protocol_version = 0;
 	u16 formspec_version = 0;
@@ -143,7 +157,7 @@ class RemotePlayer : public Player
 
 private:
 	PlayerSAO *m_sao = nullptr;
-	bool m_dirty = false;
+	u8 m_dirty_flags = 0;
 
 	static bool m_setting_cache_loaded;
 	static float m_setting_chat_message_limit_per_10sec;
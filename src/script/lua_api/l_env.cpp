@@ -1112,6 +1112,41 @@ int ModApiEnvMod::l_line_of_sight(lua_State *L)
 	return 1;
 }
 
+// line_of_sight_bulk({{pos1, pos2}, ...}) -> {true or pos, ...}
+int ModApiEnvMod::l_line_of_sight_bulk(lua_State *L)
+{
+	GET_PLAIN_ENV_PTR;
+
+	luaL_checktype(L, 1, LUA_TTABLE);
+	size_t count = lua_objlen(L, 1);
+
+	std::vector<core::line3d<f32>> lines;
+	lines.reserve(count);
+	for (size_t i = 1; i <= count; i++) {
+		lua_rawgeti(L, 1, i);
+		luaL_checktype(L, -1, LUA_TTABLE);
+		lua_rawgeti(L, -1, 1);
+		v3d pos1 = checkDoublePos(L, -1);
+		lua_rawgeti(L, -2, 2);
+		v3d pos2 = checkDoublePos(L, -1);
+		lua_pop(L, 3);
+		lines.emplace_back(core::line3d<f32>(pos1, pos2));
+	}
+
+	std::vector<Environment::LineOfSightResult> results;
+	env->lineOfSightBulk(lines, results);
+
+	lua_createtable(L, results.size(), 0);
+	for (size_t i = 0; i < results.size(); i++) {
+		if (results[i].clear)
+			lua_pushboolean(L, true);
+		else
+			push_v3s32(L, results[i].node_pos);
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
 // fix_light(p1, p2)
 int ModApiEnvMod::l_fix_light(lua_State *L)
 {
@@ -1455,6 +1490,7 @@ void ModApiEnvMod::Initialize(lua_State *L, int top)
 	API_FCT(spawn_tree);
 	API_FCT(find_path);
 	API_FCT(line_of_sight);
+	API_FCT(line_of_sight_bulk);
 	API_FCT(raycast);
 	API_FCT(transforming_liquid_add);
 	API_FCT(forceload_block);
@@ -1474,5 +1510,6 @@ void ModApiEnvMod::InitializeClient(lua_State *L, int top)
 	API_FCT(find_nodes_in_area);
 	API_FCT(find_nodes_in_area_under_air);
 	API_FCT(line_of_sight);
+	API_FCT(line_of_sight_bulk);
 	API_FCT(raycast);
 }
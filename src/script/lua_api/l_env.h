@@ -177,6 +177,9 @@ class ModApiEnvMod : public ModApiBase {
 	// line_of_sight(pos1, pos2) -> true/false
 	static int l_line_of_sight(lua_State *L);
 
+	// line_of_sight_bulk({{pos1, pos2}, ...}) -> {true or pos, ...}
+	static int l_line_of_sight_bulk(lua_State *L);
+
 	// raycast(pos1, pos2, objects, liquids) -> Raycast
 	static int l_raycast(lua_State *L);
 
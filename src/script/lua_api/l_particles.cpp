@@ -57,6 +57,84 @@ void LuaParticleParams::readTexValue(lua_State* L, ServerParticleTexture& tex)
 
 }
 
+// Reads the parameters of a particle definition table
+static void read_particle_def(lua_State *L, int index, ParticleParameters &p)
+{
+	lua_getfield(L, index, "pos");
+	if (lua_istable(L, -1))
+		p.pos = check_v3f(L, -1);
+	lua_pop(L, 1);
+
+	lua_getfield(L, index, "vel");
+	if (lua_istable(L, -1)) {
+		p.vel = check_v3f(L, -1);
+		log_deprecated(L, "The use of vel is deprecated. "
+			"Use velocity instead");
+	}
+	lua_pop(L, 1);
+
+	lua_getfield(L, index, "velocity");
+	if (lua_istable(L, -1))
+		p.vel = check_v3f(L, -1);
+	lua_pop(L, 1);
+
+	lua_getfield(L, index, "acc");
+	if (lua_istable(L, -1)) {
+		p.acc = check_v3f(L, -1);
+		log_deprecated(L, "The use of acc is deprecated. "
+			"Use acceleration instead");
+	}
+	lua_pop(L, 1);
+
+	lua_getfield(L, index, "acceleration");
+	if (lua_istable(L, -1))
+		p.acc = check_v3f(L, -1);
+	lua_pop(L, 1);
+
+	p.expirationtime = getfloatfield_default(L, index, "expirationtime",
+		p.expirationtime);
+	p.size = getfloatfield_default(L, index, "size", p.size);
+	p.collisiondetection = getboolfield_default(L, index,
+		"collisiondetection", p.collisiondetection);
+	p.collision_removal = getboolfield_default(L, index,
+		"collision_removal", p.collision_removal);
+	p.object_collision = getboolfield_default(L, index,
+		"object_collision", p.object_collision);
+	p.vertical = getboolfield_default(L, index, "vertical", p.vertical);
+
+	lua_getfield(L, index, "animation");
+	p.animation = read_animation_definition(L, -1);
+	lua_pop(L, 1);
+
+	lua_getfield(L, index, "texture");
+	if (!lua_isnil(L, -1)) {
+		LuaParticleParams::readTexValue(L, p.texture);
+	}
+	lua_pop(L, 1);
+
+	p.glow = getintfield_default(L, index, "glow", p.glow);
+
+	lua_getfield(L, index, "node");
+	if (lua_istable(L, -1))
+		p.node = readnode(L, -1);
+	lua_pop(L, 1);
+
+	p.node_tile = getintfield_default(L, index, "node_tile", p.node_tile);
+
+	lua_getfield(L, index, "drag");
+	if (lua_istable(L, -1))
+		p.drag = check_v3f(L, -1);
+	lua_pop(L, 1);
+
+	lua_getfield(L, index, "jitter");
+	LuaParticleParams::readLuaValue(L, p.jitter);
+	lua_pop(L, 1);
+
+	lua_getfield(L, index, "bounce");
+	LuaParticleParams::readLuaValue(L, p.bounce);
+	lua_pop(L, 1);
+}
+
 // add_particle({...})
 int ModApiParticles::l_add_particle(lua_State *L)
 {
@@ -82,85 +160,56 @@ int ModApiParticles::l_add_particle(lua_State *L)
 	}
 	else if (lua_istable(L, 1))
 	{
-		lua_getfield(L, 1, "pos");
-		if (lua_istable(L, -1))
-			p.pos = check_v3f(L, -1);
-		lua_pop(L, 1);
-
-		lua_getfield(L, 1, "vel");
-		if (lua_istable(L, -1)) {
-			p.vel = check_v3f(L, -1);
-			log_deprecated(L, "The use of vel is deprecated. "
-				"Use velocity instead");
-		}
-		lua_pop(L, 1);
-
-		lua_getfield(L, 1, "velocity");
-		if (lua_istable(L, -1))
-			p.vel = check_v3f(L, -1);
-		lua_pop(L, 1);
-
-		lua_getfield(L, 1, "acc");
-		if (lua_istable(L, -1)) {
-			p.acc = check_v3f(L, -1);
-			log_deprecated(L, "The use of acc is deprecated. "
-				"Use acceleration instead");
-		}
-		lua_pop(L, 1);
-
-		lua_getfield(L, 1, "acceleration");
-		if (lua_istable(L, -1))
-			p.acc = check_v3f(L, -1);
-		lua_pop(L, 1);
+		read_particle_def(L, 1, p);
+		playername = getstringfield_default(L, 1, "playername", "");
+	}
 
-		p.expirationtime = getfloatfield_default(L, 1, "expirationtime",
-			p.expirationtime);
-		p.size = getfloatfield_default(L, 1, "size", p.size);
-		p.collisiondetection = getboolfield_default(L, 1,
-			"collisiondetection", p.collisiondetection);
-		p.collision_removal = getboolfield_default(L, 1,
-			"collision_removal", p.collision_removal);
-		p.object_collision = getboolfield_default(L, 1,
-			"object_collision", p.object_collision);
-		p.vertical = getboolfield_default(L, 1, "vertical", p.vertical);
+	getServer(L)->spawnParticle(playername, p);
+	return 1;
+}
 
-		lua_getfield(L, 1, "animation");
-		p.animation = read_animation_definition(L, -1);
-		lua_pop(L, 1);
+// add_particle_burst({particle definition, particles = {{...}, ...}})
+int ModApiParticles::l_add_particle_burst(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
 
-		lua_getfield(L, 1, "texture");
-		if (!lua_isnil(L, -1)) {
-			LuaParticleParams::readTexValue(L, p.texture);
-		}
-		lua_pop(L, 1);
+	luaL_checktype(L, 1, LUA_TTABLE);
 
-		p.glow = getintfield_default(L, 1, "glow", p.glow);
+	ParticleBurst burst;
+	const ParticleParameters &common = burst.common;
+	read_particle_def(L, 1, burst.common);
+	std::string playername = getstringfield_default(L, 1, "playername", "");
 
-		lua_getfield(L, 1, "node");
-		if (lua_istable(L, -1))
-			p.node = readnode(L, -1);
+	lua_getfield(L, 1, "particles");
+	luaL_checktype(L, -1, LUA_TTABLE);
+	int table = lua_gettop(L);
+	size_t count = lua_objlen(L, table);
+	burst.particles.reserve(count);
+	for (size_t i = 1; i <= count; i++) {
+		lua_rawgeti(L, table, i);
+		luaL_checktype(L, -1, LUA_TTABLE);
+		ParticleBurst::Entry e;
+
+		lua_getfield(L, -1, "pos");
+		e.pos = check_v3f(L, -1);
 		lua_pop(L, 1);
 
-		p.node_tile = getintfield_default(L, 1, "node_tile", p.node_tile);
-
-		playername = getstringfield_default(L, 1, "playername", "");
-
-		lua_getfield(L, 1, "drag");
-		if (lua_istable(L, -1))
-			p.drag = check_v3f(L, -1);
+		lua_getfield(L, -1, "velocity");
+		e.vel = lua_istable(L, -1) ? check_v3f(L, -1) : common.vel;
 		lua_pop(L, 1);
 
-		lua_getfield(L, 1, "jitter");
-		LuaParticleParams::readLuaValue(L, p.jitter);
-		lua_pop(L, 1);
+		e.expirationtime = getfloatfield_default(L, -1, "expirationtime",
+			common.expirationtime);
+		e.size = getfloatfield_default(L, -1, "size", common.size);
 
-		lua_getfield(L, 1, "bounce");
-		LuaParticleParams::readLuaValue(L, p.bounce);
+		burst.particles.push_back(e);
 		lua_pop(L, 1);
 	}
+	lua_pop(L, 1);
 
-	getServer(L)->spawnParticle(playername, p);
-	return 1;
+	burst.center();
+	getServer(L)->spawnParticleBurst(playername, burst);
+	return 0;
 }
 
 // add_particlespawner({...})
@@ -321,6 +370,7 @@ int ModApiParticles::l_delete_particlespawner(lua_State *L)
 void ModApiParticles::Initialize(lua_State *L, int top)
 {
 	API_FCT(add_particle);
+	API_FCT(add_particle_burst);
 	API_FCT(add_particlespawner);
 	API_FCT(delete_particlespawner);
 }
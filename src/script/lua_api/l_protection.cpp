@@ -0,0 +1,105 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "lua_api/l_protection.h"
+#include "lua_api/l_internal.h"
+#include "common/c_converter.h"
+#include "server.h"
+#include "server/protectionstore.h"
+
+static void push_protection_result(lua_State *L, ProtectionResult result)
+{
+	switch (result) {
+	case PROTECTION_NONE:
+		lua_pushliteral(L, "none");
+		break;
+	case PROTECTION_ALLOWED:
+		lua_pushliteral(L, "allowed");
+		break;
+	case PROTECTION_DENIED:
+		lua_pushliteral(L, "denied");
+		break;
+	}
+}
+
+// register_protected_area(minp, maxp, owner, members) -> id
+int ModApiProtection::l_register_protected_area(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	v3s32 minp = check_v3s32(L, 1);
+	v3s32 maxp = check_v3s32(L, 2);
+	std::string owner = luaL_checkstring(L, 3);
+
+	std::vector<std::string> list;
+	if (!lua_isnoneornil(L, 4))
+		read_stringlist(L, 4, &list);
+	std::set<std::string> members(list.begin(), list.end());
+
+	u32 id = getServer(L)->getProtectionStore()->addArea(minp, maxp, owner, members);
+	if (id == U32_MAX)
+		return 0;
+
+	lua_pushnumber(L, id);
+	return 1;
+}
+
+// unregister_protected_area(id) -> bool
+int ModApiProtection::l_unregister_protected_area(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	u32 id = luaL_checknumber(L, 1);
+	lua_pushboolean(L, getServer(L)->getProtectionStore()->removeArea(id));
+	return 1;
+}
+
+// get_protection(pos, name) -> "none", "allowed" or "denied"
+int ModApiProtection::l_get_protection(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	v3s32 pos = check_v3s32(L, 1);
+	std::string name = readParam<std::string>(L, 2, "");
+
+	push_protection_result(L, getServer(L)->getProtectionStore()->check(pos, name));
+	return 1;
+}
+
+// get_area_protection(minp, maxp, name) -> "none", "allowed" or "denied"
+int ModApiProtection::l_get_area_protection(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	v3s32 minp = check_v3s32(L, 1);
+	v3s32 maxp = check_v3s32(L, 2);
+	std::string name = readParam<std::string>(L, 3, "");
+
+	push_protection_result(L,
+		getServer(L)->getProtectionStore()->checkArea(minp, maxp, name));
+	return 1;
+}
+
+void ModApiProtection::Initialize(lua_State *L, int top)
+{
+	API_FCT(register_protected_area);
+	API_FCT(unregister_protected_area);
+	API_FCT(get_protection);
+	API_FCT(get_area_protection);
+}
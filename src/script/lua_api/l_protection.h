@@ -0,0 +1,41 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "lua_api/l_base.h"
+
+class ModApiProtection : public ModApiBase
+{
+private:
+	// register_protected_area(minp, maxp, owner, members) -> id
+	static int l_register_protected_area(lua_State *L);
+
+	// unregister_protected_area(id) -> bool
+	static int l_unregister_protected_area(lua_State *L);
+
+	// get_protection(pos, name) -> "none", "allowed" or "denied"
+	static int l_get_protection(lua_State *L);
+
+	// get_area_protection(minp, maxp, name) -> "none", "allowed" or "denied"
+	static int l_get_area_protection(lua_State *L);
+
+public:
+	static void Initialize(lua_State *L, int top);
+};
@@ -380,6 +380,27 @@ int ModApiServer::l_show_formspec(lua_State *L)
 	return 1;
 }
 
+// patch_formspec(playername, formname, patches)
+int ModApiServer::l_patch_formspec(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+	const char *playername = luaL_checkstring(L, 1);
+	std::string formname = luaL_checkstring(L, 2);
+	luaL_checktype(L, 3, LUA_TTABLE);
+
+	StringMap patches;
+	lua_pushnil(L);
+	while (lua_next(L, 3) != 0) {
+		// key at index -2 and value at index -1
+		std::string name = readParam<std::string>(L, -2);
+		patches[name] = readParam<std::string>(L, -1);
+		lua_pop(L, 1);
+	}
+
+	lua_pushboolean(L, getServer(L)->patchFormspec(playername, formname, patches));
+	return 1;
+}
+
 // get_current_modname()
 int ModApiServer::l_get_current_modname(lua_State *L)
 {
@@ -629,6 +650,7 @@ void ModApiServer::Initialize(lua_State *L, int top)
 	API_FCT(chat_send_all);
 	API_FCT(chat_send_player);
 	API_FCT(show_formspec);
+	API_FCT(patch_formspec);
 	API_FCT(sound_play);
 	API_FCT(sound_stop);
 	API_FCT(sound_fade);
@@ -67,6 +67,9 @@ class ModApiServer : public ModApiBase
 	// show_formspec(playername,formname,formspec)
 	static int l_show_formspec(lua_State *L);
 
+	// patch_formspec(playername, formname, patches)
+	static int l_patch_formspec(lua_State *L);
+
 	// sound_play(spec, parameters)
 	static int l_sound_play(lua_State *L);
 
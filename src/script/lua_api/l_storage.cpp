@@ -64,6 +64,26 @@ void StorageRef::clearMeta()
 	m_object.clear();
 }
 
+// get_keys_with_prefix(self, prefix)
+int StorageRef::l_get_keys_with_prefix(lua_State *L)
+{
+	MAP_LOCK_REQUIRED;
+
+	StorageRef *ref = checkObject<StorageRef>(L, 1);
+	std::string prefix = luaL_checkstring(L, 2);
+
+	std::vector<std::string> keys;
+	ref->m_object.getKeysWithPrefix(prefix, &keys);
+
+	int i = 0;
+	lua_createtable(L, keys.size(), 0);
+	for (const std::string &key : keys) {
+		lua_pushlstring(L, key.c_str(), key.size());
+		lua_rawseti(L, -2, ++i);
+	}
+	return 1;
+}
+
 const char StorageRef::className[] = "StorageRef";
 const luaL_Reg StorageRef::methods[] = {
 	luamethod(MetaDataRef, contains),
@@ -78,5 +98,6 @@ const luaL_Reg StorageRef::methods[] = {
 	luamethod(MetaDataRef, to_table),
 	luamethod(MetaDataRef, from_table),
 	luamethod(MetaDataRef, equals),
+	luamethod(StorageRef, get_keys_with_prefix),
 	{0,0}
 };
@@ -43,6 +43,9 @@ class StorageRef : public MetaDataRef
 	virtual IMetadata *getmeta(bool auto_create);
 	virtual void clearMeta();
 
+	// get_keys_with_prefix(self, prefix)
+	static int l_get_keys_with_prefix(lua_State *L);
+
 public:
 	StorageRef(const std::string &mod_name, ModStorageDatabase *db): m_object(mod_name, db) {}
 	~StorageRef() = default;
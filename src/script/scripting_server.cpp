@@ -37,6 +37,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "lua_api/l_noise.h"
 #include "lua_api/l_object.h"
 #include "lua_api/l_playermeta.h"
+#include "lua_api/l_protection.h"
 #include "lua_api/l_particles.h"
 #include "lua_api/l_rollback.h"
 #include "lua_api/l_server.h"
@@ -161,6 +162,7 @@ void ServerScripting::InitializeModApi(lua_State *L, int top)
 	ModApiItemMod::Initialize(L, top);
 	ModApiMapgen::Initialize(L, top);
 	ModApiParticles::Initialize(L, top);
+	ModApiProtection::Initialize(L, top);
 	ModApiRollback::Initialize(L, top);
 	ModApiServer::Initialize(L, top);
 	ModApiUtil::Initialize(L, top);
@@ -65,6 +65,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "remoteplayer.h"
 #include "server/player_sao.h"
 #include "server/serverinventorymgr.h"
+#include "server/definitioncache.h"
+#include "server/protectionstore.h"
+#include "server/steppacer.h"
 #include "translation.h"
 #include "database/database-sqlite3.h"
 #if USE_POSTGRESQL
@@ -72,6 +75,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #endif
 #include "database/database-files.h"
 #include "database/database-dummy.h"
+#include "database/database-buffered.h"
 #include "gameparams.h"
 
 class ClientNotFoundException : public BaseException
@@ -104,10 +108,12 @@ void *ServerThread::run()
 	/*
 	 * The real business of the server happens on the ServerThread.
 	 * How this works:
-	 * AsyncRunStep() runs an actual server step as soon as enough time has
-	 * passed (dedicated_server_loop keeps track of that).
-	 * Receive() blocks at least(!) 30ms waiting for a packet (so this loop
-	 * doesn't busy wait) and will process any remaining packets.
+	 * stepIfDue() runs an actual server step as soon as enough time has
+	 * passed (the step pacer of a dedicated server or Server::step keeps
+	 * track of that).
+	 * Receive() waits for a packet until the next step is due (so this loop
+	 * doesn't busy wait, but wakes up for incoming packets right away) and
+	 * will process any remaining packets.
 	 */
 
 	try {
@@ -120,9 +126,9 @@ void *ServerThread::run()
 
 	while (!stopRequested()) {
 		try {
-			m_server->AsyncRunStep();
+			u32 timeout = m_server->stepIfDue();
 
-			m_server->Receive();
+			m_server->Receive(timeout);
 
 		} catch (con::PeerNotFoundException &e) {
 			infostream<<"Server: PeerNotFoundException"<<std::endl;
@@ -304,6 +310,12 @@ Server::Server(
 			"Number of map edit events");
 
 	m_lag_gauge->set(g_settings->getFloat("dedicated_server_step"));
+
+	if (m_dedicated) {
+		u64 interval = g_settings->getFloat("dedicated_server_step") * 1000000.0f;
+		m_step_pacer = std::make_unique<StepPacer>(std::max<u64>(interval, 1000),
+				porting::getTimeUs());
+	}
 }
 
 Server::~Server()
@@ -381,6 +393,7 @@ Server::~Server()
 	delete m_rollback;
 	delete m_mod_storage_database;
 	delete m_banmanager;
+	m_defcache.reset();
 	delete m_itemdef;
 	delete m_nodedef;
 	delete m_craftdef;
@@ -451,6 +464,7 @@ void Server::init()
 
 	// Must be created before mod loading because we have some inventory creation
 	m_inventory_mgr = std::make_unique<ServerInventoryManager>();
+	m_protection_store = std::make_unique<ProtectionStore>();
 
 	m_script->loadMod(getBuiltinLuaPath() + DIR_DELIM "init.lua", BUILTIN_MOD_NAME);
 	m_script->checkSetByBuiltin();
@@ -482,9 +496,17 @@ void Server::init()
 	// unmap node names in cross-references
 	m_nodedef->resolveCrossrefs();
 
+	// Definitions are final now, compress them for joining clients while
+	// the rest of the server starts up
+	m_defcache = std::make_unique<DefinitionCache>(m_itemdef, m_nodedef);
+	m_defcache->prepare(LATEST_PROTOCOL_VERSION);
+
 	// init the recipe hashes to speed up crafting
 	m_craftdef->initHashes(this);
 
+	// Recover node changes that did not reach the database before a crash
+	servermap->replayJournal();
+
 	// Initialize Environment
 	m_startup_server_map = nullptr; // Ownership moved to ServerEnvironment
 	m_env = new ServerEnvironment(servermap, m_script, this,
@@ -572,7 +594,8 @@ void Server::step(float dtime)
 	// Limit a bit
 	if (dtime > 2.0)
 		dtime = 2.0;
-	{
+	// A dedicated server keeps time in stepIfDue()
+	if (!m_step_pacer) {
 		MutexAutoLock lock(m_step_dtime_mutex);
 		m_step_dtime += dtime;
 	}
@@ -588,6 +611,52 @@ void Server::step(float dtime)
 	}
 }
 
+u32 Server::stepIfDue()
+{
+	if (!m_step_pacer) {
+		AsyncRunStep();
+		return 30;
+	}
+
+	u64 now = porting::getTimeUs();
+	bool due;
+	{
+		MutexAutoLock lock(m_step_pacer_mutex);
+		due = m_step_pacer->isDue(now);
+		if (due) {
+			float dtime = m_step_pacer->begin(now);
+			// Limit a bit
+			dtime = std::min(dtime, 2.0f);
+			MutexAutoLock lock2(m_step_dtime_mutex);
+			m_step_dtime += dtime;
+		}
+	}
+
+	// Also runs between steps to keep sending blocks
+	AsyncRunStep();
+
+	MutexAutoLock lock(m_step_pacer_mutex);
+	now = porting::getTimeUs();
+	if (due)
+		m_step_pacer->end(now);
+	// Wake up at least as often as before to keep sending blocks
+	u32 timeout = (m_step_pacer->timeUntilDue(now) + 999) / 1000;
+	return std::min<u32>(timeout, 30);
+}
+
+std::string Server::getStepStats()
+{
+	if (!m_step_pacer)
+		return "";
+
+	MutexAutoLock lock(m_step_pacer_mutex);
+	std::string stats = "step duration: " +
+			m_step_pacer->getDurations().toString() +
+			"\nstep lateness: " + m_step_pacer->getLateness().toString();
+	m_step_pacer->clearStats();
+	return stats;
+}
+
 void Server::AsyncRunStep(bool initial_step)
 {
 
@@ -782,7 +851,7 @@ void Server::AsyncRunStep(bool initial_step)
 		// Write changes to the mod storage
 		m_mod_storage_save_timer -= dtime;
 		if (m_mod_storage_save_timer <= 0.0f) {
-			m_mod_storage_save_timer = g_settings->getFloat("server_map_save_interval");
+			m_mod_storage_save_timer = m_map_save_interval.get();
 			m_mod_storage_database->endSave();
 			m_mod_storage_database->beginSave();
 		}
@@ -1005,13 +1074,18 @@ void Server::AsyncRunStep(bool initial_step)
 		}
 	}
 
+	// Write the map journal and save blocks towards the next checkpoint
+	{
+		MutexAutoLock lock(m_env_mutex);
+		ScopeProfiler sp(g_profiler, "Server: map journal", SPT_AVG);
+		m_env->getServerMap().stepJournal(dtime);
+	}
+
 	// Save map, players and auth stuff
 	{
 		float &counter = m_savemap_timer;
 		counter += dtime;
-		static thread_local const float save_interval =
-			g_settings->getFloat("server_map_save_interval");
-		if (counter >= save_interval) {
+		if (counter >= m_map_save_interval.get()) {
 			counter = 0.0;
 			MutexAutoLock lock(m_env_mutex);
 
@@ -1036,11 +1110,12 @@ void Server::AsyncRunStep(bool initial_step)
 	m_shutdown_state.tick(dtime, this);
 }
 
-void Server::Receive()
+void Server::Receive(u32 timeout_ms)
 {
 	NetworkPacket pkt;
 	session_t peer_id;
 	bool first = true;
+	m_con->SetTimeoutMs(timeout_ms);
 	for (;;) {
 		pkt.clear();
 		peer_id = 0;
@@ -1428,21 +1503,16 @@ void Server::SendDeathscreen(session_t peer_id, bool set_camera_point_target,
 	Send(&pkt);
 }
 
-void Server::SendItemDef(session_t peer_id,
-		IItemDefManager *itemdef, u16 protocol_version)
+void Server::SendItemDef(session_t peer_id, u16 protocol_version)
 {
-	NetworkPacket pkt(TOCLIENT_ITEMDEF, 0, peer_id);
-
 	/*
 		u16 command
 		u32 length of the next item
 		zlib-compressed serialized ItemDefManager
 	*/
-	std::ostringstream tmp_os(std::ios::binary);
-	itemdef->serialize(tmp_os, protocol_version);
-	std::ostringstream tmp_os2(std::ios::binary);
-	compressZlib(tmp_os.str(), tmp_os2);
-	pkt.putLongString(tmp_os2.str());
+	const std::string &data = m_defcache->get(protocol_version)->itemdef;
+	NetworkPacket pkt(TOCLIENT_ITEMDEF, 4 + data.size(), peer_id);
+	pkt.putLongString(data);
 
 	// Make data buffer
 	verbosestream << "Server: Sending item definitions to id(" << peer_id
@@ -1451,22 +1521,16 @@ void Server::SendItemDef(session_t peer_id,
 	Send(&pkt);
 }
 
-void Server::SendNodeDef(session_t peer_id,
-	const NodeDefManager *nodedef, u16 protocol_version)
+void Server::SendNodeDef(session_t peer_id, u16 protocol_version)
 {
-	NetworkPacket pkt(TOCLIENT_NODEDEF, 0, peer_id);
-
 	/*
 		u16 command
 		u32 length of the next item
 		zlib-compressed serialized NodeDefManager
 	*/
-	std::ostringstream tmp_os(std::ios::binary);
-	nodedef->serialize(tmp_os, protocol_version);
-	std::ostringstream tmp_os2(std::ios::binary);
-	compressZlib(tmp_os.str(), tmp_os2);
-
-	pkt.putLongString(tmp_os2.str());
+	const std::string &data = m_defcache->get(protocol_version)->nodedef;
+	NetworkPacket pkt(TOCLIENT_NODEDEF, 4 + data.size(), peer_id);
+	pkt.putLongString(data);
 
 	// Make data buffer
 	verbosestream << "Server: Sending node definitions to id(" << peer_id
@@ -1497,7 +1561,7 @@ void Server::SendInventory(PlayerSAO *sao, bool incremental)
 	std::ostringstream os(std::ios::binary);
 	sao->getInventory()->serialize(os, incremental);
 	sao->getInventory()->setModified(false);
-	player->setModified(true);
+	player->setDirtyFlags(PLAYER_DIRTY_INVENTORY);
 
 	const std::string &s = os.str();
 	pkt.putRawString(s.c_str(), s.size());
@@ -1533,10 +1597,12 @@ void Server::SendShowFormspecMessage(session_t peer_id, const std::string &forms
 		const auto it = m_formspec_state_data.find(peer_id);
 		if (it != m_formspec_state_data.end() && it->second == formname) {
 			m_formspec_state_data.erase(peer_id);
+			m_formspec_elements.erase(peer_id);
 		}
 		pkt.putLongString("");
 	} else {
 		m_formspec_state_data[peer_id] = formname;
+		m_formspec_elements[peer_id] = splitFormspec(formspec);
 		pkt.putLongString(formspec);
 	}
 	pkt << formname;
@@ -1544,12 +1610,24 @@ void Server::SendShowFormspecMessage(session_t peer_id, const std::string &forms
 	Send(&pkt);
 }
 
+void Server::SendFormspecPatch(session_t peer_id, const std::string &formname,
+	const FormspecPatch &patch)
+{
+	NetworkPacket pkt(TOCLIENT_FORMSPEC_PATCH, 0, peer_id);
+	pkt << formname << (u32)patch.size();
+	for (const auto &change : patch) {
+		pkt << change.first;
+		pkt.putLongString(change.second);
+	}
+
+	Send(&pkt);
+}
+
 // Spawns a particle on peer with peer_id
 void Server::SendSpawnParticle(session_t peer_id, u16 protocol_version,
 	const ParticleParameters &p)
 {
-	static thread_local const float radius =
-			g_settings->getS32("max_block_send_distance") * MAP_BLOCKSIZE * BS;
+	const float radius = m_max_block_send_distance.get() * MAP_BLOCKSIZE * BS;
 
 	if (peer_id == PEER_ID_INEXISTENT) {
 		std::vector<session_t> clients = m_clients.getClientIDs();
@@ -1587,12 +1665,68 @@ void Server::SendSpawnParticle(session_t peer_id, u16 protocol_version,
 	Send(&pkt);
 }
 
+// Particles per TOCLIENT_SPAWN_PARTICLE_BURST packet
+static const size_t PARTICLE_BURST_PACKET_MAX = 1024;
+
+// Spawns a burst of particles on peer with peer_id
+void Server::SendSpawnParticleBurst(session_t peer_id, u16 protocol_version,
+	const ParticleBurst &burst)
+{
+	if (burst.particles.empty())
+		return;
+
+	const float radius = m_max_block_send_distance.get() * MAP_BLOCKSIZE * BS;
+
+	if (peer_id == PEER_ID_INEXISTENT) {
+		std::vector<session_t> clients = m_clients.getClientIDs();
+		const v3f pos = burst.common.pos * BS;
+		const float radius_sq = radius * radius;
+
+		for (const session_t client_id : clients) {
+			RemotePlayer *player = m_env->getPlayer(client_id);
+			if (!player)
+				continue;
+
+			PlayerSAO *sao = player->getPlayerSAO();
+			if (!sao)
+				continue;
+
+			// Do not send to distant clients
+			if (sao->getBasePosition().getDistanceFromSQ(pos) > radius_sq)
+				continue;
+
+			SendSpawnParticleBurst(client_id, player->protocol_version, burst);
+		}
+		return;
+	}
+	assert(protocol_version != 0);
+
+	if (protocol_version < 43) {
+		ParticleParameters p;
+		for (size_t i = 0; i < burst.particles.size(); i++) {
+			burst.getParticle(i, p);
+			SendSpawnParticle(peer_id, protocol_version, p);
+		}
+		return;
+	}
+
+	for (size_t first = 0; first < burst.particles.size();
+			first += PARTICLE_BURST_PACKET_MAX) {
+		NetworkPacket pkt(TOCLIENT_SPAWN_PARTICLE_BURST, 0, peer_id);
+
+		std::ostringstream oss(std::ios_base::binary);
+		burst.serialize(oss, protocol_version, first, PARTICLE_BURST_PACKET_MAX);
+		pkt.putRawString(oss.str());
+
+		Send(&pkt);
+	}
+}
+
 // Adds a ParticleSpawner on peer with peer_id
 void Server::SendAddParticleSpawner(session_t peer_id, u16 protocol_version,
 	const ParticleSpawnerParameters &p, u16 attached_id, u32 id)
 {
-	static thread_local const float radius =
-			g_settings->getS32("max_block_send_distance") * MAP_BLOCKSIZE * BS;
+	const float radius = m_max_block_send_distance.get() * MAP_BLOCKSIZE * BS;
 
 	if (peer_id == PEER_ID_INEXISTENT) {
 		std::vector<session_t> clients = m_clients.getClientIDs();
@@ -2002,16 +2136,12 @@ void Server::SendPlayerFormspecPrepend(session_t peer_id)
 void Server::SendActiveObjectRemoveAdd(RemoteClient *client, PlayerSAO *playersao)
 {
 	// Radius inside which objects are active
-	static thread_local const s32 radius =
-		g_settings->getS32("active_object_send_range_blocks") * MAP_BLOCKSIZE;
+	const s32 radius = m_active_object_send_range.get() * MAP_BLOCKSIZE;
 
 	// Radius inside which players are active
-	static thread_local const bool is_transfer_limited =
-		g_settings->exists("unlimited_player_transfer_distance") &&
-		!g_settings->getBool("unlimited_player_transfer_distance");
+	const bool is_transfer_limited = m_player_transfer_limited.get();
 
-	static thread_local const s32 player_transfer_dist =
-		g_settings->getS32("player_transfer_distance") * MAP_BLOCKSIZE;
+	const s32 player_transfer_dist = m_player_transfer_distance.get() * MAP_BLOCKSIZE;
 
 	s32 player_radius = player_transfer_dist == 0 && is_transfer_limited ?
 		radius : player_transfer_dist;
@@ -2360,7 +2490,7 @@ void Server::sendMetadataChanged(const std::unordered_set<v3s32> &positions, flo
 void Server::SendBlockNoLock(session_t peer_id, MapBlock *block, u8 ver,
 		u16 net_proto_version, SerializedBlockCache *cache)
 {
-	thread_local const int net_compression_level = rangelim(g_settings->getS32("map_compression_level_net"), -1, 9);
+	const int net_compression_level = m_net_compression_level.get();
 	std::string s, *sptr = nullptr;
 
 	if (cache) {
@@ -2425,8 +2555,8 @@ void Server::SendBlocks(float dtime)
 
 	// Maximal total count calculation
 	// The per-client block sends is halved with the maximal online users
-	u32 max_blocks_to_send = (m_env->getPlayerCount() + g_settings->getU32("max_users")) *
-		g_settings->getU32("max_simultaneous_block_sends_per_client") / 4 + 1;
+	u32 max_blocks_to_send = (m_env->getPlayerCount() + m_max_users.get()) *
+		m_max_block_sends_per_client.get() / 4 + 1;
 
 	ScopeProfiler sp(g_profiler, "Server::SendBlocks(): Send to clients");
 	Map &map = m_env->getMap();
@@ -2884,6 +3014,7 @@ void Server::DeleteClient(session_t peer_id, ClientDeletionReason reason)
 
 		// clear formspec info so the next client can't abuse the current state
 		m_formspec_state_data.erase(peer_id);
+		m_formspec_elements.erase(peer_id);
 
 		RemotePlayer *player = m_env->getPlayer(peer_id);
 
@@ -3267,6 +3398,37 @@ bool Server::showFormspec(const char *playername, const std::string &formspec,
 	return true;
 }
 
+bool Server::patchFormspec(const char *playername, const std::string &formname,
+	const StringMap &patches)
+{
+	// m_env will be NULL if the server is initializing
+	if (!m_env)
+		return false;
+
+	RemotePlayer *player = m_env->getPlayer(playername);
+	if (!player || player->getPeerId() == PEER_ID_INEXISTENT)
+		return false;
+
+	session_t peer_id = player->getPeerId();
+	const auto state = m_formspec_state_data.find(peer_id);
+	const auto shown = m_formspec_elements.find(peer_id);
+	if (state == m_formspec_state_data.end() || state->second != formname ||
+			shown == m_formspec_elements.end())
+		return false;
+
+	FormspecPatch patch = patchFormspecElements(shown->second, patches);
+	if (patch.empty())
+		return true;
+
+	if (m_clients.getProtocolVersion(peer_id) < 42) {
+		// Older clients get the whole patched formspec
+		SendShowFormspecMessage(peer_id, joinFormspec(shown->second), formname);
+	} else {
+		SendFormspecPatch(peer_id, formname, patch);
+	}
+	return true;
+}
+
 u32 Server::hudAdd(RemotePlayer *player, HudElement *form)
 {
 	if (!player)
@@ -3454,6 +3616,26 @@ void Server::spawnParticle(const std::string &playername,
 	SendSpawnParticle(peer_id, proto_ver, p);
 }
 
+void Server::spawnParticleBurst(const std::string &playername,
+	const ParticleBurst &burst)
+{
+	// m_env will be NULL if the server is initializing
+	if (!m_env)
+		return;
+
+	session_t peer_id = PEER_ID_INEXISTENT;
+	u16 proto_ver = 0;
+	if (!playername.empty()) {
+		RemotePlayer *player = m_env->getPlayer(playername.c_str());
+		if (!player)
+			return;
+		peer_id = player->getPeerId();
+		proto_ver = player->protocol_version;
+	}
+
+	SendSpawnParticleBurst(peer_id, proto_ver, burst);
+}
+
 u32 Server::addParticleSpawner(const ParticleSpawnerParameters &p,
 	ServerActiveObject *attached, const std::string &playername)
 {
@@ -3687,7 +3869,18 @@ ICraftDefManager *Server::getCraftDefManager()
 
 u16 Server::allocateUnknownNodeId(const std::string &name)
 {
-	return m_nodedef->allocateDummy(name);
+	if (!m_defcache)
+		return m_nodedef->allocateDummy(name);
+
+	// A build may be serializing the definitions on another thread
+	u16 id;
+	{
+		auto lock = m_defcache->lockDefinitions();
+		id = m_nodedef->allocateDummy(name);
+	}
+	// Joining clients need to know about the new node
+	m_defcache->invalidate();
+	return id;
 }
 
 IWritableItemDefManager *Server::getWritableItemDefManager()
@@ -3902,6 +4095,10 @@ void dedicated_server_loop(Server &server, bool &kill)
 				infostream<<"Profiler:"<<std::endl;
 				g_profiler->print(infostream);
 				g_profiler->clear();
+
+				std::string step_stats = server.getStepStats();
+				if (!step_stats.empty())
+					infostream << step_stats << std::endl;
 			}
 		}
 	}
@@ -4019,7 +4216,10 @@ ModStorageDatabase *Server::openModStorageDatabase(const std::string &world_path
 			<< std::endl << "Switching to SQLite3 is advised, "
 			<< "please read http://wiki.minetest.net/Database_backends." << std::endl;
 
-	return openModStorageDatabase(backend, world_path, world_mt);
+	// Mods read and write their storage from memory, changes are written
+	// in the background at each save interval
+	return new ModStorageDatabaseBuffered(
+		openModStorageDatabase(backend, world_path, world_mt));
 }
 
 ModStorageDatabase *Server::openModStorageDatabase(const std::string &backend,
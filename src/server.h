@@ -39,6 +39,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "clientiface.h"
 #include "chatmessage.h"
 #include "translation.h"
+#include "formspec_patch.h"
+#include "settings.h"
 #include <string>
 #include <list>
 #include <map>
@@ -71,8 +73,11 @@ struct MoonParams;
 struct StarParams;
 struct Lighting;
 class ServerThread;
+class StepPacer;
 class ServerModManager;
 class ServerInventoryManager;
+class DefinitionCache;
+class ProtectionStore;
 struct PackedValue;
 
 enum ClientDeletionReason {
@@ -161,7 +166,12 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	void step(float dtime);
 	// This is run by ServerThread and does the actual processing
 	void AsyncRunStep(bool initial_step=false);
-	void Receive();
+	// Runs AsyncRunStep() and returns how long Receive() may wait for
+	// packets before the next step is due (in ms)
+	u32 stepIfDue();
+	void Receive(u32 timeout_ms = 30);
+	// Step duration and lateness of the dedicated server, cleared on read
+	std::string getStepStats();
 	PlayerSAO* StageTwoClientInit(session_t peer_id);
 
 	/*
@@ -249,6 +259,9 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	void spawnParticle(const std::string &playername,
 		const ParticleParameters &p);
 
+	void spawnParticleBurst(const std::string &playername,
+		const ParticleBurst &burst);
+
 	u32 addParticleSpawner(const ParticleSpawnerParameters &p,
 		ServerActiveObject *attached, const std::string &playername);
 
@@ -258,6 +271,7 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 		const std::string &to_player, bool ephemeral);
 
 	ServerInventoryManager *getInventoryMgr() const { return m_inventory_mgr.get(); }
+	ProtectionStore *getProtectionStore() const { return m_protection_store.get(); }
 	void sendDetachedInventory(Inventory *inventory, const std::string &name, session_t peer_id);
 
 	// Envlock and conlock should be locked when using scriptapi
@@ -299,6 +313,8 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	}
 
 	bool showFormspec(const char *name, const std::string &formspec, const std::string &formname);
+	bool patchFormspec(const char *name, const std::string &formname,
+		const StringMap &patches);
 	Map & getMap() { return m_env->getMap(); }
 	ServerEnvironment & getEnv() { return *m_env; }
 	v3f findSpawnPos();
@@ -393,6 +409,7 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	friend class EmergeThread;
 	friend class RemoteClient;
 	friend class TestServerShutdownState;
+	friend class BenchmarkServerFixture;
 
 	struct ShutdownState {
 		friend class TestServerShutdownState;
@@ -435,9 +452,8 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	void SendAccessDenied_Legacy(session_t peer_id, const std::wstring &reason);
 	void SendDeathscreen(session_t peer_id, bool set_camera_point_target,
 		v3f camera_point_target);
-	void SendItemDef(session_t peer_id, IItemDefManager *itemdef, u16 protocol_version);
-	void SendNodeDef(session_t peer_id, const NodeDefManager *nodedef,
-		u16 protocol_version);
+	void SendItemDef(session_t peer_id, u16 protocol_version);
+	void SendNodeDef(session_t peer_id, u16 protocol_version);
 
 
 	virtual void SendChatMessage(session_t peer_id, const ChatMessage &message);
@@ -451,6 +467,8 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	void SendPlayerFormspecPrepend(session_t peer_id);
 	void SendShowFormspecMessage(session_t peer_id, const std::string &formspec,
 		const std::string &formname);
+	void SendFormspecPatch(session_t peer_id, const std::string &formname,
+		const FormspecPatch &patch);
 	void SendHUDAdd(session_t peer_id, u32 id, HudElement *form);
 	void SendHUDRemove(session_t peer_id, u32 id);
 	void SendHUDChange(session_t peer_id, u32 id, HudElementStat stat, void *value);
@@ -509,6 +527,10 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	void SendSpawnParticle(session_t peer_id, u16 protocol_version,
 		const ParticleParameters &p);
 
+	// Spawns many particles on peer with peer_id (PEER_ID_INEXISTENT == all)
+	void SendSpawnParticleBurst(session_t peer_id, u16 protocol_version,
+		const ParticleBurst &burst);
+
 	void SendActiveObjectRemoveAdd(RemoteClient *client, PlayerSAO *playersao);
 	void SendActiveObjectMessages(session_t peer_id, const std::string &datas,
 		bool reliable = true);
@@ -607,9 +629,15 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	// Craft definition manager
 	IWritableCraftDefManager *m_craftdef;
 
+	// Compressed item and node definitions sent to joining clients
+	std::unique_ptr<DefinitionCache> m_defcache;
+
 	// Mods
 	std::unique_ptr<ServerModManager> m_modmgr;
 
+	// Protected areas registered by mods
+	std::unique_ptr<ProtectionStore> m_protection_store;
+
 	std::unordered_map<std::string, Translations> server_translations;
 
 	/*
@@ -620,6 +648,11 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	float m_step_dtime = 0.0f;
 	std::mutex m_step_dtime_mutex;
 
+	// Paces steps of the dedicated server, which then keeps time itself
+	// instead of relying on step(). Null when hosted by a client.
+	std::unique_ptr<StepPacer> m_step_pacer;
+	std::mutex m_step_pacer_mutex;
+
 	// The server mainly operates in this thread
 	ServerThread *m_thread = nullptr;
 
@@ -642,6 +675,8 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	std::queue<con::PeerChange> m_peer_change_queue;
 
 	std::unordered_map<session_t, std::string> m_formspec_state_data;
+	// Elements of the formspec in m_formspec_state_data, for patching
+	std::unordered_map<session_t, std::vector<std::string>> m_formspec_elements;
 
 	/*
 		Random stuff
@@ -699,6 +734,26 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	u64 m_csm_restriction_flags = CSMRestrictionFlags::CSM_RF_NONE;
 	u32 m_csm_restriction_noderange = 8;
 
+	// Settings read on hot paths
+	SettingHandle<float> m_map_save_interval {g_settings, "server_map_save_interval"};
+	SettingHandle<s32> m_max_block_send_distance {g_settings, "max_block_send_distance"};
+	SettingHandle<s32> m_active_object_send_range {g_settings,
+		"active_object_send_range_blocks"};
+	SettingHandle<bool> m_player_transfer_limited {g_settings,
+		"unlimited_player_transfer_distance",
+		[](const Settings *settings, const std::string &name) {
+			return settings->exists(name) && !settings->getBool(name);
+		}};
+	SettingHandle<s32> m_player_transfer_distance {g_settings, "player_transfer_distance"};
+	SettingHandle<s32> m_net_compression_level {g_settings, "map_compression_level_net",
+		[](const Settings *settings, const std::string &name) {
+			return rangelim(settings->getS32(name), -1, 9);
+		}};
+	SettingHandle<u32> m_max_users {g_settings, "max_users"};
+	SettingHandle<u32> m_max_block_sends_per_client {g_settings,
+		"max_simultaneous_block_sends_per_client"};
+	SettingHandle<bool> m_enable_mod_channels {g_settings, "enable_mod_channels"};
+
 	// ModChannel manager
 	std::unique_ptr<ModChannelMgr> m_modchannel_mgr;
 
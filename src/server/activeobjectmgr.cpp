@@ -17,6 +17,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
 
+#include <algorithm>
+#include <cmath>
 #include <log.h>
 #include "mapblock.h"
 #include "profiler.h"
@@ -39,12 +41,14 @@ void ActiveObjectMgr::clear(const std::function<bool(ServerActiveObject *, u16)>
 	for (u16 i : objects_to_remove) {
 		m_active_objects.erase(i);
 	}
+	m_sap_valid = false;
 }
 
 void ActiveObjectMgr::step(
 		float dtime, const std::function<void(ServerActiveObject *)> &f)
 {
 	g_profiler->avg("ActiveObjectMgr: SAO count [#]", m_active_objects.size());
+	refreshSweepAndPrune();
 	for (auto &ao_it : m_active_objects) {
 		f(ao_it.second);
 	}
@@ -88,6 +92,7 @@ bool ActiveObjectMgr::registerObject(ServerActiveObject *obj)
 	}
 
 	m_active_objects[obj->getId()] = obj;
+	m_sap_valid = false;
 
 	verbosestream << "Server::ActiveObjectMgr::addActiveObjectRaw(): "
 			<< "Added id=" << obj->getId() << "; there are now "
@@ -107,6 +112,7 @@ void ActiveObjectMgr::removeObject(u16 id)
 	}
 
 	m_active_objects.erase(id);
+	m_sap_valid = false;
 	delete obj;
 }
 
@@ -127,6 +133,100 @@ void ActiveObjectMgr::getObjectsInsideRadius(const v3d &pos, float radius,
 	}
 }
 
+// Objects moving further than this between refreshes are checked one by one,
+// so that a teleport doesn't widen every query
+#define SAP_MAX_MARGIN (4.0 * BS)
+
+void ActiveObjectMgr::getCollisionCandidates(const v3d &pos, float radius,
+		std::vector<ServerActiveObject *> &result,
+		std::function<bool(ServerActiveObject *obj)> include_obj_cb)
+{
+	if (!m_sap_valid)
+		rebuildSweepAndPrune();
+
+	f64 reach = radius + m_sap_margin;
+	auto it = std::lower_bound(m_sap.begin(), m_sap.end(), pos.X - reach,
+		[] (const SweepAndPruneEntry &entry, f64 x) { return entry.x < x; });
+
+	float r2 = radius * radius;
+	for (; it != m_sap.end() && it->x <= pos.X + reach; ++it) {
+		ServerActiveObject *obj = it->obj;
+		if (!m_sap_moved.empty() && m_sap_moved.count(obj))
+			continue;
+		const v3d &objectpos = obj->getBasePosition();
+		if (objectpos.getDistanceFromSQ(pos) > r2)
+			continue;
+
+		if (!include_obj_cb || include_obj_cb(obj))
+			result.push_back(obj);
+	}
+
+	for (ServerActiveObject *obj : m_sap_moved) {
+		if (obj->getBasePosition().getDistanceFromSQ(pos) > r2)
+			continue;
+
+		if (!include_obj_cb || include_obj_cb(obj))
+			result.push_back(obj);
+	}
+}
+
+void ActiveObjectMgr::objectMoved(ServerActiveObject *obj)
+{
+	// Objects that are not registered yet are added by the next rebuild
+	if (!m_sap_valid || obj->getId() == 0)
+		return;
+
+	f64 distance = std::fabs(obj->getBasePosition().X - obj->m_sap_x);
+	if (distance <= SAP_MAX_MARGIN)
+		m_sap_margin = std::max(m_sap_margin, distance);
+	else if (getActiveObject(obj->getId()) == obj)
+		m_sap_moved.insert(obj);
+}
+
+void ActiveObjectMgr::rebuildSweepAndPrune()
+{
+	m_sap.clear();
+	m_sap.reserve(m_active_objects.size());
+	for (auto &ao_it : m_active_objects) {
+		ServerActiveObject *obj = ao_it.second;
+		obj->m_sap_x = obj->getBasePosition().X;
+		m_sap.push_back({obj->m_sap_x, obj});
+	}
+
+	std::sort(m_sap.begin(), m_sap.end(),
+		[] (const SweepAndPruneEntry &a, const SweepAndPruneEntry &b) {
+			return a.x < b.x;
+		});
+	m_sap_margin = 0.0;
+	m_sap_moved.clear();
+	m_sap_valid = true;
+}
+
+void ActiveObjectMgr::refreshSweepAndPrune()
+{
+	if (!m_sap_valid) {
+		rebuildSweepAndPrune();
+		return;
+	}
+
+	for (SweepAndPruneEntry &entry : m_sap) {
+		entry.x = entry.obj->getBasePosition().X;
+		entry.obj->m_sap_x = entry.x;
+	}
+	m_sap_margin = 0.0;
+	m_sap_moved.clear();
+
+	// Objects move little between steps, so the list is almost sorted
+	// and insertion sort is close to linear
+	for (size_t i = 1; i < m_sap.size(); i++) {
+		SweepAndPruneEntry entry = m_sap[i];
+		size_t j = i;
+		for (; j > 0 && m_sap[j - 1].x > entry.x; j--)
+			m_sap[j] = m_sap[j - 1];
+		m_sap[j] = entry;
+	}
+}
+
 void ActiveObjectMgr::getObjectsInArea(const aabb3f &box,
 		std::vector<ServerActiveObject *> &result,
 		std::function<bool(ServerActiveObject *obj)> include_obj_cb)
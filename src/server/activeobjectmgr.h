@@ -20,6 +20,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #pragma once
 
 #include <functional>
+#include <unordered_set>
 #include <vector>
 #include "../activeobjectmgr.h"
 #include "serveractiveobject.h"
@@ -38,6 +39,13 @@ class ActiveObjectMgr : public ::ActiveObjectMgr<ServerActiveObject>
 	void getObjectsInsideRadius(const v3d &pos, float radius,
 			std::vector<ServerActiveObject *> &result,
 			std::function<bool(ServerActiveObject *obj)> include_obj_cb);
+	// Same as getObjectsInsideRadius(), but uses a sweep-and-prune index
+	// along X that is sorted again at the beginning of every step
+	void getCollisionCandidates(const v3d &pos, float radius,
+			std::vector<ServerActiveObject *> &result,
+			std::function<bool(ServerActiveObject *obj)> include_obj_cb);
+	// Keeps the index valid for objects that moved since it was sorted
+	void objectMoved(ServerActiveObject *obj);
 	void getObjectsInArea(const aabb3f &box,
 			std::vector<ServerActiveObject *> &result,
 			std::function<bool(ServerActiveObject *obj)> include_obj_cb);
@@ -45,5 +53,25 @@ class ActiveObjectMgr : public ::ActiveObjectMgr<ServerActiveObject>
 	void getAddedActiveObjectsAroundPos(const v3d &player_pos, f32 radius,
 			f32 player_radius, std::set<u16> &current_objects,
 			std::queue<u16> &added_objects);
+
+private:
+	struct SweepAndPruneEntry
+	{
+		f64 x;
+		ServerActiveObject *obj;
+	};
+
+	void rebuildSweepAndPrune();
+	void refreshSweepAndPrune();
+
+	// Objects sorted by their X position
+	std::vector<SweepAndPruneEntry> m_sap;
+	bool m_sap_valid = false;
+	// Largest movement along X since the last refresh, queries are widened
+	// by it
+	f64 m_sap_margin = 0.0;
+	// Objects that moved too far for the margin since the last refresh,
+	// these are checked one by one
+	std::unordered_set<ServerActiveObject *> m_sap_moved;
 };
 } // namespace server
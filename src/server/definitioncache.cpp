@@ -0,0 +1,165 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "definitioncache.h"
+#include "debug.h"
+#include "itemdef.h"
+#include "log.h"
+#include "nodedef.h"
+#include "porting.h"
+#include "serialization.h"
+#include "threading/thread.h"
+#include <sstream>
+
+class DefinitionCacheThread : public Thread
+{
+public:
+	DefinitionCacheThread(DefinitionCache *cache, u16 protocol_version):
+		Thread("DefinitionCache"),
+		m_cache(cache),
+		m_protocol_version(protocol_version)
+	{}
+
+	void *run();
+
+private:
+	DefinitionCache *m_cache;
+	u16 m_protocol_version;
+};
+
+void *DefinitionCacheThread::run()
+{
+	BEGIN_DEBUG_EXCEPTION_HANDLER
+
+	u64 t0 = porting::getTimeMs();
+	std::shared_ptr<DefinitionCache::Blob> blob;
+	{
+		auto lock = m_cache->lockDefinitions();
+		blob = std::make_shared<DefinitionCache::Blob>(DefinitionCache::build(
+				m_cache->m_itemdef, m_cache->m_nodedef, m_protocol_version));
+	}
+
+	verbosestream << "DefinitionCache: Built definitions for protocol version "
+			<< m_protocol_version << " in " << (porting::getTimeMs() - t0)
+			<< "ms: itemdef=" << blob->itemdef.size()
+			<< " nodedef=" << blob->nodedef.size() << std::endl;
+
+	{
+		std::lock_guard<std::mutex> lock(m_cache->m_mutex);
+		m_cache->m_blobs[m_protocol_version] = std::move(blob);
+		m_cache->m_pending.erase(m_protocol_version);
+	}
+	m_cache->m_cond.notify_all();
+
+	END_DEBUG_EXCEPTION_HANDLER
+
+	return nullptr;
+}
+
+DefinitionCache::DefinitionCache(IItemDefManager *itemdef,
+		const NodeDefManager *nodedef) :
+	m_itemdef(itemdef),
+	m_nodedef(nodedef)
+{
+}
+
+DefinitionCache::~DefinitionCache()
+{
+	waitForThread();
+}
+
+void DefinitionCache::waitForThread()
+{
+	if (m_thread) {
+		m_thread->wait();
+		m_thread.reset();
+	}
+}
+
+void DefinitionCache::prepare(u16 protocol_version)
+{
+	// Only one build runs in the background at a time
+	waitForThread();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_blobs.count(protocol_version) || m_pending.count(protocol_version))
+			return;
+		m_pending.insert(protocol_version);
+	}
+
+	m_thread.reset(new DefinitionCacheThread(this, protocol_version));
+	m_thread->start();
+}
+
+std::shared_ptr<const DefinitionCache::Blob> DefinitionCache::get(u16 protocol_version)
+{
+	u32 generation;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_cond.wait(lock, [&] { return m_pending.count(protocol_version) == 0; });
+
+		auto it = m_blobs.find(protocol_version);
+		if (it != m_blobs.end())
+			return it->second;
+		generation = m_generation;
+	}
+
+	std::shared_ptr<const Blob> blob;
+	{
+		auto build_lock = lockDefinitions();
+		blob = std::make_shared<const Blob>(
+				build(m_itemdef, m_nodedef, protocol_version));
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	// Do not keep the blob if the definitions changed in the meantime
+	if (generation == m_generation)
+		m_blobs[protocol_version] = blob;
+	return blob;
+}
+
+void DefinitionCache::invalidate()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_cond.wait(lock, [&] { return m_pending.empty(); });
+	m_blobs.clear();
+	m_generation++;
+}
+
+DefinitionCache::Blob DefinitionCache::build(IItemDefManager *itemdef,
+		const NodeDefManager *nodedef, u16 protocol_version)
+{
+	Blob blob;
+	{
+		std::ostringstream tmp_os(std::ios::binary);
+		itemdef->serialize(tmp_os, protocol_version);
+		std::ostringstream tmp_os2(std::ios::binary);
+		compressZlib(tmp_os.str(), tmp_os2);
+		blob.itemdef = tmp_os2.str();
+	}
+	{
+		std::ostringstream tmp_os(std::ios::binary);
+		nodedef->serialize(tmp_os, protocol_version);
+		std::ostringstream tmp_os2(std::ios::binary);
+		compressZlib(tmp_os.str(), tmp_os2);
+		blob.nodedef = tmp_os2.str();
+	}
+	return blob;
+}
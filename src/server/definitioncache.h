@@ -0,0 +1,98 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include "util/basic_macros.h"
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+class IItemDefManager;
+class NodeDefManager;
+class DefinitionCacheThread;
+
+/*
+	Keeps the compressed item and node definitions that are sent to every
+	joining client, so that they are only serialized once per protocol version.
+
+	The blobs are rebuilt lazily after invalidate() has been called, which
+	has to happen whenever the definitions are changed after startup.
+*/
+class DefinitionCache
+{
+public:
+	struct Blob
+	{
+		// zlib-compressed serialized IItemDefManager
+		std::string itemdef;
+		// zlib-compressed serialized NodeDefManager
+		std::string nodedef;
+	};
+
+	DefinitionCache(IItemDefManager *itemdef, const NodeDefManager *nodedef);
+	~DefinitionCache();
+	DISABLE_CLASS_COPY(DefinitionCache)
+
+	// Starts building the blob for a protocol version on a worker thread
+	void prepare(u16 protocol_version);
+
+	// Returns the blob for a protocol version. Builds it on the calling thread
+	// if it is neither cached nor being built in the background.
+	std::shared_ptr<const Blob> get(u16 protocol_version);
+
+	// Drops all blobs. Waits for a pending background build to finish first.
+	void invalidate();
+
+	// Blocks all builds while it is held, definitions must only be changed
+	// under it. Call invalidate() after releasing it.
+	std::unique_lock<std::mutex> lockDefinitions()
+	{
+		return std::unique_lock<std::mutex>(m_build_mutex);
+	}
+
+	// Serializes and compresses the definitions, without any caching
+	static Blob build(IItemDefManager *itemdef, const NodeDefManager *nodedef,
+			u16 protocol_version);
+
+private:
+	friend class DefinitionCacheThread;
+
+	void waitForThread();
+
+	IItemDefManager *m_itemdef;
+	const NodeDefManager *m_nodedef;
+
+	// Held while serializing the definitions
+	std::mutex m_build_mutex;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::map<u16, std::shared_ptr<const Blob>> m_blobs;
+	// Protocol versions that are being built by m_thread
+	std::set<u16> m_pending;
+	// Incremented by invalidate(), used to discard outdated blobs
+	u32 m_generation = 0;
+
+	std::unique_ptr<DefinitionCacheThread> m_thread;
+};
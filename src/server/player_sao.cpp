@@ -492,6 +492,8 @@ void PlayerSAO::setHP(s32 target_hp, const PlayerHPChangeReason &reason, bool fr
 		m_properties_sent = false;
 
 	if (hp != m_hp) {
+		if (m_player)
+			m_player->setDirty(true);
 		m_hp = hp;
 		m_env->getGameDef()->HandlePlayerHPChange(this, reason);
 	} else if (from_client)
@@ -579,7 +581,7 @@ bool PlayerSAO::checkMovementCheat()
 {
 	if (m_is_singleplayer ||
 			isAttached() ||
-			g_settings->getBool("disable_anticheat")) {
+			!m_env->isAnticheatEnabled()) {
 		m_last_good_position = m_base_position;
 		return false;
 	}
@@ -0,0 +1,90 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "protectionstore.h"
+#include "util/areastore.h"
+
+ProtectionStore::ProtectionStore() :
+	m_store(AreaStore::getOptimalImplementation())
+{
+}
+
+ProtectionStore::~ProtectionStore() = default;
+
+u32 ProtectionStore::addArea(const v3s32 &minp, const v3s32 &maxp,
+		const std::string &owner, const std::set<std::string> &members)
+{
+	Area a(minp, maxp);
+	if (!m_store->insertArea(&a))
+		return U32_MAX;
+
+	Owner &o = m_owners[a.id];
+	o.name = owner;
+	o.members = members;
+	return a.id;
+}
+
+bool ProtectionStore::removeArea(u32 id)
+{
+	if (!m_store->removeArea(id))
+		return false;
+
+	m_owners.erase(id);
+	return true;
+}
+
+ProtectionResult ProtectionStore::check(const v3s32 &pos, const std::string &actor)
+{
+	std::vector<Area *> areas;
+	m_store->getAreasForPos(&areas, pos);
+	return evaluate(areas, actor);
+}
+
+ProtectionResult ProtectionStore::checkArea(const v3s32 &minp, const v3s32 &maxp,
+		const std::string &actor)
+{
+	v3s32 minedge = minp, maxedge = maxp;
+	sortBoxVerticies(minedge, maxedge);
+
+	std::vector<Area *> areas;
+	m_store->getAreasInArea(&areas, minedge, maxedge, true);
+	return evaluate(areas, actor);
+}
+
+ProtectionResult ProtectionStore::evaluate(const std::vector<Area *> &areas,
+		const std::string &actor) const
+{
+	if (areas.empty())
+		return PROTECTION_NONE;
+
+	// Non-players are never granted access
+	if (actor.empty())
+		return PROTECTION_DENIED;
+
+	for (const Area *a : areas) {
+		auto it = m_owners.find(a->id);
+		if (it == m_owners.end())
+			continue;
+
+		const Owner &o = it->second;
+		if (o.name != actor && o.members.count(actor) == 0)
+			return PROTECTION_DENIED;
+	}
+	return PROTECTION_ALLOWED;
+}
@@ -0,0 +1,78 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "irr_v3d.h"
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class AreaStore;
+struct Area;
+
+enum ProtectionResult
+{
+	// No registered area covers the queried position or area
+	PROTECTION_NONE,
+	// Every covering area is owned by the actor or lists it as member
+	PROTECTION_ALLOWED,
+	// At least one covering area does not grant access to the actor
+	PROTECTION_DENIED,
+};
+
+/*
+	Native registry of protected areas.
+
+	Protection mods register their areas here so that the common queries
+	can be answered without calling into the minetest.is_protected() chain.
+	The registry is not persisted, mods register their areas again on startup.
+*/
+class ProtectionStore
+{
+public:
+	ProtectionStore();
+	~ProtectionStore();
+
+	// Returns the ID of the new area or U32_MAX on failure
+	u32 addArea(const v3s32 &minp, const v3s32 &maxp, const std::string &owner,
+			const std::set<std::string> &members);
+	bool removeArea(u32 id);
+	size_t size() const { return m_owners.size(); }
+
+	ProtectionResult check(const v3s32 &pos, const std::string &actor);
+	// Checks every area intersecting the cuboid between minp and maxp
+	ProtectionResult checkArea(const v3s32 &minp, const v3s32 &maxp,
+			const std::string &actor);
+
+private:
+	struct Owner
+	{
+		std::string name;
+		std::set<std::string> members;
+	};
+
+	ProtectionResult evaluate(const std::vector<Area *> &areas,
+			const std::string &actor) const;
+
+	std::unique_ptr<AreaStore> m_store;
+	std::unordered_map<u32, Owner> m_owners;
+};
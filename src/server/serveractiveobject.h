@@ -83,7 +83,8 @@ class ServerActiveObject : public ActiveObject
 		Some simple getters/setters
 	*/
 	v3d getBasePosition() const { return m_base_position; }
-	void setBasePosition(v3d pos){ m_base_position = pos; }
+	// Keeps the collision index of the environment up to date
+	void setBasePosition(v3d pos);
 	ServerEnvironment* getEnv(){ return m_env; }
 
 	/*
@@ -235,6 +236,11 @@ class ServerActiveObject : public ActiveObject
 	*/
 	v3s32 m_static_block = v3s32(1337,1337,1337);
 
+	/*
+		X position in the sweep-and-prune index of server::ActiveObjectMgr
+	*/
+	f64 m_sap_x = 0.0;
+
 protected:
 	virtual void onMarkedForDeactivation() {}
 	virtual void onMarkedForRemoval() {}
@@ -88,7 +88,7 @@ void ServerInventoryManager::setInventoryModified(const InventoryLocation &loc)
 		if (!player)
 			return;
 
-		player->setModified(true);
+		player->setDirtyFlags(PLAYER_DIRTY_INVENTORY);
 		player->inventory.setModified(true);
 		// Updates are sent in ServerEnvironment::step()
 	} break;
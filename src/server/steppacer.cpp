@@ -0,0 +1,91 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "steppacer.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+void TimeHistogram::add(u64 us)
+{
+	size_t bucket = 0;
+	for (u64 bound = 1000; bucket < BUCKETS - 1 && us >= bound; bound *= 2)
+		bucket++;
+	m_buckets[bucket]++;
+	m_count++;
+	m_sum += us;
+	m_max = std::max(m_max, us);
+}
+
+u64 TimeHistogram::percentile(f32 fraction) const
+{
+	u64 wanted = std::ceil(m_count * fraction);
+	u64 seen = 0;
+	for (size_t i = 0; i < BUCKETS; i++) {
+		seen += m_buckets[i];
+		if (seen >= wanted && seen > 0)
+			return i == BUCKETS - 1 ? m_max : (1000ULL << i);
+	}
+	return 0;
+}
+
+std::string TimeHistogram::toString() const
+{
+	std::ostringstream os;
+	os << std::fixed << std::setprecision(1)
+		<< "n=" << m_count
+		<< " mean=" << mean() / 1000.0f << "ms"
+		<< " p50<" << percentile(0.5f) / 1000 << "ms"
+		<< " p99<" << percentile(0.99f) / 1000 << "ms"
+		<< " max=" << m_max / 1000.0f << "ms";
+	return os.str();
+}
+
+StepPacer::StepPacer(u64 interval, u64 now) :
+	m_interval(interval),
+	m_deadline(now)
+{
+}
+
+f32 StepPacer::begin(u64 now)
+{
+	m_lateness.add(now > m_deadline ? now - m_deadline : 0);
+
+	if (now > m_deadline && now - m_deadline > m_interval)
+		m_deadline = now + m_interval;
+	else
+		m_deadline += m_interval;
+
+	u64 dtime = m_last_begin ? now - m_last_begin : m_interval;
+	m_last_begin = now;
+	m_step_begin = now;
+	return dtime / 1000000.0f;
+}
+
+void StepPacer::end(u64 now)
+{
+	m_durations.add(now - m_step_begin);
+}
+
+void StepPacer::clearStats()
+{
+	m_durations.clear();
+	m_lateness.clear();
+}
@@ -0,0 +1,87 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include <string>
+
+/*
+	Histogram of durations in power-of-two buckets from 1 ms up.
+*/
+class TimeHistogram
+{
+public:
+	static const size_t BUCKETS = 12;
+
+	void add(u64 us);
+	void clear() { *this = TimeHistogram(); }
+
+	u64 count() const { return m_count; }
+	u64 max() const { return m_max; }
+	u64 mean() const { return m_count ? m_sum / m_count : 0; }
+	// Upper bound of the bucket the given fraction of samples falls into
+	u64 percentile(f32 fraction) const;
+
+	// e.g. "n=100 mean=12.3ms p50<16ms p99<32ms max=20.1ms"
+	std::string toString() const;
+
+private:
+	u64 m_buckets[BUCKETS] = {};
+	u64 m_count = 0;
+	u64 m_sum = 0;
+	u64 m_max = 0;
+};
+
+/*
+	Deadline-based pacing of server steps.
+
+	Each step is due one interval after the previous one was due, not after
+	it finished, so a late step is followed by an early one. When the server
+	falls more than an interval behind, the schedule restarts from the
+	current time instead of running the missed steps back to back.
+
+	Times are in microseconds.
+*/
+class StepPacer
+{
+public:
+	// The first step is due at 'now'
+	StepPacer(u64 interval, u64 now);
+
+	bool isDue(u64 now) const { return now >= m_deadline; }
+	u64 timeUntilDue(u64 now) const { return isDue(now) ? 0 : m_deadline - now; }
+
+	// Starts the due step and returns the seconds since the previous one
+	f32 begin(u64 now);
+	void end(u64 now);
+
+	const TimeHistogram &getDurations() const { return m_durations; }
+	const TimeHistogram &getLateness() const { return m_lateness; }
+	void clearStats();
+
+private:
+	u64 m_interval;
+	u64 m_deadline;
+	u64 m_last_begin = 0;
+	u64 m_step_begin = 0;
+
+	TimeHistogram m_durations;
+	TimeHistogram m_lateness;
+};
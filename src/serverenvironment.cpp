@@ -408,6 +408,7 @@ ServerEnvironment::ServerEnvironment(ServerMap *map,
 	m_script(script_iface),
 	m_server(server),
 	m_path_world(path_world),
+	m_node_timer_wheel(m_cache_nodetimer_interval),
 	m_rgen(seed())
 {
 	m_step_time_counter = mb->addCounter(
@@ -418,6 +419,14 @@ ServerEnvironment::ServerEnvironment(ServerMap *map,
 
 	m_active_object_gauge = mb->addGauge(
 		"minetest_env_active_objects", "Number of active objects");
+
+	m_activation_backlog_gauge = mb->addGauge(
+		"minetest_env_activation_backlog",
+		"Number of stored objects waiting for activation in active blocks");
+
+	m_activation_time_gauge = mb->addGauge(
+		"minetest_env_activation_time",
+		"Time spent activating objects in the last step (in microseconds)");
 }
 
 void ServerEnvironment::init()
@@ -497,6 +506,14 @@ void ServerEnvironment::init()
 
 ServerEnvironment::~ServerEnvironment()
 {
+	// The wheel is destroyed together with the environment, but the map
+	// might still be referenced elsewhere
+	for (const v3s32 &p: m_active_blocks.m_list) {
+		MapBlock *block = m_map->getBlockNoCreateNoEx(p);
+		if (block)
+			block->detachNodeTimers();
+	}
+
 	// Clear active block list.
 	// This makes the next one delete all active objects.
 	m_active_blocks.clear();
@@ -592,18 +609,30 @@ void ServerEnvironment::kickAllPlayers(AccessDeniedCode reason,
 
 void ServerEnvironment::saveLoadedPlayers(bool force)
 {
+	bool batch_started = false;
 	for (RemotePlayer *player : m_players) {
-		if (force || player->checkModified() || (player->getPlayerSAO() &&
-				player->getPlayerSAO()->getMeta().isModified())) {
-			try {
-				m_player_database->savePlayer(player);
-			} catch (DatabaseException &e) {
-				errorstream << "Failed to save player " << player->getName() << " exception: "
-					<< e.what() << std::endl;
-				throw;
+		if (force)
+			player->setModified(true);
+		// Only the changed parts of the player are written
+		if (!player->checkModified())
+			continue;
+
+		try {
+			// Lazy beginSaveBatch()
+			if (!batch_started) {
+				m_player_database->beginSaveBatch();
+				batch_started = true;
 			}
+			m_player_database->savePlayer(player);
+		} catch (DatabaseException &e) {
+			errorstream << "Failed to save player " << player->getName() << " exception: "
+				<< e.what() << std::endl;
+			throw;
 		}
 	}
+
+	if (batch_started)
+		m_player_database->endSaveBatch();
 }
 
 void ServerEnvironment::savePlayer(RemotePlayer *player)
@@ -865,7 +894,8 @@ class ABMHandler
 					wider += block2->m_static_objects.size();
 				}
 		// Extrapolate
-		u32 active_object_count = block->m_static_objects.getActiveSize();
+		// Stored objects count too, they may still be waiting for activation
+		u32 active_object_count = block->m_static_objects.size();
 		u32 wider_known_count = 3 * 3 * 3 - wider_unknown_count;
 		wider += wider_unknown_count * wider / wider_known_count;
 		return active_object_count;
@@ -1011,8 +1041,10 @@ void ServerEnvironment::activateBlock(MapBlock *block, u32 additional_dtime)
 	/*infostream<<"ServerEnvironment::activateBlock(): block is "
 			<<dtime_s<<" seconds old."<<std::endl;*/
 
-	// Activate stored objects
-	activateObjects(block, dtime_s);
+	// Stored objects are activated by stepObjectActivation() once a
+	// player comes close enough
+	if (!block->m_static_objects.getAllStored().empty())
+		m_pending_activations[block->getPos()] = {m_game_time, dtime_s};
 
 	/* Handle LoadingBlockModifiers */
 	m_lbm_mgr.applyLBMs(this, block, stamp, (float)dtime_s);
@@ -1318,9 +1350,7 @@ void ServerEnvironment::step(float dtime)
 	// Update this one
 	// NOTE: This is kind of funny on a singleplayer game, but doesn't
 	// really matter that much.
-	static thread_local const float server_step =
-			g_settings->getFloat("dedicated_server_step");
-	m_recommended_send_interval = server_step;
+	m_recommended_send_interval = m_server_step.get();
 
 	/*
 		Increment game time
@@ -1374,10 +1404,8 @@ void ServerEnvironment::step(float dtime)
 		*/
 		// use active_object_send_range_blocks since that is max distance
 		// for active objects sent the client anyway
-		static thread_local const s32 active_object_range =
-				g_settings->getS32("active_object_send_range_blocks");
-		static thread_local const s32 active_block_range =
-				g_settings->getS32("active_block_range");
+		const s32 active_object_range = m_active_object_range.get();
+		const s32 active_block_range = m_active_block_range.get();
 		std::set<v3s32> blocks_removed;
 		std::set<v3s32> blocks_added;
 		m_active_blocks.update(players, active_block_range, active_object_range,
@@ -1397,8 +1425,14 @@ void ServerEnvironment::step(float dtime)
 
 			// Set current time as timestamp (and let it set ChangedFlag)
 			block->setTimestamp(m_game_time);
+
+			// Stop the node timers until the block is activated again
+			block->detachNodeTimers();
 		}
 
+		for (const v3s32 &p: blocks_removed)
+			m_pending_activations.erase(p);
+
 		/*
 			Handle added blocks
 		*/
@@ -1417,6 +1451,27 @@ void ServerEnvironment::step(float dtime)
 			activateBlock(block);
 		}
 
+		for (const v3s32 &p: m_active_blocks.m_list) {
+			MapBlock *block = m_map->getBlockNoCreateNoEx(p);
+			if (!block)
+				continue;
+
+			// Reset block usage timer
+			block->resetUsageTimer();
+
+			// Set current time as timestamp
+			block->setTimestampNoChangedFlag(m_game_time);
+			// If time has changed much from the one on disk,
+			// set block to be saved when it is unloaded
+			if(block->getTimestamp() > block->getDiskTimestamp() + 60)
+				block->raiseModified(MOD_STATE_WRITE_AT_UNLOAD,
+					MOD_REASON_BLOCK_EXPIRED);
+
+			// Newly activated blocks, or blocks that were replaced while active
+			if (!block->nodeTimersAttached())
+				block->attachNodeTimers(&m_node_timer_wheel);
+		}
+
 		// Some blocks may be removed again by the code above so do this here
 		m_active_block_gauge->set(m_active_blocks.size());
 
@@ -1424,35 +1479,31 @@ void ServerEnvironment::step(float dtime)
 			--m_fast_active_block_divider;
 	}
 
+	/*
+		Activate stored objects of active blocks
+	*/
+	stepObjectActivation();
+
 	/*
 		Mess around in active blocks
 	*/
 	if (m_active_blocks_nodemetadata_interval.step(dtime, m_cache_nodetimer_interval)) {
 		ScopeProfiler sp(g_profiler, "ServerEnv: Run node timers", SPT_AVG);
 
-		float dtime = m_cache_nodetimer_interval;
+		std::vector<v3s32> due_blocks;
+		m_node_timer_wheel.step(m_cache_nodetimer_interval, due_blocks);
 
-		for (const v3s32 &p: m_active_blocks.m_list) {
+		for (const v3s32 &p: due_blocks) {
 			MapBlock *block = m_map->getBlockNoCreateNoEx(p);
 			if (!block)
 				continue;
 
-			// Reset block usage timer
-			block->resetUsageTimer();
-
-			// Set current time as timestamp
-			block->setTimestampNoChangedFlag(m_game_time);
-			// If time has changed much from the one on disk,
-			// set block to be saved when it is unloaded
-			if(block->getTimestamp() > block->getDiskTimestamp() + 60)
-				block->raiseModified(MOD_STATE_WRITE_AT_UNLOAD,
-					MOD_REASON_BLOCK_EXPIRED);
-
 			// Run node timers
-			block->step(dtime, [&](v3s32 p, MapNode n, f32 d) -> bool {
+			block->step(0.0f, [&](v3s32 p, MapNode n, f32 d) -> bool {
 				return m_script->node_on_timer(p, n, d);
 			});
 		}
+		g_profiler->avg("ServerEnv: blocks with elapsed node timers", due_blocks.size());
 	}
 
 	if (m_active_block_modifier_interval.step(dtime, m_cache_abm_interval)) {
@@ -2012,6 +2063,82 @@ void ServerEnvironment::activateObjects(MapBlock *block, u32 dtime_s)
 	*/
 }
 
+void ServerEnvironment::stepObjectActivation()
+{
+	if (m_pending_activations.empty()) {
+		m_activation_backlog_gauge->set(0);
+		m_activation_time_gauge->set(0);
+		return;
+	}
+
+	ScopeProfiler sp(g_profiler, "ServerEnv: activate objects", SPT_AVG);
+	const u64 start_time = porting::getTimeUs();
+
+	const s32 activation_range = m_activation_range.get();
+	const u32 activation_limit = m_activation_limit.get();
+
+	std::vector<v3s32> player_blocks;
+	player_blocks.reserve(m_players.size());
+	for (RemotePlayer *player : m_players) {
+		PlayerSAO *playersao = player->getPlayerSAO();
+		if (player->getPeerId() == PEER_ID_INEXISTENT || !playersao)
+			continue;
+		player_blocks.push_back(getNodeBlockPos(
+				floatToInt(playersao->getBasePosition(), BS)));
+	}
+
+	// Collect the blocks in range, ordered by distance to the closest player.
+	// Forceloaded blocks come first since no player needs to be near them.
+	const s32 range_sq = activation_range * activation_range;
+	std::vector<std::pair<s32, v3s32>> candidates;
+	size_t backlog = 0;
+	for (auto it = m_pending_activations.begin(); it != m_pending_activations.end();) {
+		MapBlock *block = m_map->getBlockNoCreateNoEx(it->first);
+		if (!block || block->m_static_objects.getAllStored().empty()) {
+			it = m_pending_activations.erase(it);
+			continue;
+		}
+		backlog += block->m_static_objects.getStoredSize();
+
+		s32 distance_sq = S32_MAX;
+		if (m_active_blocks.m_forceloaded_list.count(it->first)) {
+			distance_sq = -1;
+		} else {
+			for (const v3s32 &p : player_blocks)
+				distance_sq = std::min(distance_sq, (p - it->first).getLengthSQ());
+		}
+		if (distance_sq <= range_sq)
+			candidates.emplace_back(distance_sq, it->first);
+		++it;
+	}
+	std::sort(candidates.begin(), candidates.end(),
+		[] (const std::pair<s32, v3s32> &a, const std::pair<s32, v3s32> &b) {
+			return a.first < b.first;
+		});
+
+	// Whole blocks are activated, at least one per step
+	u32 activated = 0;
+	for (const auto &candidate : candidates) {
+		if (activated >= activation_limit)
+			break;
+
+		auto it = m_pending_activations.find(candidate.second);
+		MapBlock *block = m_map->getBlockNoCreateNoEx(candidate.second);
+		// Account for the time spent waiting in the queue
+		u32 dtime_s = it->second.dtime_s + (m_game_time - it->second.activated_time);
+		m_pending_activations.erase(it);
+
+		u32 count = block->m_static_objects.getStoredSize();
+		activateObjects(block, dtime_s);
+		activated += count;
+		backlog -= count;
+	}
+
+	g_profiler->avg("ServerEnv: objects activated per step", activated);
+	m_activation_backlog_gauge->set(backlog);
+	m_activation_time_gauge->set(porting::getTimeUs() - start_time);
+}
+
 /*
 	Convert objects that are not standing inside active blocks to static.
 
@@ -2295,6 +2422,7 @@ bool ServerEnvironment::migratePlayersDatabase(const GameParams &game_params,
 			playerSAO.finalize(&player, std::set<std::string>());
 			player.setPlayerSAO(&playerSAO);
 
+			player.setModified(true);
 			dstdb->savePlayer(&player);
 
 			// For files source, move player files to backup dir
@@ -22,6 +22,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "activeobject.h"
 #include "environment.h"
 #include "map.h"
+#include "nodetimer.h"
 #include "settings.h"
 #include "server/activeobjectmgr.h"
 #include "util/numeric.h"
@@ -236,6 +237,9 @@ class ServerEnvironment final : public Environment
 	float getSendRecommendedInterval()
 	{ return m_recommended_send_interval; }
 
+	bool isAnticheatEnabled() const
+	{ return !m_disable_anticheat.get(); }
+
 	void kickAllPlayers(AccessDeniedCode reason,
 		const std::string &str_reason, bool reconnect);
 	// Save players
@@ -350,6 +354,20 @@ class ServerEnvironment final : public Environment
 		return m_ao_manager.getObjectsInsideRadius(pos, radius, objects, include_obj_cb);
 	}
 
+	// Called when the position of an active object changed
+	void objectMoved(ServerActiveObject *obj)
+	{
+		m_ao_manager.objectMoved(obj);
+	}
+
+	// Find the active objects a moving object might collide with
+	void getCollisionCandidates(std::vector<ServerActiveObject *> &objects,
+			const v3d &pos, float radius,
+			std::function<bool(ServerActiveObject *obj)> include_obj_cb)
+	{
+		return m_ao_manager.getCollisionCandidates(pos, radius, objects, include_obj_cb);
+	}
+
 	// Find all active objects inside a box
 	void getObjectsInArea(std::vector<ServerActiveObject *> &objects, const aabb3f &box,
 			std::function<bool(ServerActiveObject *obj)> include_obj_cb)
@@ -433,6 +451,12 @@ class ServerEnvironment final : public Environment
 	*/
 	void activateObjects(MapBlock *block, u32 dtime_s);
 
+	/*
+		Activate the stored objects of the pending blocks closest to the
+		players, up to object_activation_limit objects per step
+	*/
+	void stepObjectActivation();
+
 	/*
 		Convert objects that are not in active blocks to static.
 
@@ -479,6 +503,16 @@ class ServerEnvironment final : public Environment
 	IntervalLimiter m_active_blocks_mgmt_interval;
 	IntervalLimiter m_active_block_modifier_interval;
 	IntervalLimiter m_active_blocks_nodemetadata_interval;
+	// Node timers of the active blocks
+	NodeTimerWheel m_node_timer_wheel;
+	// Active blocks whose stored objects have not been activated yet
+	struct PendingActivation
+	{
+		// Game time when the block was activated
+		u32 activated_time;
+		u32 dtime_s;
+	};
+	std::unordered_map<v3s32, PendingActivation> m_pending_activations;
 	// Whether the variables below have been read from file yet
 	bool m_meta_loaded = false;
 	// Time from the beginning of the game in seconds.
@@ -494,6 +528,23 @@ class ServerEnvironment final : public Environment
 	LBMManager m_lbm_mgr;
 	// An interval for generally sending object positions and stuff
 	float m_recommended_send_interval = 0.1f;
+
+	// Settings read on hot paths
+	SettingHandle<float> m_server_step {g_settings, "dedicated_server_step"};
+	SettingHandle<s32> m_active_object_range {g_settings,
+		"active_object_send_range_blocks"};
+	SettingHandle<s32> m_active_block_range {g_settings, "active_block_range"};
+	// Clamped to the minimum from settingtypes.txt so a bad runtime value
+	// cannot stop activation or make the range check wrap
+	SettingHandle<s32> m_activation_range {g_settings, "object_activation_range",
+		[](const Settings *settings, const std::string &name) {
+			return MYMAX(1, settings->getS32(name));
+		}};
+	SettingHandle<u32> m_activation_limit {g_settings, "object_activation_limit",
+		[](const Settings *settings, const std::string &name) {
+			return (u32)MYMAX(1, settings->getS32(name));
+		}};
+	SettingHandle<bool> m_disable_anticheat {g_settings, "disable_anticheat"};
 	// Estimate for general maximum lag as determined by server.
 	// Can raise to high values like 15s with eg. map generation mods.
 	float m_max_lag_estimate = 0.1f;
@@ -516,6 +567,8 @@ class ServerEnvironment final : public Environment
 	MetricCounterPtr m_step_time_counter;
 	MetricGaugePtr m_active_block_gauge;
 	MetricGaugePtr m_active_object_gauge;
+	MetricGaugePtr m_activation_backlog_gauge;
+	MetricGaugePtr m_activation_time_gauge;
 
 	ServerActiveObject* createSAO(ActiveObjectType type, v3f pos, const std::string &data);
 };
@@ -22,6 +22,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "irrlichttypes_bloated.h"
 #include "util/string.h"
 #include "util/basic_macros.h"
+#include "exceptions.h"
+#include <atomic>
 #include <string>
 #include <list>
 #include <set>
@@ -298,3 +300,95 @@ class Settings {
 
 	static std::unordered_map<std::string, const FlagDesc *> s_flags;
 };
+
+/*
+	A setting that is read on hot paths.
+
+	The value is converted once and then kept up to date through a changed
+	callback, so get() is an atomic load instead of a locked lookup through
+	the settings hierarchy. Changes made to other layers than 'settings'
+	(e.g. the defaults) are not seen, like with other changed callbacks.
+	The handle must not outlive 'settings'.
+*/
+template <typename T>
+class SettingHandle
+{
+public:
+	// Converts the setting, e.g. to clamp or scale it
+	typedef T (*Reader)(const Settings *settings, const std::string &name);
+
+	// Throws SettingNotFoundException like the Settings getters
+	SettingHandle(Settings *settings, const std::string &name,
+			Reader reader = &SettingHandle::read) :
+		m_settings(settings),
+		m_name(name),
+		m_reader(reader),
+		m_value(reader(settings, name))
+	{
+		m_settings->registerChangedCallback(m_name, &SettingHandle::changed, this);
+	}
+
+	~SettingHandle()
+	{
+		m_settings->deregisterChangedCallback(m_name, &SettingHandle::changed, this);
+	}
+
+	DISABLE_CLASS_COPY(SettingHandle)
+
+	T get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+	static T read(const Settings *settings, const std::string &name);
+
+	static void changed(const std::string &name, void *data)
+	{
+		SettingHandle *handle = (SettingHandle *)data;
+		try {
+			handle->m_value.store(handle->m_reader(handle->m_settings, name),
+				std::memory_order_relaxed);
+		} catch (SettingNotFoundException &) {
+			// Removed without a default, keep the last value
+		}
+	}
+
+	Settings *m_settings;
+	const std::string m_name;
+	const Reader m_reader;
+	std::atomic<T> m_value;
+};
+
+template <>
+inline bool SettingHandle<bool>::read(const Settings *settings, const std::string &name)
+{
+	return settings->getBool(name);
+}
+
+template <>
+inline u16 SettingHandle<u16>::read(const Settings *settings, const std::string &name)
+{
+	return settings->getU16(name);
+}
+
+template <>
+inline s16 SettingHandle<s16>::read(const Settings *settings, const std::string &name)
+{
+	return settings->getS16(name);
+}
+
+template <>
+inline u32 SettingHandle<u32>::read(const Settings *settings, const std::string &name)
+{
+	return settings->getU32(name);
+}
+
+template <>
+inline s32 SettingHandle<s32>::read(const Settings *settings, const std::string &name)
+{
+	return settings->getS32(name);
+}
+
+template <>
+inline float SettingHandle<float>::read(const Settings *settings, const std::string &name)
+{
+	return settings->getFloat(name);
+}
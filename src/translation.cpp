@@ -20,6 +20,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "translation.h"
 #include "log.h"
 #include "util/string.h"
+#include <set>
 #include <unordered_map>
 
 
@@ -30,25 +31,70 @@ Translations *g_client_translations = &client_translations;
 #endif
 
 
+// Chat messages are mostly unique, don't let them pile up
+#define TRANSLATED_STRINGS_MAX 4096
+
 void Translations::clear()
 {
+	m_textdomains.clear();
 	m_translations.clear();
+	m_translated_strings.clear();
+}
+
+size_t Translations::internTextdomain(const std::wstring &textdomain)
+{
+	auto it = m_textdomains.find(textdomain);
+	if (it != m_textdomains.end())
+		return it->second;
+
+	size_t id = m_translations.size();
+	m_textdomains.emplace(textdomain, id);
+	m_translations.emplace_back();
+	return id;
 }
 
 const std::wstring &Translations::getTranslation(
 		const std::wstring &textdomain, const std::wstring &s)
 {
-	std::wstring key = textdomain + L"|" + s;
-	try {
-		return m_translations.at(key);
-	} catch (const std::out_of_range &) {
-		verbosestream << "Translations: can't find translation for string \""
-		              << wide_to_utf8(s) << "\" in textdomain \""
-		              << wide_to_utf8(textdomain) << "\"" << std::endl;
-		// Silence that warning in the future
-		m_translations[key] = s;
-		return s;
+	auto domain = m_textdomains.find(textdomain);
+	if (domain != m_textdomains.end()) {
+		const StringTable &table = m_translations[domain->second];
+		auto it = table.find(s);
+		if (it != table.end())
+			return it->second;
+	}
+
+	verbosestream << "Translations: can't find translation for string \""
+	              << wide_to_utf8(s) << "\" in textdomain \""
+	              << wide_to_utf8(textdomain) << "\"" << std::endl;
+	// Silence that warning in the future
+	size_t id = internTextdomain(textdomain);
+	m_translations[id][s] = s;
+	return s;
+}
+
+const std::wstring *Translations::getTranslatedString(const std::wstring &s) const
+{
+	auto it = m_translated_strings.find(s);
+	return it != m_translated_strings.end() ? &it->second : nullptr;
+}
+
+void Translations::cacheTranslatedString(const std::wstring &s,
+		const std::wstring &result)
+{
+	if (m_translated_strings.size() >= TRANSLATED_STRINGS_MAX)
+		m_translated_strings.clear();
+	m_translated_strings[s] = result;
+}
+
+std::wstring Translations::getCharacters() const
+{
+	std::set<wchar_t> chars;
+	for (const StringTable &table : m_translations) {
+		for (const auto &it : table)
+			chars.insert(it.second.begin(), it.second.end());
 	}
+	return std::wstring(chars.begin(), chars.end());
 }
 
 void Translations::loadTranslation(const std::string &data)
@@ -57,6 +103,9 @@ void Translations::loadTranslation(const std::string &data)
 	std::wstring textdomain;
 	std::string line;
 
+	// Translated strings may change
+	m_translated_strings.clear();
+
 	while (is.good()) {
 		std::getline(is, line);
 		// Trim last character if file was using a \r\n line ending
@@ -151,9 +200,8 @@ void Translations::loadTranslation(const std::string &data)
 
 		std::wstring oword1 = word1.str(), oword2 = word2.str();
 		if (!oword2.empty()) {
-			std::wstring translation_index = textdomain + L"|";
-			translation_index.append(oword1);
-			m_translations[translation_index] = oword2;
+			size_t id = internTextdomain(textdomain);
+			m_translations[id][oword1] = oword2;
 		} else {
 			infostream << "Ignoring empty translation for \""
 				<< wide_to_utf8(oword1) << "\"" << std::endl;
@@ -21,6 +21,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 class Translations;
 #ifndef SERVER
@@ -34,7 +35,23 @@ class Translations
 	void clear();
 	const std::wstring &getTranslation(
 			const std::wstring &textdomain, const std::wstring &s);
+	// Every character used by the translated strings, once each
+	std::wstring getCharacters() const;
+
+	// Results of translate_string(), so strings shown over and over
+	// are parsed only once
+	const std::wstring *getTranslatedString(const std::wstring &s) const;
+	void cacheTranslatedString(const std::wstring &s, const std::wstring &result);
 
 private:
-	std::unordered_map<std::wstring, std::wstring> m_translations;
+	typedef std::unordered_map<std::wstring, std::wstring> StringTable;
+
+	size_t internTextdomain(const std::wstring &textdomain);
+
+	// Textdomains are interned, so lookups don't build "textdomain|string" keys
+	std::unordered_map<std::wstring, size_t> m_textdomains;
+	// Indexed by textdomain
+	std::vector<StringTable> m_translations;
+
+	StringTable m_translated_strings;
 };
@@ -0,0 +1,159 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include "client/filecache.h"
+#include "filesys.h"
+
+class TestFileCache : public TestBase
+{
+public:
+	TestFileCache() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestFileCache"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testPersistence();
+	void testLooseFiles();
+	void testEviction();
+	void testReplace();
+	void testSharedDirectory();
+};
+
+static TestFileCache g_test_instance;
+
+void TestFileCache::runTests(IGameDef *gamedef)
+{
+	TEST(testPersistence);
+	TEST(testLooseFiles);
+	TEST(testEviction);
+	TEST(testReplace);
+	TEST(testSharedDirectory);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TestFileCache::testPersistence()
+{
+	std::string dir = getTestTempDirectory() + DIR_DELIM "filecache_persist";
+
+	{
+		FileCache cache(dir);
+		UASSERT(!cache.exists("aa"));
+		UASSERT(cache.update("aa", "first"));
+		UASSERT(cache.update("bb", std::string("with\0zero", 9)));
+		UASSERT(cache.update("cc", ""));
+		UASSERT(cache.exists("aa"));
+	}
+
+	FileCache cache(dir);
+	std::string data;
+	UASSERT(cache.load("aa", data));
+	UASSERTEQ(std::string, data, "first");
+	UASSERT(cache.load("cc", data));
+	UASSERT(data.empty());
+
+	std::unordered_map<std::string, std::string> result;
+	cache.loadMany({"bb", "missing", "aa"}, result);
+	UASSERTEQ(size_t, result.size(), 2);
+	UASSERT(result["bb"] == std::string("with\0zero", 9));
+	UASSERTEQ(std::string, result["aa"], "first");
+
+	fs::RecursiveDelete(dir);
+}
+
+void TestFileCache::testLooseFiles()
+{
+	std::string dir = getTestTempDirectory() + DIR_DELIM "filecache_loose";
+	fs::CreateAllDirs(dir);
+	UASSERT(fs::safeWriteToFile(dir + DIR_DELIM "dd", "old layout"));
+
+	{
+		FileCache cache(dir);
+		UASSERT(cache.exists("dd"));
+		std::string data;
+		UASSERT(cache.load("dd", data));
+		UASSERTEQ(std::string, data, "old layout");
+	}
+
+	// Moved into a pack
+	UASSERT(!fs::PathExists(dir + DIR_DELIM "dd"));
+	FileCache cache(dir);
+	std::string data;
+	UASSERT(cache.load("dd", data));
+	UASSERTEQ(std::string, data, "old layout");
+
+	fs::RecursiveDelete(dir);
+}
+
+void TestFileCache::testEviction()
+{
+	std::string dir = getTestTempDirectory() + DIR_DELIM "filecache_evict";
+	FileCache cache(dir, 1000);
+	std::string data;
+
+	UASSERT(cache.update("a", std::string(400, 'a')));
+	UASSERT(cache.update("b", std::string(400, 'b')));
+	// Used more recently than b
+	UASSERT(cache.load("a", data));
+	UASSERT(cache.update("c", std::string(400, 'c')));
+
+	UASSERT(cache.exists("a"));
+	UASSERT(!cache.exists("b"));
+	UASSERT(cache.exists("c"));
+	UASSERT(cache.load("a", data));
+	UASSERTEQ(std::string, data, std::string(400, 'a'));
+	UASSERT(cache.load("c", data));
+	UASSERTEQ(std::string, data, std::string(400, 'c'));
+
+	fs::RecursiveDelete(dir);
+}
+
+void TestFileCache::testReplace()
+{
+	std::string dir = getTestTempDirectory() + DIR_DELIM "filecache_replace";
+	FileCache cache(dir);
+	std::string data;
+
+	// A file that failed to verify is downloaded again
+	UASSERT(cache.update("aa", "corrupt"));
+	UASSERT(cache.update("aa", "fixed"));
+	UASSERT(cache.load("aa", data));
+	UASSERTEQ(std::string, data, "fixed");
+
+	fs::RecursiveDelete(dir);
+}
+
+void TestFileCache::testSharedDirectory()
+{
+	std::string dir = getTestTempDirectory() + DIR_DELIM "filecache_shared";
+	FileCache cache1(dir), cache2(dir);
+	std::string data;
+
+	// Neither has seen the other's index
+	UASSERT(cache1.update("aa", "first"));
+	UASSERT(cache2.update("bb", "second"));
+	UASSERT(cache1.load("aa", data));
+	UASSERTEQ(std::string, data, "first");
+	UASSERT(cache2.load("bb", data));
+	UASSERTEQ(std::string, data, "second");
+
+	fs::RecursiveDelete(dir);
+}
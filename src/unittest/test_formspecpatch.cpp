@@ -0,0 +1,111 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include "formspec_patch.h"
+
+class TestFormspecPatch : public TestBase
+{
+public:
+	TestFormspecPatch() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestFormspecPatch"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testSplitJoin();
+	void testElementName();
+	void testPatch();
+};
+
+static TestFormspecPatch g_test_instance;
+
+void TestFormspecPatch::runTests(IGameDef *gamedef)
+{
+	TEST(testSplitJoin);
+	TEST(testElementName);
+	TEST(testPatch);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TestFormspecPatch::testSplitJoin()
+{
+	const std::string formspec = "size[8,9]label[0,0;a\\]b]\nbutton[1,1;2,1;go;Go]";
+	std::vector<std::string> elements = splitFormspec(formspec);
+	UASSERTEQ(size_t, elements.size(), 4);
+	UASSERTEQ(std::string, elements[1], "label[0,0;a\\]b");
+	UASSERTEQ(std::string, elements[3], "");
+	UASSERTEQ(std::string, joinFormspec(elements), formspec);
+}
+
+void TestFormspecPatch::testElementName()
+{
+	UASSERTEQ(std::string, getFormspecElementName("\nbutton[1,1;2,1;go;Go"), "go");
+	UASSERTEQ(std::string, getFormspecElementType("\nbutton[1,1;2,1;go;Go"), "button");
+	UASSERTEQ(std::string, getFormspecElementName("field[name;Label;]"), "name");
+	UASSERTEQ(std::string, getFormspecElementName("field[0,0;2,1;name;Label;"), "name");
+	UASSERTEQ(std::string, getFormspecElementName("checkbox[0,0;check;Label;true"), "check");
+	UASSERTEQ(std::string, getFormspecElementName("scrollbar[0,0;3,1;horizontal;sb;5"), "sb");
+	UASSERTEQ(std::string, getFormspecElementName("image_button[0,0;1,1;a.png;ib;"), "ib");
+	UASSERTEQ(std::string, getFormspecElementName("label[0,0;text"), "");
+	UASSERTEQ(std::string, getFormspecElementName("button[1,1"), "");
+	UASSERTEQ(std::string, getFormspecElementName("no bracket"), "");
+}
+
+void TestFormspecPatch::testPatch()
+{
+	const std::string formspec = "size[8,9]button[1,1;2,1;go;Go]"
+		"checkbox[0,2;check;Check;false]label[0,3;text]";
+	std::vector<std::string> server = splitFormspec(formspec);
+	std::vector<std::string> client = server;
+
+	StringMap patches;
+	patches["go"] = "button[1,1;2,1;go;Stop]";
+	patches["check"] = "checkbox[0,2;check;Check;false]"; // unchanged
+	patches["missing"] = "button[0,0;1,1;missing;x]";
+	FormspecPatch patch = patchFormspecElements(server, patches);
+	UASSERTEQ(size_t, patch.size(), 1);
+	UASSERTEQ(u32, patch[0].first, 1);
+	UASSERTEQ(std::string, patch[0].second, "button[1,1;2,1;go;Stop");
+
+	UASSERT(applyFormspecPatch(client, patch));
+	UASSERTEQ(std::string, joinFormspec(client), joinFormspec(server));
+	UASSERTEQ(std::string, joinFormspec(client), "size[8,9]button[1,1;2,1;go;Stop]"
+		"checkbox[0,2;check;Check;false]label[0,3;text]");
+
+	// Replacements must be exactly one element
+	patches.clear();
+	patches["go"] = "button[1,1;2,1;go;A]label[0,0;B]";
+	UASSERT(patchFormspecElements(server, patches).empty());
+
+	// Removal keeps the indices of the following elements
+	patches.clear();
+	patches["check"] = "";
+	patch = patchFormspecElements(server, patches);
+	UASSERTEQ(size_t, patch.size(), 1);
+	UASSERTEQ(u32, patch[0].first, 2);
+	UASSERT(applyFormspecPatch(client, patch));
+	UASSERTEQ(std::string, joinFormspec(client),
+		"size[8,9]button[1,1;2,1;go;Stop]]label[0,3;text]");
+
+	// Indices past the end mean client and server are out of sync
+	patch = {{10, "label[0,0;x"}};
+	UASSERT(!applyFormspecPatch(client, patch));
+}
@@ -0,0 +1,133 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include "client/hud.h"
+
+class TestHudTextLayout : public TestBase
+{
+public:
+	TestHudTextLayout() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestHudTextLayout"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testLines();
+	void testReuse();
+	void testPrune();
+};
+
+static TestHudTextLayout g_test_instance;
+
+void TestHudTextLayout::runTests(IGameDef *gamedef)
+{
+	TEST(testLines);
+	TEST(testReuse);
+	TEST(testPrune);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Fonts are only compared, never used
+static gui::IGUIFont *const FONT_A = reinterpret_cast<gui::IGUIFont *>(0x10);
+static gui::IGUIFont *const FONT_B = reinterpret_cast<gui::IGUIFont *>(0x20);
+
+struct CountingMeasure
+{
+	u32 calls = 0;
+
+	HudTextLayoutCache::Measure get()
+	{
+		return [this] (const std::wstring &s) {
+			calls++;
+			return core::dimension2d<u32>(s.size() * 10, 20);
+		};
+	}
+};
+
+void TestHudTextLayout::testLines()
+{
+	HudTextLayoutCache cache;
+	CountingMeasure measure;
+	HudElement e;
+	e.text = "one\nthree";
+
+	const HudTextLayout &layout = cache.get(&e, FONT_A, measure.get());
+	UASSERTEQ(size_t, layout.lines.size(), 2);
+	UASSERT(layout.lines[0].text == L"one");
+	UASSERTEQ(u32, layout.lines[0].size.Width, 30);
+	UASSERT(layout.lines[1].text == L"three");
+	UASSERTEQ(u32, layout.lines[1].size.Width, 50);
+	UASSERTEQ(u32, layout.size.Width, 90);
+}
+
+void TestHudTextLayout::testReuse()
+{
+	HudTextLayoutCache cache;
+	CountingMeasure measure;
+	HudElement e;
+	e.text = "hello";
+
+	cache.get(&e, FONT_A, measure.get());
+	u32 first = measure.calls;
+	UASSERT(first > 0);
+
+	// Unchanged, nothing is measured
+	for (int i = 0; i < 10; i++)
+		cache.get(&e, FONT_A, measure.get());
+	UASSERTEQ(u32, measure.calls, first);
+
+	// Changed by hud_change
+	e.text = "world\n!";
+	const HudTextLayout &layout = cache.get(&e, FONT_A, measure.get());
+	UASSERT(measure.calls > first);
+	UASSERTEQ(size_t, layout.lines.size(), 2);
+
+	// Another font
+	u32 calls = measure.calls;
+	cache.get(&e, FONT_B, measure.get());
+	UASSERT(measure.calls > calls);
+}
+
+void TestHudTextLayout::testPrune()
+{
+	HudTextLayoutCache cache;
+	CountingMeasure measure;
+	HudElement a, b;
+	a.text = "a";
+	b.text = "b";
+
+	cache.get(&a, FONT_A, measure.get());
+	cache.get(&b, FONT_A, measure.get());
+	cache.prune();
+	UASSERTEQ(size_t, cache.size(), 2);
+
+	// b was removed and is no longer drawn
+	cache.get(&a, FONT_A, measure.get());
+	cache.prune();
+	UASSERTEQ(size_t, cache.size(), 1);
+
+	u32 calls = measure.calls;
+	cache.get(&a, FONT_A, measure.get());
+	UASSERTEQ(u32, measure.calls, calls);
+
+	cache.clear();
+	UASSERTEQ(size_t, cache.size(), 0);
+}
@@ -0,0 +1,127 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "cmake_config.h"
+
+#include "test.h"
+
+#include <cstdlib>
+#include "database/database-dummy.h"
+#include "database/database-sqlite3.h"
+#if USE_POSTGRESQL
+#include "database/database-postgresql.h"
+#endif
+
+class TestMapDatabase : public TestBase
+{
+public:
+	TestMapDatabase() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestMapDatabase"; }
+
+	void runTests(IGameDef *gamedef);
+	void runTestsForCurrentDB();
+
+	void testSaveBlocks();
+	void testLoadBlocks();
+
+private:
+	MapDatabase *map_db;
+};
+
+static TestMapDatabase g_test_instance;
+
+void TestMapDatabase::runTests(IGameDef *gamedef)
+{
+	rawstream << "-------- Dummy database" << std::endl;
+
+	map_db = new Database_Dummy();
+	runTestsForCurrentDB();
+	delete map_db;
+
+	rawstream << "-------- SQLite3 database" << std::endl;
+
+	map_db = new MapDatabaseSQLite3(getTestTempDirectory());
+	runTestsForCurrentDB();
+	delete map_db;
+
+#if USE_POSTGRESQL
+	const char *env_postgresql_connect_string = getenv("MINETEST_POSTGRESQL_CONNECT_STRING");
+	if (env_postgresql_connect_string) {
+		rawstream << "-------- PostgreSQL database" << std::endl;
+
+		map_db = new MapDatabasePostgreSQL(env_postgresql_connect_string);
+		runTestsForCurrentDB();
+		delete map_db;
+	}
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TestMapDatabase::runTestsForCurrentDB()
+{
+	TEST(testSaveBlocks);
+	TEST(testLoadBlocks);
+}
+
+void TestMapDatabase::testSaveBlocks()
+{
+	std::vector<std::pair<v3s32, std::string>> blocks = {
+		{v3s32(0, 0, 0), "origin"},
+		{v3s32(-1, 2, -3), std::string("with\0zero", 9)},
+		{v3s32(100, -200, 300), "far"},
+	};
+
+	map_db->beginSave();
+	UASSERT(map_db->saveBlocks(blocks));
+	map_db->endSave();
+
+	std::string data;
+	map_db->loadBlock(v3s32(-1, 2, -3), &data);
+	UASSERT(data == std::string("with\0zero", 9));
+
+	// Overwrite an existing block
+	map_db->beginSave();
+	UASSERT(map_db->saveBlocks({{v3s32(0, 0, 0), "changed"}}));
+	map_db->endSave();
+
+	map_db->loadBlock(v3s32(0, 0, 0), &data);
+	UASSERTEQ(std::string, data, "changed");
+}
+
+void TestMapDatabase::testLoadBlocks()
+{
+	std::vector<v3s32> positions = {
+		v3s32(100, -200, 300), v3s32(5, 5, 5), v3s32(0, 0, 0)
+	};
+
+	std::vector<std::string> blocks;
+	map_db->loadBlocks(positions, blocks);
+
+	UASSERTEQ(size_t, blocks.size(), 3);
+	UASSERTEQ(std::string, blocks[0], "far");
+	UASSERT(blocks[1].empty());
+	UASSERTEQ(std::string, blocks[2], "changed");
+
+	map_db->beginSave();
+	map_db->deleteBlock(v3s32(0, 0, 0));
+	map_db->deleteBlock(v3s32(-1, 2, -3));
+	map_db->deleteBlock(v3s32(100, -200, 300));
+	map_db->endSave();
+}
@@ -0,0 +1,211 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include <fstream>
+#include "filesys.h"
+#include "gamedef.h"
+#include "mapjournal.h"
+
+class TestMapJournal : public TestBase {
+public:
+	TestMapJournal() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestMapJournal"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testReplay(IGameDef *gamedef);
+	void testSavedMarker(IGameDef *gamedef);
+	void testRotate(IGameDef *gamedef);
+	void testTruncated(IGameDef *gamedef);
+	void testUnjournaled(IGameDef *gamedef);
+
+private:
+	struct Change
+	{
+		v3s32 p;
+		MapNode n;
+		bool remove_metadata;
+	};
+
+	static void addNode(MapJournal &journal, v3s32 p, MapNode n, bool swap = false);
+	static std::vector<Change> replay(MapJournal &journal);
+};
+
+static TestMapJournal g_test_instance;
+
+void TestMapJournal::runTests(IGameDef *gamedef)
+{
+	TEST(testReplay, gamedef);
+	TEST(testSavedMarker, gamedef);
+	TEST(testRotate, gamedef);
+	TEST(testTruncated, gamedef);
+	TEST(testUnjournaled, gamedef);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TestMapJournal::addNode(MapJournal &journal, v3s32 p, MapNode n, bool swap)
+{
+	MapEditEvent event;
+	event.type = swap ? MEET_SWAPNODE : MEET_ADDNODE;
+	event.n = n;
+	event.setPositionModified(p);
+	journal.onMapEditEvent(event);
+}
+
+std::vector<TestMapJournal::Change> TestMapJournal::replay(MapJournal &journal)
+{
+	std::vector<Change> changes;
+	journal.replay([&] (v3s32 p, MapNode n, bool remove_metadata) {
+		changes.push_back({p, n, remove_metadata});
+		return true;
+	});
+	return changes;
+}
+
+void TestMapJournal::testReplay(IGameDef *gamedef)
+{
+	std::string dir = getTestTempDirectory();
+	MapJournal journal(dir, gamedef->ndef());
+	journal.clear();
+
+	addNode(journal, v3s32(1, 2, 3), MapNode(t_CONTENT_STONE));
+	addNode(journal, v3s32(-40, 0, 7), MapNode(t_CONTENT_TORCH, 0, 3), true);
+
+	MapEditEvent event;
+	event.type = MEET_REMOVENODE;
+	event.setPositionModified(v3s32(1, 2, 3));
+	journal.onMapEditEvent(event);
+	journal.flush();
+
+	// A new instance reads what the previous one wrote
+	MapJournal journal2(dir, gamedef->ndef());
+	std::vector<Change> changes = replay(journal2);
+	UASSERTEQ(size_t, changes.size(), 3);
+
+	UASSERT(changes[0].p == v3s32(1, 2, 3));
+	UASSERTEQ(content_t, changes[0].n.getContent(), t_CONTENT_STONE);
+	UASSERT(changes[0].remove_metadata);
+
+	UASSERT(changes[1].p == v3s32(-40, 0, 7));
+	UASSERTEQ(content_t, changes[1].n.getContent(), t_CONTENT_TORCH);
+	UASSERTEQ(int, changes[1].n.getParam2(), 3);
+	UASSERT(!changes[1].remove_metadata);
+
+	UASSERTEQ(content_t, changes[2].n.getContent(), CONTENT_AIR);
+
+	journal2.clear();
+	UASSERTEQ(size_t, replay(journal2).size(), 0);
+}
+
+void TestMapJournal::testSavedMarker(IGameDef *gamedef)
+{
+	MapJournal journal(getTestTempDirectory(), gamedef->ndef());
+	journal.clear();
+
+	addNode(journal, v3s32(1, 1, 1), MapNode(t_CONTENT_STONE));
+	addNode(journal, v3s32(17, 1, 1), MapNode(t_CONTENT_BRICK));
+	journal.blockSaved(v3s32(0, 0, 0));
+	addNode(journal, v3s32(2, 2, 2), MapNode(t_CONTENT_GRASS));
+	journal.flush();
+
+	// Only the changes that were not saved with their block remain
+	std::vector<Change> changes = replay(journal);
+	UASSERTEQ(size_t, changes.size(), 2);
+	UASSERTEQ(content_t, changes[0].n.getContent(), t_CONTENT_BRICK);
+	UASSERTEQ(content_t, changes[1].n.getContent(), t_CONTENT_GRASS);
+
+	journal.clear();
+}
+
+void TestMapJournal::testRotate(IGameDef *gamedef)
+{
+	std::string dir = getTestTempDirectory();
+	MapJournal journal(dir, gamedef->ndef());
+	journal.clear();
+
+	addNode(journal, v3s32(0, 0, 0), MapNode(t_CONTENT_STONE));
+	journal.rotate();
+	addNode(journal, v3s32(0, 0, 1), MapNode(t_CONTENT_STONE));
+	// Ignored while the old segment exists
+	journal.rotate();
+	addNode(journal, v3s32(0, 0, 2), MapNode(t_CONTENT_BRICK));
+	journal.flush();
+
+	UASSERT(fs::PathExists(dir + DIR_DELIM + "map_journal.old"));
+	UASSERTEQ(size_t, replay(journal).size(), 3);
+
+	// The name of a content ID is written again to the new segment
+	journal.dropOldSegment();
+	std::vector<Change> changes = replay(journal);
+	UASSERTEQ(size_t, changes.size(), 2);
+	UASSERTEQ(content_t, changes[0].n.getContent(), t_CONTENT_STONE);
+
+	journal.clear();
+	UASSERT(!fs::PathExists(dir + DIR_DELIM + "map_journal"));
+}
+
+void TestMapJournal::testTruncated(IGameDef *gamedef)
+{
+	std::string dir = getTestTempDirectory();
+	std::string path = dir + DIR_DELIM + "map_journal";
+	{
+		MapJournal journal(dir, gamedef->ndef());
+		journal.clear();
+		addNode(journal, v3s32(5, 5, 5), MapNode(t_CONTENT_STONE));
+		addNode(journal, v3s32(6, 5, 5), MapNode(t_CONTENT_STONE));
+	}
+
+	// Simulate a crash in the middle of the last record
+	std::string data;
+	UASSERT(fs::ReadFile(path, data));
+	data.resize(data.size() - 3);
+	{
+		std::ofstream os(path, std::ios::binary | std::ios::trunc);
+		os << data;
+	}
+
+	MapJournal journal(dir, gamedef->ndef());
+	std::vector<Change> changes = replay(journal);
+	UASSERTEQ(size_t, changes.size(), 1);
+	UASSERT(changes[0].p == v3s32(5, 5, 5));
+
+	journal.clear();
+}
+
+void TestMapJournal::testUnjournaled(IGameDef *gamedef)
+{
+	MapJournal journal(getTestTempDirectory(), gamedef->ndef());
+	journal.clear();
+
+	MapEditEvent event;
+	event.type = MEET_OTHER;
+	event.modified_blocks = {v3s32(0, 0, 0), v3s32(1, 0, 0)};
+	journal.onMapEditEvent(event);
+	journal.blockSaved(v3s32(1, 0, 0));
+
+	v3s32 blockpos;
+	UASSERT(journal.popUnjournaledBlock(blockpos));
+	UASSERT(blockpos == v3s32(0, 0, 0));
+	UASSERT(!journal.popUnjournaledBlock(blockpos));
+
+	journal.clear();
+}
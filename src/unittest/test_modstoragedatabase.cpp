@@ -25,7 +25,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "test.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include "database/database-buffered.h"
 #include "database/database-dummy.h"
 #include "database/database-files.h"
 #include "database/database-sqlite3.h"
@@ -117,6 +119,56 @@ class SQLite3Provider : public ModStorageDatabaseProvider
 	ModStorageDatabase *m_db = nullptr;
 };
 
+class BufferedSQLite3Provider : public ModStorageDatabaseProvider
+{
+public:
+	BufferedSQLite3Provider(const std::string &dir): m_dir(dir) {}
+
+	~BufferedSQLite3Provider()
+	{
+		delete m_db;
+	}
+
+	ModStorageDatabase *getModStorageDatabase() override
+	{
+		// Pending changes are written when the buffer is destroyed
+		delete m_db;
+		m_db = new ModStorageDatabaseBuffered(new ModStorageDatabaseSQLite3(m_dir));
+		return m_db;
+	}
+
+private:
+	std::string m_dir;
+	ModStorageDatabase *m_db = nullptr;
+};
+
+// Fails to commit while `fail` is set and, like SQLite3, refuses to begin a
+// transaction within a transaction
+class FailingCommitDatabase : public Database_Dummy
+{
+public:
+	void beginSave() override
+	{
+		if (in_transaction)
+			throw DatabaseException("cannot start a transaction within a transaction");
+		in_transaction = true;
+	}
+
+	void endSave() override
+	{
+		if (fail)
+			throw DatabaseException("database is locked");
+		in_transaction = false;
+		commits++;
+	}
+
+	void abortSave() override { in_transaction = false; }
+
+	std::atomic<bool> fail {true};
+	std::atomic<bool> in_transaction {false};
+	std::atomic<int> commits {0};
+};
+
 #if USE_POSTGRESQL
 void clearPostgreSQLDatabase(const std::string &connect_string)
 {
@@ -172,9 +224,12 @@ class TestModStorageDatabase : public TestBase
 	void testRecall();
 	void testChange();
 	void testRecallChanged();
+	void testKeysWithPrefix();
 	void testListMods();
 	void testRemove();
 
+	void testBufferedFailedFlush();
+
 private:
 	ModStorageDatabaseProvider *mod_storage_provider;
 };
@@ -246,6 +301,35 @@ void TestModStorageDatabase::runTests(IGameDef *gamedef)
 
 	delete mod_storage_provider;
 
+	// reset database
+	fs::DeleteSingleFileOrEmptyDirectory(test_dir + DIR_DELIM + "mod_storage.sqlite");
+
+	rawstream << "-------- Buffered SQLite3 database (same object)" << std::endl;
+
+	mod_storage_db = new ModStorageDatabaseBuffered(new ModStorageDatabaseSQLite3(test_dir));
+	mod_storage_provider = new FixedProvider(mod_storage_db);
+
+	runTestsForCurrentDB();
+
+	// Hand the changes to the flush thread while the database is in use
+	mod_storage_db->endSave();
+
+	delete mod_storage_db;
+	delete mod_storage_provider;
+
+	// reset database
+	fs::DeleteSingleFileOrEmptyDirectory(test_dir + DIR_DELIM + "mod_storage.sqlite");
+
+	rawstream << "-------- Buffered SQLite3 database (new objects)" << std::endl;
+
+	mod_storage_provider = new BufferedSQLite3Provider(test_dir);
+
+	runTestsForCurrentDB();
+
+	delete mod_storage_provider;
+
+	TEST(testBufferedFailedFlush);
+
 #if USE_POSTGRESQL
 	const char *env_postgresql_connect_string = getenv("MINETEST_POSTGRESQL_CONNECT_STRING");
 	if (env_postgresql_connect_string) {
@@ -283,6 +367,7 @@ void TestModStorageDatabase::runTestsForCurrentDB()
 	TEST(testRecall);
 	TEST(testChange);
 	TEST(testRecallChanged);
+	TEST(testKeysWithPrefix);
 	TEST(testListMods);
 	TEST(testRemove);
 	TEST(testRecallFail);
@@ -344,6 +429,31 @@ void TestModStorageDatabase::testRecallChanged()
 	UASSERT(mod_storage_db->hasModEntry("mod1", "key1"));
 }
 
+void TestModStorageDatabase::testKeysWithPrefix()
+{
+	ModStorageDatabase *mod_storage_db = mod_storage_provider->getModStorageDatabase();
+	UASSERT(mod_storage_db->setModEntry("mod1", "player:b", "1"));
+	UASSERT(mod_storage_db->setModEntry("mod1", "player:a", "2"));
+	UASSERT(mod_storage_db->setModEntry("mod1", "playerx", "3"));
+	UASSERT(mod_storage_db->setModEntry("mod2", "player:c", "4"));
+
+	std::vector<std::string> keys;
+	mod_storage_db->getModKeysWithPrefix("mod1", "player:", &keys);
+	std::sort(keys.begin(), keys.end());
+	UASSERTCMP(size_t, ==, keys.size(), 2);
+	UASSERTCMP(std::string, ==, keys[0], "player:a");
+	UASSERTCMP(std::string, ==, keys[1], "player:b");
+
+	keys.clear();
+	mod_storage_db->getModKeysWithPrefix("mod1", "", &keys);
+	UASSERTCMP(size_t, ==, keys.size(), 4);
+
+	UASSERT(mod_storage_db->removeModEntry("mod1", "player:a"));
+	UASSERT(mod_storage_db->removeModEntry("mod1", "player:b"));
+	UASSERT(mod_storage_db->removeModEntry("mod1", "playerx"));
+	UASSERT(mod_storage_db->removeModEntry("mod2", "player:c"));
+}
+
 void TestModStorageDatabase::testListMods()
 {
 	ModStorageDatabase *mod_storage_db = mod_storage_provider->getModStorageDatabase();
@@ -363,3 +473,29 @@ void TestModStorageDatabase::testRemove()
 	UASSERT(!mod_storage_db->removeModEntries("mod1"));
 	UASSERT(mod_storage_db->removeModEntries("mod2"));
 }
+
+void TestModStorageDatabase::testBufferedFailedFlush()
+{
+	FailingCommitDatabase *backend = new FailingCommitDatabase();
+	ModStorageDatabaseBuffered db(backend);
+
+	// More batches than are queued separately
+	for (int i = 0; i < 20; i++) {
+		UASSERT(db.setModEntry("mod1", "key1", itos(i)));
+		UASSERT(db.setModEntry("mod1", "key" + itos(i + 2), "x"));
+		db.endSave();
+		db.flushQueued();
+		UASSERT(!backend->in_transaction);
+	}
+	UASSERTEQ(int, backend->commits, 0);
+
+	backend->fail = false;
+	db.flushQueued();
+	UASSERT(backend->commits > 0);
+	UASSERT(!backend->in_transaction);
+
+	std::string value;
+	UASSERT(backend->getModEntry("mod1", "key1", &value));
+	UASSERTCMP(std::string, ==, value, "19");
+	UASSERT(backend->hasModEntry("mod1", "key21"));
+}
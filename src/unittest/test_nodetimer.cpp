@@ -0,0 +1,164 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include "nodetimer.h"
+#include "serialization.h"
+#include <cmath>
+#include <sstream>
+
+class TestNodeTimer : public TestBase {
+public:
+	TestNodeTimer() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestNodeTimer"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testList();
+	void testWheel();
+	void testWheelCascade();
+	void testAttachDetach();
+};
+
+static TestNodeTimer g_test_instance;
+
+void TestNodeTimer::runTests(IGameDef *gamedef)
+{
+	TEST(testList);
+	TEST(testWheel);
+	TEST(testWheelCascade);
+	TEST(testAttachDetach);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TestNodeTimer::testList()
+{
+	NodeTimerList list;
+	list.set(NodeTimer(1.0f, 0.0f, v3s32(1, 2, 3)));
+	list.set(NodeTimer(3.0f, 0.0f, v3s32(4, 5, 6)));
+
+	UASSERT(list.step(0.5f).empty());
+	UASSERT(std::fabs(list.get(v3s32(1, 2, 3)).elapsed - 0.5f) < 0.001f);
+
+	std::vector<NodeTimer> elapsed = list.step(0.6f);
+	UASSERTEQ(size_t, elapsed.size(), 1);
+	UASSERT(elapsed[0].position == v3s32(1, 2, 3));
+	UASSERT(list.get(v3s32(1, 2, 3)).timeout == 0.0f);
+
+	list.remove(v3s32(4, 5, 6));
+	UASSERT(list.step(10.0f).empty());
+}
+
+void TestNodeTimer::testWheel()
+{
+	NodeTimerWheel wheel(0.2);
+	std::vector<v3s32> due;
+
+	wheel.schedule(v3s32(0, 0, 0), 1.0);
+	wheel.schedule(v3s32(1, 0, 0), 0.5);
+	wheel.schedule(v3s32(2, 0, 0), 0.3);
+	wheel.unschedule(v3s32(2, 0, 0));
+	UASSERTEQ(size_t, wheel.size(), 2);
+
+	for (int i = 0; i < 3; i++)
+		wheel.step(0.2, due);
+	UASSERTEQ(size_t, due.size(), 1);
+	UASSERT(due[0] == v3s32(1, 0, 0));
+
+	// Moving the trigger time drops the earlier entry
+	wheel.schedule(v3s32(0, 0, 0), 2.0);
+	due.clear();
+	for (int i = 0; i < 5; i++)
+		wheel.step(0.2, due);
+	UASSERT(due.empty());
+	for (int i = 0; i < 5; i++)
+		wheel.step(0.2, due);
+	UASSERTEQ(size_t, due.size(), 1);
+	UASSERTEQ(size_t, wheel.size(), 0);
+}
+
+void TestNodeTimer::testWheelCascade()
+{
+	NodeTimerWheel wheel(1.0);
+	std::vector<v3s32> due;
+
+	// Beyond the first level, and beyond the first two levels
+	wheel.schedule(v3s32(0, 0, 0), 1000.0);
+	wheel.schedule(v3s32(1, 0, 0), 70000.0);
+
+	wheel.step(999.0, due);
+	UASSERT(due.empty());
+	wheel.step(1.0, due);
+	UASSERTEQ(size_t, due.size(), 1);
+	UASSERT(due[0] == v3s32(0, 0, 0));
+
+	due.clear();
+	wheel.step(68999.0, due);
+	UASSERT(due.empty());
+	wheel.step(1.0, due);
+	UASSERTEQ(size_t, due.size(), 1);
+	UASSERT(due[0] == v3s32(1, 0, 0));
+}
+
+void TestNodeTimer::testAttachDetach()
+{
+	NodeTimerWheel wheel(0.2);
+	std::vector<v3s32> due;
+	v3s32 blockpos(3, -1, 7);
+
+	NodeTimerList list;
+	list.step(100.0f);
+	list.set(NodeTimer(1.0f, 0.0f, v3s32(1, 1, 1)));
+	list.attach(&wheel, blockpos);
+	UASSERT(list.isAttached());
+	UASSERTEQ(size_t, wheel.size(), 1);
+
+	// Attached timers advance with the wheel only
+	UASSERT(list.step(5.0f).empty());
+	for (int i = 0; i < 4; i++)
+		wheel.step(0.2, due);
+	UASSERT(due.empty());
+	UASSERT(std::fabs(list.get(v3s32(1, 1, 1)).elapsed - 0.8f) < 0.001f);
+
+	// Serialized data stays relative to the current time
+	std::ostringstream os(std::ios::binary);
+	list.serialize(os, SER_FMT_VER_HIGHEST_WRITE);
+	NodeTimerList list2;
+	std::istringstream is(os.str(), std::ios::binary);
+	list2.deSerialize(is, SER_FMT_VER_HIGHEST_WRITE);
+	UASSERT(std::fabs(list2.get(v3s32(1, 1, 1)).elapsed - 0.8f) < 0.001f);
+
+	wheel.step(0.2, due);
+	UASSERTEQ(size_t, due.size(), 1);
+	UASSERT(due[0] == blockpos);
+	std::vector<NodeTimer> elapsed = list.step(0.0f);
+	UASSERTEQ(size_t, elapsed.size(), 1);
+
+	// Detached timers are frozen and unscheduled
+	list.set(NodeTimer(1.0f, 0.0f, v3s32(1, 1, 1)));
+	UASSERTEQ(size_t, wheel.size(), 1);
+	list.detach();
+	UASSERTEQ(size_t, wheel.size(), 0);
+	due.clear();
+	wheel.step(10.0, due);
+	UASSERT(due.empty());
+	UASSERT(std::fabs(list.get(v3s32(1, 1, 1)).elapsed) < 0.001f);
+}
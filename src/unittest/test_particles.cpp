@@ -0,0 +1,143 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include "particles.h"
+#include "network/networkprotocol.h"
+
+class TestParticles : public TestBase
+{
+public:
+	TestParticles() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestParticles"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testBurstRoundtrip();
+	void testBurstClamp();
+	void testBurstRange();
+};
+
+static TestParticles g_test_instance;
+
+void TestParticles::runTests(IGameDef *gamedef)
+{
+	TEST(testBurstRoundtrip);
+	TEST(testBurstClamp);
+	TEST(testBurstRange);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool near(v3f a, v3f b, f32 tolerance)
+{
+	return a.getDistanceFrom(b) <= tolerance;
+}
+
+static ParticleBurst makeBurst(size_t count)
+{
+	ParticleBurst burst;
+	burst.common.vel = v3f(0, -5, 0);
+	burst.common.acc = v3f(0, -1, 0);
+	burst.common.expirationtime = 2;
+	burst.common.size = 1;
+	burst.common.texture.string = "rain.png";
+	burst.common.collisiondetection = true;
+	for (size_t i = 0; i < count; i++) {
+		f32 f = i;
+		burst.particles.push_back({v3f(100 + f * 0.3f, 20 - f * 0.1f, -50 + f),
+			v3f(f * 0.01f, -5 - f * 0.05f, 0), 2 + f * 0.02f, 0.5f + f * 0.01f});
+	}
+	burst.center();
+	return burst;
+}
+
+void TestParticles::testBurstRoundtrip()
+{
+	ParticleBurst burst = makeBurst(50);
+
+	std::ostringstream os(std::ios_base::binary);
+	burst.serialize(os, LATEST_PROTOCOL_VERSION);
+	std::istringstream is(os.str(), std::ios_base::binary);
+	ParticleBurst result;
+	result.deSerialize(is, LATEST_PROTOCOL_VERSION);
+
+	UASSERTEQ(size_t, result.particles.size(), 50);
+	UASSERT(result.common.texture.string == "rain.png");
+	UASSERT(result.common.collisiondetection);
+	UASSERT(result.common.acc == v3f(0, -1, 0));
+	UASSERT(near(result.common.pos, burst.common.pos, 0.001f));
+
+	for (size_t i = 0; i < burst.particles.size(); i++) {
+		const ParticleBurst::Entry &a = burst.particles[i];
+		const ParticleBurst::Entry &b = result.particles[i];
+		UASSERT(near(a.pos, b.pos, 0.01f));
+		UASSERT(near(a.vel, b.vel, 0.005f));
+		UASSERT(std::fabs(a.expirationtime - b.expirationtime) < 0.005f);
+		UASSERT(std::fabs(a.size - b.size) < 0.005f);
+	}
+
+	ParticleParameters p;
+	result.getParticle(7, p);
+	UASSERT(p.pos == result.particles[7].pos);
+	UASSERT(p.texture.string == "rain.png");
+
+	// Much smaller than a packet per particle
+	std::ostringstream single(std::ios_base::binary);
+	p.serialize(single, LATEST_PROTOCOL_VERSION);
+	UASSERT(os.str().size() * 3 < single.str().size() * burst.particles.size());
+}
+
+void TestParticles::testBurstClamp()
+{
+	ParticleBurst burst;
+	burst.common.expirationtime = 1;
+	burst.particles.push_back({v3f(0, 0, 0), v3f(0, 0, 0), 1, 1});
+	burst.particles.push_back({v3f(1000, 0, 0), v3f(500, 0, 0), 1000, 1});
+	burst.center();
+	UASSERT(burst.common.pos == v3f(500, 0, 0));
+
+	std::ostringstream os(std::ios_base::binary);
+	burst.serialize(os, LATEST_PROTOCOL_VERSION);
+	std::istringstream is(os.str(), std::ios_base::binary);
+	ParticleBurst result;
+	result.deSerialize(is, LATEST_PROTOCOL_VERSION);
+
+	UASSERTEQ(size_t, result.particles.size(), 2);
+	// 256 nodes from the middle at most
+	UASSERT(near(result.particles[0].pos, v3f(244, 0, 0), 0.01f));
+	UASSERT(near(result.particles[1].vel, v3f(128, 0, 0), 0.01f));
+	UASSERT(std::fabs(result.particles[1].expirationtime - 129) < 0.01f);
+}
+
+void TestParticles::testBurstRange()
+{
+	ParticleBurst burst = makeBurst(10);
+
+	std::ostringstream os(std::ios_base::binary);
+	burst.serialize(os, LATEST_PROTOCOL_VERSION, 8, 5);
+	std::istringstream is(os.str(), std::ios_base::binary);
+	ParticleBurst result;
+	result.deSerialize(is, LATEST_PROTOCOL_VERSION);
+
+	UASSERTEQ(size_t, result.particles.size(), 2);
+	UASSERT(near(result.particles[0].pos, burst.particles[8].pos, 0.01f));
+	UASSERT(near(result.particles[1].pos, burst.particles[9].pos, 0.01f));
+}
@@ -0,0 +1,120 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include "database/database-sqlite3.h"
+#include "gamedef.h"
+#include "remoteplayer.h"
+#include "server/player_sao.h"
+
+class TestPlayerDatabase : public TestBase
+{
+public:
+	TestPlayerDatabase() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestPlayerDatabase"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testDirtyFlags(IGameDef *gamedef);
+	void testPartialSave(IGameDef *gamedef);
+};
+
+static TestPlayerDatabase g_test_instance;
+
+void TestPlayerDatabase::runTests(IGameDef *gamedef)
+{
+	TEST(testDirtyFlags, gamedef);
+	TEST(testPartialSave, gamedef);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TestPlayerDatabase::testDirtyFlags(IGameDef *gamedef)
+{
+	RemotePlayer player("flags", gamedef->idef());
+	PlayerSAO sao(nullptr, &player, 15000, false);
+	sao.finalize(&player, std::set<std::string>());
+	player.setPlayerSAO(&sao);
+
+	player.setModified(false);
+	player.inventory.setModified(false);
+	sao.getMeta().setModified(false);
+	UASSERT(!player.checkModified());
+
+	sao.setLookPitch(10.0f);
+	UASSERTEQ(int, player.getDirtyFlags(), PLAYER_DIRTY_STATE);
+
+	sao.getMeta().setString("key", "value");
+	UASSERTEQ(int, player.getDirtyFlags(), PLAYER_DIRTY_STATE | PLAYER_DIRTY_META);
+
+	player.onSuccessfulSave();
+	UASSERT(!player.checkModified());
+
+	player.inventory.addList("main", 4);
+	UASSERTEQ(int, player.getDirtyFlags(), PLAYER_DIRTY_INVENTORY);
+
+	player.setPlayerSAO(nullptr);
+}
+
+void TestPlayerDatabase::testPartialSave(IGameDef *gamedef)
+{
+	PlayerDatabaseSQLite3 db(getTestTempDirectory());
+	IItemDefManager *idef = gamedef->idef();
+
+	{
+		RemotePlayer player("partial", idef);
+		PlayerSAO sao(nullptr, &player, 15000, false);
+		sao.finalize(&player, std::set<std::string>());
+		player.setPlayerSAO(&sao);
+
+		InventoryList *list = player.inventory.addList("main", 4);
+		list->changeItem(1, ItemStack("default:stone", 5, 0, idef));
+		sao.getMeta().setString("key", "old");
+
+		// A new player is written completely
+		db.beginSaveBatch();
+		db.savePlayer(&player);
+		db.endSaveBatch();
+		UASSERT(!(player.getDirtyFlags() & (PLAYER_DIRTY_STATE | PLAYER_DIRTY_META)));
+
+		// Changed without marking the inventory as dirty, must not be written
+		list->changeItem(1, ItemStack("default:stone", 9, 0, idef));
+		player.inventory.setModified(false);
+		sao.getMeta().setString("key", "new");
+		UASSERTEQ(int, player.getDirtyFlags(), PLAYER_DIRTY_META);
+		db.savePlayer(&player);
+
+		player.setPlayerSAO(nullptr);
+	}
+
+	RemotePlayer player("partial", idef);
+	PlayerSAO sao(nullptr, &player, 15000, false);
+	UASSERT(db.loadPlayer(&player, &sao));
+	sao.finalize(&player, std::set<std::string>());
+
+	std::string value;
+	UASSERT(sao.getMeta().getStringToRef("key", value));
+	UASSERTEQ(std::string, value, "new");
+	InventoryList *list = player.inventory.getList("main");
+	UASSERT(list);
+	UASSERTEQ(u32, list->getSize(), 4);
+	UASSERT(list->getItem(0).empty());
+	UASSERTEQ(u16, list->getItem(1).count, 5);
+}
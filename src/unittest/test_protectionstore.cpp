@@ -0,0 +1,94 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include "server/protectionstore.h"
+
+class TestProtectionStore : public TestBase {
+public:
+	TestProtectionStore() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestProtectionStore"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testCheck();
+	void testCheckArea();
+	void testRemove();
+};
+
+static TestProtectionStore g_test_instance;
+
+void TestProtectionStore::runTests(IGameDef *gamedef)
+{
+	TEST(testCheck);
+	TEST(testCheckArea);
+	TEST(testRemove);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TestProtectionStore::testCheck()
+{
+	ProtectionStore store;
+	store.addArea(v3s32(0, 0, 0), v3s32(10, 10, 10), "alice", {"bob"});
+	store.addArea(v3s32(5, 5, 5), v3s32(20, 20, 20), "bob", {});
+
+	UASSERT(store.check(v3s32(-1, 0, 0), "alice") == PROTECTION_NONE);
+	UASSERT(store.check(v3s32(1, 1, 1), "alice") == PROTECTION_ALLOWED);
+	UASSERT(store.check(v3s32(1, 1, 1), "bob") == PROTECTION_ALLOWED);
+	UASSERT(store.check(v3s32(1, 1, 1), "carol") == PROTECTION_DENIED);
+	UASSERT(store.check(v3s32(1, 1, 1), "") == PROTECTION_DENIED);
+
+	// Overlapping areas must all grant access
+	UASSERT(store.check(v3s32(7, 7, 7), "alice") == PROTECTION_DENIED);
+	UASSERT(store.check(v3s32(7, 7, 7), "bob") == PROTECTION_ALLOWED);
+}
+
+void TestProtectionStore::testCheckArea()
+{
+	ProtectionStore store;
+	store.addArea(v3s32(0, 0, 0), v3s32(10, 10, 10), "alice", {});
+	store.addArea(v3s32(30, 0, 0), v3s32(40, 10, 10), "bob", {});
+
+	UASSERT(store.checkArea(v3s32(11, 0, 0), v3s32(29, 10, 10), "carol")
+			== PROTECTION_NONE);
+	UASSERT(store.checkArea(v3s32(-5, -5, -5), v3s32(20, 5, 5), "alice")
+			== PROTECTION_ALLOWED);
+	UASSERT(store.checkArea(v3s32(-5, -5, -5), v3s32(35, 5, 5), "alice")
+			== PROTECTION_DENIED);
+
+	// Unsorted corners
+	UASSERT(store.checkArea(v3s32(35, 5, 5), v3s32(20, -5, -5), "bob")
+			== PROTECTION_ALLOWED);
+}
+
+void TestProtectionStore::testRemove()
+{
+	ProtectionStore store;
+	u32 id = store.addArea(v3s32(0, 0, 0), v3s32(10, 10, 10), "alice", {});
+	UASSERT(id != U32_MAX);
+	UASSERTEQ(size_t, store.size(), 1);
+	UASSERT(store.check(v3s32(1, 1, 1), "bob") == PROTECTION_DENIED);
+
+	UASSERT(store.removeArea(id));
+	UASSERT(!store.removeArea(id));
+	UASSERTEQ(size_t, store.size(), 0);
+	UASSERT(store.check(v3s32(1, 1, 1), "bob") == PROTECTION_NONE);
+}
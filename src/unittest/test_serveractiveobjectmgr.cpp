@@ -39,6 +39,7 @@ class TestServerActiveObjectMgr : public TestBase
 	void testRegisterObject();
 	void testRemoveObject();
 	void testGetObjectsInsideRadius();
+	void testGetCollisionCandidates();
 	void testGetAddedActiveObjectsAroundPos();
 };
 
@@ -50,6 +51,7 @@ void TestServerActiveObjectMgr::runTests(IGameDef *gamedef)
 	TEST(testRegisterObject)
 	TEST(testRemoveObject)
 	TEST(testGetObjectsInsideRadius);
+	TEST(testGetCollisionCandidates);
 	TEST(testGetAddedActiveObjectsAroundPos);
 }
 
@@ -163,6 +165,56 @@ void TestServerActiveObjectMgr::testGetObjectsInsideRadius()
 	clearSAOMgr(&saomgr);
 }
 
+void TestServerActiveObjectMgr::testGetCollisionCandidates()
+{
+	server::ActiveObjectMgr saomgr;
+	std::vector<ServerActiveObject *> objects;
+	for (int i = 0; i < 10; i++) {
+		objects.push_back(new MockServerActiveObject(nullptr, v3f(i * 100, 0, 0)));
+		saomgr.registerObject(objects.back());
+	}
+
+	std::vector<ServerActiveObject *> result;
+	saomgr.getCollisionCandidates(v3f(300, 0, 0), 50, result, nullptr);
+	UASSERTCMP(int, ==, result.size(), 1);
+	UASSERT(result[0] == objects[3]);
+
+	// Moved after the index was sorted, without a step in between
+	auto move = [&] (ServerActiveObject *obj, v3f pos) {
+		obj->setBasePosition(pos);
+		saomgr.objectMoved(obj);
+	};
+	move(objects[3], v3f(310, 0, 0));
+	move(objects[9], v3f(-500, 0, 0));
+
+	result.clear();
+	saomgr.getCollisionCandidates(v3f(320, 0, 0), 15, result, nullptr);
+	UASSERTCMP(int, ==, result.size(), 1);
+	UASSERT(result[0] == objects[3]);
+
+	result.clear();
+	saomgr.getCollisionCandidates(v3f(-500, 0, 0), 10, result, nullptr);
+	UASSERTCMP(int, ==, result.size(), 1);
+	UASSERT(result[0] == objects[9]);
+
+	result.clear();
+	saomgr.getCollisionCandidates(v3f(900, 0, 0), 10, result, nullptr);
+	UASSERTCMP(int, ==, result.size(), 0);
+
+	// Sorted again by the step
+	saomgr.step(0.1f, [](ServerActiveObject *obj) {});
+	result.clear();
+	saomgr.getCollisionCandidates(v3f(-450, 0, 0), 100, result, nullptr);
+	UASSERTCMP(int, ==, result.size(), 1);
+	UASSERT(result[0] == objects[9]);
+
+	result.clear();
+	saomgr.getCollisionCandidates(v3f(0, 0, 0), 10000, result, nullptr);
+	UASSERTCMP(int, ==, result.size(), 10);
+
+	clearSAOMgr(&saomgr);
+}
+
 void TestServerActiveObjectMgr::testGetAddedActiveObjectsAroundPos()
 {
 	server::ActiveObjectMgr saomgr;
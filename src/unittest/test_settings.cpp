@@ -23,6 +23,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "settings.h"
 #include "defaultsettings.h"
 #include "noise.h"
+#include "util/numeric.h"
 
 class TestSettings : public TestBase {
 public:
@@ -34,6 +35,7 @@ class TestSettings : public TestBase {
 	void testAllSettings();
 	void testDefaults();
 	void testFlagDesc();
+	void testSettingHandle();
 
 	static const char *config_text_before;
 	static const std::string config_text_after;
@@ -46,6 +48,7 @@ void TestSettings::runTests(IGameDef *gamedef)
 	TEST(testAllSettings);
 	TEST(testDefaults);
 	TEST(testFlagDesc);
+	TEST(testSettingHandle);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -294,3 +297,38 @@ void TestSettings::testFlagDesc()
 
 	delete &s;
 }
+
+void TestSettings::testSettingHandle()
+{
+	Settings s;
+	s.set("test_int", "5");
+	s.set("test_float", "1.5");
+
+	{
+		SettingHandle<s32> h_int(&s, "test_int");
+		SettingHandle<float> h_clamped(&s, "test_float",
+			[](const Settings *settings, const std::string &name) {
+				return rangelim(settings->getFloat(name), 0.0f, 2.0f);
+			});
+		UASSERTEQ(s32, h_int.get(), 5);
+		UASSERTEQ(float, h_clamped.get(), 1.5f);
+
+		s.setS32("test_int", -3);
+		s.set("test_float", "10");
+		UASSERTEQ(s32, h_int.get(), -3);
+		UASSERTEQ(float, h_clamped.get(), 2.0f);
+
+		// Removing keeps the last value
+		s.remove("test_int");
+		UASSERTEQ(s32, h_int.get(), -3);
+	}
+
+	// Destroyed handles are no longer called
+	s.set("test_float", "0.5");
+
+	try {
+		SettingHandle<bool> h_missing(&s, "test_missing");
+		UASSERT(false);
+	} catch (SettingNotFoundException &) {
+	}
+}
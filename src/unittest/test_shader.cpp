@@ -0,0 +1,135 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include "client/shader.h"
+#include "settings.h"
+#include "util/string.h"
+
+class TestShader : public TestBase
+{
+public:
+	TestShader() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestShader"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testPreprocess();
+	void testDiscard();
+	void testReadSettings();
+};
+
+static TestShader g_test_instance;
+
+void TestShader::runTests(IGameDef *gamedef)
+{
+	TEST(testPreprocess);
+	TEST(testDiscard);
+	TEST(testReadSettings);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool contains(const std::string &s, const std::string &part)
+{
+	return s.find(part) != std::string::npos;
+}
+
+void TestShader::testPreprocess()
+{
+	ShaderHeaderParams params;
+	params.defines = "#define ENABLE_TEST 1\n";
+
+	ShaderInfo info;
+	info.material_type = TILE_MATERIAL_WAVING_LEAVES;
+	info.drawtype = NDT_ALLFACES;
+
+	ShaderProgramSources templates;
+	templates.vertex = "void main() { vertex(); }";
+	templates.fragment = "void main() { fragment(); }";
+
+	ShaderProgramSources sources = preprocessShader(params, info, templates);
+	UASSERT(contains(sources.vertex, "#version 120"));
+	UASSERT(contains(sources.vertex, "#define MATERIAL_TYPE " +
+		std::to_string(TILE_MATERIAL_WAVING_LEAVES) + "\n"));
+	UASSERT(contains(sources.vertex, "#define DRAW_TYPE " +
+		std::to_string(NDT_ALLFACES) + "\n"));
+	UASSERT(contains(sources.vertex, "#define ENABLE_TEST 1\n"));
+	UASSERT(contains(sources.vertex, "#define mWorldView gl_ModelViewMatrix"));
+	UASSERT(!contains(sources.fragment, "gl_ModelViewMatrix"));
+	UASSERT(contains(sources.fragment, "#define baseTexture texture0"));
+
+	// The templates follow the header
+	size_t line = sources.vertex.find("#line 0\n");
+	UASSERT(line != std::string::npos);
+	UASSERT(sources.vertex.find(templates.vertex) > line);
+	UASSERT(str_ends_with(sources.vertex, templates.vertex));
+	UASSERT(str_ends_with(sources.fragment, templates.fragment));
+
+	// No geometry shader without a template
+	UASSERT(sources.geometry.empty());
+	templates.geometry = "void main() { geometry(); }";
+	sources = preprocessShader(params, info, templates);
+	UASSERT(str_ends_with(sources.geometry, templates.geometry));
+
+	params.use_gles = true;
+	sources = preprocessShader(params, info, templates);
+	UASSERT(contains(sources.vertex, "#version 100"));
+	UASSERT(contains(sources.vertex, "uniform highp mat4 mWorldView;"));
+	UASSERT(contains(sources.fragment, "precision mediump float;"));
+}
+
+void TestShader::testDiscard()
+{
+	ShaderHeaderParams params;
+	ShaderInfo info;
+	ShaderProgramSources templates;
+
+	info.base_material = video::EMT_TRANSPARENT_ALPHA_CHANNEL;
+	UASSERT(!contains(preprocessShader(params, info, templates).vertex, "USE_DISCARD"));
+
+	params.use_discard = true;
+	UASSERT(contains(preprocessShader(params, info, templates).vertex,
+		"#define USE_DISCARD 1\n"));
+
+	info.base_material = video::EMT_TRANSPARENT_ALPHA_CHANNEL_REF;
+	UASSERT(contains(preprocessShader(params, info, templates).vertex,
+		"#define USE_DISCARD_REF 1\n"));
+
+	info.base_material = video::EMT_SOLID;
+	UASSERT(!contains(preprocessShader(params, info, templates).vertex, "USE_DISCARD"));
+}
+
+void TestShader::testReadSettings()
+{
+	Settings *settings = Settings::createLayer(SL_GAME);
+	settings->setBool("enable_waving_water", true);
+	settings->setFloat("water_wave_height", 1.0f);
+	settings->setBool("enable_waving_leaves", false);
+
+	ShaderHeaderParams params;
+	params.readSettings();
+	UASSERT(contains(params.defines, "#define ENABLE_WAVING_WATER 1\n"));
+	// GLSL ES needs a decimal point
+	UASSERT(contains(params.defines, "#define WATER_WAVE_HEIGHT 1.0"));
+	UASSERT(contains(params.defines, "#define ENABLE_WAVING_LEAVES 0\n"));
+
+	delete settings;
+}
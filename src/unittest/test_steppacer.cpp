@@ -0,0 +1,102 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include <cmath>
+#include "server/steppacer.h"
+
+class TestStepPacer : public TestBase
+{
+public:
+	TestStepPacer() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestStepPacer"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testSchedule();
+	void testFallingBehind();
+	void testHistogram();
+};
+
+static TestStepPacer g_test_instance;
+
+void TestStepPacer::runTests(IGameDef *gamedef)
+{
+	TEST(testSchedule);
+	TEST(testFallingBehind);
+	TEST(testHistogram);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TestStepPacer::testSchedule()
+{
+	StepPacer pacer(100000, 1000000);
+	UASSERT(pacer.isDue(1000000));
+	UASSERTEQ(float, pacer.begin(1000000), 0.1f);
+	pacer.end(1020000);
+
+	UASSERT(!pacer.isDue(1050000));
+	UASSERTEQ(u64, pacer.timeUntilDue(1050000), 50000);
+
+	// A late step is followed by an early one
+	UASSERT(pacer.isDue(1130000));
+	UASSERT(std::fabs(pacer.begin(1130000) - 0.13f) < 0.0001f);
+	pacer.end(1140000);
+	UASSERTEQ(u64, pacer.timeUntilDue(1140000), 60000);
+
+	UASSERTEQ(u64, pacer.getDurations().count(), 2);
+	UASSERTEQ(u64, pacer.getDurations().max(), 20000);
+	UASSERTEQ(u64, pacer.getLateness().max(), 30000);
+
+	pacer.clearStats();
+	UASSERTEQ(u64, pacer.getDurations().count(), 0);
+	UASSERTEQ(u64, pacer.getLateness().count(), 0);
+}
+
+void TestStepPacer::testFallingBehind()
+{
+	StepPacer pacer(100000, 0);
+	pacer.begin(0);
+	pacer.end(0);
+
+	// Missed steps are not run back to back
+	pacer.begin(550000);
+	pacer.end(560000);
+	UASSERTEQ(u64, pacer.timeUntilDue(560000), 90000);
+}
+
+void TestStepPacer::testHistogram()
+{
+	TimeHistogram h;
+	UASSERTEQ(u64, h.percentile(0.5f), 0);
+
+	for (int i = 0; i < 98; i++)
+		h.add(500);
+	h.add(5000);
+	h.add(100000000);
+
+	UASSERTEQ(u64, h.count(), 100);
+	UASSERTEQ(u64, h.max(), 100000000);
+	UASSERTEQ(u64, h.percentile(0.5f), 1000);
+	UASSERTEQ(u64, h.percentile(0.99f), 8000);
+	// The last bucket is open-ended
+	UASSERTEQ(u64, h.percentile(1.0f), 100000000);
+}
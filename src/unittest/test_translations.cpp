@@ -0,0 +1,104 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include "translation.h"
+#include "util/string.h"
+
+class TestTranslations : public TestBase
+{
+public:
+	TestTranslations() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestTranslations"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testLookup();
+	void testTranslateString();
+	void testReload();
+};
+
+static TestTranslations g_test_instance;
+
+static const char *translation_data =
+	"# textdomain: mod\n"
+	"Hello=Hallo\n"
+	"@1 Wool=@1 Wolle\n"
+	"White=Wei\xc3\x9f\n"
+	"# textdomain: other\n"
+	"Hello=Servus\n";
+
+void TestTranslations::runTests(IGameDef *gamedef)
+{
+	TEST(testLookup);
+	TEST(testTranslateString);
+	TEST(testReload);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TestTranslations::testLookup()
+{
+	Translations translations;
+	translations.loadTranslation(translation_data);
+
+	UASSERT(translations.getTranslation(L"mod", L"Hello") == L"Hallo");
+	UASSERT(translations.getTranslation(L"other", L"Hello") == L"Servus");
+	UASSERT(translations.getTranslation(L"mod", L"Missing") == L"Missing");
+	UASSERT(translations.getTranslation(L"unknown", L"Hello") == L"Hello");
+	// Still the same once the miss was remembered
+	UASSERT(translations.getTranslation(L"unknown", L"Hello") == L"Hello");
+	UASSERT(translations.getTranslation(L"mod", L"Hello") == L"Hallo");
+}
+
+void TestTranslations::testTranslateString()
+{
+	Translations translations;
+	translations.loadTranslation(translation_data);
+
+	const std::wstring plain = L"no escapes";
+	UASSERT(translate_string(plain, &translations) == plain);
+	UASSERT(translations.getTranslatedString(plain) == nullptr);
+
+	const std::wstring wool =
+		L"\x1b(T@mod)\x1b" L"F\x1b(T@mod)White\x1b" L"E\x1b" L"E Wool\x1b" L"E";
+	UASSERT(translate_string(wool, &translations) == L"Wei\u00df Wolle");
+	const std::wstring *cached = translations.getTranslatedString(wool);
+	UASSERT(cached && *cached == L"Wei\u00df Wolle");
+	UASSERT(translate_string(wool, &translations) == L"Wei\u00df Wolle");
+
+	// Untranslated, the escapes are just removed
+	UASSERT(translate_string(wool, nullptr) == L"White Wool");
+}
+
+void TestTranslations::testReload()
+{
+	Translations translations;
+	const std::wstring hello = L"\x1b(T@mod)Hello\x1b" L"E";
+
+	UASSERT(translate_string(hello, &translations) == L"Hello");
+
+	translations.loadTranslation(translation_data);
+	UASSERT(translate_string(hello, &translations) == L"Hallo");
+
+	translations.clear();
+	UASSERT(translations.getTranslatedString(hello) == nullptr);
+	UASSERT(translate_string(hello, &translations) == L"Hello");
+}
@@ -23,6 +23,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "voxelalgorithms.h"
 #include "util/numeric.h"
 #include "dummymap.h"
+#include "dummyenvironment.h"
+#include "noise.h"
 
 class TestVoxelAlgorithms : public TestBase {
 public:
@@ -33,6 +35,7 @@ class TestVoxelAlgorithms : public TestBase {
 
 	void testVoxelLineIterator();
 	void testLighting(IGameDef *gamedef);
+	void testLineOfSightBulk(IGameDef *gamedef);
 };
 
 static TestVoxelAlgorithms g_test_instance;
@@ -41,6 +44,7 @@ void TestVoxelAlgorithms::runTests(IGameDef *gamedef)
 {
 	TEST(testVoxelLineIterator);
 	TEST(testLighting, gamedef);
+	TEST(testLineOfSightBulk, gamedef);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -168,3 +172,42 @@ void TestVoxelAlgorithms::testLighting(IGameDef *gamedef)
 		UASSERTEQ(int, n.getParam1(), 153);
 	}
 }
+
+void TestVoxelAlgorithms::testLineOfSightBulk(IGameDef *gamedef)
+{
+	// Nodes outside of the filled area stay ignore, lines may also leave the map
+	v3s32 bpmin(-2, -2, -2), bpmax(1, 1, 1);
+	DummyMap map(gamedef, bpmin, bpmax);
+	DummyEnvironment env(gamedef, &map);
+
+	PcgRandom pr(1234);
+	for (s32 z = -16; z < 16; z++)
+	for (s32 y = -16; y < 16; y++)
+	for (s32 x = -16; x < 16; x++) {
+		// Leave the block at the origin empty
+		bool stone = (x < 0 || y < 0 || z < 0) && pr.range(0, 99) < 2;
+		map.setNode(v3s32(x, y, z), MapNode(stone ? t_CONTENT_STONE : CONTENT_AIR));
+	}
+
+	// Enough lines to use worker threads
+	std::vector<core::line3d<f32>> lines;
+	for (int i = 0; i < 600; i++) {
+		v3f pos1(pr.range(-2000, 2000), pr.range(-2000, 2000), pr.range(-2000, 2000));
+		v3f pos2(pr.range(-3000, 3000), pr.range(-3000, 3000), pr.range(-3000, 3000));
+		lines.emplace_back(pos1 * (BS / 100), pos2 * (BS / 100));
+	}
+	lines.emplace_back(v3f(1, 1, 1) * BS, v3f(14, 14, 14) * BS);
+
+	std::vector<Environment::LineOfSightResult> results;
+	env.lineOfSightBulk(lines, results);
+	UASSERTEQ(size_t, results.size(), lines.size());
+
+	for (size_t i = 0; i < lines.size(); i++) {
+		v3s32 p;
+		bool clear = env.line_of_sight(lines[i].start, lines[i].end, &p);
+		UASSERTEQ(bool, results[i].clear, clear);
+		if (!clear)
+			UASSERT(results[i].node_pos == p);
+	}
+	UASSERT(results.back().clear);
+}
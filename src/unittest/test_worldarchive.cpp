@@ -0,0 +1,175 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "test.h"
+
+#include "worldarchive.h"
+#include "exceptions.h"
+#include "filesys.h"
+#include <fstream>
+#include <sstream>
+
+class TestWorldArchive : public TestBase
+{
+public:
+	TestWorldArchive() { TestManager::registerTestModule(this); }
+	const char *getName() { return "TestWorldArchive"; }
+
+	void runTests(IGameDef *gamedef);
+
+	void testRoundTrip();
+	void testRegions();
+	void testInvalid();
+	void testFileNames();
+};
+
+static TestWorldArchive g_test_instance;
+
+void TestWorldArchive::runTests(IGameDef *gamedef)
+{
+	TEST(testRoundTrip);
+	TEST(testRegions);
+	TEST(testInvalid);
+	TEST(testFileNames);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static std::string write_archive(std::vector<std::vector<WorldArchiveChunk>> batches)
+{
+	std::ostringstream os(std::ios_base::binary);
+	WorldArchiveWriter writer(os);
+	for (auto &chunks : batches)
+		writer.write(chunks);
+	writer.finish();
+	return os.str();
+}
+
+void TestWorldArchive::testRoundTrip()
+{
+	std::vector<WorldArchiveChunk> files(1), players(20);
+	files[0].section = WORLD_ARCHIVE_FILES;
+	files[0].addRecord({"world.mt", "backend = sqlite3\n"});
+	files[0].addRecord({"empty", ""});
+	for (size_t i = 0; i < players.size(); i++) {
+		players[i].section = WORLD_ARCHIVE_PLAYERS;
+		players[i].addRecord({"player" + std::to_string(i),
+			std::string(1000 + i, 'a' + i % 26)});
+	}
+
+	std::istringstream is(write_archive({files, players}), std::ios_base::binary);
+	WorldArchiveReader reader(is);
+	const std::vector<WorldArchiveChunk> &index = reader.getIndex();
+	UASSERTEQ(size_t, index.size(), 21);
+	UASSERTEQ(int, index[0].section, WORLD_ARCHIVE_FILES);
+	UASSERTEQ(u32, index[0].records, 2);
+	UASSERT(index[0].data.empty());
+
+	// Out of order and repeated
+	std::vector<WorldArchiveChunk> chunks;
+	reader.read({20, 0, 5, 5}, chunks);
+	UASSERTEQ(size_t, chunks.size(), 4);
+
+	std::vector<std::vector<std::string>> records;
+	parse_world_archive_records(chunks[1].data, records);
+	UASSERTEQ(size_t, records.size(), 2);
+	UASSERTEQ(std::string, records[0][0], "world.mt");
+	UASSERTEQ(std::string, records[0][1], "backend = sqlite3\n");
+	UASSERTEQ(std::string, records[1][0], "empty");
+	UASSERT(records[1][1].empty());
+
+	records.clear();
+	parse_world_archive_records(chunks[0].data, records);
+	UASSERTEQ(size_t, records.size(), 1);
+	UASSERTEQ(std::string, records[0][0], "player19");
+	UASSERT(records[0][1] == std::string(1019, 'a' + 19));
+	UASSERT(chunks[2].data == chunks[3].data);
+}
+
+void TestWorldArchive::testRegions()
+{
+	WorldArchiveChunk chunk;
+	chunk.section = WORLD_ARCHIVE_MAP;
+	chunk.addBlock(v3s32(-3, 2, 5), "first");
+	chunk.addBlock(v3s32(-8, 7, 0), std::string("with\0zero", 9));
+	UASSERTEQ(u32, chunk.records, 2);
+	UASSERT(chunk.min == v3s32(-8, 2, 0));
+	UASSERT(chunk.max == v3s32(-3, 7, 5));
+
+	UASSERT(chunk.overlaps(v3s32(-3, 7, 5), v3s32(10, 10, 10)));
+	UASSERT(chunk.overlaps(v3s32(-100, -100, -100), v3s32(100, 100, 100)));
+	UASSERT(!chunk.overlaps(v3s32(-2, 0, 0), v3s32(10, 10, 10)));
+	UASSERT(!chunk.overlaps(v3s32(-8, 8, 0), v3s32(-3, 9, 5)));
+	UASSERT(!WorldArchiveChunk().overlaps(v3s32(-1, -1, -1), v3s32(1, 1, 1)));
+
+	std::vector<WorldArchiveChunk> chunks{chunk};
+	std::istringstream is(write_archive({chunks}), std::ios_base::binary);
+	WorldArchiveReader reader(is);
+	UASSERT(reader.getIndex()[0].min == v3s32(-8, 2, 0));
+	UASSERT(reader.getIndex()[0].max == v3s32(-3, 7, 5));
+
+	reader.read({0}, chunks);
+	std::vector<std::vector<std::string>> records;
+	parse_world_archive_records(chunks[0].data, records);
+	UASSERTEQ(size_t, records.size(), 2);
+	UASSERTEQ(size_t, records[1][0].size(), 12);
+	UASSERT(readV3S32((const u8 *)records[1][0].data()) == v3s32(-8, 7, 0));
+	UASSERT(records[1][1] == std::string("with\0zero", 9));
+}
+
+void TestWorldArchive::testInvalid()
+{
+	std::vector<WorldArchiveChunk> chunks(1);
+	chunks[0].addRecord({"name", std::string(5000, 'x')});
+	std::string data = write_archive({chunks});
+
+	std::istringstream not_archive("not a world archive at all, just some text");
+	EXCEPTION_CHECK(SerializationError, WorldArchiveReader reader(not_archive));
+
+	// Cut off index
+	std::istringstream truncated(data.substr(0, data.size() - 1),
+		std::ios_base::binary);
+	EXCEPTION_CHECK(SerializationError, WorldArchiveReader reader(truncated));
+
+	// Damaged chunk data, the index is intact
+	std::string damaged = data;
+	damaged[12] ^= 0xff;
+	damaged[20] ^= 0xff;
+	std::istringstream is(damaged, std::ios_base::binary);
+	WorldArchiveReader reader(is);
+	EXCEPTION_CHECK(SerializationError, reader.read({0}, chunks));
+}
+
+void TestWorldArchive::testFileNames()
+{
+	const std::string dir = getTestTempDirectory();
+	const std::string world_path = dir + DIR_DELIM "world";
+	const std::string archive_path = dir + DIR_DELIM "escape.mtwa";
+
+	std::vector<WorldArchiveChunk> chunks(1);
+	chunks[0].section = WORLD_ARCHIVE_FILES;
+	chunks[0].addRecord({".." DIR_DELIM "escaped.txt", "outside of the world"});
+	{
+		std::ofstream os(archive_path, std::ios_base::binary);
+		os << write_archive({chunks});
+	}
+
+	UASSERT(!import_world(world_path, archive_path));
+	UASSERT(!fs::PathExists(dir + DIR_DELIM "escaped.txt"));
+}
@@ -792,9 +792,21 @@ void translate_all(const std::wstring &s, size_t &i,
 // Translate string server side
 std::wstring translate_string(const std::wstring &s, Translations *translations)
 {
+	// Without escape sequences, there is nothing to translate
+	if (s.find(L'\x1b') == std::wstring::npos)
+		return s;
+
+	if (translations) {
+		const std::wstring *cached = translations->getTranslatedString(s);
+		if (cached)
+			return *cached;
+	}
+
 	size_t i = 0;
 	std::wstring res;
 	translate_all(s, i, translations, res);
+	if (translations)
+		translations->cacheTranslatedString(s, res);
 	return res;
 }
 
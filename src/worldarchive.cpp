@@ -0,0 +1,754 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "worldarchive.h"
+#include "database/database-files.h"
+#include "exceptions.h"
+#include "filesys.h"
+#include "log.h"
+#include "map.h"
+#include "mapblock.h"
+#include "porting.h"
+#include "remoteplayer.h"
+#include "server.h"
+#include "serialization.h"
+#include "serverenvironment.h"
+#include "settings.h"
+#include "server/player_sao.h"
+#include "threading/thread.h"
+#include "util/serialize.h"
+#include "util/string.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+static const char WORLD_ARCHIVE_MAGIC[8] = {'M', 'T', 'W', 'O', 'R', 'L', 'D', 'A'};
+static const u16 WORLD_ARCHIVE_VERSION = 1;
+// Trailer: index offset and magic
+static const u64 WORLD_ARCHIVE_TRAILER_SIZE = 8 + sizeof(WORLD_ARCHIVE_MAGIC);
+
+// Blocks loaded from or saved to the map database at once
+#define WORLD_ARCHIVE_BATCH 4096
+// Players and mod storage entries are cut into chunks of about this size
+#define WORLD_ARCHIVE_CHUNK_SIZE (4 * 1024 * 1024)
+
+static void append_string32(std::string &data, const std::string &s)
+{
+	char buf[4];
+	writeU32((u8 *)buf, s.size());
+	data.append(buf, sizeof(buf));
+	data.append(s);
+}
+
+void WorldArchiveChunk::addRecord(const std::vector<std::string> &fields)
+{
+	data.push_back((char)fields.size());
+	for (const std::string &field : fields)
+		append_string32(data, field);
+	records++;
+}
+
+void WorldArchiveChunk::addBlock(v3s32 pos, const std::string &blob)
+{
+	char buf[12];
+	writeV3S32((u8 *)buf, pos);
+	data.push_back(2);
+	append_string32(data, std::string(buf, sizeof(buf)));
+	append_string32(data, blob);
+
+	if (records == 0) {
+		min = max = pos;
+	} else {
+		min = v3s32(std::min(min.X, pos.X), std::min(min.Y, pos.Y), std::min(min.Z, pos.Z));
+		max = v3s32(std::max(max.X, pos.X), std::max(max.Y, pos.Y), std::max(max.Z, pos.Z));
+	}
+	records++;
+}
+
+bool WorldArchiveChunk::overlaps(v3s32 bmin, v3s32 bmax) const
+{
+	return records > 0 &&
+		min.X <= bmax.X && max.X >= bmin.X &&
+		min.Y <= bmax.Y && max.Y >= bmin.Y &&
+		min.Z <= bmax.Z && max.Z >= bmin.Z;
+}
+
+void parse_world_archive_records(const std::string &data,
+		std::vector<std::vector<std::string>> &records)
+{
+	std::istringstream is(data, std::ios_base::binary);
+	while (is.peek() != EOF) {
+		u8 count = readU8(is);
+		records.emplace_back();
+		std::vector<std::string> &fields = records.back();
+		fields.reserve(count);
+		for (u8 i = 0; i < count; i++)
+			fields.push_back(deSerializeString32(is));
+	}
+}
+
+/*
+	(De)compresses a range of chunks in place
+*/
+class WorldArchiveThread : public Thread
+{
+public:
+	WorldArchiveThread(std::vector<WorldArchiveChunk> &chunks,
+			std::vector<char> &failed, size_t begin, size_t end,
+			bool compress, int compression_level) :
+		Thread("WorldArchive"),
+		m_chunks(chunks), m_failed(failed), m_begin(begin), m_end(end),
+		m_compress(compress), m_compression_level(compression_level)
+	{}
+
+	static void processRange(std::vector<WorldArchiveChunk> &chunks,
+			std::vector<char> &failed, size_t begin, size_t end,
+			bool compress, int compression_level)
+	{
+		for (size_t i = begin; i < end; i++) {
+			WorldArchiveChunk &chunk = chunks[i];
+			std::ostringstream os(std::ios_base::binary);
+			if (compress) {
+				chunk.raw_size = chunk.data.size();
+				compressZstd(chunk.data, os, compression_level);
+				chunk.data = os.str();
+				chunk.size = chunk.data.size();
+				continue;
+			}
+
+			std::istringstream is(chunk.data, std::ios_base::binary);
+			try {
+				decompressZstd(is, os);
+			} catch (SerializationError &e) {
+				failed[i] = 1;
+				continue;
+			}
+			chunk.data = os.str();
+			if (chunk.data.size() != chunk.raw_size)
+				failed[i] = 1;
+		}
+	}
+
+	void *run()
+	{
+		BEGIN_DEBUG_EXCEPTION_HANDLER
+
+		processRange(m_chunks, m_failed, m_begin, m_end, m_compress,
+				m_compression_level);
+
+		END_DEBUG_EXCEPTION_HANDLER
+
+		return nullptr;
+	}
+
+private:
+	std::vector<WorldArchiveChunk> &m_chunks;
+	std::vector<char> &m_failed;
+	size_t m_begin, m_end;
+	bool m_compress;
+	int m_compression_level;
+};
+
+static void process_chunks(std::vector<WorldArchiveChunk> &chunks,
+		std::vector<char> &failed, bool compress, int compression_level)
+{
+	failed.assign(chunks.size(), 0);
+	const size_t num_threads = std::min<size_t>(chunks.size(),
+			std::max(1U, Thread::getNumberOfProcessors()));
+	if (num_threads <= 1) {
+		WorldArchiveThread::processRange(chunks, failed, 0, chunks.size(),
+				compress, compression_level);
+		return;
+	}
+
+	std::vector<std::unique_ptr<WorldArchiveThread>> threads;
+	size_t range = (chunks.size() + num_threads - 1) / num_threads;
+	for (size_t i = 0; i < chunks.size(); i += range) {
+		threads.emplace_back(new WorldArchiveThread(chunks, failed, i,
+			std::min(i + range, chunks.size()), compress, compression_level));
+		threads.back()->start();
+	}
+	for (auto &thread : threads)
+		thread->wait();
+}
+
+/*
+	WorldArchiveWriter
+*/
+
+WorldArchiveWriter::WorldArchiveWriter(std::ostream &os, int compression_level) :
+	m_os(os), m_compression_level(compression_level)
+{
+	m_os.write(WORLD_ARCHIVE_MAGIC, sizeof(WORLD_ARCHIVE_MAGIC));
+	writeU16(m_os, WORLD_ARCHIVE_VERSION);
+	m_offset = sizeof(WORLD_ARCHIVE_MAGIC) + 2;
+}
+
+void WorldArchiveWriter::write(std::vector<WorldArchiveChunk> &chunks)
+{
+	std::vector<char> failed;
+	process_chunks(chunks, failed, true, m_compression_level);
+
+	for (WorldArchiveChunk &chunk : chunks) {
+		chunk.offset = m_offset;
+		m_os.write(chunk.data.data(), chunk.data.size());
+		m_offset += chunk.size;
+		chunk.data.clear();
+		chunk.data.shrink_to_fit();
+		m_index.push_back(chunk);
+	}
+	if (!m_os.good())
+		throw SerializationError("WorldArchiveWriter: write failed");
+}
+
+void WorldArchiveWriter::finish()
+{
+	const u64 index_offset = m_offset;
+	std::ostringstream os(std::ios_base::binary);
+	writeU32(os, m_index.size());
+	for (const WorldArchiveChunk &chunk : m_index) {
+		writeU8(os, chunk.section);
+		writeU64(os, chunk.offset);
+		writeU32(os, chunk.size);
+		writeU32(os, chunk.raw_size);
+		writeU32(os, chunk.records);
+		writeV3S32(os, chunk.min);
+		writeV3S32(os, chunk.max);
+	}
+	writeU64(os, index_offset);
+	os.write(WORLD_ARCHIVE_MAGIC, sizeof(WORLD_ARCHIVE_MAGIC));
+
+	const std::string index = os.str();
+	m_os.write(index.data(), index.size());
+	m_os.flush();
+	m_offset += index.size();
+	if (!m_os.good())
+		throw SerializationError("WorldArchiveWriter: write failed");
+}
+
+/*
+	WorldArchiveReader
+*/
+
+WorldArchiveReader::WorldArchiveReader(std::istream &is) :
+	m_is(is)
+{
+	char magic[sizeof(WORLD_ARCHIVE_MAGIC)];
+
+	m_is.seekg(0, std::ios_base::end);
+	const u64 file_size = m_is.tellg();
+	if (!m_is.good() || file_size < sizeof(magic) + 2 + 4 + WORLD_ARCHIVE_TRAILER_SIZE)
+		throw SerializationError("WorldArchiveReader: not a world archive");
+
+	m_is.seekg(0);
+	m_is.read(magic, sizeof(magic));
+	if (memcmp(magic, WORLD_ARCHIVE_MAGIC, sizeof(magic)) != 0)
+		throw SerializationError("WorldArchiveReader: not a world archive");
+	u16 version = readU16(m_is);
+	if (version != WORLD_ARCHIVE_VERSION)
+		throw SerializationError("WorldArchiveReader: unsupported version " +
+			std::to_string(version));
+
+	m_is.seekg(file_size - WORLD_ARCHIVE_TRAILER_SIZE);
+	const u64 index_offset = readU64(m_is);
+	m_is.read(magic, sizeof(magic));
+	if (!m_is.good() || memcmp(magic, WORLD_ARCHIVE_MAGIC, sizeof(magic)) != 0 ||
+			index_offset > file_size - WORLD_ARCHIVE_TRAILER_SIZE)
+		throw SerializationError("WorldArchiveReader: truncated archive");
+
+	m_is.seekg(index_offset);
+	u32 count = readU32(m_is);
+	// Every entry takes 45 bytes
+	if (count > (file_size - index_offset) / 45)
+		throw SerializationError("WorldArchiveReader: corrupt index");
+	m_index.resize(count);
+	for (WorldArchiveChunk &chunk : m_index) {
+		chunk.section = (WorldArchiveSection)readU8(m_is);
+		chunk.offset = readU64(m_is);
+		chunk.size = readU32(m_is);
+		chunk.raw_size = readU32(m_is);
+		chunk.records = readU32(m_is);
+		chunk.min = readV3S32(m_is);
+		chunk.max = readV3S32(m_is);
+		if (chunk.offset + chunk.size > index_offset)
+			throw SerializationError("WorldArchiveReader: corrupt index");
+	}
+	if (!m_is.good())
+		throw SerializationError("WorldArchiveReader: truncated archive");
+}
+
+void WorldArchiveReader::read(const std::vector<size_t> &which,
+		std::vector<WorldArchiveChunk> &chunks)
+{
+	chunks.clear();
+	chunks.reserve(which.size());
+	for (size_t i : which) {
+		chunks.push_back(m_index.at(i));
+		WorldArchiveChunk &chunk = chunks.back();
+		chunk.data.resize(chunk.size);
+		m_is.seekg(chunk.offset);
+		m_is.read(&chunk.data[0], chunk.size);
+		if (!m_is.good())
+			throw SerializationError("WorldArchiveReader: truncated archive");
+	}
+
+	std::vector<char> failed;
+	process_chunks(chunks, failed, false, 0);
+	for (size_t i = 0; i < chunks.size(); i++) {
+		if (failed[i])
+			throw SerializationError("WorldArchiveReader: corrupt chunk at offset " +
+				std::to_string(chunks[i].offset));
+	}
+}
+
+/*
+	Export and import
+*/
+
+static const char *const WORLD_ARCHIVE_FILE_NAMES[] = {
+	"world.mt",
+	"map_meta.txt",
+	"env_meta.txt",
+};
+
+static v3s32 get_archive_region(v3s32 blockpos)
+{
+	return getContainerPos(blockpos, WORLD_ARCHIVE_REGION_SIZE);
+}
+
+static std::string get_backend(const Settings &world_mt, const std::string &key,
+		const std::string &def)
+{
+	return world_mt.exists(key) ? world_mt.get(key) : def;
+}
+
+static void print_progress(const char *verb, u64 done, u64 total, u64 start_time)
+{
+	f32 seconds = std::max<u64>(porting::getTimeMs() - start_time, 1) / 1000.0f;
+	std::cerr << " " << verb << " " << done << " of " << total << " blocks, "
+		<< (total ? 100.0f * done / total : 100.0f) << "% completed, "
+		<< (u32)(done / seconds) << " blocks/s.\r";
+}
+
+// Adds a record to the current chunk of a section and writes the chunk
+// once it is full, so that only one chunk is held in memory
+static void export_record(WorldArchiveWriter &writer,
+		std::vector<WorldArchiveChunk> &chunks, WorldArchiveSection section,
+		const std::vector<std::string> &fields)
+{
+	if (chunks.empty()) {
+		chunks.emplace_back();
+		chunks.back().section = section;
+	}
+	chunks.back().addRecord(fields);
+	if (chunks.back().data.size() >= WORLD_ARCHIVE_CHUNK_SIZE) {
+		writer.write(chunks);
+		chunks.clear();
+	}
+}
+
+static bool export_map(const std::string &world_path, Settings &world_mt,
+		WorldArchiveWriter &writer, u64 &count)
+{
+	const std::string backend = get_backend(world_mt, "backend", "sqlite3");
+	std::unique_ptr<MapDatabase> db(ServerMap::createDatabase(backend,
+			world_path, world_mt));
+	bool &kill = *porting::signal_handler_killstatus();
+
+	// Grouped by region, in database key order within each region
+	std::vector<v3s32> blocks;
+	db->listAllLoadableBlocks(blocks);
+	std::sort(blocks.begin(), blocks.end(), [] (const v3s32 &a, const v3s32 &b) {
+		s64 ra = MapDatabase::getBlockAsInteger(get_archive_region(a));
+		s64 rb = MapDatabase::getBlockAsInteger(get_archive_region(b));
+		if (ra != rb)
+			return ra < rb;
+		return MapDatabase::getBlockAsInteger(a) < MapDatabase::getBlockAsInteger(b);
+	});
+
+	const u64 start_time = porting::getTimeMs();
+	u64 last_update_time = start_time;
+	size_t begin = 0;
+	while (begin < blocks.size()) {
+		if (kill)
+			return false;
+
+		// Whole regions only, so that each becomes one chunk
+		size_t end = begin;
+		while (end < blocks.size() && (end - begin < WORLD_ARCHIVE_BATCH ||
+				get_archive_region(blocks[end]) == get_archive_region(blocks[end - 1])))
+			end++;
+
+		std::vector<v3s32> positions(blocks.begin() + begin, blocks.begin() + end);
+		std::vector<std::string> blobs;
+		db->loadBlocks(positions, blobs);
+
+		std::vector<WorldArchiveChunk> chunks;
+		for (size_t i = 0; i < positions.size(); i++) {
+			if (blobs[i].empty())
+				continue;
+			if (chunks.empty() || get_archive_region(positions[i]) !=
+					get_archive_region(chunks.back().min)) {
+				chunks.emplace_back();
+				chunks.back().section = WORLD_ARCHIVE_MAP;
+			}
+			chunks.back().addBlock(positions[i], blobs[i]);
+			count++;
+		}
+		blobs.clear();
+		writer.write(chunks);
+		begin = end;
+
+		u64 now = porting::getTimeMs();
+		if (now - last_update_time >= 1000) {
+			print_progress("Exported", end, blocks.size(), start_time);
+			last_update_time = now;
+		}
+	}
+	std::cerr << std::endl;
+	return true;
+}
+
+bool export_world(const std::string &world_path, const std::string &archive_path)
+{
+	Settings world_mt;
+	const std::string world_mt_path = world_path + DIR_DELIM + "world.mt";
+	if (!world_mt.readConfigFile(world_mt_path.c_str())) {
+		errorstream << "Cannot read world.mt at " << world_mt_path << std::endl;
+		return false;
+	}
+
+	std::ofstream os(archive_path, std::ios_base::binary | std::ios_base::trunc);
+	if (!os.good()) {
+		errorstream << "Cannot open " << archive_path << " for writing" << std::endl;
+		return false;
+	}
+
+	u64 blocks = 0, players = 0, auths = 0, entries = 0;
+	try {
+		WorldArchiveWriter writer(os);
+		std::vector<WorldArchiveChunk> chunks;
+
+		chunks.emplace_back();
+		chunks.back().section = WORLD_ARCHIVE_FILES;
+		for (const char *name : WORLD_ARCHIVE_FILE_NAMES) {
+			std::string path = world_path + DIR_DELIM + name;
+			std::string content;
+			if (fs::PathExists(path) && fs::ReadFile(path, content))
+				chunks.back().addRecord({name, content});
+		}
+		writer.write(chunks);
+
+		if (!export_map(world_path, world_mt, writer, blocks)) {
+			os.close();
+			fs::DeleteSingleFileOrEmptyDirectory(archive_path);
+			errorstream << "Interrupted, no archive was written." << std::endl;
+			return false;
+		}
+
+		// Players in the format of the files backend, whatever they are stored in
+		std::unique_ptr<PlayerDatabase> player_db(ServerEnvironment::openPlayerDatabase(
+				get_backend(world_mt, "player_backend", "files"), world_path, world_mt));
+		std::vector<std::string> names;
+		player_db->listPlayers(names);
+		chunks.clear();
+		for (const std::string &name : names) {
+			RemotePlayer player(name.c_str(), nullptr);
+			PlayerSAO sao(nullptr, &player, 15000, false);
+			if (!player_db->loadPlayer(&player, &sao))
+				continue;
+			sao.finalize(&player, std::set<std::string>());
+			player.setPlayerSAO(&sao);
+
+			std::ostringstream ss(std::ios_base::binary);
+			PlayerDatabaseFiles::serialize(&player, ss);
+			export_record(writer, chunks, WORLD_ARCHIVE_PLAYERS, {name, ss.str()});
+			players++;
+		}
+		writer.write(chunks);
+
+		std::unique_ptr<AuthDatabase> auth_db(ServerEnvironment::openAuthDatabase(
+				get_backend(world_mt, "auth_backend", "files"), world_path, world_mt));
+		names.clear();
+		auth_db->listNames(names);
+		chunks.clear();
+		for (const std::string &name : names) {
+			AuthEntry auth;
+			if (!auth_db->getAuth(name, auth))
+				continue;
+			export_record(writer, chunks, WORLD_ARCHIVE_AUTH, {auth.name,
+				auth.password, str_join(auth.privileges, ","),
+				std::to_string(auth.last_login)});
+			auths++;
+		}
+		writer.write(chunks);
+
+		std::unique_ptr<ModStorageDatabase> storage_db(Server::openModStorageDatabase(
+				get_backend(world_mt, "mod_storage_backend", "files"), world_path, world_mt));
+		std::vector<std::string> mods;
+		storage_db->listMods(&mods);
+		chunks.clear();
+		for (const std::string &mod : mods) {
+			StringMap mod_entries;
+			storage_db->getModEntries(mod, &mod_entries);
+			for (const auto &entry : mod_entries) {
+				export_record(writer, chunks, WORLD_ARCHIVE_MOD_STORAGE,
+					{mod, entry.first, entry.second});
+				entries++;
+			}
+		}
+		writer.write(chunks);
+
+		writer.finish();
+	} catch (BaseException &e) {
+		os.close();
+		fs::DeleteSingleFileOrEmptyDirectory(archive_path);
+		errorstream << "Export failed: " << e.what() << std::endl;
+		return false;
+	}
+
+	actionstream << "Exported " << blocks << " blocks, " << players << " players, "
+		<< auths << " auth entries and " << entries << " mod storage entries to "
+		<< archive_path << " (" << (os.tellp() / (1024 * 1024)) << " MB)" << std::endl;
+	return true;
+}
+
+static bool parse_region(const std::string &region, v3s32 &bmin, v3s32 &bmax)
+{
+	v3s32 p1, p2;
+	if (sscanf(region.c_str(), "%d,%d,%d %d,%d,%d",
+			&p1.X, &p1.Y, &p1.Z, &p2.X, &p2.Y, &p2.Z) != 6)
+		return false;
+	sortBoxVerticies(p1, p2);
+	bmin = getNodeBlockPos(p1);
+	bmax = getNodeBlockPos(p2);
+	return true;
+}
+
+static bool import_map(const std::string &world_path, Settings &world_mt,
+		WorldArchiveReader &reader, const std::vector<size_t> &which,
+		bool has_region, v3s32 bmin, v3s32 bmax, u64 &count)
+{
+	const std::string backend = get_backend(world_mt, "backend", "sqlite3");
+	std::unique_ptr<MapDatabase> db(ServerMap::createDatabase(backend,
+			world_path, world_mt));
+	bool &kill = *porting::signal_handler_killstatus();
+
+	u64 total = 0;
+	for (size_t i : which)
+		total += reader.getIndex()[i].records;
+
+	const u64 start_time = porting::getTimeMs();
+	u64 last_update_time = start_time, done = 0;
+	size_t begin = 0;
+	while (begin < which.size()) {
+		if (kill)
+			return false;
+
+		// About a batch of blocks at a time
+		size_t end = begin;
+		u64 batch_records = 0;
+		while (end < which.size() && batch_records < WORLD_ARCHIVE_BATCH)
+			batch_records += reader.getIndex()[which[end++]].records;
+
+		std::vector<WorldArchiveChunk> chunks;
+		reader.read(std::vector<size_t>(which.begin() + begin, which.begin() + end),
+				chunks);
+
+		std::vector<std::pair<v3s32, std::string>> blocks;
+		for (WorldArchiveChunk &chunk : chunks) {
+			std::vector<std::vector<std::string>> records;
+			parse_world_archive_records(chunk.data, records);
+			chunk.data.clear();
+			for (auto &record : records) {
+				if (record.size() != 2 || record[0].size() != 12)
+					throw SerializationError("Invalid map record");
+				v3s32 pos = readV3S32((const u8 *)record[0].data());
+				if (has_region && (pos.X < bmin.X || pos.X > bmax.X ||
+						pos.Y < bmin.Y || pos.Y > bmax.Y ||
+						pos.Z < bmin.Z || pos.Z > bmax.Z))
+					continue;
+				blocks.emplace_back(pos, std::move(record[1]));
+			}
+		}
+
+		db->beginSave();
+		bool ok = db->saveBlocks(blocks);
+		db->endSave();
+		if (!ok) {
+			errorstream << "Failed to save imported blocks" << std::endl;
+			return false;
+		}
+		count += blocks.size();
+		done += batch_records;
+		begin = end;
+
+		u64 now = porting::getTimeMs();
+		if (now - last_update_time >= 1000) {
+			print_progress("Imported", done, total, start_time);
+			last_update_time = now;
+		}
+	}
+	std::cerr << std::endl;
+	return true;
+}
+
+bool import_world(const std::string &world_path, const std::string &archive_path,
+		const std::string &region)
+{
+	const bool has_region = !region.empty();
+	v3s32 bmin, bmax;
+	if (has_region && !parse_region(region, bmin, bmax)) {
+		errorstream << "Invalid region \"" << region
+			<< "\", expected \"x1,y1,z1 x2,y2,z2\"" << std::endl;
+		return false;
+	}
+
+	std::ifstream is(archive_path, std::ios_base::binary);
+	if (!is.good()) {
+		errorstream << "Cannot open " << archive_path << std::endl;
+		return false;
+	}
+
+	u64 blocks = 0, players = 0, auths = 0, entries = 0;
+	try {
+		WorldArchiveReader reader(is);
+		std::vector<size_t> sections[WORLD_ARCHIVE_MOD_STORAGE + 1];
+		const std::vector<WorldArchiveChunk> &index = reader.getIndex();
+		for (size_t i = 0; i < index.size(); i++) {
+			if (index[i].section > WORLD_ARCHIVE_MOD_STORAGE)
+				continue;
+			if (has_region && index[i].section == WORLD_ARCHIVE_MAP &&
+					!index[i].overlaps(bmin, bmax))
+				continue;
+			sections[index[i].section].push_back(i);
+		}
+
+		std::vector<WorldArchiveChunk> chunks;
+		std::vector<std::vector<std::string>> records;
+		auto read_section = [&] (WorldArchiveSection section, size_t fields) {
+			reader.read(sections[section], chunks);
+			records.clear();
+			for (const WorldArchiveChunk &chunk : chunks)
+				parse_world_archive_records(chunk.data, records);
+			chunks.clear();
+			for (const auto &record : records) {
+				if (record.size() != fields)
+					throw SerializationError("Invalid record");
+			}
+		};
+
+		// world.mt selects the backends, so the files come first.
+		// Files the world already has are kept.
+		fs::CreateAllDirs(world_path);
+		if (!has_region) {
+			read_section(WORLD_ARCHIVE_FILES, 2);
+			for (const auto &record : records) {
+				// Only known names, others could point outside of the world
+				auto name_end = std::end(WORLD_ARCHIVE_FILE_NAMES);
+				if (std::find(std::begin(WORLD_ARCHIVE_FILE_NAMES), name_end,
+						record[0]) == name_end)
+					throw SerializationError("Invalid world file name \"" +
+						record[0] + "\"");
+				std::string path = world_path + DIR_DELIM + record[0];
+				if (fs::PathExists(path))
+					continue;
+				if (!fs::safeWriteToFile(path, record[1])) {
+					errorstream << "Failed to write " << path << std::endl;
+					return false;
+				}
+			}
+		}
+
+		Settings world_mt;
+		const std::string world_mt_path = world_path + DIR_DELIM + "world.mt";
+		if (!world_mt.readConfigFile(world_mt_path.c_str())) {
+			errorstream << "Cannot read world.mt at " << world_mt_path << std::endl;
+			return false;
+		}
+
+		if (!import_map(world_path, world_mt, reader, sections[WORLD_ARCHIVE_MAP],
+				has_region, bmin, bmax, blocks)) {
+			errorstream << "Import stopped after " << blocks << " blocks" << std::endl;
+			return false;
+		}
+
+		if (!has_region) {
+			std::unique_ptr<PlayerDatabase> player_db(ServerEnvironment::openPlayerDatabase(
+					get_backend(world_mt, "player_backend", "files"), world_path, world_mt));
+			read_section(WORLD_ARCHIVE_PLAYERS, 2);
+			player_db->beginSaveBatch();
+			for (const auto &record : records) {
+				RemotePlayer player(record[0].c_str(), nullptr);
+				PlayerSAO sao(nullptr, &player, 15000, false);
+				std::istringstream ss(record[1], std::ios_base::binary);
+				PlayerDatabaseFiles::deSerialize(&player, ss, record[0], &sao);
+				sao.finalize(&player, std::set<std::string>());
+				player.setPlayerSAO(&sao);
+				player.setModified(true);
+				player_db->savePlayer(&player);
+				players++;
+			}
+			player_db->endSaveBatch();
+
+			std::unique_ptr<AuthDatabase> auth_db(ServerEnvironment::openAuthDatabase(
+					get_backend(world_mt, "auth_backend", "files"), world_path, world_mt));
+			read_section(WORLD_ARCHIVE_AUTH, 4);
+			for (const auto &record : records) {
+				AuthEntry auth;
+				bool exists = auth_db->getAuth(record[0], auth);
+				auth.name = record[0];
+				auth.password = record[1];
+				auth.privileges.clear();
+				if (!record[2].empty())
+					auth.privileges = str_split(record[2], ',');
+				auth.last_login = stoi64(record[3]);
+				if (exists ? auth_db->saveAuth(auth) : auth_db->createAuth(auth))
+					auths++;
+			}
+
+			std::unique_ptr<ModStorageDatabase> storage_db(Server::openModStorageDatabase(
+					get_backend(world_mt, "mod_storage_backend", "files"),
+					world_path, world_mt));
+			read_section(WORLD_ARCHIVE_MOD_STORAGE, 3);
+			storage_db->beginSave();
+			for (const auto &record : records) {
+				if (storage_db->setModEntry(record[0], record[1], record[2]))
+					entries++;
+			}
+			storage_db->endSave();
+		}
+	} catch (BaseException &e) {
+		errorstream << "Import failed: " << e.what() << std::endl;
+		return false;
+	}
+
+	if (has_region) {
+		actionstream << "Imported " << blocks << " blocks of region " << region
+			<< " from " << archive_path << std::endl;
+	} else {
+		actionstream << "Imported " << blocks << " blocks, " << players << " players, "
+			<< auths << " auth entries and " << entries << " mod storage entries from "
+			<< archive_path << std::endl;
+	}
+	return true;
+}
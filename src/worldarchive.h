@@ -0,0 +1,130 @@
+/*
+Minetest
+Copyright (C) 2022 Minetest core development team
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "irrlichttypes_bloated.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+	Seekable archive of a world's databases.
+
+	The archive is a sequence of chunks, each a zstd frame holding records
+	of one section, followed by an index of the chunks. Map blocks are
+	grouped into chunks by region, and the index keeps the block range of
+	every map chunk, so a region can be read without decompressing the rest.
+
+	Layout:
+		magic, u16 version
+		chunks
+		index: u32 count, then per chunk: u8 section, u64 offset,
+			u32 size, u32 raw size, u32 records, v3s32 min, v3s32 max
+		u64 index offset, magic
+
+	A record is a u8 field count followed by that many long strings.
+*/
+
+enum WorldArchiveSection : u8
+{
+	// World files such as world.mt: name, content
+	WORLD_ARCHIVE_FILES,
+	// Position as V3S32, serialized block
+	WORLD_ARCHIVE_MAP,
+	// Name, player file as written by the files backend
+	WORLD_ARCHIVE_PLAYERS,
+	// Name, password, comma separated privileges, last login
+	WORLD_ARCHIVE_AUTH,
+	// Mod name, key, value
+	WORLD_ARCHIVE_MOD_STORAGE,
+};
+
+// Edge length of the regions map chunks are made of, in blocks
+#define WORLD_ARCHIVE_REGION_SIZE 8
+
+struct WorldArchiveChunk
+{
+	WorldArchiveSection section = WORLD_ARCHIVE_FILES;
+	u64 offset = 0;
+	u32 size = 0;
+	u32 raw_size = 0;
+	u32 records = 0;
+	// Block range of map chunks
+	v3s32 min, max;
+
+	// Serialized records, before compression or after decompression
+	std::string data;
+
+	void addRecord(const std::vector<std::string> &fields);
+	void addBlock(v3s32 pos, const std::string &data);
+
+	bool overlaps(v3s32 bmin, v3s32 bmax) const;
+};
+
+// Splits serialized records into their fields
+void parse_world_archive_records(const std::string &data,
+		std::vector<std::vector<std::string>> &records);
+
+class WorldArchiveWriter
+{
+public:
+	WorldArchiveWriter(std::ostream &os, int compression_level = 0);
+
+	// Compresses the chunks on all cores and appends them in order
+	void write(std::vector<WorldArchiveChunk> &chunks);
+	// Writes the index, which completes the archive
+	void finish();
+
+	u64 getSize() const { return m_offset; }
+
+private:
+	std::ostream &m_os;
+	int m_compression_level;
+	u64 m_offset = 0;
+	std::vector<WorldArchiveChunk> m_index;
+};
+
+class WorldArchiveReader
+{
+public:
+	// Reads the index, throws SerializationError if it isn't an archive
+	WorldArchiveReader(std::istream &is);
+
+	// Without data
+	const std::vector<WorldArchiveChunk> &getIndex() const { return m_index; }
+
+	// Reads and decompresses the chunks at these index positions,
+	// decompressing on all cores
+	void read(const std::vector<size_t> &which, std::vector<WorldArchiveChunk> &chunks);
+
+private:
+	std::istream &m_is;
+	std::vector<WorldArchiveChunk> m_index;
+};
+
+// Writes the world's map, players, auth and mod storage databases
+// to an archive
+bool export_world(const std::string &world_path, const std::string &archive_path);
+
+// Restores a world from an archive, into the backends set in its world.mt.
+// With a region ("x1,y1,z1 x2,y2,z2" in nodes) only the blocks overlapping
+// it are restored.
+bool import_world(const std::string &world_path, const std::string &archive_path,
+		const std::string &region = "");